@@ -8,6 +8,7 @@ set(TESSERACT_SRC_API
     src/api/capi.cpp
     src/api/hocrrenderer.cpp
     src/api/lstmboxrenderer.cpp
+    src/api/pagequeue.cpp
     src/api/pagerenderer.cpp
     src/api/pdfrenderer.cpp
     src/api/renderer.cpp
@@ -16,6 +17,7 @@ set(TESSERACT_SRC_API
 
 # Architecture-specific sources
 set(TESSERACT_SRC_ARCH
+    src/arch/activationtables.cpp
     src/arch/dotproduct.cpp
     src/arch/simddetect.cpp
     src/arch/intsimdmatrix.cpp
@@ -29,10 +31,23 @@ set(TESSERACT_SRC_ARCH_AVX
 set(TESSERACT_SRC_ARCH_AVX2
     src/arch/intsimdmatrixavx2.cpp
     src/arch/dotproductavx.cpp
+    src/arch/activationavx2.cpp
+    src/arch/thresholdavx2.cpp
+    src/arch/intmatchavx2.cpp
 )
 
 set(TESSERACT_SRC_ARCH_AVX512F
     src/arch/dotproductavx512.cpp
+    src/arch/activationavx512.cpp
+    src/arch/thresholdavx512.cpp
+)
+
+set(TESSERACT_SRC_ARCH_AVX512VNNI
+    src/arch/intsimdmatrixavx512vnni.cpp
+)
+
+set(TESSERACT_SRC_ARCH_AVXVNNI
+    src/arch/intsimdmatrixavxvnni.cpp
 )
 
 set(TESSERACT_SRC_ARCH_FMA
@@ -42,11 +57,15 @@ set(TESSERACT_SRC_ARCH_FMA
 set(TESSERACT_SRC_ARCH_SSE41
     src/arch/dotproductsse.cpp
     src/arch/intsimdmatrixsse.cpp
+    src/arch/activationsse.cpp
+    src/arch/thresholdsse.cpp
 )
 
 set(TESSERACT_SRC_ARCH_NEON
     src/arch/dotproductneon.cpp
     src/arch/intsimdmatrixneon.cpp
+    src/arch/activationneon.cpp
+    src/arch/thresholdneon.cpp
 )
 
 # CCMain module sources
@@ -129,10 +148,12 @@ set(TESSERACT_SRC_CCUTIL
     src/ccutil/ccutil.cpp
     src/ccutil/errcode.cpp
     src/ccutil/indexmapbidi.cpp
+    src/ccutil/mappedfile.cpp
     src/ccutil/params.cpp
     src/ccutil/scanutils.cpp
     src/ccutil/serialis.cpp
     src/ccutil/tessdatamanager.cpp
+    src/ccutil/threadpool.cpp
     src/ccutil/tprintf.cpp
     src/ccutil/unichar.cpp
     src/ccutil/unicharcompress.cpp
@@ -155,6 +176,7 @@ set(TESSERACT_SRC_CLASSIFY
     src/classify/intfeaturespace.cpp
     src/classify/intfx.cpp
     src/classify/intmatcher.cpp
+    src/classify/matchcache.cpp
     src/classify/intproto.cpp
     src/classify/kdtree.cpp
     src/classify/mfoutline.cpp
@@ -192,7 +214,6 @@ set(TESSERACT_SRC_DICT
 set(TESSERACT_SRC_LSTM
     src/lstm/convolve.cpp
     src/lstm/fullyconnected.cpp
-    src/lstm/functions.cpp
     src/lstm/input.cpp
     src/lstm/lstm.cpp
     src/lstm/lstmrecognizer.cpp
@@ -313,6 +334,7 @@ set(TESSERACT_SRC_LEGACY
     src/classify/intfeaturespace.cpp
     src/classify/intfx.cpp
     src/classify/intmatcher.cpp
+    src/classify/matchcache.cpp
     src/classify/intproto.cpp
     src/classify/kdtree.cpp
     src/classify/mfoutline.cpp
@@ -365,10 +387,15 @@ set(TESSERACT_HDR_INCLUDE
 
 # Internal header files
 set(TESSERACT_HDR_INTERNAL
+    src/api/pagequeue.h
     src/api/pdf_ttf.h
+    src/arch/activation.h
+    src/arch/activationsimd.h
     src/arch/dotproduct.h
+    src/arch/intmatch.h
     src/arch/intsimdmatrix.h
     src/arch/simddetect.h
+    src/arch/threshold.h
     src/ccmain/control.h
     src/ccmain/docqual.h
     src/ccmain/equationdetect.h
@@ -437,6 +464,7 @@ set(TESSERACT_HDR_INTERNAL
     src/ccutil/indexmapbidi.h
     src/ccutil/kdpair.h
     src/ccutil/lsterr.h
+    src/ccutil/mappedfile.h
     src/ccutil/object_cache.h
     src/ccutil/params.h
     src/ccutil/qrsequence.h
@@ -446,6 +474,7 @@ set(TESSERACT_HDR_INTERNAL
     src/ccutil/tessdatamanager.h
     src/ccutil/tesserrstream.h
     src/ccutil/tesstypes.h
+    src/ccutil/threadpool.h
     src/ccutil/tprintf.h
     src/ccutil/unicity_table.h
     src/ccutil/unicharcompress.h
@@ -462,6 +491,7 @@ set(TESSERACT_HDR_INTERNAL
     src/classify/intfeaturespace.h
     src/classify/intfx.h
     src/classify/intmatcher.h
+    src/classify/matchcache.h
     src/classify/intproto.h
     src/classify/kdtree.h
     src/classify/mfdefs.h
@@ -30,7 +30,8 @@
 #include <tesseract/version.h>
 
 #include <cstdio>
-#include <vector> // for std::vector
+#include <functional> // for std::function
+#include <vector>     // for std::vector
 
 struct Pix;
 struct Pixa;
@@ -45,15 +46,21 @@ class ETEXT_DESC;
 struct OSResults;
 class UNICHARSET;
 
+class BoolParam;
 class Dawg;
 class Dict;
+class DoubleParam;
 class EquationDetect;
 class PageIterator;
 class ImageThresholder;
+class IntParam;
 class LTRResultIterator;
 class ResultIterator;
 class MutableIterator;
+class PageQueue;
+class StringParam;
 class TessResultRenderer;
+class TessBaseAPI;
 class Tesseract;
 
 // Function to read a std::vector<char> from a whole file.
@@ -65,6 +72,12 @@ using DictFunc = int (Dict::*)(void *, const UNICHARSET &, UNICHAR_ID,
 using ProbabilityInContextFunc = double (Dict::*)(const char *, const char *,
                                                   int, const char *, int);
 
+// Function called on a worker thread when a page given to
+// TessBaseAPI::SubmitPage is done. api holds the results of the page and may
+// only be used during the call.
+using PageDoneFunc = void (*)(int job_id, bool success, TessBaseAPI *api,
+                              void *user_data);
+
 /**
  * Base class for all tesseract APIs.
  * Specific classes can add ability to work on different inputs or produce
@@ -138,6 +151,37 @@ public:
    */
   const char *GetStringVariable(const char *name) const;
 
+  /**
+   * Returns a handle of the parameter of the given name and type, or
+   * nullptr if there is none. The handle can be used with GetVariable and
+   * SetVariable below to get and set the parameter without looking up its
+   * name again. It stays valid until the next Init or End, so find it
+   * after Init.
+   */
+  IntParam *FindIntVariable(const char *name);
+  BoolParam *FindBoolVariable(const char *name);
+  DoubleParam *FindDoubleVariable(const char *name);
+  StringParam *FindStringVariable(const char *name);
+
+  /**
+   * Returns the value of the parameter with the given handle, or
+   * 0, false, 0.0 or nullptr if the handle is nullptr.
+   */
+  int GetVariable(const IntParam *param) const;
+  bool GetVariable(const BoolParam *param) const;
+  double GetVariable(const DoubleParam *param) const;
+  const char *GetVariable(const StringParam *param) const;
+
+  /**
+   * Sets the parameter with the given handle to the given value.
+   * Returns false if the handle is nullptr, or if the parameter can only
+   * be set by Init, like SetVariable ignores such parameters.
+   */
+  bool SetVariable(IntParam *param, int value);
+  bool SetVariable(BoolParam *param, bool value);
+  bool SetVariable(DoubleParam *param, double value);
+  bool SetVariable(StringParam *param, const char *value);
+
 #ifndef DISABLED_LEGACY_ENGINE
 
   /**
@@ -317,6 +361,18 @@ public:
    */
   void SetImage(Pix *pix);
 
+  /**
+   * Provide an image that the caller has already binarized, skipping
+   * thresholding. binary must be 1 bpp. grey may be nullptr or an 8 bpp
+   * image without colormap of the same size, which the LSTM recognizer then
+   * reads instead of the binary image.
+   * Unlike SetImage, Tesseract only clones the images instead of copying or
+   * converting them, so the caller may pixDestroy its references, but must
+   * not modify the image data until the next SetImage, Clear or End.
+   * Other input is passed on to SetImage and thresholded as usual.
+   */
+  void SetBinarizedImage(Pix *binary, Pix *grey);
+
   /**
    * Set the resolution of the source image in pixels per inch so font size
    * information can be calculated in results.  Call this after SetImage().
@@ -477,6 +533,12 @@ public:
    * If tessedit_page_number is non-negative, will only process that
    * single page. Works for multi-page tiff file, or filelist.
    *
+   * If page_num_threads is greater than 1, the pages of a multi-page tiff
+   * file or filelist are recognized concurrently by that many internal
+   * copies of this instance, which share its loaded models. The renderer
+   * still gets the pages in order, but the results of the last page are
+   * not kept in this instance then.
+   *
    * Returns true if successful, false on error.
    */
   bool ProcessPages(const char *filename, const char *retry_config,
@@ -498,6 +560,53 @@ public:
                    const char *retry_config, int timeout_millisec,
                    TessResultRenderer *renderer);
 
+  /**
+   * Starts num_workers threads that recognize the pages given to SubmitPage
+   * in the background, each with its own copy of this instance, which shares
+   * its loaded models. Call it after Init and after setting the variables
+   * that all pages share. At most max_pending pages wait for a worker, and
+   * SubmitPage blocks while that many are waiting.
+   * Returns false if the workers cannot be initialized.
+   */
+  bool StartPageQueue(int num_workers, int max_pending);
+
+  /**
+   * Queues the page for recognition by the workers of StartPageQueue, and
+   * returns the id of its job, or -1 if there is no page queue. The pix is
+   * cloned, so the caller may destroy it at once. If vars_vec and
+   * vars_values are given, the variables are set to these values for this
+   * page only.
+   *
+   * If func is not nullptr, it is called with user_data on the worker thread
+   * when the page is done, and the worker it gets can be used to read the
+   * results, for example with GetUTF8Text or TessResultRenderer::AddImage.
+   * Otherwise the UTF-8 text of the page is kept for WaitForPage.
+   */
+  int SubmitPage(Pix *pix, const std::vector<std::string> *vars_vec,
+                 const std::vector<std::string> *vars_values,
+                 PageDoneFunc func, void *user_data);
+
+  /**
+   * Returns true if the page with the given job id, which was submitted
+   * without a callback, is done, so WaitForPage does not block.
+   */
+  bool IsPageDone(int job_id) const;
+
+  /**
+   * Waits until the page with the given job id, which was submitted without
+   * a callback, is done, and sets *text to its UTF-8 text, which must be
+   * freed with the delete [] operator. The job is then forgotten.
+   * Returns false and sets *text to nullptr if the recognition failed or
+   * there is no such job.
+   */
+  bool WaitForPage(int job_id, char **text);
+
+  /**
+   * Waits until all submitted pages are done, and stops the workers of
+   * StartPageQueue. End does this too.
+   */
+  void EndPageQueue();
+
   /**
    * Get a reading-order iterator to the results of LayoutAnalysis and/or
    * Recognize. The returned iterator must be deleted after use.
@@ -524,6 +633,19 @@ public:
    */
   char *GetUTF8Text();
 
+  /**
+   * Function that gets the consecutive pieces of the text of a page from
+   * the Write*Text functions below. Returns false to stop the output.
+   */
+  using TextWriter = std::function<bool(const std::string &text)>;
+
+  /**
+   * Gives the recognized text, coded as UTF8, to write one paragraph at a
+   * time, so the text of the whole page is never held in memory.
+   * Returns false if the recognition fails or write returns false.
+   */
+  bool WriteUTF8Text(const TextWriter &write);
+
   /**
    * Make a HTML-formatted string with hOCR markup from the internal
    * data structures.
@@ -543,6 +665,14 @@ public:
    */
   char *GetHOCRText(int page_number);
 
+  /**
+   * Gives the hOCR markup of GetHOCRText to write one block at a time, so
+   * the output can go straight to its destination.
+   * Returns false if the recognition fails or write returns false.
+   */
+  bool WriteHOCRText(ETEXT_DESC *monitor, int page_number,
+                     const TextWriter &write);
+
   /**
    * Make an XML-formatted string with Alto markup from the internal
    * data structures.
@@ -555,6 +685,14 @@ public:
    */
   char *GetAltoText(int page_number);
 
+  /**
+   * Gives the Alto markup of GetAltoText to write one block at a time, so
+   * the output can go straight to its destination.
+   * Returns false if the recognition fails or write returns false.
+   */
+  bool WriteAltoText(ETEXT_DESC *monitor, int page_number,
+                     const TextWriter &write);
+
    /**
    * Make an XML-formatted string with PAGE markup from the internal
    * data structures.
@@ -567,6 +705,14 @@ public:
    */
   char *GetPAGEText(int page_number);
 
+  /**
+   * Gives the PAGE markup of GetPAGEText to write, all at once, because its
+   * reading order precedes the regions.
+   * Returns false if the recognition fails or write returns false.
+   */
+  bool WritePAGEText(ETEXT_DESC *monitor, int page_number,
+                     const TextWriter &write);
+
   /**
    * Make a TSV-formatted string from the internal data structures.
    * page_number is 0-based but will appear in the output as 1-based.
@@ -574,6 +720,13 @@ public:
    */
   char *GetTSVText(int page_number);
 
+  /**
+   * Gives the rows of the TSV-formatted text of GetTSVText to write one at a
+   * time, so the text of the whole page is never held in memory.
+   * Returns false if the recognition fails or write returns false.
+   */
+  bool WriteTSVText(int page_number, const TextWriter &write);
+
   /**
    * Make a box file for LSTM training from the internal data structures.
    * Constructs coordinates in the original image - not just the rectangle.
@@ -784,6 +937,7 @@ protected:
   std::string language_;             ///< Last initialized language.
   OcrEngineMode last_oem_requested_; ///< Last ocr language mode requested.
   bool recognition_done_;            ///< page_res_ contains recognition data.
+  PageQueue *page_queue_;            ///< Pages from SubmitPage.
 
   /**
    * @defgroup ThresholderParams Thresholder Parameters
@@ -810,6 +964,29 @@ private:
                                  int timeout_millisec,
                                  TessResultRenderer *renderer,
                                  int tessedit_page_number);
+  // Reads the next page of a multipage document. Sets *pix to the page, which
+  // the caller must destroy, or to nullptr if there are no more pages.
+  // Returns false on error.
+  using PageReader =
+      std::function<bool(Pix **pix, int *page_index, std::string *filename)>;
+  // Processes all the pages from read_page with ProcessPage. If
+  // page_num_threads is greater than 1, runs ProcessPagesParallel instead,
+  // unless that cannot be used with the given retry_config or the current
+  // training mode, or the workers cannot be initialized.
+  // If set_applybox_page, sets applybox_page to the index of each page.
+  bool ProcessPagesPipeline(const PageReader &read_page, bool set_applybox_page,
+                            const char *retry_config, int timeout_millisec,
+                            TessResultRenderer *renderer);
+  // Returns a new TessBaseAPI with the same language, engine mode and
+  // parameters as this one, which shares its cached models, or nullptr if
+  // it cannot be initialized.
+  TessBaseAPI *NewPageWorker() const;
+  // Reads the pages from read_page on the calling thread, ahead of their
+  // recognition, and recognizes them concurrently, one on each of the given
+  // workers. Gives the results to the renderer in page order.
+  bool ProcessPagesParallel(const PageReader &read_page, bool set_applybox_page,
+                            int timeout_millisec, TessResultRenderer *renderer,
+                            const std::vector<TessBaseAPI *> &workers);
 }; // class TessBaseAPI.
 
 /** Escape a char string - replace &<>"' with HTML codes. */
@@ -138,6 +138,8 @@ typedef struct ETEXT_DESC ETEXT_DESC;
 typedef bool (*TessCancelFunc)(void *cancel_this, int words);
 typedef bool (*TessProgressFunc)(ETEXT_DESC *ths, int left, int right, int top,
                                  int bottom);
+typedef void (*TessPageDoneFunc)(int job_id, bool success, TessBaseAPI *handle,
+                                 void *user_data);
 
 struct Pix;
 struct Boxa;
@@ -322,6 +324,15 @@ TESS_API void TessBaseAPISetImage(TessBaseAPI *handle,
  */
 TESS_API void TessBaseAPISetImage2(TessBaseAPI *handle, struct Pix *pix);
 
+/**
+ * Sets an already binarized 1 bpp image and an optional 8 bpp grey image
+ * for recognition without thresholding. The images are cloned, not copied,
+ * so the caller must not modify them until the next image is set.
+ */
+TESS_API void TessBaseAPISetBinarizedImage(TessBaseAPI *handle,
+                                           struct Pix *binary,
+                                           struct Pix *grey);
+
 TESS_API void TessBaseAPISetSourceResolution(TessBaseAPI *handle, int ppi);
 
 TESS_API void TessBaseAPISetRectangle(TessBaseAPI *handle, int left, int top,
@@ -371,6 +382,22 @@ TESS_API BOOL TessBaseAPIProcessPage(TessBaseAPI *handle, struct Pix *pix,
                                      int timeout_millisec,
                                      TessResultRenderer *renderer);
 
+/**
+ * Background recognition of pages, see TessBaseAPI::StartPageQueue and
+ * TessBaseAPI::SubmitPage. The text from TessBaseAPIWaitForPage must be freed
+ * using TessDeleteText.
+ */
+TESS_API BOOL TessBaseAPIStartPageQueue(TessBaseAPI *handle, int num_workers,
+                                        int max_pending);
+TESS_API int TessBaseAPISubmitPage(TessBaseAPI *handle, struct Pix *pix,
+                                   char **vars_vec, char **vars_values,
+                                   size_t vars_vec_size, TessPageDoneFunc func,
+                                   void *user_data);
+TESS_API BOOL TessBaseAPIIsPageDone(const TessBaseAPI *handle, int job_id);
+TESS_API BOOL TessBaseAPIWaitForPage(TessBaseAPI *handle, int job_id,
+                                     char **text);
+TESS_API void TessBaseAPIEndPageQueue(TessBaseAPI *handle);
+
 TESS_API TessResultIterator *TessBaseAPIGetIterator(TessBaseAPI *handle);
 TESS_API TessMutableIterator *TessBaseAPIGetMutableIterator(
     TessBaseAPI *handle);
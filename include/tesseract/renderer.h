@@ -21,9 +21,11 @@
 // To avoid collision with other typenames include the ABSOLUTE MINIMUM
 // complexity of includes here. Use forward declarations wherever possible
 // and hide includes of complex types in baseapi.cpp.
+#include <cstddef> // for size_t
 #include <cstdint>
-#include <string> // for std::string
-#include <vector> // for std::vector
+#include <cstdio>  // for FILE
+#include <string>  // for std::string
+#include <vector>  // for std::vector
 
 struct Pix;
 
@@ -31,6 +33,35 @@ namespace tesseract {
 
 class TessBaseAPI;
 
+/**
+ * Destination for the output of a TessResultRenderer, as an alternative to
+ * its output file. The renderer gives the output to Write in pieces of
+ * bounded size, as soon as they are produced, so a sink can stream a
+ * document of any length without holding it in memory.
+ */
+class TESS_API TessOutputSink {
+public:
+  virtual ~TessOutputSink();
+
+  // Writes the next size bytes of the output. Returns false on failure,
+  // which makes the renderer unhappy.
+  virtual bool Write(const char *data, size_t size) = 0;
+};
+
+/**
+ * Output sink that appends the output to a string owned by the caller, so
+ * the output of a renderer can be used without any further copies.
+ */
+class TESS_API TessStringSink : public TessOutputSink {
+public:
+  explicit TessStringSink(std::string *output) : output_(output) {}
+
+  bool Write(const char *data, size_t size) override;
+
+private:
+  std::string *output_; // not owned
+};
+
 /**
  * Interface for rendering tesseract results into a document, such as text,
  * HOCR or pdf. This class is abstract. Specific classes handle individual
@@ -58,6 +89,15 @@ public:
     return next_;
   }
 
+  /**
+   * Sends the output to the given sink, which must outlive the renderer,
+   * instead of the output file. Use an outputbase of "-" for a renderer
+   * that only writes to a sink. Call it before BeginDocument.
+   */
+  void SetOutputSink(TessOutputSink *sink) {
+    sink_ = sink;
+  }
+
   /**
    * Starts a new document with the given title.
    * This clears the contents of the output data.
@@ -129,14 +169,14 @@ protected:
   virtual bool EndDocumentHandler();
 
   // Renderers can call this to append '\0' terminated strings into
-  // the output string returned by GetOutput.
-  // This method will grow the output buffer if needed.
+  // the output.
+  // The output is buffered, up to a fixed size, until the end of the page.
   void AppendString(const char *s);
 
   // Renderers can call this to append binary byte sequences into
-  // the output string returned by GetOutput. Note that s is not necessarily
+  // the output. Note that s is not necessarily
   // '\0' terminated (and can contain '\0' within it).
-  // This method will grow the output buffer if needed.
+  // The output is buffered, up to a fixed size, until the end of the page.
   void AppendData(const char *s, int len);
 
   template <typename T>
@@ -146,8 +186,15 @@ protected:
   }
 
 private:
+  // Writes the buffered output to the sink or the output file.
+  void FlushOutput();
+  // Writes the given data to the sink or the output file.
+  void WriteOutput(const char *data, size_t size);
+
   TessResultRenderer *next_;   // Can link multiple renderers together
   FILE *fout_;                 // output file pointer
+  TessOutputSink *sink_;       // output sink used instead of fout_ if set
+  std::string buffer_;         // output that is not yet written
   const char *file_extension_; // standard extension for generated output
   std::string title_;          // title of document being rendered
   int imagenum_;               // index of last image added
@@ -263,7 +310,7 @@ private:
   // Bookkeeping + emit data.
   void AppendPDFObject(const char *data);
   // Create the /Contents object for an entire page.
-  char *GetPDFTextObjects(TessBaseAPI *api, double width, double height);
+  std::string GetPDFTextObjects(TessBaseAPI *api, double width, double height);
   // Turn an image into a PDF object. Only transcode if we have to.
   static bool imageToPDFObj(Pix *pix, const char *filename, long int objnum,
                             char **pdf_object, long int *pdf_object_size,
@@ -109,14 +109,10 @@ bool TessAltoRenderer::AddImageHandler(TessBaseAPI *api) {
     begin_document = false;
   }
 
-  const std::unique_ptr<const char[]> text(api->GetAltoText(imagenum()));
-  if (text == nullptr) {
-    return false;
-  }
-
-  AppendString(text.get());
-
-  return true;
+  return api->WriteAltoText(nullptr, imagenum(), [this](const std::string &text) {
+    AppendData(text);
+    return happy();
+  });
 }
 
 ///
@@ -145,9 +141,24 @@ char *TessBaseAPI::GetAltoText(int page_number) {
 /// data structures.
 ///
 char *TessBaseAPI::GetAltoText(ETEXT_DESC *monitor, int page_number) {
-  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(monitor) < 0)) {
+  std::string text;
+  if (!WriteAltoText(monitor, page_number, [&text](const std::string &block) {
+        text += block;
+        return true;
+      })) {
     return nullptr;
   }
+  return copy_string(text);
+}
+
+///
+/// Write the XML-formatted text with ALTO markup from the internal
+/// data structures block by block.
+///
+bool TessBaseAPI::WriteAltoText(ETEXT_DESC *monitor, int page_number, const TextWriter &write) {
+  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(monitor) < 0)) {
+    return false;
+  }
 
   int lcnt = 0, tcnt = 0, bcnt = 0, wcnt = 0;
 
@@ -262,13 +273,18 @@ char *TessBaseAPI::GetAltoText(ETEXT_DESC *monitor, int page_number) {
     if (last_word_in_cblock) {
       alto_str << "\t\t\t\t</ComposedBlock>\n";
       bcnt++;
+      // Give the finished block to write, so the page is not kept whole.
+      if (!write(alto_str.str())) {
+        return false;
+      }
+      alto_str.str("");
     }
   }
 
   alto_str << "\t\t\t</PrintSpace>\n"
            << "\t\t</Page>\n";
 
-  return copy_string(alto_str.str());
+  return write(alto_str.str());
 }
 
 } // namespace tesseract
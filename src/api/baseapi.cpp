@@ -40,8 +40,10 @@
 #ifndef DISABLED_LEGACY_ENGINE
 #  include "intfx.h" // for INT_FX_RESULT_STRUCT
 #endif
+#include "lstmrecognizer.h"  // for LSTMRecognizer
 #include "mutableiterator.h" // for MutableIterator
 #include "normalis.h"        // for kBlnBaselineOffset, kBlnXHeight
+#include "pagequeue.h"       // for PageQueue
 #include "pageres.h"         // for PAGE_RES_IT, WERD_RES, PAGE_RES, CR_DE...
 #include "paragraphs.h"      // for DetectParagraphs
 #include "params.h"          // for BoolParam, IntParam, DoubleParam, Stri...
@@ -62,17 +64,23 @@
 #include <tesseract/renderer.h>       // for TessResultRenderer
 #include <tesseract/resultiterator.h> // for ResultIterator
 
+#include <algorithm> // for std::max
+#include <atomic>   // for std::atomic
 #include <cmath>    // for round, M_PI
+#include <condition_variable> // for std::condition_variable
 #include <cstdint>  // for int32_t
 #include <cstring>  // for strcmp, strcpy
+#include <deque>    // for std::deque
 #include <filesystem> // for std::filesystem
 #include <fstream>  // for size_t
 #include <iostream> // for std::cin
 #include <locale>   // for std::locale::classic
 #include <memory>   // for std::unique_ptr
+#include <mutex>    // for std::mutex
 #include <set>      // for std::pair
 #include <sstream>  // for std::stringstream
 #include <string_view>
+#include <thread>   // for std::thread
 #include <vector>   // for std::vector
 
 #ifdef HAVE_LIBCURL
@@ -176,6 +184,7 @@ TessBaseAPI::TessBaseAPI()
     , page_res_(nullptr)
     , last_oem_requested_(OEM_DEFAULT)
     , recognition_done_(false)
+    , page_queue_(nullptr)
     , rect_left_(0)
     , rect_top_(0)
     , rect_width_(0)
@@ -224,8 +233,7 @@ bool TessBaseAPI::SetDebugVariable(const char *name, const char *value) {
 }
 
 bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
-  auto *p = ParamUtils::FindParam<IntParam>(name, GlobalParams()->int_params,
-                                            tesseract_->params()->int_params);
+  auto *p = ParamUtils::FindParam<IntParam>(name, tesseract_->params());
   if (p == nullptr) {
     return false;
   }
@@ -234,8 +242,7 @@ bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
 }
 
 bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
-  auto *p = ParamUtils::FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                             tesseract_->params()->bool_params);
+  auto *p = ParamUtils::FindParam<BoolParam>(name, tesseract_->params());
   if (p == nullptr) {
     return false;
   }
@@ -244,14 +251,12 @@ bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
 }
 
 const char *TessBaseAPI::GetStringVariable(const char *name) const {
-  auto *p = ParamUtils::FindParam<StringParam>(name, GlobalParams()->string_params,
-                                               tesseract_->params()->string_params);
+  auto *p = ParamUtils::FindParam<StringParam>(name, tesseract_->params());
   return (p != nullptr) ? p->c_str() : nullptr;
 }
 
 bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
-  auto *p = ParamUtils::FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                               tesseract_->params()->double_params);
+  auto *p = ParamUtils::FindParam<DoubleParam>(name, tesseract_->params());
   if (p == nullptr) {
     return false;
   }
@@ -259,6 +264,94 @@ bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
   return true;
 }
 
+IntParam *TessBaseAPI::FindIntVariable(const char *name) {
+  if (tesseract_ == nullptr) {
+    tesseract_ = new Tesseract;
+  }
+  return ParamUtils::FindParam<IntParam>(name, tesseract_->params());
+}
+
+BoolParam *TessBaseAPI::FindBoolVariable(const char *name) {
+  if (tesseract_ == nullptr) {
+    tesseract_ = new Tesseract;
+  }
+  return ParamUtils::FindParam<BoolParam>(name, tesseract_->params());
+}
+
+DoubleParam *TessBaseAPI::FindDoubleVariable(const char *name) {
+  if (tesseract_ == nullptr) {
+    tesseract_ = new Tesseract;
+  }
+  return ParamUtils::FindParam<DoubleParam>(name, tesseract_->params());
+}
+
+StringParam *TessBaseAPI::FindStringVariable(const char *name) {
+  if (tesseract_ == nullptr) {
+    tesseract_ = new Tesseract;
+  }
+  return ParamUtils::FindParam<StringParam>(name, tesseract_->params());
+}
+
+int TessBaseAPI::GetVariable(const IntParam *param) const {
+  if (param == nullptr) {
+    return 0;
+  }
+  return static_cast<int32_t>(*param);
+}
+
+bool TessBaseAPI::GetVariable(const BoolParam *param) const {
+  if (param == nullptr) {
+    return false;
+  }
+  return static_cast<bool>(*param);
+}
+
+double TessBaseAPI::GetVariable(const DoubleParam *param) const {
+  if (param == nullptr) {
+    return 0.0;
+  }
+  return static_cast<double>(*param);
+}
+
+const char *TessBaseAPI::GetVariable(const StringParam *param) const {
+  if (param == nullptr) {
+    return nullptr;
+  }
+  return param->c_str();
+}
+
+bool TessBaseAPI::SetVariable(IntParam *param, int value) {
+  if (param == nullptr || !param->constraint_ok(SET_PARAM_CONSTRAINT_NON_INIT_ONLY)) {
+    return false;
+  }
+  param->set_value(value);
+  return true;
+}
+
+bool TessBaseAPI::SetVariable(BoolParam *param, bool value) {
+  if (param == nullptr || !param->constraint_ok(SET_PARAM_CONSTRAINT_NON_INIT_ONLY)) {
+    return false;
+  }
+  param->set_value(value);
+  return true;
+}
+
+bool TessBaseAPI::SetVariable(DoubleParam *param, double value) {
+  if (param == nullptr || !param->constraint_ok(SET_PARAM_CONSTRAINT_NON_INIT_ONLY)) {
+    return false;
+  }
+  param->set_value(value);
+  return true;
+}
+
+bool TessBaseAPI::SetVariable(StringParam *param, const char *value) {
+  if (param == nullptr || !param->constraint_ok(SET_PARAM_CONSTRAINT_NON_INIT_ONLY)) {
+    return false;
+  }
+  param->set_value(value);
+  return true;
+}
+
 /** Get value of named variable as a string, if it exists. */
 bool TessBaseAPI::GetVariableAsString(const char *name, std::string *val) const {
   return ParamUtils::GetParamAsString(name, tesseract_->params(), val);
@@ -539,6 +632,32 @@ void TessBaseAPI::SetImage(Pix *pix) {
   }
 }
 
+/**
+ * Provide an already binarized image, and optionally its grey original,
+ * which are cloned rather than copied and used without thresholding.
+ */
+void TessBaseAPI::SetBinarizedImage(Pix *binary, Pix *grey) {
+  if (pixGetDepth(binary) != 1) {
+    SetImage(binary);
+    return;
+  }
+  if (grey != nullptr &&
+      (pixGetDepth(grey) != 8 || pixGetColormap(grey) != nullptr ||
+       pixGetWidth(grey) != pixGetWidth(binary) ||
+       pixGetHeight(grey) != pixGetHeight(binary))) {
+    tprintf("Warning: Ignoring grey image which is not 8 bpp or does not "
+            "match the binary image.\n");
+    grey = nullptr;
+  }
+  if (InternalSetImage()) {
+    Image grey_clone = grey != nullptr ? pixClone(grey) : nullptr;
+    thresholder_->SetBinarizedImage(pixClone(binary), grey_clone);
+    // The recognizer reads the original image, so give it the grey one.
+    SetInputImage(grey != nullptr ? thresholder_->GetPixRectGrey()
+                                  : thresholder_->GetPixRect());
+  }
+}
+
 /**
  * Restrict recognition to a sub-rectangle of the image. Call after SetImage.
  * Each SetRectangle clears the recognition results so multiple rectangles
@@ -918,34 +1037,38 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist, std::string *buf, const char
     return false;
   }
 
-  // Loop over all pages - or just the requested one
-  while (true) {
+  // Read all pages - or just the requested one
+  bool done = false;
+  auto read_page = [&](Pix **pix, int *page_index, std::string *filename) {
+    *pix = nullptr;
+    if (done) {
+      return true;
+    }
     if (flist) {
       if (fgets(pagename, sizeof(pagename), flist) == nullptr) {
-        break;
+        return true;
       }
     } else {
       if (page >= lines.size()) {
-        break;
+        return true;
       }
       snprintf(pagename, sizeof(pagename), "%s", lines[page].c_str());
     }
     chomp_string(pagename);
-    Pix *pix = pixRead(pagename);
-    if (pix == nullptr) {
+    *pix = pixRead(pagename);
+    if (*pix == nullptr) {
       tprintf("Image file %s cannot be read!\n", pagename);
       return false;
     }
     tprintf("Page %u : %s\n", page, pagename);
-    bool r = ProcessPage(pix, page, pagename, retry_config, timeout_millisec, renderer);
-    pixDestroy(&pix);
-    if (!r) {
-      return false;
-    }
-    if (tessedit_page_number >= 0) {
-      break;
-    }
+    *page_index = page;
+    *filename = pagename;
+    done = tessedit_page_number >= 0;
     ++page;
+    return true;
+  };
+  if (!ProcessPagesPipeline(read_page, false, retry_config, timeout_millisec, renderer)) {
+    return false;
   }
 
   // Finish producing output
@@ -959,39 +1082,220 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data, size_t size, co
                                             const char *retry_config, int timeout_millisec,
                                             TessResultRenderer *renderer,
                                             int tessedit_page_number) {
-  Pix *pix = nullptr;
   int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
   size_t offset = 0;
-  for (;; ++page) {
+  bool done = false;
+  auto read_page = [&](Pix **pix, int *page_index, std::string *page_filename) {
+    *pix = nullptr;
+    if (done) {
+      return true;
+    }
     if (tessedit_page_number >= 0) {
-      page = tessedit_page_number;
-      pix = (data) ? pixReadMemTiff(data, size, page) : pixReadTiff(filename, page);
+      *pix = (data) ? pixReadMemTiff(data, size, page) : pixReadTiff(filename, page);
     } else {
-      pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
-                   : pixReadFromMultipageTiff(filename, &offset);
+      *pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
+                    : pixReadFromMultipageTiff(filename, &offset);
     }
-    if (pix == nullptr) {
-      break;
+    if (*pix == nullptr) {
+      return true;
     }
     if (offset || page > 0) {
       // Only print page number for multipage TIFF file.
       tprintf("Page %d\n", page + 1);
     }
-    auto page_string = std::to_string(page);
-    SetVariable("applybox_page", page_string.c_str());
-    bool r = ProcessPage(pix, page, filename, retry_config, timeout_millisec, renderer);
+    *page_index = page;
+    *page_filename = filename;
+    done = tessedit_page_number >= 0 || !offset;
+    ++page;
+    return true;
+  };
+  return ProcessPagesPipeline(read_page, true, retry_config, timeout_millisec, renderer);
+}
+
+bool TessBaseAPI::ProcessPagesPipeline(const PageReader &read_page, bool set_applybox_page,
+                                       const char *retry_config, int timeout_millisec,
+                                       TessResultRenderer *renderer) {
+  int num_threads = std::max(1, static_cast<int>(tesseract_->page_num_threads));
+  // The retry writes the variables to a fixed file, and the training data
+  // is collected in this instance, so both need the pages processed here.
+  if (num_threads > 1 && (retry_config == nullptr || retry_config[0] == '\0') &&
+      !tesseract_->tessedit_train_from_boxes) {
+    std::vector<std::unique_ptr<TessBaseAPI>> workers;
+    std::vector<TessBaseAPI *> worker_ptrs;
+    for (int t = 0; t < num_threads; ++t) {
+      TessBaseAPI *worker = NewPageWorker();
+      if (worker == nullptr) {
+        break;
+      }
+      workers.emplace_back(worker);
+      worker_ptrs.push_back(worker);
+    }
+    if (worker_ptrs.size() == static_cast<size_t>(num_threads)) {
+      return ProcessPagesParallel(read_page, set_applybox_page, timeout_millisec, renderer,
+                                  worker_ptrs);
+    }
+    tprintf("Warning: Failed to initialize %d page workers, processing one page at a time\n",
+            num_threads);
+  }
+  for (;;) {
+    Pix *pix = nullptr;
+    int page_index = 0;
+    std::string filename;
+    if (!read_page(&pix, &page_index, &filename)) {
+      return false;
+    }
+    if (pix == nullptr) {
+      return true;
+    }
+    if (set_applybox_page) {
+      auto page_string = std::to_string(page_index);
+      SetVariable("applybox_page", page_string.c_str());
+    }
+    bool r = ProcessPage(pix, page_index, filename.c_str(), retry_config, timeout_millisec,
+                         renderer);
     pixDestroy(&pix);
     if (!r) {
       return false;
     }
-    if (tessedit_page_number >= 0) {
+  }
+}
+
+TessBaseAPI *TessBaseAPI::NewPageWorker() const {
+  // Pass all member params to Init, so the ones that only Init can set are
+  // also the same as in this instance.
+  std::vector<std::string> names;
+  std::vector<std::string> values;
+  const ParamsVectors *params = tesseract_->params();
+  auto add_params = [&](const auto &param_vec) {
+    for (auto *param : param_vec) {
+      std::string value;
+      if (ParamUtils::GetParamAsString(param->name_str(), params, &value)) {
+        names.emplace_back(param->name_str());
+        values.push_back(std::move(value));
+      }
+    }
+  };
+  add_params(params->int_params);
+  add_params(params->bool_params);
+  add_params(params->string_params);
+  add_params(params->double_params);
+
+  auto *worker = new TessBaseAPI;
+  worker->reader_ = reader_;
+  worker->SetOutputName(output_file_.c_str());
+  if (worker->Init(datapath_.c_str(), language_.c_str(), last_oem_requested_, nullptr, 0, &names,
+                   &values, false) != 0) {
+    delete worker;
+    return nullptr;
+  }
+  return worker;
+}
+
+bool TessBaseAPI::ProcessPagesParallel(const PageReader &read_page, bool set_applybox_page,
+                                       int timeout_millisec, TessResultRenderer *renderer,
+                                       const std::vector<TessBaseAPI *> &workers) {
+  // A page that has been read and waits for a worker.
+  struct PageJob {
+    // Position of the page in the output.
+    int sequence;
+    Pix *pix;
+    int page_index;
+    std::string filename;
+  };
+  // Pages that have been read ahead, at most one per worker.
+  std::deque<PageJob> queue;
+  bool reading_done = false;
+  std::mutex queue_mutex;
+  std::condition_variable queue_cv;
+  // Sequence of the page that goes to the renderer next.
+  int next_to_render = 0;
+  std::mutex render_mutex;
+  std::condition_variable render_cv;
+  // Cleared when a page fails. The remaining pages are not processed.
+  std::atomic<bool> ok{true};
+
+  auto run_worker = [&](TessBaseAPI *worker) {
+    for (;;) {
+      PageJob job;
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_cv.wait(lock, [&] { return !queue.empty() || reading_done; });
+        if (queue.empty()) {
+          return;
+        }
+        job = std::move(queue.front());
+        queue.pop_front();
+      }
+      queue_cv.notify_all();
+      bool r = ok;
+      if (r) {
+        if (set_applybox_page) {
+          auto page_string = std::to_string(job.page_index);
+          worker->SetVariable("applybox_page", page_string.c_str());
+        }
+        r = worker->ProcessPage(job.pix, job.page_index, job.filename.c_str(), nullptr,
+                                timeout_millisec, nullptr);
+      }
+      pixDestroy(&job.pix);
+      // Wait for the previous pages, so the renderer gets them in order. The
+      // results stay in the worker until then.
+      {
+        std::unique_lock<std::mutex> lock(render_mutex);
+        render_cv.wait(lock, [&] { return next_to_render == job.sequence; });
+        if (r && ok && renderer != nullptr) {
+          r = renderer->AddImage(worker);
+        }
+        if (!r) {
+          ok = false;
+        }
+        ++next_to_render;
+      }
+      render_cv.notify_all();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(workers.size());
+  for (auto *worker : workers) {
+    threads.emplace_back(run_worker, worker);
+  }
+
+  // Read the pages on this thread, while the workers recognize the ones
+  // before them. A page that cannot be read ends the reading, but the pages
+  // before it are still processed, as they are when running sequentially.
+  bool read_ok = true;
+  for (int sequence = 0; ok; ++sequence) {
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      queue_cv.wait(lock, [&] { return queue.size() < workers.size() || !ok; });
+    }
+    if (!ok) {
       break;
     }
-    if (!offset) {
+    Pix *pix = nullptr;
+    int page_index = 0;
+    std::string filename;
+    if (!read_page(&pix, &page_index, &filename)) {
+      read_ok = false;
       break;
     }
+    if (pix == nullptr) {
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      queue.push_back({sequence, pix, page_index, std::move(filename)});
+    }
+    queue_cv.notify_all();
   }
-  return true;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    reading_done = true;
+  }
+  queue_cv.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return ok && read_ok;
 }
 
 // Master ProcessPages calls ProcessPagesInternal and then does any post-
@@ -1256,6 +1560,50 @@ bool TessBaseAPI::ProcessPage(Pix *pix, int page_index, const char *filename,
   return !failed;
 }
 
+bool TessBaseAPI::StartPageQueue(int num_workers, int max_pending) {
+  EndPageQueue();
+  if (tesseract_ == nullptr || num_workers < 1) {
+    return false;
+  }
+  std::vector<std::unique_ptr<TessBaseAPI>> workers;
+  for (int t = 0; t < num_workers; ++t) {
+    TessBaseAPI *worker = NewPageWorker();
+    if (worker == nullptr) {
+      tprintf("Error, failed to initialize page queue worker %d\n", t);
+      return false;
+    }
+    workers.emplace_back(worker);
+  }
+  page_queue_ = new PageQueue(std::move(workers), max_pending);
+  return true;
+}
+
+int TessBaseAPI::SubmitPage(Pix *pix, const std::vector<std::string> *vars_vec,
+                            const std::vector<std::string> *vars_values, PageDoneFunc func,
+                            void *user_data) {
+  if (page_queue_ == nullptr || pix == nullptr) {
+    return -1;
+  }
+  return page_queue_->Submit(pix, vars_vec, vars_values, func, user_data);
+}
+
+bool TessBaseAPI::IsPageDone(int job_id) const {
+  return page_queue_ != nullptr && page_queue_->IsDone(job_id);
+}
+
+bool TessBaseAPI::WaitForPage(int job_id, char **text) {
+  if (page_queue_ == nullptr) {
+    *text = nullptr;
+    return false;
+  }
+  return page_queue_->Wait(job_id, text);
+}
+
+void TessBaseAPI::EndPageQueue() {
+  delete page_queue_;
+  page_queue_ = nullptr;
+}
+
 /**
  * Get a left-to-right iterator to the results of LayoutAnalysis and/or
  * Recognize. The returned iterator must be deleted after use.
@@ -1305,10 +1653,21 @@ MutableIterator *TessBaseAPI::GetMutableIterator() {
 
 /** Make a text string from the internal data structures. */
 char *TessBaseAPI::GetUTF8Text() {
-  if (tesseract_ == nullptr || (!recognition_done_ && Recognize(nullptr) < 0)) {
+  std::string text("");
+  if (!WriteUTF8Text([&text](const std::string &para_text) {
+        text += para_text;
+        return true;
+      })) {
     return nullptr;
   }
-  std::string text("");
+  return copy_string(text);
+}
+
+/** Write the text from the internal data structures paragraph by paragraph. */
+bool TessBaseAPI::WriteUTF8Text(const TextWriter &write) {
+  if (tesseract_ == nullptr || (!recognition_done_ && Recognize(nullptr) < 0)) {
+    return false;
+  }
   const std::unique_ptr</*non-const*/ ResultIterator> it(GetIterator());
   do {
     if (it->Empty(RIL_PARA)) {
@@ -1331,9 +1690,11 @@ char *TessBaseAPI::GetUTF8Text() {
     }
 
     const std::unique_ptr<const char[]> para_text(it->GetUTF8Text(RIL_PARA));
-    text += para_text.get();
+    if (!write(para_text.get())) {
+      return false;
+    }
   } while (it->Next(RIL_PARA));
-  return copy_string(text);
+  return true;
 }
 
 static void AddBoxToTSV(const PageIterator *it, PageIteratorLevel level, std::string &text) {
@@ -1351,9 +1712,24 @@ static void AddBoxToTSV(const PageIterator *it, PageIteratorLevel level, std::st
  * Returned string must be freed with the delete [] operator.
  */
 char *TessBaseAPI::GetTSVText(int page_number) {
-  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(nullptr) < 0)) {
+  std::string tsv_str;
+  if (!WriteTSVText(page_number, [&tsv_str](const std::string &row) {
+        tsv_str += row;
+        return true;
+      })) {
     return nullptr;
   }
+  return copy_string(tsv_str);
+}
+
+/**
+ * Write the TSV-formatted text from the internal data structures row by row.
+ * page_number is 0-based but will appear in the output as 1-based.
+ */
+bool TessBaseAPI::WriteTSVText(int page_number, const TextWriter &write) {
+  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(nullptr) < 0)) {
+    return false;
+  }
 
 #if !defined(NDEBUG)
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
@@ -1377,6 +1753,9 @@ char *TessBaseAPI::GetTSVText(int page_number) {
   tsv_str += "\t" + std::to_string(rect_width_);
   tsv_str += "\t" + std::to_string(rect_height_);
   tsv_str += "\t-1\t\n";
+  if (!write(tsv_str)) {
+    return false;
+  }
 
   const std::unique_ptr</*non-const*/ ResultIterator> res_it(GetIterator());
   while (!res_it->Empty(RIL_BLOCK)) {
@@ -1385,6 +1764,9 @@ char *TessBaseAPI::GetTSVText(int page_number) {
       continue;
     }
 
+    // The rows of the word and of any new block/paragraph/textline before it.
+    tsv_str.clear();
+
     // Add rows for any new block/paragraph/textline.
     if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
       block_num++;
@@ -1460,9 +1842,12 @@ char *TessBaseAPI::GetTSVText(int page_number) {
 #if !defined(NDEBUG)
     wcnt++;
 #endif
+    if (!write(tsv_str)) {
+      return false;
+    }
   }
 
-  return copy_string(tsv_str);
+  return true;
 }
 
 /** The 5 numbers output for each box (the usual 4 and a page number.) */
@@ -1859,6 +2244,7 @@ void TessBaseAPI::Clear() {
  * other than Init and anything declared above it in the class definition.
  */
 void TessBaseAPI::End() {
+  EndPageQueue();
   Clear();
   delete thresholder_;
   thresholder_ = nullptr;
@@ -1892,11 +2278,12 @@ void TessBaseAPI::End() {
 
 // Clear any library-level memory caches.
 // There are a variety of expensive-to-load constant data structures (mostly
-// language dictionaries) that are cached globally -- surviving the Init()
-// and End() of individual TessBaseAPI's.  This function allows the clearing
-// of these caches.
+// language dictionaries and LSTM models) that are cached globally -- surviving
+// the Init() and End() of individual TessBaseAPI's.  This function allows the
+// clearing of these caches.
 void TessBaseAPI::ClearPersistentCache() {
   Dict::GlobalDawgCache()->DeleteUnusedDawgs();
+  LSTMRecognizer::GlobalModelCache()->DeleteUnusedObjects();
 }
 
 /**
@@ -2033,7 +2420,10 @@ bool TessBaseAPI::Threshold(Pix **pix) {
       tesseract_->set_pix_grey(thresholder_->GetPixRectGrey());
     } else {
       tesseract_->set_pix_thresholds(nullptr);
-      tesseract_->set_pix_grey(nullptr);
+      // A grey image given with SetBinarizedImage is used as it is.
+      tesseract_->set_pix_grey(thresholder_->HasGreyImage()
+                                   ? thresholder_->GetPixRectGrey()
+                                   : nullptr);
     }
   } else {
     auto [ok, pix_grey, pix_binary, pix_thresholds] = thresholder_->Threshold(this, thresholding_method);
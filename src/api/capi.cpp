@@ -315,6 +315,11 @@ void TessBaseAPISetImage2(TessBaseAPI *handle, struct Pix *pix) {
   return handle->SetImage(pix);
 }
 
+void TessBaseAPISetBinarizedImage(TessBaseAPI *handle, struct Pix *binary,
+                                  struct Pix *grey) {
+  handle->SetBinarizedImage(binary, grey);
+}
+
 void TessBaseAPISetSourceResolution(TessBaseAPI *handle, int ppi) {
   handle->SetSourceResolution(ppi);
 }
@@ -408,6 +413,36 @@ BOOL TessBaseAPIProcessPage(TessBaseAPI *handle, struct Pix *pix, int page_index
       handle->ProcessPage(pix, page_index, filename, retry_config, timeout_millisec, renderer));
 }
 
+BOOL TessBaseAPIStartPageQueue(TessBaseAPI *handle, int num_workers, int max_pending) {
+  return static_cast<int>(handle->StartPageQueue(num_workers, max_pending));
+}
+
+int TessBaseAPISubmitPage(TessBaseAPI *handle, struct Pix *pix, char **vars_vec,
+                          char **vars_values, size_t vars_vec_size, TessPageDoneFunc func,
+                          void *user_data) {
+  std::vector<std::string> varNames;
+  std::vector<std::string> varValues;
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    for (size_t i = 0; i < vars_vec_size; i++) {
+      varNames.emplace_back(vars_vec[i]);
+      varValues.emplace_back(vars_values[i]);
+    }
+  }
+  return handle->SubmitPage(pix, &varNames, &varValues, func, user_data);
+}
+
+BOOL TessBaseAPIIsPageDone(const TessBaseAPI *handle, int job_id) {
+  return static_cast<int>(handle->IsPageDone(job_id));
+}
+
+BOOL TessBaseAPIWaitForPage(TessBaseAPI *handle, int job_id, char **text) {
+  return static_cast<int>(handle->WaitForPage(job_id, text));
+}
+
+void TessBaseAPIEndPageQueue(TessBaseAPI *handle) {
+  handle->EndPageQueue();
+}
+
 TessResultIterator *TessBaseAPIGetIterator(TessBaseAPI *handle) {
   return handle->GetIterator();
 }
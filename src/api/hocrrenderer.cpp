@@ -130,9 +130,25 @@ char *TessBaseAPI::GetHOCRText(int page_number) {
  * Returned string must be freed with the delete [] operator.
  */
 char *TessBaseAPI::GetHOCRText(ETEXT_DESC *monitor, int page_number) {
+  std::string text;
+  if (!WriteHOCRText(monitor, page_number, [&text](const std::string &block) {
+        text += block;
+        return true;
+      })) {
+    return nullptr;
+  }
+  return copy_string(text);
+}
+
+/**
+ * Write the HTML-formatted text with hOCR markup from the internal data
+ * structures block by block.
+ * page_number is 0-based but will appear in the output as 1-based.
+ */
+bool TessBaseAPI::WriteHOCRText(ETEXT_DESC *monitor, int page_number, const TextWriter &write) {
   if (tesseract_ == nullptr ||
       (page_res_ == nullptr && Recognize(monitor) < 0)) {
-    return nullptr;
+    return false;
   }
 
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1, scnt = 1, tcnt = 1, ccnt = 1;
@@ -457,11 +473,16 @@ char *TessBaseAPI::GetHOCRText(ETEXT_DESC *monitor, int page_number) {
     if (last_word_in_block) {
       hocr_str << "   </div>\n";
       bcnt++;
+      // Give the finished block to write, so the page is not kept whole.
+      if (!write(hocr_str.str())) {
+        return false;
+      }
+      hocr_str.str("");
     }
   }
   hocr_str << "  </div>\n";
 
-  return copy_string(hocr_str.str());
+  return write(hocr_str.str());
 }
 
 /**********************************************************************
@@ -511,14 +532,10 @@ bool TessHOcrRenderer::EndDocumentHandler() {
 }
 
 bool TessHOcrRenderer::AddImageHandler(TessBaseAPI *api) {
-  const std::unique_ptr<const char[]> hocr(api->GetHOCRText(imagenum()));
-  if (hocr == nullptr) {
-    return false;
-  }
-
-  AppendString(hocr.get());
-
-  return true;
+  return api->WriteHOCRText(nullptr, imagenum(), [this](const std::string &hocr) {
+    AppendData(hocr);
+    return happy();
+  });
 }
 
 } // namespace tesseract
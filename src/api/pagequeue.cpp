@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagequeue.cpp
+// Description: Queue of pages recognized in the background for TessBaseAPI.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagequeue.h"
+
+#include <allheaders.h> // for pixClone, pixDestroy
+
+#include <algorithm> // for std::max
+
+namespace tesseract {
+
+PageQueue::PageQueue(std::vector<std::unique_ptr<TessBaseAPI>> workers, int max_pending)
+    : workers_(std::move(workers)), max_pending_(std::max(1, max_pending)) {
+  threads_.reserve(workers_.size());
+  for (auto &worker : workers_) {
+    threads_.emplace_back(&PageQueue::WorkerLoop, this, worker.get());
+  }
+}
+
+PageQueue::~PageQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  // The workers only stop when the queue is empty.
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  for (auto &result : results_) {
+    delete[] result.second.text;
+  }
+}
+
+int PageQueue::Submit(Pix *pix, const std::vector<std::string> *vars_vec,
+                      const std::vector<std::string> *vars_values, PageDoneFunc func,
+                      void *user_data) {
+  Job job;
+  job.pix = pixClone(pix);
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    job.names = *vars_vec;
+    job.values = *vars_values;
+    job.values.resize(job.names.size());
+  }
+  job.func = func;
+  job.user_data = user_data;
+  int job_id;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_cv_.wait(lock, [this] { return queue_.size() < max_pending_; });
+    job_id = next_id_++;
+    job.id = job_id;
+    if (func == nullptr) {
+      results_[job_id] = Result();
+    }
+    queue_.push_back(std::move(job));
+  }
+  queue_cv_.notify_one();
+  return job_id;
+}
+
+bool PageQueue::IsDone(int job_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = results_.find(job_id);
+  return it != results_.end() && it->second.done;
+}
+
+bool PageQueue::Wait(int job_id, char **text) {
+  *text = nullptr;
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The map may be rehashed by Submit, or the entry collected by another
+  // Wait, while the lock is released, so look the job up again each time.
+  done_cv_.wait(lock, [this, job_id] {
+    auto it = results_.find(job_id);
+    return it == results_.end() || it->second.done;
+  });
+  auto it = results_.find(job_id);
+  if (it == results_.end()) {
+    return false;
+  }
+  bool success = it->second.success;
+  *text = it->second.text;
+  results_.erase(it);
+  return success;
+}
+
+void PageQueue::WorkerLoop(TessBaseAPI *worker) {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_cv_.wait(lock, [this] { return !queue_.empty() || stop_; });
+      if (queue_.empty()) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    space_cv_.notify_one();
+    RunJob(worker, &job);
+  }
+}
+
+void PageQueue::RunJob(TessBaseAPI *worker, Job *job) {
+  // Set the variables of the page, remembering the values to restore.
+  std::vector<std::string> old_values(job->names.size());
+  std::vector<bool> was_set(job->names.size());
+  for (size_t i = 0; i < job->names.size(); ++i) {
+    const char *name = job->names[i].c_str();
+    was_set[i] = worker->GetVariableAsString(name, &old_values[i]) &&
+                 worker->SetVariable(name, job->values[i].c_str());
+  }
+
+  bool success = worker->ProcessPage(job->pix, job->id, nullptr, nullptr, 0, nullptr);
+  pixDestroy(&job->pix);
+  if (job->func != nullptr) {
+    job->func(job->id, success, worker, job->user_data);
+  } else {
+    char *text = success ? worker->GetUTF8Text() : nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto &result = results_[job->id];
+      result.done = true;
+      result.success = success && text != nullptr;
+      result.text = text;
+    }
+    done_cv_.notify_all();
+  }
+
+  for (size_t i = job->names.size(); i-- > 0;) {
+    if (was_set[i]) {
+      worker->SetVariable(job->names[i].c_str(), old_values[i].c_str());
+    }
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagequeue.h
+// Description: Queue of pages recognized in the background for TessBaseAPI.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PAGEQUEUE_H_
+#define TESSERACT_API_PAGEQUEUE_H_
+
+#include <tesseract/baseapi.h> // for TessBaseAPI, PageDoneFunc
+
+#include <condition_variable> // for std::condition_variable
+#include <deque>              // for std::deque
+#include <memory>             // for std::unique_ptr
+#include <mutex>              // for std::mutex
+#include <string>             // for std::string
+#include <thread>             // for std::thread
+#include <unordered_map>      // for std::unordered_map
+#include <vector>             // for std::vector
+
+struct Pix;
+
+namespace tesseract {
+
+// Recognizes the pages given to Submit on a fixed set of worker threads, each
+// with its own TessBaseAPI, and hands the results to a callback or keeps
+// their text until it is collected with Wait.
+// The pages that wait for a worker are limited, and Submit blocks while the
+// limit is reached, so a fast producer cannot queue unbounded images.
+class PageQueue {
+public:
+  // Takes the workers, which must be initialized, and starts a thread for
+  // each of them. At most max_pending pages wait for a worker.
+  PageQueue(std::vector<std::unique_ptr<TessBaseAPI>> workers, int max_pending);
+  // Waits until all submitted pages are done, and stops the threads.
+  ~PageQueue();
+
+  PageQueue(const PageQueue &) = delete;
+  PageQueue &operator=(const PageQueue &) = delete;
+
+  // Queues a clone of pix, and returns the id of its job. Blocks while
+  // max_pending pages are waiting. See TessBaseAPI::SubmitPage.
+  int Submit(Pix *pix, const std::vector<std::string> *vars_vec,
+             const std::vector<std::string> *vars_values, PageDoneFunc func, void *user_data);
+  // Returns true if the job, which has no callback, is done.
+  bool IsDone(int job_id) const;
+  // Waits until the job, which has no callback, is done and forgets it.
+  // Returns false if the job is unknown or was collected by another Wait.
+  // See TessBaseAPI::WaitForPage.
+  bool Wait(int job_id, char **text);
+
+private:
+  // A page that waits for a worker.
+  struct Job {
+    int id;
+    Pix *pix;
+    // Variables that are set on the worker for this page only.
+    std::vector<std::string> names;
+    std::vector<std::string> values;
+    PageDoneFunc func;
+    void *user_data;
+  };
+  // The outcome of a job without a callback.
+  struct Result {
+    bool done = false;
+    bool success = false;
+    // UTF-8 text of the page, owned until it is collected by Wait.
+    char *text = nullptr;
+  };
+
+  // Main loop of the thread that runs the given worker.
+  void WorkerLoop(TessBaseAPI *worker);
+  // Recognizes the page of the job with the given worker.
+  void RunJob(TessBaseAPI *worker, Job *job);
+
+  std::vector<std::unique_ptr<TessBaseAPI>> workers_;
+  std::vector<std::thread> threads_;
+  size_t max_pending_;
+  // Guards all the members below.
+  mutable std::mutex mutex_;
+  // Signals the workers that a job was queued, or that they must stop.
+  std::condition_variable queue_cv_;
+  // Signals Submit that a job was taken from the queue.
+  std::condition_variable space_cv_;
+  // Signals Wait that a job is done.
+  std::condition_variable done_cv_;
+  std::deque<Job> queue_;
+  // Jobs without a callback, by id, until they are collected by Wait.
+  std::unordered_map<int, Result> results_;
+  int next_id_ = 0;
+  bool stop_ = false;
+};
+
+} // namespace tesseract
+
+#endif // TESSERACT_API_PAGEQUEUE_H_
@@ -672,14 +672,10 @@ bool TessPAGERenderer::AddImageHandler(TessBaseAPI *api) {
     begin_document = false;
   }
 
-  const std::unique_ptr<const char[]> text(api->GetPAGEText(imagenum()));
-  if (text == nullptr) {
-    return false;
-  }
-
-  AppendString(text.get());
-
-  return true;
+  return api->WritePAGEText(nullptr, imagenum(), [this](const std::string &text) {
+    AppendData(text);
+    return happy();
+  });
 }
 
 ///
@@ -705,10 +701,27 @@ char *TessBaseAPI::GetPAGEText(int page_number) {
 /// Make an XML-formatted string with PAGE markup from the internal
 /// data structures.
 ///
-char *TessBaseAPI::GetPAGEText(ETEXT_DESC *monitor, int /*page_number*/) {
+char *TessBaseAPI::GetPAGEText(ETEXT_DESC *monitor, int page_number) {
+  char *result = nullptr;
+  // WritePAGEText gives the whole page at once.
+  if (!WritePAGEText(monitor, page_number, [&result](const std::string &text) {
+        result = copy_string(text);
+        return true;
+      })) {
+    return nullptr;
+  }
+  return result;
+}
+
+///
+/// Write the XML-formatted text with PAGE markup from the internal
+/// data structures.
+///
+bool TessBaseAPI::WritePAGEText(ETEXT_DESC *monitor, int /*page_number*/,
+                                const TextWriter &write) {
   if (tesseract_ == nullptr ||
       (page_res_ == nullptr && Recognize(monitor) < 0)) {
-    return nullptr;
+    return false;
   }
 
   int rcnt = 0, lcnt = 0, wcnt = 0;
@@ -1133,7 +1146,7 @@ char *TessBaseAPI::GetPAGEText(ETEXT_DESC *monitor, int /*page_number*/) {
   const std::string &text = reading_order_str.str();
   reading_order_str.str("");
 
-  return copy_string(text);
+  return write(text);
 }
 
 } // namespace tesseract
@@ -22,7 +22,7 @@
 
 #include "pdf_ttf.h"
 #include "tprintf.h"
-#include "helpers.h" // for Swap, copy_string
+#include "helpers.h" // for Swap
 #include "image.h"   // for Leptonica (lept_free, ...)
 
 #include <tesseract/baseapi.h>
@@ -328,7 +328,7 @@ static bool CodepointToUtf16be(int code, char utf16[kMaxBytesPerCodepoint]) {
   return true;
 }
 
-char *TessPDFRenderer::GetPDFTextObjects(TessBaseAPI *api, double width, double height) {
+std::string TessPDFRenderer::GetPDFTextObjects(TessBaseAPI *api, double width, double height) {
   double ppi = api->GetSourceYResolution();
 
   // These initial conditions are all arbitrary and will be overwritten
@@ -497,7 +497,7 @@ char *TessPDFRenderer::GetPDFTextObjects(TessBaseAPI *api, double width, double
       pdf_str << "ET\n"; // end the text object
     }
   }
-  return copy_string(pdf_str.str());
+  return pdf_str.str();
 }
 
 bool TessPDFRenderer::BeginDocumentHandler() {
@@ -870,11 +870,11 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI *api) {
   AppendPDFObject(stream.str().c_str());
 
   // CONTENTS
-  const std::unique_ptr<char[]> pdftext(GetPDFTextObjects(api, width, height));
-  const size_t pdftext_len = strlen(pdftext.get());
+  std::string pdftext = GetPDFTextObjects(api, width, height);
+  const size_t pdftext_len = pdftext.size();
   size_t len = pdftext_len;
 #ifndef NO_PDF_COMPRESSION
-  auto comp_pdftext = zlibCompress(reinterpret_cast<unsigned char *>(pdftext.get()), pdftext_len, &len);
+  auto comp_pdftext = zlibCompress(reinterpret_cast<unsigned char *>(pdftext.data()), pdftext_len, &len);
 #endif
   stream.str("");
   stream << obj_
@@ -895,7 +895,7 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI *api) {
 #ifndef NO_PDF_COMPRESSION
   AppendData(reinterpret_cast<char *>(comp_pdftext), len);
 #else
-  AppendData(reinterpret_cast<char *>(pdftext.get()), len);
+  AppendData(pdftext.data(), len);
 #endif
   objsize += len;
 #ifndef NO_PDF_COMPRESSION
@@ -27,12 +27,23 @@
 
 namespace tesseract {
 
+// Size of the output that a renderer buffers before it writes it.
+const size_t kOutputBufferSize = 64 * 1024;
+
+TessOutputSink::~TessOutputSink() = default;
+
+bool TessStringSink::Write(const char *data, size_t size) {
+  output_->append(data, size);
+  return true;
+}
+
 /**********************************************************************
  * Base Renderer interface implementation
  **********************************************************************/
 TessResultRenderer::TessResultRenderer(const char *outputbase, const char *extension)
     : next_(nullptr)
     , fout_(stdout)
+    , sink_(nullptr)
     , file_extension_(extension)
     , title_("")
     , imagenum_(-1)
@@ -47,6 +58,7 @@ TessResultRenderer::TessResultRenderer(const char *outputbase, const char *exten
 }
 
 TessResultRenderer::~TessResultRenderer() {
+  FlushOutput();
   if (fout_ != nullptr) {
     if (fout_ != stdout) {
       fclose(fout_);
@@ -79,6 +91,7 @@ bool TessResultRenderer::BeginDocument(const char *title) {
   title_ = title;
   imagenum_ = -1;
   bool ok = BeginDocumentHandler();
+  FlushOutput();
   if (next_) {
     ok = next_->BeginDocument(title) && ok;
   }
@@ -91,6 +104,7 @@ bool TessResultRenderer::AddImage(TessBaseAPI *api) {
   }
   ++imagenum_;
   bool ok = AddImageHandler(api);
+  FlushOutput();
   if (next_) {
     ok = next_->AddImage(api) && ok;
   }
@@ -102,6 +116,7 @@ bool TessResultRenderer::EndDocument() {
     return false;
   }
   bool ok = EndDocumentHandler();
+  FlushOutput();
   if (next_) {
     ok = next_->EndDocument() && ok;
   }
@@ -116,10 +131,36 @@ void TessResultRenderer::AppendString(const char *s) {
 }
 
 void TessResultRenderer::AppendData(const char *s, int len) {
-  if (!tesseract::Serialize(fout_, s, len)) {
-    happy_ = false;
+  if (buffer_.size() + len > kOutputBufferSize) {
+    FlushOutput();
+    if (static_cast<size_t>(len) >= kOutputBufferSize) {
+      // Write large data directly instead of copying it into the buffer.
+      WriteOutput(s, len);
+      return;
+    }
+  }
+  buffer_.append(s, len);
+}
+
+void TessResultRenderer::FlushOutput() {
+  if (buffer_.empty()) {
+    return;
+  }
+  WriteOutput(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+void TessResultRenderer::WriteOutput(const char *data, size_t size) {
+  if (sink_ != nullptr) {
+    if (!sink_->Write(data, size)) {
+      happy_ = false;
+    }
+  } else if (fout_ != nullptr) {
+    if (!tesseract::Serialize(fout_, data, size)) {
+      happy_ = false;
+    }
+    fflush(fout_);
   }
-  fflush(fout_);
 }
 
 bool TessResultRenderer::BeginDocumentHandler() {
@@ -137,17 +178,28 @@ TessTextRenderer::TessTextRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "txt") {}
 
 bool TessTextRenderer::AddImageHandler(TessBaseAPI *api) {
-  const std::unique_ptr<const char[]> utf8(api->GetUTF8Text());
-  if (utf8 == nullptr) {
+  // The page separator goes before the text, but only if the page could be
+  // recognized.
+  bool separated = false;
+  auto separate = [&]() {
+    if (!separated) {
+      const char *pageSeparator = api->GetStringVariable("page_separator");
+      if (pageSeparator != nullptr && *pageSeparator != '\0' && imagenum() > 0) {
+        AppendString(pageSeparator);
+      }
+      separated = true;
+    }
+  };
+
+  // Write the text a paragraph at a time instead of the whole page.
+  if (!api->WriteUTF8Text([&](const std::string &text) {
+        separate();
+        AppendString(text.c_str());
+        return happy();
+      })) {
     return false;
   }
-
-  const char *pageSeparator = api->GetStringVariable("page_separator");
-  if (pageSeparator != nullptr && *pageSeparator != '\0' && imagenum() > 0) {
-    AppendString(pageSeparator);
-  }
-
-  AppendString(utf8.get());
+  separate();
 
   return true;
 }
@@ -177,14 +229,11 @@ bool TessTsvRenderer::EndDocumentHandler() {
 }
 
 bool TessTsvRenderer::AddImageHandler(TessBaseAPI *api) {
-  const std::unique_ptr<const char[]> tsv(api->GetTSVText(imagenum()));
-  if (tsv == nullptr) {
-    return false;
-  }
-
-  AppendString(tsv.get());
-
-  return true;
+  // Write the rows one at a time instead of the whole page.
+  return api->WriteTSVText(imagenum(), [this](const std::string &rows) {
+    AppendString(rows.c_str());
+    return happy();
+  });
 }
 
 /**********************************************************************
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activation.h
+// Description: LSTM activation functions and their lookup tables.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_ACTIVATION_H_
+#define TESSERACT_ARCH_ACTIVATION_H_
+
+#include "tesstypes.h"
+
+namespace tesseract {
+
+// Size of static tables.
+constexpr int kTableSize = 4096;
+// Scale factor for float arg to int index.
+constexpr TFloat kScaleFactor = 256.0;
+
+// Generated lookup tables.
+extern const TFloat TanhTable[];
+extern const TFloat LogisticTable[];
+
+// Non-linearity (sigmoid) functions with cache tables and clipping.
+inline TFloat Tanh(TFloat x) {
+  if (x < 0) {
+    return -Tanh(-x);
+  }
+  x *= kScaleFactor;
+  auto index = static_cast<unsigned>(x);
+  if (index >= (kTableSize - 1)) {
+    return 1;
+  }
+  TFloat tanh_i0 = TanhTable[index];
+  TFloat tanh_i1 = TanhTable[index + 1];
+  // Linear interpolation.
+  return tanh_i0 + (tanh_i1 - tanh_i0) * (x - index);
+}
+
+inline TFloat Logistic(TFloat x) {
+  if (x < 0) {
+    return 1 - Logistic(-x);
+  }
+  x *= kScaleFactor;
+  auto index = static_cast<unsigned>(x);
+  if (index >= (kTableSize - 1)) {
+    return 1;
+  }
+  TFloat l0 = LogisticTable[index];
+  TFloat l1 = LogisticTable[index + 1];
+  // Linear interpolation.
+  return l0 + (l1 - l0) * (x - index);
+}
+
+// Vectorized versions of the functions selected by SIMDDetect for the
+// TanhInPlace, LogisticInPlace and LSTMStateUpdate function pointers.
+// See simddetect.h for a description of the arguments.
+
+// Uses Intel SSE 4.1 intrinsics.
+void TanhInPlaceSSE(int n, TFloat *inout);
+void LogisticInPlaceSSE(int n, TFloat *inout);
+void LSTMStateUpdateSSE(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                        const TFloat *go, TFloat clip, TFloat *state, TFloat *output);
+
+// Uses Intel AVX2 intrinsics.
+void TanhInPlaceAVX2(int n, TFloat *inout);
+void LogisticInPlaceAVX2(int n, TFloat *inout);
+void LSTMStateUpdateAVX2(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                         const TFloat *go, TFloat clip, TFloat *state, TFloat *output);
+
+// Uses Intel AVX512F intrinsics.
+void TanhInPlaceAVX512F(int n, TFloat *inout);
+void LogisticInPlaceAVX512F(int n, TFloat *inout);
+void LSTMStateUpdateAVX512F(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                            const TFloat *go, TFloat clip, TFloat *state, TFloat *output);
+
+// Uses NEON intrinsics. Only available on 64 bit ARM.
+void TanhInPlaceNEON(int n, TFloat *inout);
+void LogisticInPlaceNEON(int n, TFloat *inout);
+void LSTMStateUpdateNEON(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                         const TFloat *go, TFloat clip, TFloat *state, TFloat *output);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_ACTIVATION_H_
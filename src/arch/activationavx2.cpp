@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationavx2.cpp
+// Description: LSTM activation functions for Intel AVX2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "activation.h"
+#  include "activationsimd.h"
+
+namespace tesseract {
+
+namespace {
+
+#  if defined(FAST_FLOAT)
+struct AVX2Ops {
+  using Vec = __m256;
+  static constexpr int kLanes = 8;
+  static Vec Load(const float *p) {
+    return _mm256_loadu_ps(p);
+  }
+  static void Store(float *p, Vec v) {
+    _mm256_storeu_ps(p, v);
+  }
+  static Vec Set1(float x) {
+    return _mm256_set1_ps(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm256_add_ps(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm256_min_ps(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm256_max_ps(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+  }
+  static Vec Negate(Vec a) {
+    return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a);
+  }
+  static Vec LessThan(Vec a, Vec b) {
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+  }
+  static Vec GreaterEqual(Vec a, Vec b) {
+    return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+  }
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return _mm256_blendv_ps(b, a, mask);
+  }
+  static Vec Interpolate(const float *table, Vec x) {
+    __m256i index = _mm256_cvttps_epi32(x);
+    __m256 t0 = _mm256_i32gather_ps(table, index, sizeof(float));
+    __m256 t1 = _mm256_i32gather_ps(table + 1, index, sizeof(float));
+    __m256 fraction = _mm256_sub_ps(x, _mm256_cvtepi32_ps(index));
+    return _mm256_add_ps(t0, _mm256_mul_ps(_mm256_sub_ps(t1, t0), fraction));
+  }
+};
+#  else
+struct AVX2Ops {
+  using Vec = __m256d;
+  static constexpr int kLanes = 4;
+  static Vec Load(const double *p) {
+    return _mm256_loadu_pd(p);
+  }
+  static void Store(double *p, Vec v) {
+    _mm256_storeu_pd(p, v);
+  }
+  static Vec Set1(double x) {
+    return _mm256_set1_pd(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm256_add_pd(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_pd(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_pd(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm256_min_pd(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm256_max_pd(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+  }
+  static Vec Negate(Vec a) {
+    return _mm256_xor_pd(_mm256_set1_pd(-0.0), a);
+  }
+  static Vec LessThan(Vec a, Vec b) {
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+  }
+  static Vec GreaterEqual(Vec a, Vec b) {
+    return _mm256_cmp_pd(a, b, _CMP_GE_OQ);
+  }
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return _mm256_blendv_pd(b, a, mask);
+  }
+  static Vec Interpolate(const double *table, Vec x) {
+    __m128i index = _mm256_cvttpd_epi32(x);
+    __m256d t0 = _mm256_i32gather_pd(table, index, sizeof(double));
+    __m256d t1 = _mm256_i32gather_pd(table + 1, index, sizeof(double));
+    __m256d fraction = _mm256_sub_pd(x, _mm256_cvtepi32_pd(index));
+    return _mm256_add_pd(t0, _mm256_mul_pd(_mm256_sub_pd(t1, t0), fraction));
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhInPlaceAVX2(int n, TFloat *inout) {
+  TanhInPlaceSIMD<AVX2Ops>(n, inout);
+}
+
+void LogisticInPlaceAVX2(int n, TFloat *inout) {
+  LogisticInPlaceSIMD<AVX2Ops>(n, inout);
+}
+
+void LSTMStateUpdateAVX2(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                         const TFloat *go, TFloat clip, TFloat *state, TFloat *output) {
+  LSTMStateUpdateSIMD<AVX2Ops>(n, ci, gi, gf, go, clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
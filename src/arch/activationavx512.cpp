@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationavx512.cpp
+// Description: LSTM activation functions for Intel AVX512F.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX512F capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "activation.h"
+#  include "activationsimd.h"
+
+namespace tesseract {
+
+namespace {
+
+// AVX512F includes fused multiply-add, so this file must be compiled with
+// -ffp-contract=off to get the same results as the scalar functions.
+// The sign bit is flipped with integer instructions, because the floating
+// point xor needs AVX512DQ.
+#  if defined(FAST_FLOAT)
+struct AVX512FOps {
+  using Vec = __m512;
+  static constexpr int kLanes = 16;
+  static Vec Load(const float *p) {
+    return _mm512_loadu_ps(p);
+  }
+  static void Store(float *p, Vec v) {
+    _mm512_storeu_ps(p, v);
+  }
+  static Vec Set1(float x) {
+    return _mm512_set1_ps(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm512_add_ps(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_ps(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_ps(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm512_min_ps(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm512_max_ps(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm512_abs_ps(a);
+  }
+  static Vec Negate(Vec a) {
+    __m512i sign = _mm512_set1_epi32(static_cast<int>(0x80000000));
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), sign));
+  }
+  static __mmask16 LessThan(Vec a, Vec b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+  }
+  static __mmask16 GreaterEqual(Vec a, Vec b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ);
+  }
+  static Vec Select(__mmask16 mask, Vec a, Vec b) {
+    return _mm512_mask_blend_ps(mask, b, a);
+  }
+  static Vec Interpolate(const float *table, Vec x) {
+    __m512i index = _mm512_cvttps_epi32(x);
+    __m512 t0 = _mm512_i32gather_ps(index, table, sizeof(float));
+    __m512 t1 = _mm512_i32gather_ps(index, table + 1, sizeof(float));
+    Vec fraction = Sub(x, _mm512_cvtepi32_ps(index));
+    return Add(t0, Mul(Sub(t1, t0), fraction));
+  }
+};
+#  else
+struct AVX512FOps {
+  using Vec = __m512d;
+  static constexpr int kLanes = 8;
+  static Vec Load(const double *p) {
+    return _mm512_loadu_pd(p);
+  }
+  static void Store(double *p, Vec v) {
+    _mm512_storeu_pd(p, v);
+  }
+  static Vec Set1(double x) {
+    return _mm512_set1_pd(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm512_add_pd(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_pd(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_pd(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm512_min_pd(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm512_max_pd(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm512_abs_pd(a);
+  }
+  static Vec Negate(Vec a) {
+    __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+    return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), sign));
+  }
+  static __mmask8 LessThan(Vec a, Vec b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+  }
+  static __mmask8 GreaterEqual(Vec a, Vec b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ);
+  }
+  static Vec Select(__mmask8 mask, Vec a, Vec b) {
+    return _mm512_mask_blend_pd(mask, b, a);
+  }
+  static Vec Interpolate(const double *table, Vec x) {
+    __m256i index = _mm512_cvttpd_epi32(x);
+    __m512d t0 = _mm512_i32gather_pd(index, table, sizeof(double));
+    __m512d t1 = _mm512_i32gather_pd(index, table + 1, sizeof(double));
+    Vec fraction = Sub(x, _mm512_cvtepi32_pd(index));
+    return Add(t0, Mul(Sub(t1, t0), fraction));
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhInPlaceAVX512F(int n, TFloat *inout) {
+  TanhInPlaceSIMD<AVX512FOps>(n, inout);
+}
+
+void LogisticInPlaceAVX512F(int n, TFloat *inout) {
+  LogisticInPlaceSIMD<AVX512FOps>(n, inout);
+}
+
+void LSTMStateUpdateAVX512F(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                            const TFloat *go, TFloat clip, TFloat *state, TFloat *output) {
+  LSTMStateUpdateSIMD<AVX512FOps>(n, ci, gi, gf, go, clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationneon.cpp
+// Description: LSTM activation functions for ARM NEON.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+#include "activation.h"
+#include "activationsimd.h"
+
+namespace tesseract {
+
+// Documentation:
+// https://developer.arm.com/architectures/instruction-sets/intrinsics/
+
+// Only 64 bit ARM has the double precision vectors and the conversions which
+// are needed here.
+#if defined(__ARM_ARCH_ISA_A64)
+
+namespace {
+
+#if defined(FAST_FLOAT)
+struct NEONOps {
+  using Vec = float32x4_t;
+  static constexpr int kLanes = 4;
+  static Vec Load(const float *p) {
+    return vld1q_f32(p);
+  }
+  static void Store(float *p, Vec v) {
+    vst1q_f32(p, v);
+  }
+  static Vec Set1(float x) {
+    return vdupq_n_f32(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return vaddq_f32(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return vsubq_f32(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return vmulq_f32(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return vminq_f32(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return vmaxq_f32(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return vabsq_f32(a);
+  }
+  static Vec Negate(Vec a) {
+    return vnegq_f32(a);
+  }
+  static uint32x4_t LessThan(Vec a, Vec b) {
+    return vcltq_f32(a, b);
+  }
+  static uint32x4_t GreaterEqual(Vec a, Vec b) {
+    return vcgeq_f32(a, b);
+  }
+  static Vec Select(uint32x4_t mask, Vec a, Vec b) {
+    return vbslq_f32(mask, a, b);
+  }
+  static Vec Interpolate(const float *table, Vec x) {
+    uint32x4_t index = vcvtq_u32_f32(x);
+    float t0[kLanes], t1[kLanes];
+    t0[0] = table[vgetq_lane_u32(index, 0)];
+    t0[1] = table[vgetq_lane_u32(index, 1)];
+    t0[2] = table[vgetq_lane_u32(index, 2)];
+    t0[3] = table[vgetq_lane_u32(index, 3)];
+    t1[0] = table[vgetq_lane_u32(index, 0) + 1];
+    t1[1] = table[vgetq_lane_u32(index, 1) + 1];
+    t1[2] = table[vgetq_lane_u32(index, 2) + 1];
+    t1[3] = table[vgetq_lane_u32(index, 3) + 1];
+    float32x4_t low = vld1q_f32(t0);
+    float32x4_t fraction = vsubq_f32(x, vcvtq_f32_u32(index));
+    return vaddq_f32(low, vmulq_f32(vsubq_f32(vld1q_f32(t1), low), fraction));
+  }
+};
+#else
+struct NEONOps {
+  using Vec = float64x2_t;
+  static constexpr int kLanes = 2;
+  static Vec Load(const double *p) {
+    return vld1q_f64(p);
+  }
+  static void Store(double *p, Vec v) {
+    vst1q_f64(p, v);
+  }
+  static Vec Set1(double x) {
+    return vdupq_n_f64(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return vaddq_f64(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return vsubq_f64(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return vmulq_f64(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return vminq_f64(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return vmaxq_f64(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return vabsq_f64(a);
+  }
+  static Vec Negate(Vec a) {
+    return vnegq_f64(a);
+  }
+  static uint64x2_t LessThan(Vec a, Vec b) {
+    return vcltq_f64(a, b);
+  }
+  static uint64x2_t GreaterEqual(Vec a, Vec b) {
+    return vcgeq_f64(a, b);
+  }
+  static Vec Select(uint64x2_t mask, Vec a, Vec b) {
+    return vbslq_f64(mask, a, b);
+  }
+  static Vec Interpolate(const double *table, Vec x) {
+    uint64x2_t index = vcvtq_u64_f64(x);
+    double t0[kLanes], t1[kLanes];
+    t0[0] = table[vgetq_lane_u64(index, 0)];
+    t0[1] = table[vgetq_lane_u64(index, 1)];
+    t1[0] = table[vgetq_lane_u64(index, 0) + 1];
+    t1[1] = table[vgetq_lane_u64(index, 1) + 1];
+    float64x2_t low = vld1q_f64(t0);
+    float64x2_t fraction = vsubq_f64(x, vcvtq_f64_u64(index));
+    return vaddq_f64(low, vmulq_f64(vsubq_f64(vld1q_f64(t1), low), fraction));
+  }
+};
+#endif
+
+} // namespace
+
+void TanhInPlaceNEON(int n, TFloat *inout) {
+  TanhInPlaceSIMD<NEONOps>(n, inout);
+}
+
+void LogisticInPlaceNEON(int n, TFloat *inout) {
+  LogisticInPlaceSIMD<NEONOps>(n, inout);
+}
+
+void LSTMStateUpdateNEON(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                         const TFloat *go, TFloat clip, TFloat *state, TFloat *output) {
+  LSTMStateUpdateSIMD<NEONOps>(n, ci, gi, gf, go, clip, state, output);
+}
+
+#endif
+
+} // namespace tesseract.
+
+#endif /* __ARM_NEON */
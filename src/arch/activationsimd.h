@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationsimd.h
+// Description: Generic SIMD code for the LSTM activation functions.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_ACTIVATIONSIMD_H_
+#define TESSERACT_ARCH_ACTIVATIONSIMD_H_
+
+#include "activation.h" // for Tanh, Logistic, TanhTable, LogisticTable
+#include "helpers.h"    // for ClipToRange
+
+namespace tesseract {
+
+// The activation functions over vectors, written once for all the SIMD
+// instruction sets. Only to be included by the architecture-specific source
+// files, which provide the operations on the registers as an Ops class:
+//   Vec: type of a register of TFloat values.
+//   kLanes: number of TFloat values in a Vec.
+//   Load, Store, Set1: unaligned load, store and broadcast.
+//   Add, Sub, Mul, Min, Max: element-wise arithmetic.
+//   Abs, Negate: clear or flip the sign bit.
+//   LessThan, GreaterEqual: element-wise comparisons.
+//   Select(mask, a, b): a where mask is set, otherwise b.
+//   Interpolate(table, x): the linear interpolation of table at the
+//     non-negative, scaled arguments x < kTableSize - 1.
+// The arithmetic is done in exactly the same order as in the scalar Tanh and
+// Logistic, so the results are the same as those of the lookup tables.
+
+// Returns the table function of the non-negative arguments abs_x, which is 1
+// beyond the end of the table.
+template <class Ops>
+inline typename Ops::Vec TableFunction(const TFloat *table, typename Ops::Vec abs_x) {
+  auto x = Ops::Mul(abs_x, Ops::Set1(kScaleFactor));
+  auto beyond_table = Ops::GreaterEqual(x, Ops::Set1(kTableSize - 1));
+  // Keep the index in range for the lanes that are replaced by 1.
+  auto result = Ops::Interpolate(table, Ops::Select(beyond_table, Ops::Set1(0), x));
+  return Ops::Select(beyond_table, Ops::Set1(1), result);
+}
+
+template <class Ops>
+inline typename Ops::Vec TanhVec(typename Ops::Vec x) {
+  auto negative = Ops::LessThan(x, Ops::Set1(0));
+  auto result = TableFunction<Ops>(TanhTable, Ops::Abs(x));
+  return Ops::Select(negative, Ops::Negate(result), result);
+}
+
+template <class Ops>
+inline typename Ops::Vec LogisticVec(typename Ops::Vec x) {
+  auto negative = Ops::LessThan(x, Ops::Set1(0));
+  auto result = TableFunction<Ops>(LogisticTable, Ops::Abs(x));
+  return Ops::Select(negative, Ops::Sub(Ops::Set1(1), result), result);
+}
+
+template <class Ops>
+inline void TanhInPlaceSIMD(int n, TFloat *inout) {
+  int i = 0;
+  for (; i + Ops::kLanes <= n; i += Ops::kLanes) {
+    Ops::Store(inout + i, TanhVec<Ops>(Ops::Load(inout + i)));
+  }
+  for (; i < n; ++i) {
+    inout[i] = Tanh(inout[i]);
+  }
+}
+
+template <class Ops>
+inline void LogisticInPlaceSIMD(int n, TFloat *inout) {
+  int i = 0;
+  for (; i + Ops::kLanes <= n; i += Ops::kLanes) {
+    Ops::Store(inout + i, LogisticVec<Ops>(Ops::Load(inout + i)));
+  }
+  for (; i < n; ++i) {
+    inout[i] = Logistic(inout[i]);
+  }
+}
+
+template <class Ops>
+inline void LSTMStateUpdateSIMD(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                                const TFloat *go, TFloat clip, TFloat *state, TFloat *output) {
+  auto lower = Ops::Set1(-clip);
+  auto upper = Ops::Set1(clip);
+  int i = 0;
+  for (; i + Ops::kLanes <= n; i += Ops::kLanes) {
+    auto new_state = Ops::Mul(Ops::Load(state + i), LogisticVec<Ops>(Ops::Load(gf + i)));
+    auto cell_input = TanhVec<Ops>(Ops::Load(ci + i));
+    new_state = Ops::Add(new_state, Ops::Mul(cell_input, LogisticVec<Ops>(Ops::Load(gi + i))));
+    new_state = Ops::Min(Ops::Max(new_state, lower), upper);
+    Ops::Store(state + i, new_state);
+    Ops::Store(output + i, Ops::Mul(TanhVec<Ops>(new_state), LogisticVec<Ops>(Ops::Load(go + i))));
+  }
+  for (; i < n; ++i) {
+    TFloat new_state = state[i] * Logistic(gf[i]);
+    new_state += Tanh(ci[i]) * Logistic(gi[i]);
+    new_state = ClipToRange(new_state, -clip, clip);
+    state[i] = new_state;
+    output[i] = Tanh(new_state) * Logistic(go[i]);
+  }
+}
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_ACTIVATIONSIMD_H_
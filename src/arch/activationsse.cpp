@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationsse.cpp
+// Description: LSTM activation functions for Intel SSE 4.1.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for SSE 4.1 capable architectures
+#  endif
+#else
+
+#  include <emmintrin.h>
+#  include <smmintrin.h>
+#  include "activation.h"
+#  include "activationsimd.h"
+
+namespace tesseract {
+
+namespace {
+
+#  if defined(FAST_FLOAT)
+struct SSEOps {
+  using Vec = __m128;
+  static constexpr int kLanes = 4;
+  static Vec Load(const float *p) {
+    return _mm_loadu_ps(p);
+  }
+  static void Store(float *p, Vec v) {
+    _mm_storeu_ps(p, v);
+  }
+  static Vec Set1(float x) {
+    return _mm_set1_ps(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm_add_ps(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm_sub_ps(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm_mul_ps(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm_min_ps(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm_max_ps(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+  }
+  static Vec Negate(Vec a) {
+    return _mm_xor_ps(_mm_set1_ps(-0.0f), a);
+  }
+  static Vec LessThan(Vec a, Vec b) {
+    return _mm_cmplt_ps(a, b);
+  }
+  static Vec GreaterEqual(Vec a, Vec b) {
+    return _mm_cmpge_ps(a, b);
+  }
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return _mm_blendv_ps(b, a, mask);
+  }
+  static Vec Interpolate(const float *table, Vec x) {
+    // SSE has no gather, so the table entries are loaded one by one.
+    __m128i index = _mm_cvttps_epi32(x);
+    int i0 = _mm_extract_epi32(index, 0);
+    int i1 = _mm_extract_epi32(index, 1);
+    int i2 = _mm_extract_epi32(index, 2);
+    int i3 = _mm_extract_epi32(index, 3);
+    __m128 t0 = _mm_set_ps(table[i3], table[i2], table[i1], table[i0]);
+    __m128 t1 = _mm_set_ps(table[i3 + 1], table[i2 + 1], table[i1 + 1], table[i0 + 1]);
+    __m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(index));
+    return _mm_add_ps(t0, _mm_mul_ps(_mm_sub_ps(t1, t0), fraction));
+  }
+};
+#  else
+struct SSEOps {
+  using Vec = __m128d;
+  static constexpr int kLanes = 2;
+  static Vec Load(const double *p) {
+    return _mm_loadu_pd(p);
+  }
+  static void Store(double *p, Vec v) {
+    _mm_storeu_pd(p, v);
+  }
+  static Vec Set1(double x) {
+    return _mm_set1_pd(x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm_add_pd(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm_sub_pd(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm_mul_pd(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm_min_pd(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm_max_pd(a, b);
+  }
+  static Vec Abs(Vec a) {
+    return _mm_andnot_pd(_mm_set1_pd(-0.0), a);
+  }
+  static Vec Negate(Vec a) {
+    return _mm_xor_pd(_mm_set1_pd(-0.0), a);
+  }
+  static Vec LessThan(Vec a, Vec b) {
+    return _mm_cmplt_pd(a, b);
+  }
+  static Vec GreaterEqual(Vec a, Vec b) {
+    return _mm_cmpge_pd(a, b);
+  }
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return _mm_blendv_pd(b, a, mask);
+  }
+  static Vec Interpolate(const double *table, Vec x) {
+    __m128i index = _mm_cvttpd_epi32(x);
+    int i0 = _mm_extract_epi32(index, 0);
+    int i1 = _mm_extract_epi32(index, 1);
+    __m128d t0 = _mm_set_pd(table[i1], table[i0]);
+    __m128d t1 = _mm_set_pd(table[i1 + 1], table[i0 + 1]);
+    __m128d fraction = _mm_sub_pd(x, _mm_cvtepi32_pd(index));
+    return _mm_add_pd(t0, _mm_mul_pd(_mm_sub_pd(t1, t0), fraction));
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhInPlaceSSE(int n, TFloat *inout) {
+  TanhInPlaceSIMD<SSEOps>(n, inout);
+}
+
+void LogisticInPlaceSSE(int n, TFloat *inout) {
+  LogisticInPlaceSIMD<SSEOps>(n, inout);
+}
+
+void LSTMStateUpdateSSE(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                        const TFloat *go, TFloat clip, TFloat *state, TFloat *output) {
+  LSTMStateUpdateSIMD<SSEOps>(n, ci, gi, gf, go, clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
@@ -1,5 +1,5 @@
 // Generated code with lookup tables (see generate_lut.py)
-#include "functions.h"
+#include "activation.h"
 namespace tesseract {
 const TFloat TanhTable[] = {
     0.0,
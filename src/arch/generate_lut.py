@@ -4,7 +4,7 @@
 
 import math
 
-# kTableSize and kScaleFactor must match the values in functions.h.
+# kTableSize and kScaleFactor must match the values in activation.h.
 
 # Size of static tables.
 kTableSize = 4096
@@ -12,7 +12,7 @@ kTableSize = 4096
 kScaleFactor = 256.0
 
 print("// Generated code with lookup tables (see generate_lut.py)")
-print('#include "functions.h"')
+print('#include "activation.h"')
 print("namespace tesseract {")
 
 print("const TFloat TanhTable[] = {")
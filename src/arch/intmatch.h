@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatch.h
+// Description: Architecture-specific code for the integer matcher of the
+//              legacy classifier.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_INTMATCH_H_
+#define TESSERACT_ARCH_INTMATCH_H_
+
+#include "simddetect.h"
+
+#include <cstdint>
+
+namespace tesseract {
+
+// Vectorized versions of the functions selected by SIMDDetect for the
+// ClassPrunerSum and ProtoEvidence function pointers.
+// See simddetect.h for a description of the arguments.
+
+// Uses Intel AVX2 intrinsics.
+void ClassPrunerSumAVX2(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                        int num_offsets, int *class_count);
+void ProtoEvidenceAVX2(const uint32_t *protos, int n, const ProtoEvidenceParams &params,
+                       uint8_t *evidence);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_INTMATCH_H_
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatchavx2.cpp
+// Description: Integer matcher of the legacy classifier for Intel AVX2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "intmatch.h"
+
+namespace tesseract {
+
+// Adds the class pruner weights at the given offsets to the class counts.
+// The counts of the 32 classes of a pruner stay in 4 registers while the
+// features are added. Each pruner word is broadcast and shifted by a
+// different amount in each lane, so each lane gets the weight of one class.
+void ClassPrunerSumAVX2(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                        int num_offsets, int *class_count) {
+  const __m256i low_shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+  const __m256i high_shifts = _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30);
+  const __m256i mask = _mm256_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uint32_t *pruner = pruners[p];
+    __m256i count0 = _mm256_setzero_si256();
+    __m256i count1 = _mm256_setzero_si256();
+    __m256i count2 = _mm256_setzero_si256();
+    __m256i count3 = _mm256_setzero_si256();
+    for (int f = 0; f < num_offsets; ++f) {
+      const uint32_t *words = pruner + offsets[f];
+      __m256i word0 = _mm256_set1_epi32(words[0]);
+      __m256i word1 = _mm256_set1_epi32(words[1]);
+      count0 =
+          _mm256_add_epi32(count0, _mm256_and_si256(_mm256_srlv_epi32(word0, low_shifts), mask));
+      count1 =
+          _mm256_add_epi32(count1, _mm256_and_si256(_mm256_srlv_epi32(word0, high_shifts), mask));
+      count2 =
+          _mm256_add_epi32(count2, _mm256_and_si256(_mm256_srlv_epi32(word1, low_shifts), mask));
+      count3 =
+          _mm256_add_epi32(count3, _mm256_and_si256(_mm256_srlv_epi32(word1, high_shifts), mask));
+    }
+    auto *counts = reinterpret_cast<__m256i *>(class_count + 32 * p);
+    _mm256_storeu_si256(counts, _mm256_add_epi32(_mm256_loadu_si256(counts), count0));
+    _mm256_storeu_si256(counts + 1, _mm256_add_epi32(_mm256_loadu_si256(counts + 1), count1));
+    _mm256_storeu_si256(counts + 2, _mm256_add_epi32(_mm256_loadu_si256(counts + 2), count2));
+    _mm256_storeu_si256(counts + 3, _mm256_add_epi32(_mm256_loadu_si256(counts + 3), count3));
+  }
+}
+
+// Returns the sign-extended byte at the given bit offset of each lane.
+template <int kShift>
+static inline __m256i SignedByte(__m256i v) {
+  return _mm256_srai_epi32(_mm256_slli_epi32(v, 24 - kShift), 24);
+}
+
+// Returns x < 0 ? ~x : x in each lane, shifted right by shift and limited
+// to max.
+static inline __m256i ClipMagnitude(__m256i x, __m128i shift, __m256i max) {
+  x = _mm256_xor_si256(x, _mm256_srai_epi32(x, 31));
+  return _mm256_min_epi32(_mm256_sra_epi32(x, shift), max);
+}
+
+// Computes the evidence of a feature for each of the protos, 8 protos at a
+// time. Only the final table lookup is done one proto at a time.
+void ProtoEvidenceAVX2(const uint32_t *protos, int n, const ProtoEvidenceParams &params,
+                       uint8_t *evidence) {
+  const __m256i x_offset = _mm256_set1_epi32((params.x - 128) * 2);
+  const __m256i y_offset = _mm256_set1_epi32(params.y - 128);
+  const __m256i theta = _mm256_set1_epi32(params.theta);
+  const __m256i theta_fudge = _mm256_set1_epi32(params.theta_fudge * 2);
+  const __m128i mult_shift = _mm_cvtsi32_si128(params.mult_trunc_shift);
+  const __m128i table_shift = _mm_cvtsi32_si128(params.table_trunc_shift);
+  const __m256i mult_max = _mm256_set1_epi32(params.evidence_mult_mask);
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i proto = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(protos + i));
+    __m256i a = SignedByte<0>(proto);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(proto, 8), byte_mask);
+    __m256i c = SignedByte<16>(proto);
+    __m256i angle = _mm256_srli_epi32(proto, 24);
+    __m256i a3 = _mm256_sub_epi32(_mm256_mullo_epi32(a, x_offset), _mm256_mullo_epi32(b, y_offset));
+    a3 = _mm256_add_epi32(a3, _mm256_slli_epi32(c, 9));
+    __m256i m3 = SignedByte<0>(_mm256_sub_epi32(theta, angle));
+    m3 = _mm256_mullo_epi32(m3, theta_fudge);
+    a3 = ClipMagnitude(a3, mult_shift, mult_max);
+    m3 = ClipMagnitude(m3, mult_shift, mult_max);
+    __m256i a4 = _mm256_add_epi32(_mm256_mullo_epi32(a3, a3), _mm256_mullo_epi32(m3, m3));
+    a4 = _mm256_srl_epi32(a4, table_shift);
+    alignas(32) uint32_t indices[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(indices), a4);
+    for (int j = 0; j < 8; ++j) {
+      evidence[i + j] = indices[j] > static_cast<uint32_t>(params.evidence_table_mask)
+                            ? 0
+                            : params.table[indices[j]];
+    }
+  }
+  if (i < n) {
+    // The remaining protos are padded to a full register.
+    alignas(32) uint32_t tail[8] = {};
+    alignas(32) uint8_t tail_evidence[8];
+    for (int j = i; j < n; ++j) {
+      tail[j - i] = protos[j];
+    }
+    ProtoEvidenceAVX2(tail, 8, params, tail_evidence);
+    for (int j = i; j < n; ++j) {
+      evidence[j] = tail_evidence[j - i];
+    }
+  }
+}
+
+} // namespace tesseract.
+
+#endif
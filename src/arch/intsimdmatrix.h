@@ -66,6 +66,12 @@ struct TESS_API IntSimdMatrix {
   void Init(const GENERIC_2D_ARRAY<int8_t> &w, std::vector<int8_t> &shaped_w,
             int32_t &rounded_num_out) const;
 
+  // Returns an identifier of the layout of the weights computed by Init.
+  // Implementations with the same identifier can use the same weights.
+  uint32_t ShapeId() const {
+    return num_outputs_per_register_ << 16 | max_output_registers_ << 8 | num_inputs_per_group_;
+  }
+
   // Rounds the size up to a multiple of the input register size (in int8_t).
   int RoundInputs(int size) const {
     return Roundup(size, num_inputs_per_register_);
@@ -120,6 +126,9 @@ struct TESS_API IntSimdMatrix {
   // Only available with AVX2 / AVX / FMA / SSE.
   static const IntSimdMatrix intSimdMatrixAVX2;
   static const IntSimdMatrix intSimdMatrixSSE;
+  // Only available with AVX512 VNNI / AVX VNNI.
+  static const IntSimdMatrix intSimdMatrixAVX512VNNI;
+  static const IntSimdMatrix intSimdMatrixAVXVNNI;
 };
 
 } // namespace tesseract
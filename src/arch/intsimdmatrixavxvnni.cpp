@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavxvnni.cpp
+// Description: matrix-vector product for 8-bit data on avx vnni.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "intsimdmatrix.h"
+
+#if !defined(__AVXVNNI__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX VNNI capable architectures
+#  endif
+#else
+#  include <immintrin.h>
+#  include <cstdint>
+#  include <cstring>
+
+namespace tesseract {
+
+// Number of outputs held in each register. 8 x 32 bit ints.
+constexpr int kNumOutputsPerRegister = 8;
+// Maximum number of registers that we will use.
+constexpr int kMaxOutputRegisters = 8;
+// Number of inputs in each weight group.
+constexpr int kNumInputsPerGroup = 4;
+// Number of inputs in the inputs register. Each group of inputs is
+// broadcast directly from memory, so the inputs only need to be padded to a
+// whole group.
+constexpr int kNumInputsPerRegister = kNumInputsPerGroup;
+// Number of weights in a register.
+constexpr int kNumWeightsPerRegister = kNumOutputsPerRegister * kNumInputsPerGroup;
+
+// Computes one set of 4x8 products of inputs and weights, adding to result.
+// Horizontally adds 4 adjacent results, making 8x32-bit results.
+// rep_input is an 8x replicated set of 4x8-bit signed integers.
+// vpdpbusd multiplies unsigned by signed bytes, so the signs of the weights
+// are moved to the inputs, like in the AVX2 version.
+static inline __m256i MultiplyGroup(__m256i rep_input, const int8_t *wi, __m256i result) {
+  __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(wi));
+  __m256i reps = _mm256_sign_epi8(rep_input, weights);
+  return _mm256_dpbusd_avx_epi32(result, _mm256_sign_epi8(weights, weights), reps);
+}
+
+// Adds the 8 biases in wi, scales the results with scales and stores them
+// in v.
+static inline void ExtractResults8(__m256i result, const int8_t *wi, const TFloat *scales,
+                                   TFloat *v) {
+  __m256i biases = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(wi)));
+  // result += bias * 127
+  result = _mm256_add_epi32(result, _mm256_mullo_epi32(biases, _mm256_set1_epi32(INT8_MAX)));
+#  if defined(FAST_FLOAT)
+  __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(result), _mm256_loadu_ps(scales));
+  _mm256_storeu_ps(v, scaled);
+#  else
+  __m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(result));
+  __m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(result, 1));
+  _mm256_storeu_pd(v, _mm256_mul_pd(low, _mm256_loadu_pd(scales)));
+  _mm256_storeu_pd(v + 4, _mm256_mul_pd(high, _mm256_loadu_pd(scales + 4)));
+#  endif
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=8*kNumRegisters results.
+// The weights *must* be arranged so that consecutive reads from wi
+// provides (num_in/kNumInputsPerGroup groups of (N output dim groups of
+// (kNumInputsPerGroup inputs))). After that there must be N consecutive
+// bias weights, before continuing with any more weights.
+// u must be padded out with zeros to
+// kNumInputsPerGroup*ceil(num_in/kNumInputsPerGroup) elements.
+template <int kNumRegisters>
+static void PartialMatrixDotVector(const int8_t *wi, const TFloat *scales, const int8_t *u,
+                                   int num_in, TFloat *v) {
+  __m256i results[kNumRegisters];
+#  pragma GCC unroll 8
+  for (auto &result : results) {
+    result = _mm256_setzero_si256();
+  }
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    int32_t inputs;
+    memcpy(&inputs, u + j, sizeof(inputs));
+    // Replicate the 4 inputs 8 times.
+    __m256i rep_input = _mm256_set1_epi32(inputs);
+    // The loops over the registers are unrolled, so the results are kept in
+    // registers.
+#  pragma GCC unroll 8
+    for (auto &result : results) {
+      result = MultiplyGroup(rep_input, wi, result);
+      wi += kNumWeightsPerRegister;
+    }
+  }
+#  pragma GCC unroll 8
+  for (auto &result : results) {
+    ExtractResults8(result, wi, scales, v);
+    wi += kNumOutputsPerRegister;
+    scales += kNumOutputsPerRegister;
+    v += kNumOutputsPerRegister;
+  }
+}
+
+static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            const int8_t *u, TFloat *v) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  // Each call to a partial_func_ produces group_size outputs, except the
+  // last one, which can produce less.
+  const int rounded_num_in = IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int rounded_num_out = IntSimdMatrix::Roundup(num_out, kNumOutputsPerRegister);
+  int group_size = kNumOutputsPerRegister * kMaxOutputRegisters;
+  int output = 0;
+
+  int w_step = (rounded_num_in + 1) * group_size;
+
+  // Run with this group size, until it would produce too much output, then
+  // switch to a smaller size.
+  for (; output + group_size <= rounded_num_out; output += group_size) {
+    PartialMatrixDotVector<8>(wi, scales, u, rounded_num_in, v);
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+  }
+  group_size /= 2;
+  w_step /= 2;
+
+  if (output + group_size <= rounded_num_out) {
+    PartialMatrixDotVector<4>(wi, scales, u, rounded_num_in, v);
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+    output += group_size;
+  }
+  group_size /= 2;
+  w_step /= 2;
+
+  if (output + group_size <= rounded_num_out) {
+    PartialMatrixDotVector<2>(wi, scales, u, rounded_num_in, v);
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+    output += group_size;
+  }
+
+  if (output < rounded_num_out) {
+    PartialMatrixDotVector<1>(wi, scales, u, rounded_num_in, v);
+  }
+}
+
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVXVNNI = {
+    // Function.
+    matrixDotVector,
+    // Number of 32 bit outputs held in each register.
+    kNumOutputsPerRegister,
+    // Maximum number of registers that we will use to hold outputs.
+    kMaxOutputRegisters,
+    // Number of 8 bit inputs in the inputs register.
+    kNumInputsPerRegister,
+    // Number of inputs in each weight group.
+    kNumInputsPerGroup
+};
+
+} // namespace tesseract.
+
+#endif
@@ -18,11 +18,16 @@
 #ifdef HAVE_CONFIG_H
 #  include "config_auto.h" // for HAVE_AVX, ...
 #endif
+#include <cstring> // for memcpy
 #include <numeric> // for std::inner_product
+#include "activation.h"    // for Tanh, Logistic
 #include "dotproduct.h"
+#include "helpers.h"       // for ClipToRange
+#include "intmatch.h"
 #include "intsimdmatrix.h" // for IntSimdMatrix
 #include "params.h"        // for STRING_VAR
 #include "simddetect.h"
+#include "threshold.h"
 #include "tprintf.h" // for tprintf
 
 #if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ < 12)
@@ -112,6 +117,7 @@ bool SIMDDetect::avx2_available_;
 bool SIMDDetect::avx512F_available_;
 bool SIMDDetect::avx512BW_available_;
 bool SIMDDetect::avx512VNNI_available_;
+bool SIMDDetect::avxVNNI_available_;
 // If true, then FMA has been detected.
 bool SIMDDetect::fma_available_;
 // If true, then SSe4.1 has been detected.
@@ -150,6 +156,131 @@ static void SetDotProduct(DotProductFunction f, const IntSimdMatrix *m = nullptr
   IntSimdMatrix::intSimdMatrix = m;
 }
 
+// Applies Tanh in-place to inout, of size n.
+static void TanhInPlaceGeneric(int n, TFloat *inout) {
+  for (int i = 0; i < n; ++i) {
+    inout[i] = Tanh(inout[i]);
+  }
+}
+
+// Applies Logistic in-place to inout, of size n.
+static void LogisticInPlaceGeneric(int n, TFloat *inout) {
+  for (int i = 0; i < n; ++i) {
+    inout[i] = Logistic(inout[i]);
+  }
+}
+
+// Computes the new state and output of n cells of a 1-d LSTM.
+static void LSTMStateUpdateGeneric(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                                   const TFloat *go, TFloat clip, TFloat *state,
+                                   TFloat *output) {
+  for (int i = 0; i < n; ++i) {
+    TFloat new_state = state[i] * Logistic(gf[i]);
+    new_state += Tanh(ci[i]) * Logistic(gi[i]);
+    new_state = ClipToRange(new_state, -clip, clip);
+    state[i] = new_state;
+    output[i] = Tanh(new_state) * Logistic(go[i]);
+  }
+}
+
+// The activation functions are statically initialized, because they are
+// also needed by static objects which might be constructed before detector.
+ActivationFunction TanhInPlace = TanhInPlaceGeneric;
+ActivationFunction LogisticInPlace = LogisticInPlaceGeneric;
+StateUpdateFunction LSTMStateUpdate = LSTMStateUpdateGeneric;
+
+// Stores the indices of the values greater than threshold.
+static int IndicesAboveGeneric(const float *values, int n, float threshold, int *indices) {
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    if (values[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+IndicesAboveFunction IndicesAbove = IndicesAboveGeneric;
+
+// Adds the class pruner weights at the given offsets to the class counts.
+static void ClassPrunerSumGeneric(const uint32_t *const *pruners, int num_pruners,
+                                  const int *offsets, int num_offsets, int *class_count) {
+  for (int p = 0; p < num_pruners; ++p) {
+    for (int f = 0; f < num_offsets; ++f) {
+      int *count = class_count + 32 * p;
+      for (int w = 0; w < 2; ++w) {
+        uint32_t pruner_word = pruners[p][offsets[f] + w];
+        for (int c = 0; c < 16; ++c, pruner_word >>= 2) {
+          *count++ += pruner_word & 3;
+        }
+      }
+    }
+  }
+}
+
+// Computes the evidence of a feature for each of the protos.
+static void ProtoEvidenceGeneric(const uint32_t *protos, int n,
+                                 const ProtoEvidenceParams &params, uint8_t *evidence) {
+  for (int i = 0; i < n; ++i) {
+    uint8_t proto[4];
+    memcpy(proto, &protos[i], sizeof(proto));
+    int32_t a = static_cast<int8_t>(proto[0]);
+    int32_t b = proto[1];
+    int32_t c = static_cast<int8_t>(proto[2]);
+    int32_t A3 = a * (params.x - 128) * 2 - b * (params.y - 128) + c * 512;
+    int32_t M3 = static_cast<int8_t>(params.theta - proto[3]) * params.theta_fudge * 2;
+    if (A3 < 0) {
+      A3 = ~A3;
+    }
+    if (M3 < 0) {
+      M3 = ~M3;
+    }
+    A3 >>= params.mult_trunc_shift;
+    M3 >>= params.mult_trunc_shift;
+    if (A3 > params.evidence_mult_mask) {
+      A3 = params.evidence_mult_mask;
+    }
+    if (M3 > params.evidence_mult_mask) {
+      M3 = params.evidence_mult_mask;
+    }
+    uint32_t A4 = (A3 * A3) + (M3 * M3);
+    A4 >>= params.table_trunc_shift;
+    evidence[i] = A4 > static_cast<uint32_t>(params.evidence_table_mask) ? 0 : params.table[A4];
+  }
+}
+
+ClassPrunerSumFunction ClassPrunerSum = ClassPrunerSumGeneric;
+ProtoEvidenceFunction ProtoEvidence = ProtoEvidenceGeneric;
+
+static void SetActivations(ActivationFunction tanh_in_place,
+                           ActivationFunction logistic_in_place,
+                           StateUpdateFunction state_update,
+                           IndicesAboveFunction indices_above) {
+  TanhInPlace = tanh_in_place;
+  LogisticInPlace = logistic_in_place;
+  LSTMStateUpdate = state_update;
+  IndicesAbove = indices_above;
+}
+
+// Selects the generic activation functions, for the dot product functions
+// which have no vectorized activation functions of their own.
+static void SetGenericActivations() {
+  SetActivations(TanhInPlaceGeneric, LogisticInPlaceGeneric, LSTMStateUpdateGeneric,
+                 IndicesAboveGeneric);
+}
+
+static void SetIntegerMatcher(ClassPrunerSumFunction class_pruner_sum,
+                              ProtoEvidenceFunction proto_evidence) {
+  ClassPrunerSum = class_pruner_sum;
+  ProtoEvidence = proto_evidence;
+}
+
+// Selects the generic integer matcher, for the dot product functions which
+// have no vectorized integer matcher of their own.
+static void SetGenericIntegerMatcher() {
+  SetIntegerMatcher(ClassPrunerSumGeneric, ProtoEvidenceGeneric);
+}
+
 // Constructor.
 // Tests the architecture in a system-dependent way to detect AVX, SSE and
 // any other available SIMD equipment.
@@ -181,15 +312,23 @@ SIMDDetect::SIMDDetect() {
 #      endif
 #      if defined(HAVE_AVX)
       avx_available_ = (ecx & 0x10000000) != 0;
-      if (avx_available_) {
+      if (avx_available_ && __get_cpuid_max(0, nullptr) >= 7) {
         // There is supposed to be a __get_cpuid_count function, but this is all
         // there is in my cpuid.h. It is a macro for an asm statement and cannot
         // be used inside an if.
         __cpuid_count(7, 0, eax, ebx, ecx, edx);
         avx2_available_ = (ebx & 0x00000020) != 0;
-        avx512F_available_ = (ebx & 0x00010000) != 0;
-        avx512BW_available_ = (ebx & 0x40000000) != 0;
-        avx512VNNI_available_ = (ecx & 0x00000800) != 0;
+        if ((xgetbv() & 0xE6) == 0xE6) {
+          // Opmask and ZMM state are fine too.
+          avx512F_available_ = (ebx & 0x00010000) != 0;
+          avx512BW_available_ = (ebx & 0x40000000) != 0;
+          avx512VNNI_available_ = (ecx & 0x00000800) != 0;
+        }
+        if (eax >= 1) {
+          // Subleaf 1 is supported.
+          __cpuid_count(7, 1, eax, ebx, ecx, edx);
+          avxVNNI_available_ = (eax & 0x00000010) != 0;
+        }
       }
 #      endif
     }
@@ -216,11 +355,19 @@ SIMDDetect::SIMDDetect() {
 #      endif
 #      if defined(HAVE_AVX2)
       if (max_function_id >= 7) {
-        __cpuid(cpuInfo, 7);
+        __cpuidex(cpuInfo, 7, 0);
         avx2_available_ = (cpuInfo[1] & 0x00000020) != 0;
-        avx512F_available_ = (cpuInfo[1] & 0x00010000) != 0;
-        avx512BW_available_ = (cpuInfo[1] & 0x40000000) != 0;
-        avx512VNNI_available_ = (cpuInfo[2] & 0x00000800) != 0;
+        if ((_xgetbv(0) & 0xE6) == 0xE6) {
+          // Opmask and ZMM state are fine too.
+          avx512F_available_ = (cpuInfo[1] & 0x00010000) != 0;
+          avx512BW_available_ = (cpuInfo[1] & 0x40000000) != 0;
+          avx512VNNI_available_ = (cpuInfo[2] & 0x00000800) != 0;
+        }
+        if (cpuInfo[0] >= 1) {
+          // Subleaf 1 is supported.
+          __cpuidex(cpuInfo, 7, 1);
+          avxVNNI_available_ = (cpuInfo[0] & 0x00000010) != 0;
+        }
       }
 #      endif
     }
@@ -261,11 +408,21 @@ SIMDDetect::SIMDDetect() {
   // Select code for calculation of dot product based on autodetection.
   if (false) {
     // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX512F) && defined(HAVE_AVX512VNNI)
+  } else if (avx512VNNI_available_ && avx512BW_available_) {
+    // AVX512 VNNI detected.
+    SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#endif
 #if defined(HAVE_AVX512F)
   } else if (avx512F_available_) {
     // AVX512F detected.
     SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX2);
 #endif
+#if defined(HAVE_AVXVNNI)
+  } else if (avxVNNI_available_) {
+    // AVX VNNI detected.
+    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVXVNNI);
+#endif
 #if defined(HAVE_AVX2)
   } else if (avx2_available_) {
     // AVX2 detected.
@@ -297,6 +454,42 @@ SIMDDetect::SIMDDetect() {
 #endif
   }
 
+  // Select code for the activation functions and IndicesAbove based on
+  // autodetection. The results are the same for all of them.
+  if (false) {
+    // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX512F)
+  } else if (avx512F_available_) {
+    SetActivations(TanhInPlaceAVX512F, LogisticInPlaceAVX512F, LSTMStateUpdateAVX512F,
+                   IndicesAboveAVX512F);
+#endif
+#if defined(HAVE_AVX2)
+  } else if (avx2_available_) {
+    SetActivations(TanhInPlaceAVX2, LogisticInPlaceAVX2, LSTMStateUpdateAVX2,
+                   IndicesAboveAVX2);
+#endif
+#if defined(HAVE_SSE4_1)
+  } else if (sse_available_) {
+    SetActivations(TanhInPlaceSSE, LogisticInPlaceSSE, LSTMStateUpdateSSE,
+                   IndicesAboveSSE);
+#endif
+#if defined(__aarch64__)
+  } else if (neon_available_) {
+    SetActivations(TanhInPlaceNEON, LogisticInPlaceNEON, LSTMStateUpdateNEON,
+                   IndicesAboveNEON);
+#endif
+  }
+
+  // Select code for the integer matcher of the legacy classifier based on
+  // autodetection. The results are the same for all of them.
+  if (false) {
+    // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX2)
+  } else if (avx2_available_) {
+    SetIntegerMatcher(ClassPrunerSumAVX2, ProtoEvidenceAVX2);
+#endif
+  }
+
   const char *dotproduct_env = getenv("DOTPRODUCT");
   if (dotproduct_env != nullptr) {
     // Override automatic settings by value from environment variable.
@@ -314,54 +507,109 @@ void SIMDDetect::Update() {
   } else if (dotproduct == "generic") {
     // Generic code selected by config variable.
     SetDotProduct(DotProductGeneric);
+    SetGenericActivations();
+    SetGenericIntegerMatcher();
     dotproduct_method = "generic";
   } else if (dotproduct == "native") {
     // Native optimized code selected by config variable.
     SetDotProduct(DotProductNative, IntSimdMatrix::intSimdMatrix);
+    SetGenericActivations();
+    SetGenericIntegerMatcher();
     dotproduct_method = "native";
+#if defined(HAVE_AVX512F) && defined(HAVE_AVX512VNNI)
+  } else if (dotproduct == "avx512vnni" && avx512VNNI_available_ && avx512BW_available_) {
+    // AVX512 VNNI selected by config variable.
+    SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX512VNNI);
+    SetActivations(TanhInPlaceAVX512F, LogisticInPlaceAVX512F, LSTMStateUpdateAVX512F,
+                   IndicesAboveAVX512F);
+#  if defined(HAVE_AVX2)
+    SetIntegerMatcher(ClassPrunerSumAVX2, ProtoEvidenceAVX2);
+#  else
+    SetGenericIntegerMatcher();
+#  endif
+    dotproduct_method = "avx512vnni";
+#endif
+#if defined(HAVE_AVXVNNI)
+  } else if (dotproduct == "avxvnni" && avxVNNI_available_) {
+    // AVX VNNI selected by config variable.
+    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVXVNNI);
+    SetActivations(TanhInPlaceAVX2, LogisticInPlaceAVX2, LSTMStateUpdateAVX2,
+                   IndicesAboveAVX2);
+    SetIntegerMatcher(ClassPrunerSumAVX2, ProtoEvidenceAVX2);
+    dotproduct_method = "avxvnni";
+#endif
 #if defined(HAVE_AVX2)
   } else if (dotproduct == "avx2") {
     // AVX2 selected by config variable.
     SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVX2);
+    SetActivations(TanhInPlaceAVX2, LogisticInPlaceAVX2, LSTMStateUpdateAVX2,
+                   IndicesAboveAVX2);
+    SetIntegerMatcher(ClassPrunerSumAVX2, ProtoEvidenceAVX2);
     dotproduct_method = "avx2";
 #endif
 #if defined(HAVE_AVX)
   } else if (dotproduct == "avx") {
     // AVX selected by config variable.
     SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixSSE);
+    SetGenericActivations();
+    // There is no AVX version of the integer matcher.
+    SetGenericIntegerMatcher();
     dotproduct_method = "avx";
 #endif
 #if defined(HAVE_FMA)
   } else if (dotproduct == "fma") {
     // FMA selected by config variable.
     SetDotProduct(DotProductFMA, IntSimdMatrix::intSimdMatrix);
+    SetGenericActivations();
+    SetGenericIntegerMatcher();
     dotproduct_method = "fma";
 #endif
 #if defined(HAVE_SSE4_1)
   } else if (dotproduct == "sse") {
     // SSE selected by config variable.
     SetDotProduct(DotProductSSE, &IntSimdMatrix::intSimdMatrixSSE);
+    SetActivations(TanhInPlaceSSE, LogisticInPlaceSSE, LSTMStateUpdateSSE,
+                   IndicesAboveSSE);
+    // There is no SSE version of the integer matcher.
+    SetGenericIntegerMatcher();
     dotproduct_method = "sse";
 #endif
 #if defined(HAVE_FRAMEWORK_ACCELERATE)
   } else if (dotproduct == "accelerate") {
     SetDotProduct(DotProductAccelerate, IntSimdMatrix::intSimdMatrix);
+    SetGenericActivations();
+    SetGenericIntegerMatcher();
 #endif
 #if defined(HAVE_NEON) || defined(__aarch64__)
   } else if (dotproduct == "neon" && neon_available_) {
     // NEON selected by config variable.
     SetDotProduct(DotProductNEON, &IntSimdMatrix::intSimdMatrixNEON);
+#  if defined(__aarch64__)
+    SetActivations(TanhInPlaceNEON, LogisticInPlaceNEON, LSTMStateUpdateNEON,
+                   IndicesAboveNEON);
+#  else
+    // The NEON activation functions need 64 bit ARM.
+    SetActivations(TanhInPlaceGeneric, LogisticInPlaceGeneric, LSTMStateUpdateGeneric,
+                   IndicesAboveNEON);
+#  endif
+    SetGenericIntegerMatcher();
     dotproduct_method = "neon";
 #endif
 #if defined(__ARM_FEATURE_SVE)
   } else if (dotproduct == "sve" && sve_available_) {
     // SVE selected by config variable.
     SetDotProduct(DotProductSVE, &IntSimdMatrix::intSimdMatrixNEON);
+    // SVE is only available on 64 bit ARM, which always has NEON.
+    SetActivations(TanhInPlaceNEON, LogisticInPlaceNEON, LSTMStateUpdateNEON,
+                   IndicesAboveNEON);
+    SetGenericIntegerMatcher();
     dotproduct_method = "sve";
 #endif
   } else if (dotproduct == "std::inner_product") {
     // std::inner_product selected by config variable.
     SetDotProduct(DotProductStdInnerProduct, IntSimdMatrix::intSimdMatrix);
+    SetGenericActivations();
+    SetGenericIntegerMatcher();
     dotproduct_method = "std::inner_product";
   } else {
     // Unsupported value of config variable.
@@ -369,6 +617,12 @@ void SIMDDetect::Update() {
             dotproduct.c_str());
     tprintf(
         "Supported values for dotproduct: auto generic native"
+#if defined(HAVE_AVX512F) && defined(HAVE_AVX512VNNI)
+        " avx512vnni"
+#endif
+#if defined(HAVE_AVXVNNI)
+        " avxvnni"
+#endif
 #if defined(HAVE_AVX2)
         " avx2"
 #endif
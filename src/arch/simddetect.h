@@ -20,12 +20,77 @@
 #include <tesseract/export.h>
 #include "tesstypes.h"
 
+#include <cstdint> // for uint32_t
+
 namespace tesseract {
 
 // Function pointer for best calculation of dot product.
 using DotProductFunction = TFloat (*)(const TFloat *, const TFloat *, int);
 extern DotProductFunction DotProduct;
 
+// Function pointers for best calculation of the activation functions
+// Tanh and Logistic in-place on the n-vector inout.
+using ActivationFunction = void (*)(int n, TFloat *inout);
+extern TESS_API ActivationFunction TanhInPlace;
+extern TESS_API ActivationFunction LogisticInPlace;
+
+// Function pointer for best calculation of the new state and output of n
+// cells of a 1-d LSTM in a single pass from the weighted sums of the cell
+// inputs ci and of the input, forget and output gates gi, gf and go. The
+// results are identical to applying Tanh to ci and Logistic to the gates,
+// followed by MultiplyVectorsInPlace of gf into state, MultiplyAccumulate of
+// ci and gi into state, ClipVector of state to [-clip, clip] and
+// FuncMultiply<HFunc> of state and go into output.
+using StateUpdateFunction = void (*)(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf,
+                                     const TFloat *go, TFloat clip, TFloat *state,
+                                     TFloat *output);
+extern TESS_API StateUpdateFunction LSTMStateUpdate;
+
+// Stores in indices the indices of the values (of size n) which are greater
+// than threshold, in increasing order, and returns their number.
+// indices must have room for n entries.
+using IndicesAboveFunction = int (*)(const float *values, int n, float threshold, int *indices);
+extern TESS_API IndicesAboveFunction IndicesAbove;
+
+// Function pointer for best calculation of the class pruner scores of the
+// legacy classifier. Each of the num_pruners pruners holds the 2-bit weights
+// of 32 classes in 2 words, starting at the low bits, for each quantized
+// feature. Adds the weights at each of the num_offsets word offsets of each
+// pruner to the 32 counts of that pruner in class_count, which must have
+// room for 32 * num_pruners counts. The results are the same for all
+// implementations.
+using ClassPrunerSumFunction = void (*)(const uint32_t *const *pruners, int num_pruners,
+                                        const int *offsets, int num_offsets, int *class_count);
+extern TESS_API ClassPrunerSumFunction ClassPrunerSum;
+
+// A feature and the constants of the integer matcher for ProtoEvidence.
+// See IntegerMatcher::UpdateTablesForFeature.
+struct ProtoEvidenceParams {
+  // The feature.
+  int x;
+  int y;
+  int theta;
+  // Multiplier of the angle difference.
+  int theta_fudge;
+  // Shift and maximum of the distance and the angle difference.
+  int mult_trunc_shift;
+  int evidence_mult_mask;
+  // Shift of the sum of their squares and maximum index into table.
+  int table_trunc_shift;
+  int evidence_table_mask;
+  // Evidence for each index.
+  const uint8_t *table;
+};
+
+// Function pointer for best calculation of the evidence of a feature for n
+// protos. Each proto is given by its parameters A, B, C and Angle, which are
+// 4 bytes in this order in memory, like in INT_PROTO_STRUCT. Stores the
+// evidence of the i-th proto in evidence[i]. The results are the same for all
+// implementations.
+using ProtoEvidenceFunction = void (*)(const uint32_t *protos, int n,
+                                       const ProtoEvidenceParams &params, uint8_t *evidence);
+extern TESS_API ProtoEvidenceFunction ProtoEvidence;
+
 // Architecture detector. Add code here to detect any other architectures for
 // SIMD-based faster dot product functions. Intended to be a single static
 // object, but it does no real harm to have more than one.
@@ -51,6 +116,10 @@ public:
   static inline bool IsAVX512VNNIAvailable() {
     return detector.avx512VNNI_available_;
   }
+  // Returns true if AVX Vector Neural Network Instructions are available.
+  static inline bool IsAVXVNNIAvailable() {
+    return detector.avxVNNI_available_;
+  }
   // Returns true if FMA is available on this system.
   static inline bool IsFMAAvailable() {
     return detector.fma_available_;
@@ -88,6 +157,7 @@ private:
   static TESS_API bool avx512F_available_;
   static TESS_API bool avx512BW_available_;
   static TESS_API bool avx512VNNI_available_;
+  static TESS_API bool avxVNNI_available_;
   // If true, then FMA has been detected.
   static TESS_API bool fma_available_;
   // If true, then SSe4.1 has been detected.
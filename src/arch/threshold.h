@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threshold.h
+// Description: Architecture-specific search for values above a threshold.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_THRESHOLD_H_
+#define TESSERACT_ARCH_THRESHOLD_H_
+
+namespace tesseract {
+
+// Vectorized versions of the function selected by SIMDDetect for the
+// IndicesAbove function pointer.
+// See simddetect.h for a description of the arguments.
+
+// Uses Intel SSE 4.1 intrinsics.
+int IndicesAboveSSE(const float *values, int n, float threshold, int *indices);
+
+// Uses Intel AVX2 intrinsics.
+int IndicesAboveAVX2(const float *values, int n, float threshold, int *indices);
+
+// Uses Intel AVX512F intrinsics.
+int IndicesAboveAVX512F(const float *values, int n, float threshold, int *indices);
+
+// Uses NEON intrinsics.
+int IndicesAboveNEON(const float *values, int n, float threshold, int *indices);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_THRESHOLD_H_
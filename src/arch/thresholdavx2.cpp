@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdavx2.cpp
+// Description: Search for values above a threshold for Intel AVX2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "threshold.h"
+
+namespace tesseract {
+
+// Stores the indices of the values greater than threshold and returns their
+// number. Compares 16 values at a time, and only looks at the single values
+// of a group if any of them is above the threshold.
+int IndicesAboveAVX2(const float *values, int n, float threshold, int *indices) {
+  __m256 limit = _mm256_set1_ps(threshold);
+  int count = 0;
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 above0 = _mm256_cmp_ps(_mm256_loadu_ps(values + i), limit, _CMP_GT_OQ);
+    __m256 above1 = _mm256_cmp_ps(_mm256_loadu_ps(values + i + 8), limit, _CMP_GT_OQ);
+    int mask = _mm256_movemask_ps(above0) | _mm256_movemask_ps(above1) << 8;
+    for (int j = i; mask != 0; ++j, mask >>= 1) {
+      if (mask & 1) {
+        indices[count++] = j;
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    if (values[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+} // namespace tesseract.
+
+#endif
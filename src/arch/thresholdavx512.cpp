@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdavx512.cpp
+// Description: Search for values above a threshold for Intel AVX512F.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX512F capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "threshold.h"
+
+namespace tesseract {
+
+// Stores the indices of the values greater than threshold and returns their
+// number. Compares 16 values at a time, and compresses the indices of the
+// ones above the threshold straight into the output.
+int IndicesAboveAVX512F(const float *values, int n, float threshold, int *indices) {
+  __m512 limit = _mm512_set1_ps(threshold);
+  __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m512i step = _mm512_set1_epi32(16);
+  int count = 0;
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), limit, _CMP_GT_OQ);
+    if (mask != 0) {
+      _mm512_mask_compressstoreu_epi32(indices + count, mask, index);
+      count += _mm_popcnt_u32(mask);
+    }
+    index = _mm512_add_epi32(index, step);
+  }
+  for (; i < n; ++i) {
+    if (values[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+} // namespace tesseract.
+
+#endif
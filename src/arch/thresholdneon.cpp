@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdneon.cpp
+// Description: Search for values above a threshold for ARM NEON.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+#include <cstdint>
+#include "threshold.h"
+
+namespace tesseract {
+
+// Documentation:
+// https://developer.arm.com/architectures/instruction-sets/intrinsics/
+
+// Stores the indices of the values greater than threshold and returns their
+// number. Compares 8 values at a time, and only looks at the single values
+// of a group if any of them is above the threshold.
+int IndicesAboveNEON(const float *values, int n, float threshold, int *indices) {
+  float32x4_t limit = vdupq_n_f32(threshold);
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint32x4_t above0 = vcgtq_f32(vld1q_f32(values + i), limit);
+    uint32x4_t above1 = vcgtq_f32(vld1q_f32(values + i + 4), limit);
+    // Narrow the lanes to 8 bits each, so the whole group fits in 64 bits.
+    uint8x8_t above = vmovn_u16(vcombine_u16(vmovn_u32(above0), vmovn_u32(above1)));
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(above), 0);
+    for (int j = i; mask != 0; ++j, mask >>= 8) {
+      if (mask & 1) {
+        indices[count++] = j;
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    if (values[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+} // namespace tesseract.
+
+#endif /* __ARM_NEON */
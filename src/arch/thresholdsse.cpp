@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsse.cpp
+// Description: Search for values above a threshold for Intel SSE 4.1.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for SSE 4.1 capable architectures
+#  endif
+#else
+
+#  include <emmintrin.h>
+#  include <smmintrin.h>
+#  include "threshold.h"
+
+namespace tesseract {
+
+// Stores the indices of the values greater than threshold and returns their
+// number. Compares 8 values at a time, and only looks at the single values
+// of a group if any of them is above the threshold.
+int IndicesAboveSSE(const float *values, int n, float threshold, int *indices) {
+  __m128 limit = _mm_set1_ps(threshold);
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128 above0 = _mm_cmpgt_ps(_mm_loadu_ps(values + i), limit);
+    __m128 above1 = _mm_cmpgt_ps(_mm_loadu_ps(values + i + 4), limit);
+    int mask = _mm_movemask_ps(above0) | _mm_movemask_ps(above1) << 4;
+    for (int j = i; mask != 0; ++j, mask >>= 1) {
+      if (mask & 1) {
+        indices[count++] = j;
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    if (values[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+} // namespace tesseract.
+
+#endif
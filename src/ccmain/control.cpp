@@ -205,6 +205,12 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC *monitor, PAGE_RES_IT
   // added. The results will be significantly different with adaption on, and
   // deterioration will need investigation.
   pr_it->restart_page();
+  if (lstm_recognizer_ != nullptr) {
+    lstm_recognizer_->SetNumThreads(lstm_gate_threads);
+  }
+  if (pass_n == 1 && tessedit_ocr_engine_mode == OEM_LSTM_ONLY) {
+    LSTMRecognizeWordsBatched(monitor, words);
+  }
   for (unsigned w = 0; w < words->size(); ++w) {
     WordData *word = &(*words)[w];
     if (w > 0) {
@@ -1397,7 +1403,7 @@ void Tesseract::classify_word_pass1(const WordData &word_data, WERD_RES **in_wor
       tessedit_ocr_engine_mode == OEM_TESSERACT_LSTM_COMBINED) {
 #endif // def DISABLED_LEGACY_ENGINE
     if (!(*in_word)->odd_size || tessedit_ocr_engine_mode == OEM_LSTM_ONLY) {
-      LSTMRecognizeWord(*block, row, *in_word, out_words);
+      LSTMRecognizeWord(*block, row, *in_word, out_words, word_data.lstm_outputs.get());
       if (!out_words->empty()) {
         return; // Successful lstm recognition.
       }
@@ -22,9 +22,13 @@
 #include "lstmrecognizer.h"
 #include "pageres.h"
 #include "recodebeam.h"
+#include "threadpool.h"
 #include "tprintf.h"
 
+#include <tesseract/ocrclass.h> // for ETEXT_DESC
+
 #include <algorithm>
+#include <memory>
 
 namespace tesseract {
 
@@ -224,10 +228,18 @@ ImageData *Tesseract::GetRectImage(const TBOX &box, const BLOCK &block, int padd
   return new ImageData(vertical_text, box_pix);
 }
 
-// Recognizes a word or group of words, converting to WERD_RES in *words.
-// Analogous to classify_word_pass1, but can handle a group of words as well.
-void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
-                                  PointerVector<WERD_RES> *words) {
+// Words of a line, recognized in advance by LSTMRecognizeWordsBatched.
+struct LSTMWordOutputs {
+  // The Tesseract whose lstm_recognizer_, or one of its workers, recognized
+  // the words. Reset to nullptr when LSTMRecognizeWord takes the words.
+  const Tesseract *tesseract = nullptr;
+  // The recognized words, ready for SearchWords.
+  PointerVector<WERD_RES> words;
+};
+
+// Returns the box of the image to use for LSTM recognition of the word,
+// extended to cover the ascenders and descenders of the row.
+TBOX Tesseract::LSTMWordBox(ROW *row, const WERD_RES *word) const {
   TBOX word_box = word->word->bounding_box();
   // Get the word image - no frills.
   if (tessedit_pageseg_mode == PSM_SINGLE_WORD || tessedit_pageseg_mode == PSM_RAW_LINE) {
@@ -243,6 +255,26 @@ void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
       word_box.set_top(baseline + row->x_height() + row->ascenders());
     }
   }
+  return word_box;
+}
+
+// Recognizes a word or group of words, converting to WERD_RES in *words.
+// Analogous to classify_word_pass1, but can handle a group of words as well.
+void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
+                                  PointerVector<WERD_RES> *words,
+                                  LSTMWordOutputs *precomputed) {
+  if (precomputed != nullptr && precomputed->tesseract == this) {
+    // Take ownership of the words recognized in advance.
+    for (unsigned w = 0; w < precomputed->words.size(); ++w) {
+      words->push_back(precomputed->words[w]);
+      precomputed->words[w] = nullptr;
+    }
+    precomputed->words.clear();
+    precomputed->tesseract = nullptr;
+    SearchWords(words);
+    return;
+  }
+  TBOX word_box = LSTMWordBox(row, word);
   ImageData *im_data = GetRectImage(word_box, block, kImagePadding, &word_box);
   if (im_data == nullptr) {
     return;
@@ -257,6 +289,119 @@ void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
   SearchWords(words);
 }
 
+// Recognizes the words in batches of lstm_batch_size lines, spread over
+// lstm_num_threads threads, storing the words in the lstm_outputs of each
+// WordData.
+// The words are sorted by width, so each batch holds lines of similar width,
+// and little work is wasted on padding. The widest batches are started first,
+// so the threads finish at about the same time. Each thread has its own
+// LSTMRecognizer, and the results of each line go to its own WordData, so they
+// do not depend on the number of threads or the order of the work. Words that
+// need the inversion test are left for LSTMRecognizeWord to run again, so the
+// results are the same as recognizing the words one by one.
+void Tesseract::LSTMRecognizeWordsBatched(ETEXT_DESC *monitor, std::vector<WordData> *words) {
+  if (lstm_recognizer_ == nullptr || (lstm_batch_size <= 1 && lstm_num_threads <= 1) ||
+      classify_debug_level > 0) {
+    return;
+  }
+  int num_threads = SetupLSTMWorkers();
+  std::vector<unsigned> order;
+  std::vector<TBOX> word_boxes(words->size());
+  for (unsigned w = 0; w < words->size(); ++w) {
+    const WordData &word = (*words)[w];
+    if (word.word->tess_failed) {
+      continue;
+    }
+    word_boxes[w] = LSTMWordBox(word.row, word.word);
+    order.push_back(w);
+  }
+  std::stable_sort(order.begin(), order.end(), [&word_boxes](unsigned a, unsigned b) {
+    return word_boxes[a].width() < word_boxes[b].width();
+  });
+  unsigned batch_size = std::max(1, static_cast<int>(lstm_batch_size));
+  int num_batches = (order.size() + batch_size - 1) / batch_size;
+  float threshold = tessedit_do_invert ? static_cast<float>(invert_threshold) : 0.0f;
+  double worst_dict_cert = kWorstDictCertainty / kCertaintyScale;
+  auto recognize_batch = [&](int batch, int thread) {
+    if (monitor != nullptr && monitor->deadline_exceeded()) {
+      // Leave the rest to RecogAllWordsPassN, which handles the timeout.
+      return;
+    }
+    LSTMRecognizer *recognizer = thread == 0 ? lstm_recognizer_ : lstm_workers_[thread - 1];
+    unsigned start = (num_batches - 1 - batch) * batch_size;
+    unsigned end = std::min(start + batch_size, static_cast<unsigned>(order.size()));
+    std::vector<const ImageData *> images;
+    std::vector<unsigned> batch_words;
+    for (unsigned i = start; i < end; ++i) {
+      unsigned w = order[i];
+      const WordData &word = (*words)[w];
+      ImageData *im_data =
+          GetRectImage(word_boxes[w], *word.block, kImagePadding, &word_boxes[w]);
+      if (im_data != nullptr) {
+        images.push_back(im_data);
+        batch_words.push_back(w);
+      }
+    }
+    std::vector<float> scale_factors;
+    std::vector<NetworkIO> outputs;
+    recognizer->RecognizeLines(images, &scale_factors, &outputs);
+    for (unsigned i = 0; i < images.size(); ++i) {
+      delete images[i];
+      if (outputs[i].Width() == 0) {
+        continue;
+      }
+      if (threshold > 0.0f) {
+        float min_output, mean_output, sd;
+        recognizer->OutputStats(outputs[i], &min_output, &mean_output, &sd);
+        if (mean_output < threshold) {
+          // Needs the inversion test.
+          continue;
+        }
+      }
+      unsigned w = batch_words[i];
+      auto lstm_outputs = std::make_shared<LSTMWordOutputs>();
+      recognizer->DecodeLine(outputs[i], scale_factors[i], false, worst_dict_cert, word_boxes[w],
+                             &lstm_outputs->words, lstm_choice_mode, lstm_choice_iterations);
+      lstm_outputs->tesseract = this;
+      (*words)[w].lstm_outputs = std::move(lstm_outputs);
+    }
+  };
+  if (num_threads > 1) {
+    lstm_pool_->ParallelFor(num_batches, recognize_batch);
+  } else {
+    for (int batch = 0; batch < num_batches; ++batch) {
+      recognize_batch(batch, 0);
+    }
+  }
+}
+
+// Makes sure that there is a thread pool and an LSTMRecognizer worker for each
+// of lstm_num_threads threads, and returns the number of threads available.
+int Tesseract::SetupLSTMWorkers() {
+  int num_threads = std::max(1, static_cast<int>(lstm_num_threads));
+  if (lstm_pool_ != nullptr && lstm_pool_->num_threads() == num_threads) {
+    return num_threads;
+  }
+  delete lstm_pool_;
+  lstm_pool_ = nullptr;
+  while (lstm_workers_.size() > static_cast<unsigned>(num_threads - 1)) {
+    delete lstm_workers_.back();
+    lstm_workers_.pop_back();
+  }
+  while (lstm_workers_.size() < static_cast<unsigned>(num_threads - 1)) {
+    LSTMRecognizer *worker = lstm_recognizer_->NewWorker();
+    if (worker == nullptr) {
+      tprintf("Failed to make LSTM workers, using 1 thread\n");
+      return 1;
+    }
+    lstm_workers_.push_back(worker);
+  }
+  if (num_threads > 1) {
+    lstm_pool_ = new ThreadPool(num_threads);
+  }
+  return num_threads;
+}
+
 // Apply segmentation search to the given set of words, within the constraints
 // of the existing ratings matrix. If there is already a best_choice on a word
 // leaves it untouched and just sets the done/accepted etc flags.
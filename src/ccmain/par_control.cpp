@@ -17,12 +17,13 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "tesseractclass.h"
-#ifdef _OPENMP
-#  include <omp.h>
-#endif // _OPENMP
+#include "threadpool.h" // for ThreadPool
 
 namespace tesseract {
 
+// Number of threads used by PrerecAllWordsPar if tessedit_parallelize > 1.
+static const int kNumPrerecThreads = 10;
+
 struct BlobData {
   BlobData() = default;
   BlobData(int index, Tesseract *tess, const WERD_RES &word)
@@ -49,20 +50,21 @@ void Tesseract::PrerecAllWordsPar(const std::vector<WordData> &words) {
       }
     }
   }
-  // Pre-classify all the blobs.
-  if (tessedit_parallelize > 1) {
-#ifdef _OPENMP
-#  pragma omp parallel for num_threads(10)
-#endif // _OPENMP
-    // NOLINTNEXTLINE(modernize-loop-convert)
-    for (size_t b = 0; b < blobs.size(); ++b) {
-      *blobs[b].choices =
-          blobs[b].tesseract->classify_blob(blobs[b].blob, "par", ScrollView::WHITE, nullptr);
+  // Pre-classify all the blobs. The classifier only reads the templates
+  // here, and each blob has its own cell in the ratings matrix, so the
+  // results do not depend on the number of threads.
+  auto classify = [&blobs](int b, int) {
+    *blobs[b].choices =
+        blobs[b].tesseract->classify_blob(blobs[b].blob, "par", ScrollView::WHITE, nullptr);
+  };
+  if (tessedit_parallelize > 1 && blobs.size() > 1) {
+    if (prerec_pool_ == nullptr) {
+      prerec_pool_ = new ThreadPool(kNumPrerecThreads);
     }
+    prerec_pool_->ParallelFor(static_cast<int>(blobs.size()), classify);
   } else {
-    // TODO(AMD) parallelize this.
-    for (auto &blob : blobs) {
-      *blob.choices = blob.tesseract->classify_blob(blob.blob, "par", ScrollView::WHITE, nullptr);
+    for (unsigned b = 0; b < blobs.size(); ++b) {
+      classify(b, 0);
     }
   }
 }
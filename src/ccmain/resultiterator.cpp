@@ -38,8 +38,7 @@ ResultIterator::ResultIterator(const LTRResultIterator &resit) : LTRResultIterat
   at_beginning_of_minor_run_ = false;
   preserve_interword_spaces_ = false;
 
-  auto *p = ParamUtils::FindParam<BoolParam>(
-      "preserve_interword_spaces", GlobalParams()->bool_params, tesseract_->params()->bool_params);
+  auto *p = ParamUtils::FindParam<BoolParam>("preserve_interword_spaces", tesseract_->params());
   if (p != nullptr) {
     preserve_interword_spaces_ = static_cast<bool>(*p);
   }
@@ -776,8 +775,7 @@ void ResultIterator::AppendUTF8ParagraphText(std::string *text) const {
 
 bool ResultIterator::BidiDebug(int min_level) const {
   int debug_level = 1;
-  auto *p = ParamUtils::FindParam<IntParam>("bidi_debug", GlobalParams()->int_params,
-                                            tesseract_->params()->int_params);
+  auto *p = ParamUtils::FindParam<IntParam>("bidi_debug", tesseract_->params());
   if (p != nullptr) {
     debug_level = static_cast<int32_t>(*p);
   }
@@ -46,6 +46,7 @@
 #endif
 #include "image.h"       // for Image
 #include "lstmrecognizer.h"
+#include "threadpool.h"  // for ThreadPool
 #include "thresholder.h" // for ThresholdMethod
 
 namespace tesseract {
@@ -388,6 +389,12 @@ Tesseract::Tesseract()
     , BOOL_MEMBER(tessedit_create_boxfile, false, "Output text with boxes", this->params())
     , INT_MEMBER(tessedit_page_number, -1, "-1 -> All pages, else specific page to process",
                  this->params())
+    , INT_MEMBER(page_num_threads, 1,
+                 "Number of pages of a multipage TIFF or an image list to "
+                 "recognize concurrently, each on its own copy of the engine, "
+                 "sharing the loaded models. The output still gets the pages "
+                 "in order. 1 recognizes one page after the other.",
+                 this->params())
     , BOOL_MEMBER(tessedit_write_images, false, "Capture the image from the IPE", this->params())
     , BOOL_MEMBER(interactive_display_mode, false, "Run interactively?", this->params())
     , STRING_MEMBER(file_type, ".tif", "Filename extension", this->params())
@@ -439,6 +446,24 @@ Tesseract::Tesseract()
                  "lstm_choice_mode. Note that lstm_choice_mode must be set to a "
                  "value greater than 0 to produce results.",
                  this->params())
+    , INT_MEMBER(lstm_batch_size, 1,
+                 "Number of text lines to run through the LSTM network together "
+                 "in a single batch in the first recognition pass. Values above "
+                 "1 reuse the network weights across lines, at the cost of "
+                 "memory for the batch. 1 recognizes one line at a time.",
+                 this->params())
+    , INT_MEMBER(lstm_num_threads, 1,
+                 "Number of threads to recognize the text lines of a page with "
+                 "in the first recognition pass, each with its own copy of the "
+                 "LSTM network state, sharing the weights. 1 recognizes the "
+                 "lines on the calling thread only.",
+                 this->params())
+    , INT_MEMBER(lstm_gate_threads, 1,
+                 "Number of threads that share the gate computations of each "
+                 "timestep of the LSTM layers. Helps the latency of large "
+                 "models on single lines. 1 computes the gates on the calling "
+                 "thread only.",
+                 this->params())
     , double_MEMBER(lstm_rating_coefficient, 5,
                     "Sets the rating coefficient for the lstm choices. The smaller the "
                     "coefficient, the better are the ratings for each choice and less "
@@ -466,6 +491,8 @@ Tesseract::Tesseract()
     , equ_detect_(nullptr)
 #endif // ndef DISABLED_LEGACY_ENGINE
     , lstm_recognizer_(nullptr)
+    , lstm_pool_(nullptr)
+    , prerec_pool_(nullptr)
     , train_line_page_num_(0) {}
 
 Tesseract::~Tesseract() {
@@ -475,6 +502,15 @@ Tesseract::~Tesseract() {
   for (auto *lang : sub_langs_) {
     delete lang;
   }
+  delete lstm_pool_;
+  lstm_pool_ = nullptr;
+  // The workers use the model of lstm_recognizer_, so must be deleted first.
+  for (auto *worker : lstm_workers_) {
+    delete worker;
+  }
+  lstm_workers_.clear();
+  delete prerec_pool_;
+  prerec_pool_ = nullptr;
   delete lstm_recognizer_;
   lstm_recognizer_ = nullptr;
 }
@@ -498,6 +534,9 @@ void Tesseract::Clear() {
   reskew_ = FCOORD(1.0f, 0.0f);
   gradient_ = 0.0f;
   splitter_.Clear();
+#ifndef DISABLED_LEGACY_ENGINE
+  ResetMatchCache();
+#endif
   for (auto &sub_lang : sub_langs_) {
     sub_lang->Clear();
   }
@@ -50,6 +50,7 @@
 
 #include <cstdint> // for int16_t, int32_t, uint16_t
 #include <cstdio>  // for FILE
+#include <memory>  // for std::shared_ptr
 
 namespace tesseract {
 
@@ -58,6 +59,7 @@ class ETEXT_DESC;
 struct OSResults;
 class PAGE_RES;
 class PAGE_RES_IT;
+struct LSTMWordOutputs;
 class ROW;
 class SVMenuNode;
 class TBOX;
@@ -74,6 +76,7 @@ class EquationDetect;
 class ImageData;
 class LSTMRecognizer;
 class Tesseract;
+class ThreadPool;
 
 // Top-level class for all tesseract global instance data.
 // This class either holds or points to all data used by an instance
@@ -162,6 +165,8 @@ struct WordData {
   BLOCK *block;
   WordData *prev_word;
   PointerVector<WERD_RES> lang_words;
+  // LSTM results computed in advance by LSTMRecognizeWordsBatched, if any.
+  std::shared_ptr<LSTMWordOutputs> lstm_outputs;
 };
 
 // Definition of a Tesseract WordRecognizer. The WordData provides the context
@@ -327,6 +332,8 @@ public:
                                                  TO_BLOCK_LIST *to_blocks, Image *photo_mask_pix,
                                                  Image *music_mask_pix);
   // par_control.cpp
+  // Classifies the unchopped blobs of words into the diagonals of their
+  // ratings matrices, on a thread pool if tessedit_parallelize > 1.
   void PrerecAllWordsPar(const std::vector<WordData> &words);
 
   //// linerec.cpp
@@ -356,10 +363,25 @@ public:
   // is also returned to enable calculation of output bounding boxes.
   ImageData *GetRectImage(const TBOX &box, const BLOCK &block, int padding,
                           TBOX *revised_box) const;
+  // Returns the box of the image to use for LSTM recognition of the word,
+  // extended to cover the ascenders and descenders of the row.
+  TBOX LSTMWordBox(ROW *row, const WERD_RES *word) const;
   // Recognizes a word or group of words, converting to WERD_RES in *words.
   // Analogous to classify_word_pass1, but can handle a group of words as well.
+  // If precomputed is not null and was computed by this, its words are taken
+  // instead of recognizing the word again.
   void LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
-                         PointerVector<WERD_RES> *words);
+                         PointerVector<WERD_RES> *words,
+                         LSTMWordOutputs *precomputed = nullptr);
+  // Recognizes the words in batches of lstm_batch_size lines, spread over
+  // lstm_num_threads threads, storing the results in the lstm_outputs of each
+  // WordData, ready for LSTMRecognizeWord to take.
+  void LSTMRecognizeWordsBatched(ETEXT_DESC *monitor, std::vector<WordData> *words);
+  // Makes sure that there is a thread pool and an LSTMRecognizer worker for
+  // each of lstm_num_threads threads, and returns the number of threads
+  // available, which is 1 if lstm_num_threads is 1 or the workers could not
+  // be made.
+  int SetupLSTMWorkers();
   // Apply segmentation search to the given set of words, within the constraints
   // of the existing ratings matrix. If there is already a best_choice on a word
   // leaves it untouched and just sets the done/accepted etc flags.
@@ -931,6 +953,7 @@ public:
   INT_VAR_H(min_sane_x_ht_pixels);
   BOOL_VAR_H(tessedit_create_boxfile);
   INT_VAR_H(tessedit_page_number);
+  INT_VAR_H(page_num_threads);
   BOOL_VAR_H(tessedit_write_images);
   BOOL_VAR_H(interactive_display_mode);
   STRING_VAR_H(file_type);
@@ -956,6 +979,9 @@ public:
   STRING_VAR_H(page_separator);
   INT_VAR_H(lstm_choice_mode);
   INT_VAR_H(lstm_choice_iterations);
+  INT_VAR_H(lstm_batch_size);
+  INT_VAR_H(lstm_num_threads);
+  INT_VAR_H(lstm_gate_threads);
   double_VAR_H(lstm_rating_coefficient);
   BOOL_VAR_H(pageseg_apply_music_mask);
 
@@ -1010,6 +1036,13 @@ private:
 #endif // ndef DISABLED_LEGACY_ENGINE
   // LSTM recognizer, if available.
   LSTMRecognizer *lstm_recognizer_;
+  // Thread pool for recognizing lines in parallel, with lstm_num_threads
+  // threads, or nullptr. Thread t > 0 uses lstm_workers_[t - 1] in place of
+  // lstm_recognizer_.
+  ThreadPool *lstm_pool_;
+  std::vector<LSTMRecognizer *> lstm_workers_;
+  // Thread pool for pre-classifying blobs in PrerecAllWordsPar, or nullptr.
+  ThreadPool *prerec_pool_;
   // Output "page" number (actually line number) using TrainLineRecognizer.
   int train_line_page_num_;
 };
@@ -37,6 +37,7 @@ namespace tesseract {
 
 ImageThresholder::ImageThresholder()
     : pix_(nullptr)
+    , pix_grey_(nullptr)
     , image_width_(0)
     , image_height_(0)
     , pix_channels_(0)
@@ -54,6 +55,7 @@ ImageThresholder::~ImageThresholder() {
 // Destroy the Pix if there is one, freeing memory.
 void ImageThresholder::Clear() {
   pix_.destroy();
+  pix_grey_.destroy();
 }
 
 // Return true if no image has been set.
@@ -157,9 +159,7 @@ void ImageThresholder::GetImageSizes(int *left, int *top, int *width, int *heigh
 // immediately after, but may not go away until after the Thresholder has
 // finished with it.
 void ImageThresholder::SetImage(const Image pix) {
-  if (pix_ != nullptr) {
-    pix_.destroy();
-  }
+  Clear();
   Image src = pix;
   int depth;
   pixGetDimensions(src, &image_width_, &image_height_, &depth);
@@ -179,6 +179,21 @@ void ImageThresholder::SetImage(const Image pix) {
   Init();
 }
 
+// SetBinarizedImage takes over the references to binary and grey without
+// copying or converting them. binary must be 1 bpp, and grey, if not nullptr,
+// must be 8 bpp without colormap and the same size as binary.
+void ImageThresholder::SetBinarizedImage(Image binary, Image grey) {
+  Clear();
+  pix_ = binary;
+  pix_grey_ = grey;
+  pixGetDimensions(pix_, &image_width_, &image_height_, nullptr);
+  pix_channels_ = 0;
+  pix_wpl_ = pixGetWpl(pix_);
+  scale_ = 1;
+  estimated_res_ = yres_ = pixGetYRes(pix_);
+  Init();
+}
+
 std::tuple<bool, Image, Image, Image> ImageThresholder::Threshold(
                                                       TessBaseAPI *api,
                                                       ThresholdMethod method) {
@@ -191,7 +206,8 @@ std::tuple<bool, Image, Image, Image> ImageThresholder::Threshold(
     Image original = GetPixRect();
     pix_binary = original.copy();
     original.destroy();
-    return std::make_tuple(true, nullptr, pix_binary, nullptr);
+    Image pix_grey = HasGreyImage() ? GetPixRectGrey() : nullptr;
+    return std::make_tuple(true, pix_grey, pix_binary, nullptr);
   }
 
   auto pix_grey = GetPixRectGrey();
@@ -359,6 +375,16 @@ Image ImageThresholder::GetPixRect() {
 // The returned Pix must be pixDestroyed.
 // Provided to the classifier to extract features from the greyscale image.
 Image ImageThresholder::GetPixRectGrey() {
+  if (pix_grey_ != nullptr) {
+    // Use the grey image of SetBinarizedImage as it is.
+    if (IsFullImage()) {
+      return pix_grey_.clone();
+    }
+    Box *box = boxCreate(rect_left_, rect_top_, rect_width_, rect_height_);
+    Image cropped = pixClipRectangle(pix_grey_, box, nullptr);
+    boxDestroy(&box);
+    return cropped;
+  }
   auto pix = GetPixRect(); // May have to be reduced to grey.
   int depth = pixGetDepth(pix);
   if (depth != 8 || pixGetColormap(pix)) {
@@ -123,6 +123,17 @@ public:
   /// finished with it.
   void SetImage(const Image pix);
 
+  /// Takes over the caller's references to an already binarized 1 bpp image
+  /// and an optional 8 bpp grey image of the same size, which are used as
+  /// they are instead of thresholding. Neither image is copied or converted,
+  /// so the caller must not modify them while the thresholder holds them.
+  void SetBinarizedImage(Image binary, Image grey);
+
+  /// Returns true if a grey image was given with SetBinarizedImage.
+  bool HasGreyImage() const {
+    return pix_grey_ != nullptr;
+  }
+
   /// Threshold the source image as efficiently as possible to the output Pix.
   /// Creates a Pix and sets pix to point to the resulting pointer.
   /// Caller must use pixDestroy to free the created Pix.
@@ -181,6 +192,8 @@ protected:
   /// Clone or other copy of the source Pix.
   /// The pix will always be PixDestroy()ed on destruction of the class.
   Image pix_;
+  /// Grey image given with SetBinarizedImage, or nullptr.
+  Image pix_grey_;
 
   int image_width_;  ///< Width of source pix_.
   int image_height_; ///< Height of source pix_.
@@ -76,7 +76,7 @@ public:
     *this = src;
   }
   virtual ~GENERIC_2D_ARRAY() {
-    delete[] array_;
+    DeleteArray();
   }
 
   void operator=(const GENERIC_2D_ARRAY<T> &src) {
@@ -93,8 +93,8 @@ public:
   // access beyond the bounds of the array.
   void ResizeNoInit(int size1, int size2, int pad = 0) {
     int new_size = size1 * size2 + pad;
-    if (new_size > size_allocated_) {
-      delete[] array_;
+    if (new_size > size_allocated_ || external_) {
+      DeleteArray();
       array_ = new T[new_size];
       size_allocated_ = new_size;
     }
@@ -129,7 +129,7 @@ public:
           }
         }
       }
-      delete[] array_;
+      DeleteArray();
       array_ = new_array;
       dim1_ = size1;
       dim2_ = size2;
@@ -137,6 +137,15 @@ public:
     }
   }
 
+  // Frees the memory of the array, leaving it empty.
+  void Free() {
+    DeleteArray();
+    array_ = nullptr;
+    dim1_ = 0;
+    dim2_ = 0;
+    size_allocated_ = 0;
+  }
+
   // Sets all the elements of the array to the empty value.
   void Clear() {
     int total_size = num_elements();
@@ -198,6 +207,37 @@ public:
     return DeSerializeSize(fp) && fp->DeSerialize(&empty_) &&
            fp->DeSerialize(&array_[0], num_elements());
   }
+  // As DeSerialize, but if fp can provide the elements in place (see
+  // TFile::DeSerializeInPlace), the array uses them without a copy. They
+  // can't be changed, and the caller must keep fp->mapping() alive for as
+  // long as the array uses them. Resizing or freeing the array drops them.
+  bool DeSerializeInPlace(TFile *fp) {
+    int32_t size1, size2;
+    if (!fp->DeSerialize(&size1) || !fp->DeSerialize(&size2)) {
+      return false;
+    }
+    // Arbitrarily limit the number of elements to protect against bad data.
+    if (size1 < 0 || size1 > UINT16_MAX || size2 < 0 || size2 > UINT16_MAX) {
+      return false;
+    }
+    T empty;
+    if (!fp->DeSerialize(&empty)) {
+      return false;
+    }
+    const T *array = fp->DeSerializeInPlace<T>(size1 * size2);
+    if (array == nullptr) {
+      Resize(size1, size2, empty);
+      return fp->DeSerialize(&array_[0], num_elements());
+    }
+    DeleteArray();
+    array_ = const_cast<T *>(array);
+    external_ = true;
+    empty_ = empty;
+    dim1_ = size1;
+    dim2_ = size2;
+    size_allocated_ = size1 * size2;
+    return true;
+  }
 
   // Writes to the given file. Returns false in case of error.
   // Assumes a T::Serialize(FILE*) const function.
@@ -591,6 +631,18 @@ protected:
   // needed. If Resize is used, memory is retained so it can be re-expanded
   // without a further alloc, and this stores the allocated size.
   int size_allocated_;
+  // True if array_ is read-only memory owned elsewhere, see
+  // DeSerializeInPlace.
+  bool external_ = false;
+
+private:
+  // Deletes array_, unless it is external.
+  void DeleteArray() {
+    if (!external_) {
+      delete[] array_;
+    }
+    external_ = false;
+  }
 };
 
 // A generic class to store a banded triangular matrix with entries of type T.
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////
+// File:        mappedfile.cpp
+// Description: Read-only memory mapping of a whole file.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "mappedfile.h"
+
+#include <cstdint> // for SIZE_MAX
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>    // for open
+#  include <sys/mman.h> // for mmap, munmap
+#  include <sys/stat.h> // for fstat
+#  include <unistd.h>   // for close
+#endif
+
+namespace tesseract {
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_handle_);
+#else
+  munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<const MappedFile> MappedFile::Map(const char *filename) {
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 ||
+      static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  HANDLE mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  // The mapping object keeps the file open.
+  CloseHandle(file);
+  if (mapping_handle == nullptr) {
+    return nullptr;
+  }
+  void *data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping_handle);
+    return nullptr;
+  }
+  std::shared_ptr<MappedFile> mapped_file(new MappedFile);
+  mapped_file->data_ = static_cast<const char *>(data);
+  mapped_file->size_ = static_cast<size_t>(size.QuadPart);
+  mapped_file->mapping_handle_ = mapping_handle;
+  return mapped_file;
+}
+
+#else
+
+std::shared_ptr<const MappedFile> MappedFile::Map(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file open.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  std::shared_ptr<MappedFile> mapped_file(new MappedFile);
+  mapped_file->data_ = static_cast<const char *>(data);
+  mapped_file->size_ = size;
+  return mapped_file;
+}
+
+#endif
+
+} // namespace tesseract.
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////
+// File:        mappedfile.h
+// Description: Read-only memory mapping of a whole file.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_MAPPEDFILE_H_
+#define TESSERACT_CCUTIL_MAPPEDFILE_H_
+
+#include <cstddef> // for size_t
+#include <memory>  // for std::shared_ptr
+
+#include <tesseract/export.h>
+
+namespace tesseract {
+
+// A whole file mapped read-only into memory. The pages of the file are
+// loaded on demand and are shared with all the other processes that map the
+// same file, so data that is used in place costs no private memory.
+// The file must not be changed while it is mapped.
+// Mappings are shared with std::shared_ptr, so anything that uses data in
+// place can keep the mapping alive for as long as it needs the data.
+class TESS_API MappedFile {
+public:
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps the given file. Returns nullptr if the file can't be mapped, eg
+  // because it doesn't exist, is empty or isn't a regular file.
+  static std::shared_ptr<const MappedFile> Map(const char *filename);
+
+  const char *data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+private:
+  MappedFile() = default;
+
+  // The start of the mapping.
+  const char *data_ = nullptr;
+  // The size of the file and the mapping.
+  size_t size_ = 0;
+#ifdef _WIN32
+  // The handle of the file mapping object.
+  void *mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace tesseract.
+
+#endif // TESSERACT_CCUTIL_MAPPEDFILE_H_
@@ -81,8 +81,7 @@ bool ParamUtils::ReadParamsFromFp(SetParamConstraint constraint, TFile *fp,
 bool ParamUtils::SetParam(const char *name, const char *value, SetParamConstraint constraint,
                           ParamsVectors *member_params) {
   // Look for the parameter among string parameters.
-  auto *sp =
-      FindParam<StringParam>(name, GlobalParams()->string_params, member_params->string_params);
+  auto *sp = FindParam<StringParam>(name, member_params);
   if (sp != nullptr && sp->constraint_ok(constraint)) {
     sp->set_value(value);
   }
@@ -91,7 +90,7 @@ bool ParamUtils::SetParam(const char *name, const char *value, SetParamConstrain
   }
 
   // Look for the parameter among int parameters.
-  auto *ip = FindParam<IntParam>(name, GlobalParams()->int_params, member_params->int_params);
+  auto *ip = FindParam<IntParam>(name, member_params);
   if (ip && ip->constraint_ok(constraint)) {
     int intval = INT_MIN;
     std::stringstream stream(value);
@@ -103,7 +102,7 @@ bool ParamUtils::SetParam(const char *name, const char *value, SetParamConstrain
   }
 
   // Look for the parameter among bool parameters.
-  auto *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params, member_params->bool_params);
+  auto *bp = FindParam<BoolParam>(name, member_params);
   if (bp != nullptr && bp->constraint_ok(constraint)) {
     if (*value == 'T' || *value == 't' || *value == 'Y' || *value == 'y' || *value == '1') {
       bp->set_value(true);
@@ -113,8 +112,7 @@ bool ParamUtils::SetParam(const char *name, const char *value, SetParamConstrain
   }
 
   // Look for the parameter among double parameters.
-  auto *dp =
-      FindParam<DoubleParam>(name, GlobalParams()->double_params, member_params->double_params);
+  auto *dp = FindParam<DoubleParam>(name, member_params);
   if (dp != nullptr && dp->constraint_ok(constraint)) {
     double doubleval = NAN;
     std::stringstream stream(value);
@@ -130,27 +128,25 @@ bool ParamUtils::SetParam(const char *name, const char *value, SetParamConstrain
 bool ParamUtils::GetParamAsString(const char *name, const ParamsVectors *member_params,
                                   std::string *value) {
   // Look for the parameter among string parameters.
-  auto *sp =
-      FindParam<StringParam>(name, GlobalParams()->string_params, member_params->string_params);
+  auto *sp = FindParam<StringParam>(name, member_params);
   if (sp) {
     *value = sp->c_str();
     return true;
   }
   // Look for the parameter among int parameters.
-  auto *ip = FindParam<IntParam>(name, GlobalParams()->int_params, member_params->int_params);
+  auto *ip = FindParam<IntParam>(name, member_params);
   if (ip) {
     *value = std::to_string(int32_t(*ip));
     return true;
   }
   // Look for the parameter among bool parameters.
-  auto *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params, member_params->bool_params);
+  auto *bp = FindParam<BoolParam>(name, member_params);
   if (bp != nullptr) {
     *value = bool(*bp) ? "1" : "0";
     return true;
   }
   // Look for the parameter among double parameters.
-  auto *dp =
-      FindParam<DoubleParam>(name, GlobalParams()->double_params, member_params->double_params);
+  auto *dp = FindParam<DoubleParam>(name, member_params);
   if (dp != nullptr) {
     std::ostringstream stream;
     stream.imbue(std::locale::classic());
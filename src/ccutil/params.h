@@ -25,6 +25,8 @@
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace tesseract {
@@ -43,13 +45,89 @@ enum SetParamConstraint {
   SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
 };
 
+// Hashed index of the params of one type in a ParamsVectors by name, so
+// they can be found without comparing the name with every param. The params
+// add and remove themselves when they are constructed and destroyed.
+template <class T>
+class ParamIndex {
+public:
+  // Returns the param with the given name, or nullptr if there is none. If
+  // several have the same name, returns the first one that was added, like
+  // a search of the vector of params.
+  T *Find(const char *name) const {
+    auto it = index_.find(name);
+    return it != index_.end() ? it->second : nullptr;
+  }
+  // Adds the param, unless there already is one of the same name.
+  void Add(T *param) {
+    index_.emplace(param->name_str(), param);
+  }
+  // Removes the param, which has already been removed from params, and
+  // replaces it with the next one of the same name in params, if any.
+  void Remove(T *param, const std::vector<T *> &params) {
+    auto it = index_.find(param->name_str());
+    if (it == index_.end() || it->second != param) {
+      return;
+    }
+    index_.erase(it);
+    for (auto *other : params) {
+      if (strcmp(other->name_str(), param->name_str()) == 0) {
+        Add(other);
+        break;
+      }
+    }
+  }
+
+private:
+  // The keys point to the names of the params, which outlive their entries.
+  std::unordered_map<std::string_view, T *> index_;
+};
+
 struct ParamsVectors {
   std::vector<IntParam *> int_params;
   std::vector<BoolParam *> bool_params;
   std::vector<StringParam *> string_params;
   std::vector<DoubleParam *> double_params;
+  // The indexes of the params above.
+  ParamIndex<IntParam> int_index;
+  ParamIndex<BoolParam> bool_index;
+  ParamIndex<StringParam> string_index;
+  ParamIndex<DoubleParam> double_index;
+
+  // Returns the index of the params of type T.
+  template <class T>
+  const ParamIndex<T> &index() const;
 };
 
+template <>
+inline const ParamIndex<IntParam> &ParamsVectors::index<IntParam>() const {
+  return int_index;
+}
+template <>
+inline const ParamIndex<BoolParam> &ParamsVectors::index<BoolParam>() const {
+  return bool_index;
+}
+template <>
+inline const ParamIndex<StringParam> &ParamsVectors::index<StringParam>() const {
+  return string_index;
+}
+template <>
+inline const ParamIndex<DoubleParam> &ParamsVectors::index<DoubleParam>() const {
+  return double_index;
+}
+
+// Global parameter lists.
+//
+// To avoid the problem of undetermined order of static initialization
+// global_params are accessed through the GlobalParams function that
+// initializes the static pointer to global_params only on the first time
+// GlobalParams() is called.
+//
+// TODO(daria): remove GlobalParams() when all global Tesseract
+// parameters are converted to members.
+TESS_API
+ParamsVectors *GlobalParams();
+
 // Utility functions for working with Tesseract parameters.
 class TESS_API ParamUtils {
 public:
@@ -87,6 +165,18 @@ public:
     }
     return nullptr;
   }
+  // Returns the pointer to the parameter with the given name (of the
+  // appropriate type) if it was found in GlobalParams() or in the given
+  // member_params, which may be nullptr. Uses the indexes of the params, so
+  // it doesn't have to compare the name with every param.
+  template <class T>
+  static T *FindParam(const char *name, const ParamsVectors *member_params) {
+    T *param = GlobalParams()->index<T>().Find(name);
+    if (param == nullptr && member_params != nullptr) {
+      param = member_params->index<T>().Find(name);
+    }
+    return param;
+  }
   // Removes the given pointer to the param from the given vector.
   template <class T>
   static void RemoveParam(T *param_ptr, std::vector<T *> *vec) {
@@ -153,9 +243,12 @@ public:
     default_ = value;
     params_vec_ = &(vec->int_params);
     vec->int_params.push_back(this);
+    params_index_ = &(vec->int_index);
+    params_index_->Add(this);
   }
   ~IntParam() {
     ParamUtils::RemoveParam<IntParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
   operator int32_t() const {
     return value_;
@@ -170,13 +263,9 @@ public:
     value_ = default_;
   }
   void ResetFrom(const ParamsVectors *vec) {
-    for (auto *param : vec->int_params) {
-      if (strcmp(param->name_str(), name_) == 0) {
-        // printf("overriding param %s=%d by =%d\n", name_, value_,
-        // param);
-        value_ = *param;
-        break;
-      }
+    auto *param = vec->int_index.Find(name_);
+    if (param != nullptr) {
+      value_ = *param;
     }
   }
 
@@ -185,6 +274,8 @@ private:
   int32_t default_;
   // Pointer to the vector that contains this param (not owned by this class).
   std::vector<IntParam *> *params_vec_;
+  // Pointer to the index that contains this param (not owned by this class).
+  ParamIndex<IntParam> *params_index_;
 };
 
 class BoolParam : public Param {
@@ -195,9 +286,12 @@ public:
     default_ = value;
     params_vec_ = &(vec->bool_params);
     vec->bool_params.push_back(this);
+    params_index_ = &(vec->bool_index);
+    params_index_->Add(this);
   }
   ~BoolParam() {
     ParamUtils::RemoveParam<BoolParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
   operator bool() const {
     return value_;
@@ -212,13 +306,9 @@ public:
     value_ = default_;
   }
   void ResetFrom(const ParamsVectors *vec) {
-    for (auto *param : vec->bool_params) {
-      if (strcmp(param->name_str(), name_) == 0) {
-        // printf("overriding param %s=%s by =%s\n", name_, value_ ? "true" :
-        // "false", *param ? "true" : "false");
-        value_ = *param;
-        break;
-      }
+    auto *param = vec->bool_index.Find(name_);
+    if (param != nullptr) {
+      value_ = *param;
     }
   }
 
@@ -227,6 +317,8 @@ private:
   bool default_;
   // Pointer to the vector that contains this param (not owned by this class).
   std::vector<BoolParam *> *params_vec_;
+  // Pointer to the index that contains this param (not owned by this class).
+  ParamIndex<BoolParam> *params_index_;
 };
 
 class StringParam : public Param {
@@ -238,9 +330,12 @@ public:
     default_ = value;
     params_vec_ = &(vec->string_params);
     vec->string_params.push_back(this);
+    params_index_ = &(vec->string_index);
+    params_index_->Add(this);
   }
   ~StringParam() {
     ParamUtils::RemoveParam<StringParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
   operator std::string &() {
     return value_;
@@ -267,13 +362,9 @@ public:
     value_ = default_;
   }
   void ResetFrom(const ParamsVectors *vec) {
-    for (auto *param : vec->string_params) {
-      if (strcmp(param->name_str(), name_) == 0) {
-        // printf("overriding param %s=%s by =%s\n", name_, value_,
-        // param->c_str());
-        value_ = *param;
-        break;
-      }
+    auto *param = vec->string_index.Find(name_);
+    if (param != nullptr) {
+      value_ = *param;
     }
   }
 
@@ -282,6 +373,8 @@ private:
   std::string default_;
   // Pointer to the vector that contains this param (not owned by this class).
   std::vector<StringParam *> *params_vec_;
+  // Pointer to the index that contains this param (not owned by this class).
+  ParamIndex<StringParam> *params_index_;
 };
 
 class DoubleParam : public Param {
@@ -292,9 +385,12 @@ public:
     default_ = value;
     params_vec_ = &(vec->double_params);
     vec->double_params.push_back(this);
+    params_index_ = &(vec->double_index);
+    params_index_->Add(this);
   }
   ~DoubleParam() {
     ParamUtils::RemoveParam<DoubleParam>(this, params_vec_);
+    params_index_->Remove(this, *params_vec_);
   }
   operator double() const {
     return value_;
@@ -309,13 +405,9 @@ public:
     value_ = default_;
   }
   void ResetFrom(const ParamsVectors *vec) {
-    for (auto *param : vec->double_params) {
-      if (strcmp(param->name_str(), name_) == 0) {
-        // printf("overriding param %s=%f by =%f\n", name_, value_,
-        // *param);
-        value_ = *param;
-        break;
-      }
+    auto *param = vec->double_index.Find(name_);
+    if (param != nullptr) {
+      value_ = *param;
     }
   }
 
@@ -324,20 +416,10 @@ private:
   double default_;
   // Pointer to the vector that contains this param (not owned by this class).
   std::vector<DoubleParam *> *params_vec_;
+  // Pointer to the index that contains this param (not owned by this class).
+  ParamIndex<DoubleParam> *params_index_;
 };
 
-// Global parameter lists.
-//
-// To avoid the problem of undetermined order of static initialization
-// global_params are accessed through the GlobalParams function that
-// initializes the static pointer to global_params only on the first time
-// GlobalParams() is called.
-//
-// TODO(daria): remove GlobalParams() when all global Tesseract
-// parameters are converted to members.
-TESS_API
-ParamsVectors *GlobalParams();
-
 /*************************************************************************
  * Note on defining parameters.
  *
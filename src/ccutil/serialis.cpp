@@ -24,6 +24,7 @@
 
 #include <climits> // for INT_MAX
 #include <cstdio>
+#include <utility> // for std::move
 
 namespace tesseract {
 
@@ -74,7 +75,7 @@ bool TFile::DeSerializeSize(int32_t *pSize) {
   if (FReadEndian(&size, sizeof(size), 1) != 1) {
     return false;
   }
-  if (size > data_->size() / 4) {
+  if (size > ReadSize() / 4) {
     // Reverse endianness.
     swap_ = !swap_;
     ReverseN(&size, 4);
@@ -143,8 +144,8 @@ bool TFile::Serialize(const std::vector<char> &data) {
 }
 
 bool TFile::Skip(size_t count) {
-  if (data_ != nullptr) {
-    size_t data_size = data_->size();
+  if (data_ != nullptr || view_ != nullptr) {
+    size_t data_size = ReadSize();
     // Subtraction-based check to avoid overflow in offset_ + count.
     if (offset_ >= data_size || count > data_size - offset_) {
       offset_ = data_size > UINT_MAX ? UINT_MAX : static_cast<unsigned>(data_size);
@@ -156,6 +157,7 @@ bool TFile::Skip(size_t count) {
 }
 
 bool TFile::Open(const char *filename, FileReader reader) {
+  CloseView();
   if (!data_is_owned_) {
     data_ = new std::vector<char>;
     data_is_owned_ = true;
@@ -171,6 +173,7 @@ bool TFile::Open(const char *filename, FileReader reader) {
 }
 
 bool TFile::Open(const char *data, size_t size) {
+  CloseView();
   offset_ = 0;
   if (!data_is_owned_) {
     data_ = new std::vector<char>;
@@ -183,7 +186,18 @@ bool TFile::Open(const char *data, size_t size) {
   return true;
 }
 
+bool TFile::Open(const char *data, size_t size, std::shared_ptr<const MappedFile> mapping) {
+  offset_ = 0;
+  is_writing_ = false;
+  swap_ = false;
+  view_ = data;
+  view_size_ = size;
+  mapping_ = std::move(mapping);
+  return true;
+}
+
 bool TFile::Open(FILE *fp, int64_t end_offset) {
+  CloseView();
   offset_ = 0;
   auto current_pos = std::ftell(fp);
   if (current_pos < 0) {
@@ -213,9 +227,10 @@ bool TFile::Open(FILE *fp, int64_t end_offset) {
 char *TFile::FGets(char *buffer, int buffer_size) {
   ASSERT_HOST(!is_writing_);
   int size = 0;
-  while (size + 1 < buffer_size && offset_ < data_->size()) {
-    buffer[size++] = (*data_)[offset_++];
-    if ((*data_)[offset_ - 1] == '\n') {
+  const char *data = ReadData();
+  while (size + 1 < buffer_size && offset_ < ReadSize()) {
+    buffer[size++] = data[offset_++];
+    if (data[offset_ - 1] == '\n') {
       break;
     }
   }
@@ -242,15 +257,15 @@ size_t TFile::FRead(void *buffer, size_t size, size_t count) {
   size_t required_size;
   if (SIZE_MAX / size <= count) {
     // Avoid integer overflow.
-    required_size = data_->size() - offset_;
+    required_size = ReadSize() - offset_;
   } else {
     required_size = size * count;
-    if (data_->size() - offset_ < required_size) {
-      required_size = data_->size() - offset_;
+    if (ReadSize() - offset_ < required_size) {
+      required_size = ReadSize() - offset_;
     }
   }
   if (required_size > 0 && buffer != nullptr) {
-    memcpy(buffer, &(*data_)[offset_], required_size);
+    memcpy(buffer, ReadData() + offset_, required_size);
   }
   offset_ += required_size;
   return required_size / size;
@@ -262,6 +277,7 @@ void TFile::Rewind() {
 }
 
 void TFile::OpenWrite(std::vector<char> *data) {
+  CloseView();
   offset_ = 0;
   if (data != nullptr) {
     if (data_is_owned_) {
@@ -24,11 +24,14 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory> // std::shared_ptr
 #include <type_traits>
 #include <vector> // std::vector
 
 namespace tesseract {
 
+class MappedFile;
+
 // Return number of elements of an array.
 template <typename T, size_t N>
 constexpr size_t countof(T const (&)[N]) noexcept {
@@ -69,15 +72,33 @@ public:
   bool Open(const char *filename, FileReader reader);
   // From an existing memory buffer.
   bool Open(const char *data, size_t size);
+  // From memory that isn't copied, so it must stay valid while reading.
+  // If the memory is part of a memory mapped file, mapping keeps it alive
+  // while the TFile is open, and allows reading arrays in place with
+  // DeSerializeInPlace.
+  bool Open(const char *data, size_t size, std::shared_ptr<const MappedFile> mapping);
   // From an open file and an end offset.
   bool Open(FILE *fp, int64_t end_offset);
   // Sets the value of the swap flag, so that FReadEndian does the right thing.
   void set_swap(bool value) {
     swap_ = value;
   }
+  // Sets whether objects holding network weights write only the shape of the
+  // weights, for a copy of the network that is to share the weights of the
+  // original.
+  void set_omit_weights(bool value) {
+    omit_weights_ = value;
+  }
+  bool omit_weights() const {
+    return omit_weights_;
+  }
   // Returns the number of bytes remaining to be read.
   size_t RemainingBytes() const {
-    return data_ != nullptr && offset_ < data_->size() ? data_->size() - offset_ : 0;
+    return offset_ < ReadSize() ? ReadSize() - offset_ : 0;
+  }
+  // Returns the memory mapped file that is read, or nullptr.
+  const std::shared_ptr<const MappedFile> &mapping() const {
+    return mapping_;
   }
 
   // Deserialize data.
@@ -90,6 +111,24 @@ public:
   bool DeSerialize(T *data, size_t count = 1) {
     return FReadEndian(data, sizeof(T), count) == count;
   }
+  // If a memory mapped file is read without swapping, and the next count
+  // items are suitably aligned for T, returns a pointer to them in the
+  // mapping and skips them. The items are read-only, and remain valid as long
+  // as mapping() is kept alive. Otherwise returns nullptr without reading
+  // anything, so the caller can DeSerialize a copy instead.
+  template <typename T>
+  const T *DeSerializeInPlace(size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be a plain data type");
+    if (mapping_ == nullptr || swap_ || count > RemainingBytes() / sizeof(T)) {
+      return nullptr;
+    }
+    const char *data = view_ + offset_;
+    if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0) {
+      return nullptr;
+    }
+    offset_ += count * sizeof(T);
+    return reinterpret_cast<const T *>(data);
+  }
   template <typename T>
   bool DeSerialize(std::vector<T> &data) {
     uint32_t size;
@@ -221,8 +260,27 @@ public:
   size_t FWrite(const void *buffer, size_t size, size_t count);
 
 private:
+  // Returns the data to read and its size.
+  const char *ReadData() const {
+    return view_ != nullptr ? view_ : data_->data();
+  }
+  size_t ReadSize() const {
+    return view_ != nullptr ? view_size_ : data_ != nullptr ? data_->size() : 0;
+  }
+  // Stops reading from a memory mapped file.
+  void CloseView() {
+    view_ = nullptr;
+    view_size_ = 0;
+    mapping_.reset();
+  }
+
   // The buffered data from the file.
   std::vector<char> *data_ = nullptr;
+  // If not null, the data is read from here instead of data_, without a copy.
+  const char *view_ = nullptr;
+  size_t view_size_ = 0;
+  // The memory mapped file that contains view_, if any.
+  std::shared_ptr<const MappedFile> mapping_;
   // The number of bytes used so far.
   unsigned offset_ = 0;
   // True if the data_ pointer is owned by *this.
@@ -231,6 +289,8 @@ private:
   bool is_writing_ = false;
   // True if bytes need to be swapped in FReadEndian.
   bool swap_ = false;
+  // True if network weights are written without their values.
+  bool omit_weights_ = false;
 };
 
 } // namespace tesseract.
@@ -22,7 +22,9 @@
 
 #include "tessdatamanager.h"
 
+#include <cinttypes> // for PRId64
 #include <cstdio>
+#include <functional> // for std::hash
 #include <string>
 
 #if defined(HAVE_LIBARCHIVE)
@@ -39,15 +41,45 @@
 
 namespace tesseract {
 
-TessdataManager::TessdataManager() : reader_(nullptr), is_loaded_(false), swap_(false) {
+// The size of the header of a SquishedDawg before its array of edges: the
+// magic number, the unicharset size and the number of edges.
+const int kDawgHeaderSize = sizeof(int16_t) + 2 * sizeof(int32_t);
+
+TessdataManager::TessdataManager()
+    : reader_(nullptr), is_loaded_(false), swap_(false), aligned_(false) {
   SetVersionString(TESSERACT_VERSION_STR);
 }
 
 TessdataManager::TessdataManager(FileReader reader)
-    : reader_(reader), is_loaded_(false), swap_(false) {
+    : reader_(reader), is_loaded_(false), swap_(false), aligned_(false) {
   SetVersionString(TESSERACT_VERSION_STR);
 }
 
+// Returns the first offset from offset at which an entry of the given type
+// can start in the aligned layout. The dawgs are placed so that their array
+// of edges is aligned, all the other entries are aligned themselves.
+static int64_t AlignedEntryOffset(TessdataType type, int64_t offset) {
+  int64_t header_size = 0;
+  switch (type) {
+    case TESSDATA_PUNC_DAWG:
+    case TESSDATA_SYSTEM_DAWG:
+    case TESSDATA_NUMBER_DAWG:
+    case TESSDATA_FREQ_DAWG:
+    case TESSDATA_BIGRAM_DAWG:
+    case TESSDATA_UNAMBIG_DAWG:
+    case TESSDATA_LSTM_PUNC_DAWG:
+    case TESSDATA_LSTM_SYSTEM_DAWG:
+    case TESSDATA_LSTM_NUMBER_DAWG:
+      header_size = kDawgHeaderSize;
+      break;
+    default:
+      break;
+  }
+  int64_t aligned = (offset + header_size + kTessdataAlignment - 1) / kTessdataAlignment *
+                    kTessdataAlignment;
+  return aligned - header_size;
+}
+
 // Lazily loads from the given filename. Won't actually read the file
 // until it needs it.
 void TessdataManager::LoadFileLater(const char *data_file_name) {
@@ -90,6 +122,9 @@ bool TessdataManager::LoadArchiveFile(const char *filename) {
 bool TessdataManager::Init(const char *data_file_name) {
   std::vector<char> data;
   if (reader_ == nullptr) {
+    if (LoadMappedFile(data_file_name)) {
+      return true;
+    }
 #if defined(HAVE_LIBARCHIVE)
     if (LoadArchiveFile(data_file_name)) {
       return true;
@@ -106,8 +141,24 @@ bool TessdataManager::Init(const char *data_file_name) {
   return LoadMemBuffer(data_file_name, &data[0], data.size());
 }
 
+// Memory maps the given file if it is in the aligned layout.
+bool TessdataManager::LoadMappedFile(const char *filename) {
+  auto mapping = MappedFile::Map(filename);
+  if (mapping == nullptr) {
+    return false;
+  }
+  return LoadEntries(filename, mapping->data(), mapping->size(), mapping);
+}
+
 // Loads from the given memory buffer as if a file.
 bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size) {
+  return LoadEntries(name, data, size, nullptr);
+}
+
+// Loads the entries of the traineddata file in data, in place in mapping if
+// it is not null.
+bool TessdataManager::LoadEntries(const char *name, const char *data, int64_t size,
+                                  const std::shared_ptr<const MappedFile> &mapping) {
   // TODO: This method supports only the proprietary file format.
   if (size < 0) {
     return false;
@@ -115,29 +166,53 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
   Clear();
   data_file_name_ = name;
   TFile fp;
-  fp.Open(data, size);
+  fp.Open(data, size, nullptr);
   uint32_t num_entries;
   if (!fp.DeSerialize(&num_entries)) {
     return false;
   }
-  swap_ = num_entries > kMaxNumTessdataEntries;
+  swap_ = (num_entries & ~kAlignedLayoutFlag) > kMaxNumTessdataEntries;
   fp.set_swap(swap_);
   if (swap_) {
     ReverseN(&num_entries, sizeof(num_entries));
   }
-  if (num_entries > kMaxNumTessdataEntries) {
+  aligned_ = (num_entries & kAlignedLayoutFlag) != 0;
+  num_entries &= ~kAlignedLayoutFlag;
+  if (num_entries > kMaxNumTessdataEntries || (mapping != nullptr && !aligned_)) {
     return false;
   }
+  mapping_ = mapping;
   // TODO: optimize (no init required).
   std::vector<int64_t> offset_table(num_entries);
   if (!fp.DeSerialize(&offset_table[0], num_entries)) {
     return false;
   }
+  std::vector<int64_t> size_table;
+  if (aligned_) {
+    size_table.resize(num_entries);
+    if (!fp.DeSerialize(&size_table[0], num_entries)) {
+      return false;
+    }
+  }
   for (unsigned i = 0; i < num_entries && i < TESSDATA_NUM_ENTRIES; ++i) {
     if (offset_table[i] >= 0) {
       if (offset_table[i] > size) {
         return false;
       }
+      if (aligned_) {
+        // The entries are padded, so they are found by their offsets.
+        int64_t entry_size = size_table[i];
+        if (entry_size < 0 || entry_size > size - offset_table[i]) {
+          return false;
+        }
+        const char *entry = data + offset_table[i];
+        if (mapping != nullptr) {
+          mapped_entries_[i] = std::string_view(entry, entry_size);
+        } else {
+          entries_[i].assign(entry, entry + entry_size);
+        }
+        continue;
+      }
       int64_t entry_size = size - offset_table[i];
       unsigned j = i + 1;
       while (j < num_entries && offset_table[j] == -1) {
@@ -158,7 +233,7 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
       }
     }
   }
-  if (entries_[TESSDATA_VERSION].empty()) {
+  if (EntrySize(TESSDATA_VERSION) == 0) {
     SetVersionString("Pre-4.0.0");
   }
   is_loaded_ = true;
@@ -168,6 +243,7 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
 // Overwrites a single entry of the given type.
 void TessdataManager::OverwriteEntry(TessdataType type, const char *data, int size) {
   is_loaded_ = true;
+  mapped_entries_[type] = std::string_view();
   entries_[type].resize(size);
   memcpy(&entries_[type][0], data, size);
 }
@@ -191,24 +267,43 @@ void TessdataManager::Serialize(std::vector<char> *data) const {
   ASSERT_HOST(is_loaded_);
   // Compute the offset_table and total size.
   int64_t offset_table[TESSDATA_NUM_ENTRIES];
+  int64_t size_table[TESSDATA_NUM_ENTRIES];
   int64_t offset = sizeof(int32_t) + sizeof(offset_table);
+  if (aligned_) {
+    offset += sizeof(size_table);
+  }
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (entries_[i].empty()) {
+    auto type = static_cast<TessdataType>(i);
+    size_table[i] = EntrySize(type);
+    if (size_table[i] == 0) {
       offset_table[i] = -1;
     } else {
+      if (aligned_) {
+        offset = AlignedEntryOffset(type, offset);
+      }
       offset_table[i] = offset;
-      offset += entries_[i].size();
+      offset += size_table[i];
     }
   }
   data->resize(offset, 0);
-  int32_t num_entries = TESSDATA_NUM_ENTRIES;
+  uint32_t num_entries = TESSDATA_NUM_ENTRIES;
+  if (aligned_) {
+    num_entries |= kAlignedLayoutFlag;
+  }
   TFile fp;
   fp.OpenWrite(data);
   fp.Serialize(&num_entries);
   fp.Serialize(&offset_table[0], countof(offset_table));
-  for (const auto &entry : entries_) {
-    if (!entry.empty()) {
-      fp.Serialize(&entry[0], entry.size());
+  if (aligned_) {
+    fp.Serialize(&size_table[0], countof(size_table));
+  }
+  const char padding[kTessdataAlignment] = {};
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (size_table[i] != 0) {
+      if (static_cast<int64_t>(data->size()) < offset_table[i]) {
+        fp.Serialize(padding, offset_table[i] - data->size());
+      }
+      fp.Serialize(EntryData(static_cast<TessdataType>(i)), size_table[i]);
     }
   }
 }
@@ -218,18 +313,46 @@ void TessdataManager::Clear() {
   for (auto &entry : entries_) {
     entry.clear();
   }
+  for (auto &entry : mapped_entries_) {
+    entry = std::string_view();
+  }
+  mapping_.reset();
   is_loaded_ = false;
+  aligned_ = false;
+}
+
+// Copies the mapped entries to memory and releases the mapping.
+void TessdataManager::ReleaseMapping() {
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (!mapped_entries_[i].empty()) {
+      entries_[i].assign(mapped_entries_[i].begin(), mapped_entries_[i].end());
+      mapped_entries_[i] = std::string_view();
+    }
+  }
+  mapping_.reset();
 }
 
 // Prints a directory of contents.
 void TessdataManager::Directory() const {
   printf("Version:%s\n", VersionString().c_str());
-  auto offset = TESSDATA_NUM_ENTRIES * sizeof(int64_t);
+  if (aligned_) {
+    printf("Aligned layout\n");
+  }
+  int64_t offset = TESSDATA_NUM_ENTRIES * sizeof(int64_t);
+  if (aligned_) {
+    // Same offsets as Serialize: after the entry count and both tables, with
+    // each entry padded to its alignment.
+    offset = sizeof(int32_t) + 2 * TESSDATA_NUM_ENTRIES * sizeof(int64_t);
+  }
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (!entries_[i].empty()) {
-      printf("%u:%s:size=%zu, offset=%zu\n", i, kTessdataFileSuffixes[i], entries_[i].size(),
-              offset);
-      offset += entries_[i].size();
+    auto type = static_cast<TessdataType>(i);
+    size_t size = EntrySize(type);
+    if (size != 0) {
+      if (aligned_) {
+        offset = AlignedEntryOffset(type, offset);
+      }
+      printf("%u:%s:size=%zu, offset=%" PRId64 "\n", i, kTessdataFileSuffixes[i], size, offset);
+      offset += size;
     }
   }
 }
@@ -248,21 +371,35 @@ bool TessdataManager::GetComponent(TessdataType type, TFile *fp) {
 // loaded.
 bool TessdataManager::GetComponent(TessdataType type, TFile *fp) const {
   ASSERT_HOST(is_loaded_);
-  if (entries_[type].empty()) {
+  if (EntrySize(type) == 0) {
     return false;
   }
-  fp->Open(&entries_[type][0], entries_[type].size());
+  if (mapped_entries_[type].empty()) {
+    fp->Open(&entries_[type][0], entries_[type].size());
+  } else {
+    fp->Open(mapped_entries_[type].data(), mapped_entries_[type].size(), mapping_);
+  }
   fp->set_swap(swap_);
   return true;
 }
 
+// Returns a string that identifies the contents of the given component.
+std::string TessdataManager::ComponentId(TessdataType type) {
+  if (!is_loaded_ && !Init(data_file_name_.c_str())) {
+    return std::string();
+  }
+  std::string_view data(EntryData(type), EntrySize(type));
+  return std::to_string(data.size()) + ":" + std::to_string(std::hash<std::string_view>()(data));
+}
+
 // Returns the current version string.
 std::string TessdataManager::VersionString() const {
-  return std::string(&entries_[TESSDATA_VERSION][0], entries_[TESSDATA_VERSION].size());
+  return std::string(EntryData(TESSDATA_VERSION), EntrySize(TESSDATA_VERSION));
 }
 
 // Sets the version string to the given v_str.
 void TessdataManager::SetVersionString(const std::string &v_str) {
+  mapped_entries_[TESSDATA_VERSION] = std::string_view();
   entries_[TESSDATA_VERSION].resize(v_str.size());
   memcpy(&entries_[TESSDATA_VERSION][0], v_str.data(), v_str.size());
 }
@@ -278,6 +415,7 @@ bool TessdataManager::CombineDataFiles(const char *language_data_path_prefix,
     FILE *fp = fopen(filename.c_str(), "rb");
     if (fp != nullptr) {
       fclose(fp);
+      mapped_entries_[type] = std::string_view();
       if (!LoadDataFromFile(filename.c_str(), &entries_[type])) {
         tprintf("Load of file %s failed!\n", filename.c_str());
         return false;
@@ -304,6 +442,7 @@ bool TessdataManager::OverwriteComponents(const char *new_traineddata_filename,
   for (int i = 0; i < num_new_components; ++i) {
     TessdataType type;
     if (TessdataTypeFromFileName(component_filenames[i], &type)) {
+      mapped_entries_[type] = std::string_view();
       if (!LoadDataFromFile(component_filenames[i], &entries_[type])) {
         tprintf("Failed to read component file:%s\n", component_filenames[i]);
         return false;
@@ -318,10 +457,14 @@ bool TessdataManager::OverwriteComponents(const char *new_traineddata_filename,
 bool TessdataManager::ExtractToFile(const char *filename) {
   TessdataType type = TESSDATA_NUM_ENTRIES;
   ASSERT_HOST(tesseract::TessdataManager::TessdataTypeFromFileName(filename, &type));
-  if (entries_[type].empty()) {
+  if (EntrySize(type) == 0) {
     return false;
   }
-  return SaveDataToFile(entries_[type], filename);
+  if (mapped_entries_[type].empty()) {
+    return SaveDataToFile(entries_[type], filename);
+  }
+  std::vector<char> entry(EntryData(type), EntryData(type) + EntrySize(type));
+  return SaveDataToFile(entry, filename);
 }
 
 bool TessdataManager::TessdataTypeFromFileSuffix(const char *suffix, TessdataType *type) {
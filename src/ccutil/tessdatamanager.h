@@ -20,8 +20,11 @@
 #define TESSERACT_CCUTIL_TESSDATAMANAGER_H_
 
 #include <tesseract/baseapi.h> // FileReader
+#include <memory>              // std::shared_ptr
 #include <string>              // std::string
+#include <string_view>         // std::string_view
 #include <vector>              // std::vector
+#include "mappedfile.h"        // MappedFile
 #include "serialis.h"          // FileWriter
 
 static const char kTrainedDataSuffix[] = "traineddata";
@@ -124,6 +127,17 @@ static const char *const kTessdataFileSuffixes[] = {
  */
 static const int kMaxNumTessdataEntries = 1000;
 
+/**
+ * Flag in the number of entries at the start of a traineddata file, which
+ * marks the aligned layout. In the aligned layout the offset table is
+ * followed by a table of the sizes of the entries, and each entry starts at
+ * an offset which aligns its data to kTessdataAlignment bytes, so the data
+ * can be used in place when the file is memory mapped.
+ * Older versions of Tesseract can't read the aligned layout.
+ */
+static const uint32_t kAlignedLayoutFlag = 0x40000000;
+static const int kTessdataAlignment = 64;
+
 class TESS_API TessdataManager {
 public:
   TessdataManager();
@@ -137,12 +151,24 @@ public:
   bool is_loaded() const {
     return is_loaded_;
   }
+  // Returns true if the file uses, or will be saved with, the aligned layout.
+  bool is_aligned() const {
+    return aligned_;
+  }
+  // Sets whether SaveFile and Serialize write the aligned layout.
+  void set_aligned(bool value) {
+    aligned_ = value;
+  }
 
   // Lazily loads from the given filename. Won't actually read the file
   // until it needs it.
   void LoadFileLater(const char *data_file_name);
   /**
    * Opens and reads the given data file right now.
+   * A file in the aligned layout is memory mapped instead of read, and its
+   * components are read from the mapping, some of them in place. Such a file
+   * must not be changed while it is in use, so replace it by renaming a new
+   * file over it instead of overwriting it.
    * @return true on success.
    */
   bool Init(const char *data_file_name);
@@ -158,13 +184,16 @@ public:
   void Serialize(std::vector<char> *data) const;
   // Resets to the initial state, keeping the reader.
   void Clear();
+  // Copies the entries that are used in place in the mapped file to memory
+  // and releases the mapping, so that the file can be replaced.
+  void ReleaseMapping();
 
   // Prints a directory of contents.
   void Directory() const;
 
   // Returns true if the component requested is present.
   bool IsComponentAvailable(TessdataType type) const {
-    return !entries_[type].empty();
+    return EntrySize(type) != 0;
   }
   // Opens the given TFile pointer to the given component type.
   // Returns false in case of failure.
@@ -172,6 +201,10 @@ public:
   // As non-const version except it can't load the component if not already
   // loaded.
   bool GetComponent(TessdataType type, TFile *fp) const;
+  // Returns a string that identifies the contents of the given component,
+  // made of its size and a hash of its data, or an empty string if the file
+  // cannot be loaded.
+  std::string ComponentId(TessdataType type);
 
   // Returns the current version string.
   std::string VersionString() const;
@@ -180,12 +213,12 @@ public:
 
   // Returns true if the base Tesseract components are present.
   bool IsBaseAvailable() const {
-    return !entries_[TESSDATA_UNICHARSET].empty() && !entries_[TESSDATA_INTTEMP].empty();
+    return EntrySize(TESSDATA_UNICHARSET) != 0 && EntrySize(TESSDATA_INTTEMP) != 0;
   }
 
   // Returns true if the LSTM components are present.
   bool IsLSTMAvailable() const {
-    return !entries_[TESSDATA_LSTM].empty();
+    return EntrySize(TESSDATA_LSTM) != 0;
   }
 
   // Return the name of the underlying data file.
@@ -223,6 +256,21 @@ public:
 private:
   // Use libarchive.
   bool LoadArchiveFile(const char *filename);
+  // Memory maps the given file if it is in the aligned layout.
+  bool LoadMappedFile(const char *filename);
+  // Loads the entries of the traineddata file in data. If mapping is not
+  // null, data is in mapping, and only the aligned layout is accepted, with
+  // the entries left in place in the mapping.
+  bool LoadEntries(const char *name, const char *data, int64_t size,
+                   const std::shared_ptr<const MappedFile> &mapping);
+
+  // Returns the data and size of the given entry, wherever it is held.
+  const char *EntryData(TessdataType type) const {
+    return mapped_entries_[type].empty() ? entries_[type].data() : mapped_entries_[type].data();
+  }
+  size_t EntrySize(TessdataType type) const {
+    return mapped_entries_[type].empty() ? entries_[type].size() : mapped_entries_[type].size();
+  }
 
   /**
    * Fills type with TessdataType of the tessdata component represented by the
@@ -246,8 +294,14 @@ private:
   bool is_loaded_;
   // True if the bytes need swapping.
   bool swap_;
+  // True if the file is in the aligned layout.
+  bool aligned_;
   // Contents of each element of the traineddata file.
   std::vector<char> entries_[TESSDATA_NUM_ENTRIES];
+  // If the file is memory mapped, the mapping, and the location of each
+  // element in it. An element that is changed is copied to entries_.
+  std::shared_ptr<const MappedFile> mapping_;
+  std::string_view mapped_entries_[TESSDATA_NUM_ENTRIES];
 };
 
 } // namespace tesseract
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadpool.cpp
+// Description: A persistent pool of threads for data parallel loops.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "threadpool.h"
+
+namespace tesseract {
+
+// Number of times that a thread checks for its next work before it sleeps.
+const int kSpinCount = 2000;
+
+ThreadPool::ThreadPool(int num_threads) {
+  for (int t = 1; t < num_threads; ++t) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, t);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(int num_items, const std::function<void(int, int)> &func) {
+  if (workers_.empty() || num_items <= 1) {
+    for (int item = 0; item < num_items; ++item) {
+      func(item, 0);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    func_ = &func;
+    num_items_ = num_items;
+    next_item_ = 0;
+    busy_workers_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  start_cv_.notify_all();
+  RunItems(0);
+  for (int spin = 0; spin < kSpinCount && busy_workers_ > 0; ++spin) {
+    std::this_thread::yield();
+  }
+  if (busy_workers_ > 0) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+  }
+  func_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int thread) {
+  unsigned generation = 0;
+  while (WaitForLoop(&generation)) {
+    RunItems(thread);
+    if (--busy_workers_ == 0) {
+      // Take the lock, so the notification can't be lost between the check
+      // and the wait in ParallelFor.
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_cv_.notify_one();
+    }
+  }
+}
+
+bool ThreadPool::WaitForLoop(unsigned *generation) {
+  for (int spin = 0; spin < kSpinCount; ++spin) {
+    if (stop_) {
+      return false;
+    }
+    if (generation_ != *generation) {
+      *generation = generation_;
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  start_cv_.wait(lock, [this, generation] { return stop_ || generation_ != *generation; });
+  if (stop_) {
+    return false;
+  }
+  *generation = generation_;
+  return true;
+}
+
+void ThreadPool::RunItems(int thread) {
+  for (int item = next_item_++; item < num_items_; item = next_item_++) {
+    (*func_)(item, thread);
+  }
+}
+
+} // namespace tesseract
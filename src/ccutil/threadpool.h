@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadpool.h
+// Description: A persistent pool of threads for data parallel loops.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_THREADPOOL_H_
+#define TESSERACT_CCUTIL_THREADPOOL_H_
+
+#include <atomic>             // for std::atomic
+#include <condition_variable> // for std::condition_variable
+#include <functional>         // for std::function
+#include <mutex>              // for std::mutex
+#include <thread>             // for std::thread
+#include <vector>             // for std::vector
+
+#include <tesseract/export.h>
+
+namespace tesseract {
+
+// A fixed set of threads that are started once and then reused for every
+// ParallelFor, so the cost of creating threads is not paid on each call.
+// The items of a loop are handed out one at a time from a shared counter, so
+// a thread that finishes early takes the next unstarted item, and items of
+// uneven cost are balanced over the threads.
+// Between loops, the threads spin for a short while before they go to sleep,
+// so a tight sequence of small loops, such as one per LSTM timestep, does not
+// pay for waking up the threads each time.
+// Only one ParallelFor may run on a pool at a time.
+class TESS_API ThreadPool {
+public:
+  // Starts num_threads - 1 worker threads. The thread that calls ParallelFor
+  // is used as the remaining one.
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Returns the number of threads that run the items, including the caller.
+  int num_threads() const {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+
+  // Calls func(item, thread) for each item in [0, num_items), spread over the
+  // threads of the pool. thread is in [0, num_threads()) and identifies the
+  // thread that runs the call, so func can use per-thread data without
+  // locking. The calling thread is thread 0. Returns when all calls are done.
+  // The order in which the items run is undefined.
+  void ParallelFor(int num_items, const std::function<void(int, int)> &func);
+
+private:
+  // Main loop of the worker thread with the given index.
+  void WorkerLoop(int thread);
+  // Waits for a loop with a generation other than *generation, and updates
+  // *generation to it. Returns false if the pool is stopping instead.
+  bool WaitForLoop(unsigned *generation);
+  // Runs items of the current loop on the given thread until none are left.
+  void RunItems(int thread);
+
+  std::vector<std::thread> workers_;
+  // Held while starting a loop or stopping, and by the threads that sleep.
+  std::mutex mutex_;
+  // Signals the workers that a new loop has started, or that they must stop.
+  std::condition_variable start_cv_;
+  // Signals ParallelFor that the last busy worker has finished.
+  std::condition_variable done_cv_;
+  // The loop that is currently being run. Set before generation_ changes.
+  const std::function<void(int, int)> *func_ = nullptr;
+  int num_items_ = 0;
+  // Index of the next item to run.
+  std::atomic<int> next_item_{0};
+  // Incremented for each loop, so the workers can tell a new one has started.
+  std::atomic<unsigned> generation_{0};
+  // Number of workers that are still running items of the current loop.
+  std::atomic<int> busy_workers_{0};
+  std::atomic<bool> stop_{false};
+};
+
+} // namespace tesseract
+
+#endif // TESSERACT_CCUTIL_THREADPOOL_H_
@@ -35,6 +35,7 @@
 #include "intfx.h"           // for BlobToTrainingSample, INT_FX_RESULT_S...
 #include "intmatcher.h"      // for CP_RESULT_STRUCT, IntegerMatcher
 #include "intproto.h"        // for INT_FEATURE_STRUCT, (anonymous), Clas...
+#include "matchcache.h"      // for MatchCache, MatchCacheEntry
 #include "matchdefs.h"       // for CLASS_ID, FEATURE_ID, PROTO_ID, NO_PROTO
 #include "mfoutline.h"       // for baseline, character, MF_SCALE_FACTOR
 #include "normalis.h"        // for DENORM, kBlnBaselineOffset, kBlnXHeight
@@ -167,6 +168,52 @@ static float ScoredUnichar(UNICHAR_ID id, const ADAPT_RESULTS &results) {
   return results.match[index].rating;
 }
 
+// Appends the bytes of value to *key.
+template <typename T>
+static void AppendToKey(T value, std::string *key) {
+  key->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Appends the quantized position and direction of the features to *key.
+static void AppendFeaturesToKey(const INT_FEATURE_STRUCT *features, int num_features,
+                                std::string *key) {
+  AppendToKey(num_features, key);
+  for (int f = 0; f < num_features; ++f) {
+    key->push_back(static_cast<char>(features[f].X));
+    key->push_back(static_cast<char>(features[f].Y));
+    key->push_back(static_cast<char>(features[f].Theta));
+  }
+}
+
+// Returns a key for the match cache, made of everything DoAdaptiveMatch
+// uses from the blob: its vertical position, the baseline normalized
+// features, the character normalized features and the char norm feature.
+static std::string MatchCacheKey(const TBOX &box, const INT_FX_RESULT_STRUCT &fx_info,
+                                 const std::vector<INT_FEATURE_STRUCT> &bl_features,
+                                 const TrainingSample &sample) {
+  std::string key;
+  AppendToKey(box.bottom(), &key);
+  AppendToKey(box.top(), &key);
+  AppendToKey(fx_info.Length, &key);
+  AppendToKey(fx_info.Xmean, &key);
+  AppendToKey(fx_info.Ymean, &key);
+  AppendToKey(fx_info.Rx, &key);
+  AppendToKey(fx_info.Ry, &key);
+  AppendToKey(fx_info.Width, &key);
+  AppendToKey(fx_info.YBottom, &key);
+  AppendToKey(fx_info.YTop, &key);
+  AppendToKey(sample.outline_length(), &key);
+  for (int i = 0; i < kNumCNParams; ++i) {
+    AppendToKey(sample.cn_feature(i), &key);
+  }
+  for (int i = 0; i < GeoCount; ++i) {
+    AppendToKey(sample.geo_feature(i), &key);
+  }
+  AppendFeaturesToKey(bl_features.data(), bl_features.size(), &key);
+  AppendFeaturesToKey(sample.features(), sample.num_features(), &key);
+  return key;
+}
+
 void InitMatcherRatings(float *Rating);
 
 int MakeTempProtoPerm(void *item1, void *item2);
@@ -417,6 +464,7 @@ void Classify::LearnPieces(const char *fontname, int start, int length, float th
 #endif // !GRAPHICS_DISABLED
 
   if (fontname != nullptr) {
+    match_cache_.Clear();                      // the params change
     classify_norm_method.set_value(character); // force char norm spc 30/11/93
     tess_bn_matching.set_value(false);         // turn it off
     tess_cn_matching.set_value(false);
@@ -484,6 +532,7 @@ void Classify::EndAdaptiveClassifier() {
   AdaptedTemplates = nullptr;
   delete BackupAdaptedTemplates;
   BackupAdaptedTemplates = nullptr;
+  match_cache_.Clear();
 
   if (PreTrainedTemplates != nullptr) {
     delete PreTrainedTemplates;
@@ -591,6 +640,7 @@ void Classify::InitAdaptiveClassifier(TessdataManager *mgr) {
     delete AdaptedTemplates;
     AdaptedTemplates = new ADAPT_TEMPLATES_STRUCT(unicharset);
   }
+  match_cache_.Clear();
 } /* InitAdaptiveClassifier */
 
 void Classify::ResetAdaptiveClassifierInternal() {
@@ -602,6 +652,7 @@ void Classify::ResetAdaptiveClassifierInternal() {
   delete BackupAdaptedTemplates;
   BackupAdaptedTemplates = nullptr;
   NumAdaptationsFailed = 0;
+  match_cache_.Clear();
 }
 
 // If there are backup adapted templates, switches to those, otherwise resets
@@ -619,6 +670,7 @@ void Classify::SwitchAdaptiveClassifier() {
   AdaptedTemplates = BackupAdaptedTemplates;
   BackupAdaptedTemplates = nullptr;
   NumAdaptationsFailed = 0;
+  match_cache_.Clear();
 }
 
 // Resets the backup adaptive classifier to empty.
@@ -627,6 +679,15 @@ void Classify::StartBackupAdaptiveClassifier() {
   BackupAdaptedTemplates = new ADAPT_TEMPLATES_STRUCT(unicharset);
 }
 
+void Classify::ResetMatchCache() {
+  if (classify_debug_level > 0 && match_cache_.lookups() > 0) {
+    tprintf("Classifier match cache: %d hits in %d lookups\n", match_cache_.hits(),
+            match_cache_.lookups());
+  }
+  match_cache_.Clear();
+  match_cache_.ResetStats();
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine prepares the adaptive
@@ -707,6 +768,7 @@ void Classify::InitAdaptedClass(TBLOB *Blob, CLASS_ID ClassId, int FontinfoId, A
   /* this is a kludge to construct cutoffs for adapted templates */
   if (Templates == AdaptedTemplates) {
     BaselineCutoffs[ClassId] = CharNormCutoffs[ClassId];
+    match_cache_.Clear();
   }
 
   IClass = ClassForClassId(Templates->Templates, ClassId);
@@ -1489,6 +1551,29 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
     return;
   }
 
+  std::string cache_key;
+  if (classify_cache_matches) {
+    cache_key = MatchCacheKey(Blob->bounding_box(), fx_info, bl_features, *sample);
+    // The params which select and adjust the classifiers may be changed
+    // between blobs without a reset of the cache, so they are in the key too.
+    AppendToKey(static_cast<int>(matcher_permanent_classes_min), &cache_key);
+    AppendToKey(static_cast<double>(matcher_reliable_adaptive_result), &cache_key);
+    AppendToKey(static_cast<bool>(tess_cn_matching), &cache_key);
+    AppendToKey(static_cast<bool>(tess_bn_matching), &cache_key);
+    AppendToKey(static_cast<bool>(classify_bln_numeric_mode), &cache_key);
+    MatchCacheEntry entry;
+    if (match_cache_.Lookup(cache_key, &entry)) {
+      Results->BlobLength = entry.blob_length;
+      Results->HasNonfragment = entry.has_nonfragment;
+      Results->best_unichar_id = entry.best_unichar_id;
+      Results->best_match_index = entry.best_match_index;
+      Results->best_rating = entry.best_rating;
+      Results->match = std::move(entry.match);
+      delete sample;
+      return;
+    }
+  }
+
   if (AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min || tess_cn_matching) {
     CharNormClassifier(Blob, *sample, Results);
   } else {
@@ -1511,6 +1596,16 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   if (!Results->HasNonfragment || Results->match.empty()) {
     ClassifyAsNoise(Results);
   }
+  if (!cache_key.empty()) {
+    MatchCacheEntry entry;
+    entry.blob_length = Results->BlobLength;
+    entry.has_nonfragment = Results->HasNonfragment;
+    entry.best_unichar_id = Results->best_unichar_id;
+    entry.best_match_index = Results->best_match_index;
+    entry.best_rating = Results->best_rating;
+    entry.match = Results->match;
+    match_cache_.Store(cache_key, entry);
+  }
   delete sample;
 } /* DoAdaptiveMatch */
 
@@ -1687,6 +1782,9 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES_STRUCT *Templates, CLASS_ID
 
   IClass = ClassForClassId(Templates->Templates, ClassId);
   Class = Templates->Class[ClassId];
+  if (Templates == AdaptedTemplates) {
+    match_cache_.Clear();
+  }
 
   if (IClass->NumConfigs >= MAX_NUM_CONFIGS) {
     ++NumAdaptationsFailed;
@@ -1844,6 +1942,9 @@ void Classify::MakePermanent(ADAPT_TEMPLATES_STRUCT *Templates, CLASS_ID ClassId
   auto Class = Templates->Class[ClassId];
   auto Config = TempConfigFor(Class, ConfigId);
 
+  if (Templates == AdaptedTemplates) {
+    match_cache_.Clear();
+  }
   MakeConfigPermanent(Class, ConfigId);
   if (Class->NumPermConfigs == 0) {
     Templates->NumPermClasses++;
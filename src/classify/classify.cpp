@@ -80,6 +80,9 @@ Classify::Classify()
     , BOOL_MEMBER(classify_enable_adaptive_debugger, 0, "Enable match debugger", this->params())
     , BOOL_MEMBER(classify_nonlinear_norm, 0, "Non-linear stroke-density normalization",
                   this->params())
+    , BOOL_MEMBER(classify_cache_matches, 0,
+                  "Reuse the adaptive matcher results of blobs with identical features",
+                  this->params())
     , INT_MEMBER(matcher_debug_level, 0, "Matcher Debug Level", this->params())
     , INT_MEMBER(matcher_debug_flags, 0, "Matcher Debug Flags", this->params())
     , INT_MEMBER(classify_learning_debug_level, 0, "Learning Debug Level: ", this->params())
@@ -161,6 +164,7 @@ Classify::~Classify() {
 void Classify::SetStaticClassifier(ShapeClassifier *static_classifier) {
   delete static_classifier_;
   static_classifier_ = static_classifier;
+  match_cache_.Clear();
 }
 
 // Moved from speckle.cpp
@@ -61,6 +61,7 @@ private:
 #  include "fontinfo.h"
 #  include "intfx.h"
 #  include "intmatcher.h"
+#  include "matchcache.h"
 #  include "normalis.h"
 #  include "ocrfeatures.h"
 #  include "ratngs.h"
@@ -250,6 +251,9 @@ public:
   void ResetAdaptiveClassifierInternal();
   void SwitchAdaptiveClassifier();
   void StartBackupAdaptiveClassifier();
+  // Forgets the match results cached for the last page and reports how
+  // often they were reused if classify_debug_level > 0.
+  void ResetMatchCache();
 
   int GetCharNormFeature(const INT_FX_RESULT_STRUCT &fx_info, INT_TEMPLATES_STRUCT *templates,
                          uint8_t *pruner_norm_array, uint8_t *char_norm_array);
@@ -268,6 +272,9 @@ public:
   bool AdaptiveClassifierIsEmpty() const {
     return AdaptedTemplates->NumPermClasses == 0;
   }
+  const MatchCache &match_cache() const {
+    return match_cache_;
+  }
   bool LooksLikeGarbage(TBLOB *blob);
 #ifndef GRAPHICS_DISABLED
   void RefreshDebugWindow(ScrollView **win, const char *msg, int y_offset, const TBOX &wbox);
@@ -379,6 +386,7 @@ public:
   BOOL_VAR_H(classify_save_adapted_templates);
   BOOL_VAR_H(classify_enable_adaptive_debugger);
   BOOL_VAR_H(classify_nonlinear_norm);
+  BOOL_VAR_H(classify_cache_matches);
   INT_VAR_H(matcher_debug_level);
   INT_VAR_H(matcher_debug_flags);
   INT_VAR_H(classify_learning_debug_level);
@@ -469,6 +477,10 @@ private:
   /* variables used to hold performance statistics */
   int NumAdaptationsFailed = 0;
 
+  // Results of DoAdaptiveMatch for the blobs seen since the templates
+  // last changed, used if classify_cache_matches is true.
+  MatchCache match_cache_;
+
   // Expected number of features in the class pruner, used to penalize
   // unknowns that have too few features (like a c being classified as e) so
   // it doesn't recognize everything as '@' or '#'.
@@ -27,11 +27,17 @@
 #include "intproto.h"
 #include "scrollview.h"
 #include "shapetable.h"
+#include "simddetect.h" // for ClassPrunerSum, ProtoEvidence
 
 #include "helpers.h"
 
+#include <algorithm> // for std::min
 #include <cassert>
 #include <cmath>
+#include <cstddef> // for offsetof
+#include <cstring> // for memcpy
+#include <memory>  // for std::unique_ptr
+#include <vector>
 
 namespace tesseract {
 
@@ -70,6 +76,16 @@ static const uint8_t next_table[] = {
 
 // See http://b/19318793 (#6) for a complete discussion.
 
+/**
+ * Returns the evidence tables of the current thread. They are allocated once
+ * per thread and reused by every match, instead of being allocated and fully
+ * cleared for each class that is matched.
+ */
+static ScratchEvidence &ThreadScratchEvidence() {
+  static thread_local auto evidence = std::make_unique<ScratchEvidence>();
+  return *evidence;
+}
+
 /**
  * Sort Key array in ascending order using heap sort
  * algorithm.  Also sort Index array that is tied to
@@ -127,11 +143,11 @@ static void HeapSort(int n, int ra[], int rb[]) {
 class ClassPruner {
 public:
   ClassPruner(int max_classes) {
-    // The unrolled loop in ComputeScores means that the array sizes need to
-    // be rounded up so that the array is big enough to accommodate the extra
-    // entries accessed by the unrolling. Each pruner word is of sized
-    // BITS_PER_WERD and each entry is NUM_BITS_PER_CLASS, so there are
-    // BITS_PER_WERD / NUM_BITS_PER_CLASS entries.
+    // ComputeScores adds the counts of all the classes of each pruner, so
+    // the array sizes need to be rounded up so that the array is big enough
+    // to accommodate the extra entries of the last pruner. Each pruner word
+    // is of sized BITS_PER_WERD and each entry is NUM_BITS_PER_CLASS, so
+    // there are BITS_PER_WERD / NUM_BITS_PER_CLASS entries.
     // See ComputeScores.
     max_classes_ = max_classes;
     rounded_classes_ =
@@ -159,66 +175,31 @@ public:
   /// weights for each feature and stores the sums internally in class_count_.
   void ComputeScores(const INT_TEMPLATES_STRUCT *int_templates, int num_features,
                      const INT_FEATURE_STRUCT *features) {
+    static_assert(CLASSES_PER_CP == 32 && WERDS_PER_CP_VECTOR == 2,
+                  "ClassPrunerSum needs 32 classes in 2 words per pruner");
     num_features_ = num_features;
     auto num_pruners = int_templates->NumClassPruners;
-    for (int f = 0; f < num_features; ++f) {
-      const INT_FEATURE_STRUCT *feature = &features[f];
-      // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
-      int x = feature->X * NUM_CP_BUCKETS >> 8;
-      int y = feature->Y * NUM_CP_BUCKETS >> 8;
-      int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
-      int class_id = 0;
-      // Each CLASS_PRUNER_STRUCT only covers CLASSES_PER_CP(32) classes, so
-      // we need a collection of them, indexed by pruner_set.
-      for (unsigned pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
-        // Look up quantized feature in a 3-D array, an array of weights for
-        // each class.
-        const uint32_t *pruner_word_ptr = int_templates->ClassPruners[pruner_set]->p[x][y][theta];
-        for (int word = 0; word < WERDS_PER_CP_VECTOR; ++word) {
-          uint32_t pruner_word = *pruner_word_ptr++;
-          // This inner loop is unrolled to speed up the ClassPruner.
-          // Currently gcc would not unroll it unless it is set to O3
-          // level of optimization or -funroll-loops is specified.
-          /*
-uint32_t class_mask = (1 << NUM_BITS_PER_CLASS) - 1;
-for (int bit = 0; bit < BITS_PER_WERD/NUM_BITS_PER_CLASS; bit++) {
-  class_count_[class_id++] += pruner_word & class_mask;
-  pruner_word >>= NUM_BITS_PER_CLASS;
-}
-*/
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-        }
+    // Each CLASS_PRUNER_STRUCT only covers CLASSES_PER_CP(32) classes, so
+    // we need a collection of them, indexed by pruner_set.
+    const uint32_t *pruners[MAX_NUM_CLASS_PRUNERS];
+    for (unsigned pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
+      pruners[pruner_set] = &int_templates->ClassPruners[pruner_set]->p[0][0][0][0];
+    }
+    // The offsets of the weights of the features in the 3-D arrays. The
+    // counts are sums, so more than MAX_NUM_INT_FEATURES features are simply
+    // added in several chunks.
+    int offsets[MAX_NUM_INT_FEATURES];
+    for (int start = 0; start < num_features; start += MAX_NUM_INT_FEATURES) {
+      int num_offsets = std::min(num_features - start, MAX_NUM_INT_FEATURES);
+      for (int f = 0; f < num_offsets; ++f) {
+        const INT_FEATURE_STRUCT *feature = &features[start + f];
+        // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
+        int x = feature->X * NUM_CP_BUCKETS >> 8;
+        int y = feature->Y * NUM_CP_BUCKETS >> 8;
+        int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
+        offsets[f] = ((x * NUM_CP_BUCKETS + y) * NUM_CP_BUCKETS + theta) * WERDS_PER_CP_VECTOR;
       }
+      ClassPrunerSum(pruners, num_pruners, offsets, num_offsets, class_count_);
     }
   }
 
@@ -478,7 +459,7 @@ void IntegerMatcher::Match(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR ProtoMask
                            int16_t NumFeatures, const INT_FEATURE_STRUCT *Features,
                            UnicharRating *Result, int AdaptFeatureThreshold, int Debug,
                            bool SeparateDebugWindows) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = &ThreadScratchEvidence();
   int Feature;
 
   if (MatchDebuggingOn(Debug)) {
@@ -526,8 +507,6 @@ void IntegerMatcher::Match(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR ProtoMask
     tprintf("Match Complete --------------------------------------------\n");
   }
 #endif
-
-  delete tables;
 }
 
 /**
@@ -551,7 +530,7 @@ int IntegerMatcher::FindGoodProtos(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR P
                                    BIT_VECTOR ConfigMask, int16_t NumFeatures,
                                    const INT_FEATURE_ARRAY &Features, PROTO_ID *ProtoArray,
                                    int AdaptProtoThreshold, int Debug) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = &ThreadScratchEvidence();
   int NumGoodProtos = 0;
 
   /* DEBUG opening heading */
@@ -593,7 +572,6 @@ int IntegerMatcher::FindGoodProtos(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR P
   if (MatchDebuggingOn(Debug)) {
     tprintf("Match Complete --------------------------------------------\n");
   }
-  delete tables;
 
   return NumGoodProtos;
 }
@@ -615,7 +593,7 @@ int IntegerMatcher::FindBadFeatures(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR
                                     BIT_VECTOR ConfigMask, int16_t NumFeatures,
                                     const INT_FEATURE_ARRAY &Features, FEATURE_ID *FeatureArray,
                                     int AdaptFeatureThreshold, int Debug) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = &ThreadScratchEvidence();
   int NumBadFeatures = 0;
 
   /* DEBUG opening heading */
@@ -656,7 +634,6 @@ int IntegerMatcher::FindBadFeatures(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR
     tprintf("Match Complete --------------------------------------------\n");
   }
 
-  delete tables;
   return NumBadFeatures;
 }
 
@@ -691,7 +668,11 @@ IntegerMatcher::IntegerMatcher(tesseract::IntParam *classify_debug_level)
 ----------------------------------------------------------------------------*/
 void ScratchEvidence::Clear(const INT_CLASS_STRUCT *class_template) {
   memset(sum_feature_evidence_, 0, class_template->NumConfigs * sizeof(sum_feature_evidence_[0]));
-  memset(proto_evidence_, 0, class_template->NumProtos * sizeof(proto_evidence_[0]));
+  // Only the protos matched since the last Clear have non-zero evidence.
+  for (int i = 0; i < num_touched_protos_; ++i) {
+    memset(proto_evidence_[touched_protos_[i]], 0, sizeof(proto_evidence_[0]));
+  }
+  num_touched_protos_ = 0;
 }
 
 void ScratchEvidence::ClearFeatureEvidence(const INT_CLASS_STRUCT *class_template) {
@@ -757,6 +738,12 @@ int IntegerMatcher::UpdateTablesForFeature(INT_CLASS_STRUCT *ClassTemplate, BIT_
   uint32_t XFeatureAddress;
   uint32_t YFeatureAddress;
   uint32_t ThetaFeatureAddress;
+  // The protos that were not pruned, and their parameters A, B, C and Angle.
+  static_assert(offsetof(INT_PROTO_STRUCT, Angle) == offsetof(INT_PROTO_STRUCT, A) + 3,
+                "ProtoEvidence needs the parameters of a proto in 4 bytes");
+  int num_protos = 0;
+  uint16_t proto_ids[MAX_NUM_PROTOS];
+  uint32_t proto_params[MAX_NUM_PROTOS];
 
   tables->ClearFeatureEvidence(ClassTemplate);
 
@@ -790,70 +777,72 @@ int IntegerMatcher::UpdateTablesForFeature(INT_CLASS_STRUCT *ClassTemplate, BIT_
           proto_offset = offset_table[proto_byte] + proto_word_offset;
           proto_byte = next_table[proto_byte];
           Proto = &(ProtoSet->Protos[ProtoNum + proto_offset]);
-          ConfigWord = Proto->Configs[0];
-          int32_t A3 = (((Proto->A * (Feature->X - 128)) * 2) - (Proto->B * (Feature->Y - 128)) +
-                        (Proto->C * 512));
-          int32_t M3 = ((static_cast<int8_t>(Feature->Theta - Proto->Angle)) * kIntThetaFudge) * 2;
-
-          if (A3 < 0) {
-            A3 = ~A3;
-          }
-          if (M3 < 0) {
-            M3 = ~M3;
-          }
-          A3 >>= mult_trunc_shift_bits_;
-          M3 >>= mult_trunc_shift_bits_;
-          if (static_cast<uint32_t>(A3) > evidence_mult_mask_) {
-            A3 = evidence_mult_mask_;
-          }
-          if (static_cast<uint32_t>(M3) > evidence_mult_mask_) {
-            M3 = evidence_mult_mask_;
-          }
-
-          uint32_t A4 = (A3 * A3) + (M3 * M3);
-          A4 >>= table_trunc_shift_bits_;
-          if (A4 > evidence_table_mask_) {
-            Evidence = 0;
-          } else {
-            Evidence = similarity_evidence_table_[A4];
-          }
+          proto_ids[num_protos] = ActualProtoNum + proto_offset;
+          memcpy(&proto_params[num_protos], &Proto->A, sizeof(proto_params[0]));
+          ++num_protos;
+        }
+      }
+    }
+  }
 
-          if (PrintFeatureMatchesOn(Debug)) {
-            IMDebugConfiguration(FeatureNum, ActualProtoNum + proto_offset, Evidence, ConfigWord);
-          }
+  /* Compute the evidence of all the protos that were not pruned */
+  ProtoEvidenceParams params;
+  params.x = Feature->X;
+  params.y = Feature->Y;
+  params.theta = Feature->Theta;
+  params.theta_fudge = kIntThetaFudge;
+  params.mult_trunc_shift = mult_trunc_shift_bits_;
+  params.evidence_mult_mask = evidence_mult_mask_;
+  params.table_trunc_shift = table_trunc_shift_bits_;
+  params.evidence_table_mask = evidence_table_mask_;
+  params.table = similarity_evidence_table_;
+  uint8_t evidences[MAX_NUM_PROTOS];
+  ProtoEvidence(proto_params, num_protos, params, evidences);
+
+  for (int i = 0; i < num_protos; ++i) {
+    int proto_id = proto_ids[i];
+    Proto = ProtoForProtoId(ClassTemplate, proto_id);
+    ConfigWord = Proto->Configs[0];
+    Evidence = evidences[i];
+
+    if (PrintFeatureMatchesOn(Debug)) {
+      IMDebugConfiguration(FeatureNum, proto_id, Evidence, ConfigWord);
+    }
 
-          ConfigWord &= *ConfigMask;
+    ConfigWord &= *ConfigMask;
 
-          uint8_t feature_evidence_index = 0;
-          uint8_t config_byte = 0;
-          while (ConfigWord != 0 || config_byte != 0) {
-            while (config_byte == 0) {
-              config_byte = ConfigWord & 0xff;
-              ConfigWord >>= 8;
-              feature_evidence_index += 8;
-            }
-            const uint8_t config_offset = offset_table[config_byte] + feature_evidence_index - 8;
-            config_byte = next_table[config_byte];
-            if (Evidence > tables->feature_evidence_[config_offset]) {
-              tables->feature_evidence_[config_offset] = Evidence;
-            }
-          }
+    uint8_t feature_evidence_index = 0;
+    uint8_t config_byte = 0;
+    while (ConfigWord != 0 || config_byte != 0) {
+      while (config_byte == 0) {
+        config_byte = ConfigWord & 0xff;
+        ConfigWord >>= 8;
+        feature_evidence_index += 8;
+      }
+      const uint8_t config_offset = offset_table[config_byte] + feature_evidence_index - 8;
+      config_byte = next_table[config_byte];
+      if (Evidence > tables->feature_evidence_[config_offset]) {
+        tables->feature_evidence_[config_offset] = Evidence;
+      }
+    }
 
-          uint8_t ProtoIndex = ClassTemplate->ProtoLengths[ActualProtoNum + proto_offset];
-          if (ProtoIndex > MAX_PROTO_INDEX) {
-            // Avoid buffer overflow.
-            // TODO: A better fix is still open.
-            ProtoIndex = MAX_PROTO_INDEX;
-          }
-          uint8_t *UINT8Pointer = &(tables->proto_evidence_[ActualProtoNum + proto_offset][0]);
-          for (; Evidence > 0 && ProtoIndex > 0; ProtoIndex--, UINT8Pointer++) {
-            if (Evidence > *UINT8Pointer) {
-              uint8_t Temp = *UINT8Pointer;
-              *UINT8Pointer = Evidence;
-              Evidence = Temp;
-            }
-          }
-        }
+    uint8_t ProtoIndex = ClassTemplate->ProtoLengths[proto_id];
+    if (ProtoIndex > MAX_PROTO_INDEX) {
+      // Avoid buffer overflow.
+      // TODO: A better fix is still open.
+      ProtoIndex = MAX_PROTO_INDEX;
+    }
+    uint8_t *UINT8Pointer = &(tables->proto_evidence_[proto_id][0]);
+    // The evidences of a proto are sorted, so the first one is only zero
+    // until the proto gets evidence for the first time.
+    if (Evidence > 0 && ProtoIndex > 0 && *UINT8Pointer == 0) {
+      tables->touched_protos_[tables->num_touched_protos_++] = proto_id;
+    }
+    for (; Evidence > 0 && ProtoIndex > 0; ProtoIndex--, UINT8Pointer++) {
+      if (Evidence > *UINT8Pointer) {
+        uint8_t Temp = *UINT8Pointer;
+        *UINT8Pointer = Evidence;
+        Evidence = Temp;
       }
     }
   }
@@ -1019,7 +1008,8 @@ void IntegerMatcher::DisplayFeatureDebugInfo(INT_CLASS_STRUCT *ClassTemplate, BI
                                              const INT_FEATURE_STRUCT *Features,
                                              int AdaptFeatureThreshold, int Debug,
                                              bool SeparateDebugWindows) {
-  auto *tables = new ScratchEvidence();
+  // Called by Match while the tables of the thread are in use.
+  auto tables = std::make_unique<ScratchEvidence>();
 
   tables->Clear(ClassTemplate);
 
@@ -1031,7 +1021,7 @@ void IntegerMatcher::DisplayFeatureDebugInfo(INT_CLASS_STRUCT *ClassTemplate, BI
 
   for (int Feature = 0; Feature < NumFeatures; Feature++) {
     UpdateTablesForFeature(ClassTemplate, ProtoMask, ConfigMask, Feature, &Features[Feature],
-                           tables, 0);
+                           tables.get(), 0);
 
     /* Find Best Evidence for Current Feature */
     int best = 0;
@@ -1053,8 +1043,6 @@ void IntegerMatcher::DisplayFeatureDebugInfo(INT_CLASS_STRUCT *ClassTemplate, BI
       DisplayIntFeature(&Features[Feature], best / 255.0);
     }
   }
-
-  delete tables;
 }
 #endif
 
@@ -1062,36 +1050,29 @@ void IntegerMatcher::DisplayFeatureDebugInfo(INT_CLASS_STRUCT *ClassTemplate, BI
  * Add sum of Proto Evidences into Sum Of Feature Evidence Array
  */
 void ScratchEvidence::UpdateSumOfProtoEvidences(INT_CLASS_STRUCT *ClassTemplate, BIT_VECTOR ConfigMask) {
-  int *IntPointer;
-  uint32_t ConfigWord;
-  int ProtoSetIndex;
-  uint16_t ProtoNum;
-  PROTO_SET_STRUCT *ProtoSet;
-  int NumProtos;
-
-  NumProtos = ClassTemplate->NumProtos;
+  int NumProtos = ClassTemplate->NumProtos;
 
-  for (ProtoSetIndex = 0; ProtoSetIndex < ClassTemplate->NumProtoSets; ProtoSetIndex++) {
-    ProtoSet = ClassTemplate->ProtoSets[ProtoSetIndex];
-    uint16_t ActualProtoNum = (ProtoSetIndex * PROTOS_PER_PROTO_SET);
-    for (ProtoNum = 0; ((ProtoNum < PROTOS_PER_PROTO_SET) && (ActualProtoNum < NumProtos));
-         ProtoNum++, ActualProtoNum++) {
-      int temp = 0;
-      for (uint8_t i = 0; i < MAX_PROTO_INDEX && i < ClassTemplate->ProtoLengths[ActualProtoNum];
-           i++) {
-        temp += proto_evidence_[ActualProtoNum][i];
-      }
+  // Protos without evidence add nothing, so only the matched ones are summed.
+  for (int t = 0; t < num_touched_protos_; t++) {
+    int ActualProtoNum = touched_protos_[t];
+    if (ActualProtoNum >= NumProtos) {
+      continue;
+    }
+    int temp = 0;
+    for (uint8_t i = 0; i < MAX_PROTO_INDEX && i < ClassTemplate->ProtoLengths[ActualProtoNum];
+         i++) {
+      temp += proto_evidence_[ActualProtoNum][i];
+    }
 
-      ConfigWord = ProtoSet->Protos[ProtoNum].Configs[0];
-      ConfigWord &= *ConfigMask;
-      IntPointer = sum_feature_evidence_;
-      while (ConfigWord) {
-        if (ConfigWord & 1) {
-          *IntPointer += temp;
-        }
-        IntPointer++;
-        ConfigWord >>= 1;
+    uint32_t ConfigWord = ProtoForProtoId(ClassTemplate, ActualProtoNum)->Configs[0];
+    ConfigWord &= *ConfigMask;
+    int *IntPointer = sum_feature_evidence_;
+    while (ConfigWord) {
+      if (ConfigWord & 1) {
+        *IntPointer += temp;
       }
+      IntPointer++;
+      ConfigWord >>= 1;
     }
   }
 }
@@ -46,10 +46,16 @@ struct CP_RESULT_STRUCT {
 constexpr int kSETableBits = 9;
 constexpr int kSETableSize = 512;
 
+// Evidence tables of a match. They are reused by all the matches of a
+// thread, so only the rows of proto_evidence_ that a match has written are
+// cleared before the next match.
 struct ScratchEvidence {
   uint8_t feature_evidence_[MAX_NUM_CONFIGS];
   int sum_feature_evidence_[MAX_NUM_CONFIGS];
   uint8_t proto_evidence_[MAX_NUM_PROTOS][MAX_PROTO_INDEX];
+  // Ids of the protos with non-zero proto_evidence_. All other rows are zero.
+  uint16_t touched_protos_[MAX_NUM_PROTOS];
+  int num_touched_protos_ = 0;
 
   void Clear(const INT_CLASS_STRUCT *class_template);
   void ClearFeatureEvidence(const INT_CLASS_STRUCT *class_template);
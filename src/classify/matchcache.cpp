@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////
+// File:        matchcache.cpp
+// Description: Cache of adaptive classifier results for identical blobs.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "matchcache.h"
+
+namespace tesseract {
+
+bool MatchCache::Lookup(const std::string &key, MatchCacheEntry *entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++lookups_;
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  ++hits_;
+  *entry = it->second;
+  return true;
+}
+
+void MatchCache::Store(const std::string &key, const MatchCacheEntry &entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.size() >= static_cast<size_t>(kMaxEntries)) {
+    entries_.clear();
+  }
+  entries_[key] = entry;
+}
+
+void MatchCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+void MatchCache::ResetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lookups_ = 0;
+  hits_ = 0;
+}
+
+} // namespace tesseract
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////
+// File:        matchcache.h
+// Description: Cache of adaptive classifier results for identical blobs.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_MATCHCACHE_H_
+#define TESSERACT_CLASSIFY_MATCHCACHE_H_
+
+#include "shapetable.h" // for UnicharRating
+
+#include <tesseract/export.h>  // for TESS_API
+#include <tesseract/unichar.h> // for UNICHAR_ID
+
+#include <cstdint>       // for int32_t
+#include <mutex>         // for std::mutex
+#include <string>        // for std::string
+#include <unordered_map> // for std::unordered_map
+#include <vector>        // for std::vector
+
+namespace tesseract {
+
+// The results of matching one blob against the templates, as they are left
+// in ADAPT_RESULTS by Classify::DoAdaptiveMatch.
+struct MatchCacheEntry {
+  int32_t blob_length = 0;
+  bool has_nonfragment = false;
+  UNICHAR_ID best_unichar_id = INVALID_UNICHAR_ID;
+  int best_match_index = -1;
+  float best_rating = 0.0f;
+  std::vector<UnicharRating> match;
+};
+
+// Remembers the match results of blobs by a key made of everything the
+// matcher looks at, which is the quantized features of the blob. The same
+// glyph in the same font gives the same features wherever it is on the page,
+// so only the first copy of it has to go through the class pruner and the
+// integer matcher.
+// The cache knows nothing about the templates, so it must be cleared
+// whenever the templates change. Lookup and Store may be called by several
+// threads at the same time.
+class TESS_API MatchCache {
+public:
+  // Entries that are kept at most. When the cache is full, it starts again.
+  static const int kMaxEntries = 50000;
+
+  // Copies the entry for key to *entry and returns true, or returns false if
+  // there is none.
+  bool Lookup(const std::string &key, MatchCacheEntry *entry);
+  // Stores entry as the result for key.
+  void Store(const std::string &key, const MatchCacheEntry &entry);
+  // Forgets all the entries, but keeps the statistics.
+  void Clear();
+  // Resets the statistics.
+  void ResetStats();
+
+  // Statistics since the last ResetStats.
+  int lookups() const {
+    return lookups_;
+  }
+  int hits() const {
+    return hits_;
+  }
+  int size() const {
+    return static_cast<int>(entries_.size());
+  }
+
+private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, MatchCacheEntry> entries_;
+  int lookups_ = 0;
+  int hits_ = 0;
+};
+
+} // namespace tesseract
+
+#endif // TESSERACT_CLASSIFY_MATCHCACHE_H_
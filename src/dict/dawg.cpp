@@ -202,13 +202,47 @@ void Dawg::init(int unicharset_size) {
 ----------------------------------------------------------------------*/
 
 SquishedDawg::~SquishedDawg() {
-  delete[] edges_;
+  FreeEdges();
+}
+
+void SquishedDawg::FreeEdges() {
+  FreeChildIndex();
+  if (owns_edges_) {
+    delete[] edges_;
+  }
+  owns_edges_ = false;
+  mapping_.reset();
+  edges_ = nullptr;
+  num_edges_ = 0;
+}
+
+void SquishedDawg::FreeChildIndex() {
+  child_tables_ = nullptr;
+  owned_child_tables_.clear();
+  child_node_bits_.clear();
+  child_node_ranks_.clear();
 }
 
 EDGE_REF SquishedDawg::edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
                                     bool word_end) const {
   EDGE_REF edge = node;
-  if (node == 0) { // binary search
+  int table = child_table(node);
+  if (table >= 0) { // direct lookup
+    if (unichar_id < 0 || unichar_id >= unicharset_size_) {
+      return NO_EDGE;
+    }
+    uint16_t offset =
+        child_tables_[static_cast<size_t>(table) * unicharset_size_ + unichar_id];
+    if (offset == kNoChild) {
+      return NO_EDGE;
+    }
+    edge += offset;
+    if (!word_end || end_of_word_from_edge_rec(edges_[edge])) {
+      return edge;
+    }
+    // Continue with the linear search from the first edge of the unichar,
+    // for a later one that ends a word.
+  } else if (node == 0) { // binary search
     EDGE_REF start = 0;
     EDGE_REF end = num_forward_edges_in_node0 - 1;
     int compare;
@@ -224,19 +258,20 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
         end = edge - 1;
       }
     }
-  } else { // linear search
-    if (edge != NO_EDGE && edge_occupied(edge)) {
-      do {
-        if ((unichar_id_from_edge_rec(edges_[edge]) == unichar_id) &&
-            (!word_end || end_of_word_from_edge_rec(edges_[edge]))) {
-          return (edge);
-        }
-        if (last_edge(edge)) {
-          break;
-        }
-        ++edge;
-      } while (edge < num_edges_);
-    }
+    return (NO_EDGE); // not found
+  }
+  // linear search
+  if (edge != NO_EDGE && edge_occupied(edge)) {
+    do {
+      if ((unichar_id_from_edge_rec(edges_[edge]) == unichar_id) &&
+          (!word_end || end_of_word_from_edge_rec(edges_[edge]))) {
+        return (edge);
+      }
+      if (last_edge(edge)) {
+        break;
+      }
+      ++edge;
+    } while (edge < num_edges_);
   }
   return (NO_EDGE); // not found
 }
@@ -381,13 +416,21 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
   }
   Dawg::init(unicharset_size);
 
-  delete[] edges_;
-  edges_ = new EDGE_RECORD[num_edges_];
-  if (!file->DeSerialize(&edges_[0], num_edges_)) {
-    delete[] edges_;
-    edges_ = nullptr;
-    num_edges_ = 0;
-    return false;
+  uint32_t num_edges = num_edges_;
+  FreeEdges();
+  num_edges_ = num_edges;
+  // Use the edges in place if they are in a suitably aligned mapped file.
+  const EDGE_RECORD *mapped_edges = file->DeSerializeInPlace<EDGE_RECORD>(num_edges_);
+  if (mapped_edges != nullptr) {
+    edges_ = const_cast<EDGE_ARRAY>(mapped_edges);
+    mapping_ = file->mapping();
+  } else {
+    edges_ = new EDGE_RECORD[num_edges_];
+    owns_edges_ = true;
+    if (!file->DeSerialize(&edges_[0], num_edges_)) {
+      FreeEdges();
+      return false;
+    }
   }
   // Validate the loaded edge structure: check that next_node values are in
   // bounds and that forward edge runs are properly terminated.
@@ -403,9 +446,7 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
         NODE_REF nj = next_node_from_edge_rec(edges_[j]);
         if (nj != 0 && static_cast<uint32_t>(nj) >= num_edges_) {
           tprintf("Dawg edge %u has out-of-bounds next_node\n", j);
-          delete[] edges_;
-          edges_ = nullptr;
-          num_edges_ = 0;
+          FreeEdges();
           return false;
         }
         if (last_edge(j)) {
@@ -417,22 +458,22 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
       } while (j < num_edges_);
       if (!terminated) {
         tprintf("Dawg forward edge run starting at %u is not terminated\n", i);
-        delete[] edges_;
-        edges_ = nullptr;
-        num_edges_ = 0;
+        FreeEdges();
         return false;
       }
     } else {
       NODE_REF next = next_node_from_edge_rec(edges_[i]);
       if (next != 0 && static_cast<uint32_t>(next) >= num_edges_) {
         tprintf("Dawg edge %u has out-of-bounds next_node\n", i);
-        delete[] edges_;
-        edges_ = nullptr;
-        num_edges_ = 0;
+        FreeEdges();
         return false;
       }
     }
   }
+  if (!read_child_index(file)) {
+    FreeEdges();
+    return false;
+  }
   if (debug_level_ > 2) {
     tprintf("type: %d lang: %s perm: %d unicharset_size: %d num_edges: %" PRIu32 "\n",
             type_, lang_.c_str(), perm_, unicharset_size_, num_edges_);
@@ -484,7 +525,139 @@ std::unique_ptr<EDGE_REF[]> SquishedDawg::build_node_map(
   return node_map;
 }
 
-bool SquishedDawg::write_squished_dawg(TFile *file) {
+bool SquishedDawg::read_child_index(TFile *file) {
+  if (file->RemainingBytes() == 0) {
+    return true; // The child index is optional.
+  }
+  int16_t magic;
+  if (!file->DeSerialize(&magic)) {
+    return false;
+  }
+  if (magic != kChildIndexMagicNumber) {
+    // Older writers don't put anything after the edges, so this is unknown
+    // data, which is ignored like older readers ignore the child index.
+    if (debug_level_) {
+      tprintf("Ignoring unknown data after the dawg edges\n");
+    }
+    return true;
+  }
+  uint32_t num_tables;
+  uint32_t table_size;
+  if (!file->DeSerialize(&num_tables) || !file->DeSerialize(&table_size)) {
+    return false;
+  }
+  if (table_size != static_cast<uint32_t>(unicharset_size_) ||
+      num_tables > num_edges_ ||
+      num_tables > file->RemainingBytes() / sizeof(uint32_t)) {
+    tprintf("Bad dawg child index with %u tables of size %u\n", num_tables,
+            table_size);
+    return false;
+  }
+  std::vector<uint32_t> nodes(num_tables);
+  if (num_tables > 0 && !file->DeSerialize(&nodes[0], num_tables)) {
+    return false;
+  }
+  size_t num_entries = static_cast<size_t>(num_tables) * table_size;
+  if (num_entries > file->RemainingBytes() / sizeof(uint16_t)) {
+    tprintf("Dawg child index exceeds remaining data\n");
+    return false;
+  }
+  // Use the tables in place if they are in a suitably aligned mapped file.
+  const uint16_t *tables = file->DeSerializeInPlace<uint16_t>(num_entries);
+  if (tables == nullptr) {
+    owned_child_tables_.resize(num_entries);
+    if (num_entries > 0 &&
+        !file->DeSerialize(&owned_child_tables_[0], num_entries)) {
+      return false;
+    }
+    tables = owned_child_tables_.data();
+  } else {
+    // The tables need the mapping even if the edges were copied.
+    mapping_ = file->mapping();
+  }
+  // Validate the index, so that every lookup finds the same edge as a
+  // linear search would.
+  for (uint32_t t = 0; t < num_tables; ++t) {
+    uint32_t node = nodes[t];
+    if ((t > 0 && node <= nodes[t - 1]) || node >= num_edges_ ||
+        !forward_edge(node)) {
+      tprintf("Dawg child index has a bad node %u\n", node);
+      return false;
+    }
+    const uint16_t *table = tables + static_cast<size_t>(t) * table_size;
+    int32_t num_edges = num_forward_edges(node);
+    for (int32_t e = 0; e < num_edges; ++e) {
+      UNICHAR_ID unichar_id = unichar_id_from_edge_rec(edges_[node + e]);
+      if (unichar_id >= unicharset_size_ || table[unichar_id] == kNoChild ||
+          table[unichar_id] > e) {
+        tprintf("Dawg child index has no entry for edge %u\n", node + e);
+        return false;
+      }
+    }
+    for (uint32_t c = 0; c < table_size; ++c) {
+      if (table[c] != kNoChild &&
+          (table[c] >= num_edges ||
+           unichar_id_from_edge_rec(edges_[node + table[c]]) !=
+               static_cast<UNICHAR_ID>(c))) {
+        tprintf("Dawg child index has a bad entry in node %u\n", node);
+        return false;
+      }
+    }
+  }
+  set_child_nodes(nodes);
+  child_tables_ = tables;
+  return true;
+}
+
+void SquishedDawg::set_child_nodes(const std::vector<uint32_t> &nodes) {
+  size_t num_words = (num_edges_ + 63) / 64;
+  child_node_bits_.assign(num_words, 0);
+  child_node_ranks_.resize(num_words);
+  for (auto node : nodes) {
+    child_node_bits_[node >> 6] |= 1ULL << (node & 63);
+  }
+  uint32_t rank = 0;
+  for (size_t w = 0; w < num_words; ++w) {
+    child_node_ranks_[w] = rank;
+    rank += Popcount(child_node_bits_[w]);
+  }
+}
+
+void SquishedDawg::compute_child_index(const std::vector<EDGE_RECORD> &edges,
+                                       std::vector<uint32_t> *nodes,
+                                       std::vector<uint16_t> *tables) const {
+  nodes->clear();
+  tables->clear();
+  uint32_t num_edges = edges.size();
+  uint32_t end;
+  for (uint32_t node = 0; node < num_edges; node = end) {
+    // The edges of each node end with the one with the marker flag.
+    end = node;
+    bool letters_ok = true;
+    do {
+      if (unichar_id_from_edge_rec(edges[end]) >= unicharset_size_) {
+        letters_ok = false;
+      }
+    } while (!marker_flag_from_edge_rec(edges[end++]) && end < num_edges);
+    uint32_t node_edges = end - node;
+    if (!letters_ok || node_edges < kMinChildTableEdges ||
+        node_edges * kMaxChildTableSparsity < static_cast<uint32_t>(unicharset_size_) ||
+        node_edges >= kNoChild) {
+      continue;
+    }
+    nodes->push_back(node);
+    size_t table = tables->size();
+    tables->resize(table + unicharset_size_, kNoChild);
+    for (uint32_t e = node; e < end; ++e) {
+      uint16_t &entry = (*tables)[table + unichar_id_from_edge_rec(edges[e])];
+      if (entry == kNoChild) {
+        entry = e - node;
+      }
+    }
+  }
+}
+
+bool SquishedDawg::write_squished_dawg(TFile *file, bool with_child_index) {
   EDGE_REF edge;
   int32_t num_edges;
   int32_t node_count = 0;
@@ -524,16 +697,22 @@ bool SquishedDawg::write_squished_dawg(TFile *file) {
     tprintf("%d edges in DAWG\n", num_edges);
   }
 
+  // The edges as they are written, to compute the child index.
+  std::vector<EDGE_RECORD> written_edges;
   for (edge = 0; edge < num_edges_; edge++) {
     if (forward_edge(edge)) { // write forward edges
       do {
-        old_index = next_node_from_edge_rec(edges_[edge]);
-        set_next_node(edge, node_map[old_index]);
+        // The edges may be in a read-only mapped file, so they are
+        // renumbered in a copy.
         temp_record = edges_[edge];
+        old_index = next_node_from_edge_rec(temp_record);
+        set_next_node_in_edge_rec(&temp_record, node_map[old_index]);
         if (!file->Serialize(&temp_record)) {
           return false;
         }
-        set_next_node(edge, old_index);
+        if (with_child_index) {
+          written_edges.push_back(temp_record);
+        }
       } while (!last_edge(edge++));
 
       if (edge >= num_edges_) {
@@ -548,6 +727,23 @@ bool SquishedDawg::write_squished_dawg(TFile *file) {
       edge--;
     }
   }
+  if (with_child_index) {
+    std::vector<uint32_t> nodes;
+    std::vector<uint16_t> tables;
+    compute_child_index(written_edges, &nodes, &tables);
+    int16_t magic = kChildIndexMagicNumber;
+    uint32_t num_tables = nodes.size();
+    uint32_t table_size = unicharset_size_;
+    if (debug_level_) {
+      tprintf("%u child tables in DAWG\n", num_tables);
+    }
+    if (!file->Serialize(&magic) || !file->Serialize(&num_tables) ||
+        !file->Serialize(&table_size) ||
+        !file->Serialize(nodes.data(), nodes.size()) ||
+        !file->Serialize(tables.data(), tables.size())) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -28,6 +28,7 @@
 #include <cinttypes>  // for PRId64
 #include <functional> // for std::function
 #include <memory>
+#include <vector>     // for std::vector
 #include "elst.h"
 #include "params.h"
 #include "ratngs.h"
@@ -42,6 +43,7 @@
 
 namespace tesseract {
 
+class MappedFile;
 class UNICHARSET;
 
 using EDGE_RECORD = uint64_t;
@@ -398,7 +400,13 @@ public:
 /// new words cannot be added to an instance of SquishedDawg.
 /// The underlying representation of the nodes and edges in SquishedDawg
 /// is stored as a contiguous EDGE_ARRAY (read from file or given as an
-/// argument to the constructor).
+/// argument to the constructor). When the dawg is loaded from a memory
+/// mapped traineddata file with an aligned layout, the edges are used in
+/// place and the mapping is kept alive by the dawg.
+/// The edges may be followed in the file by an optional child index, which
+/// holds a dense table for each node with many edges, giving the first edge
+/// for each unichar_id. With it, edge_char_of finds the edge out of such a
+/// node without searching. Older readers ignore the index.
 //
 class TESS_API SquishedDawg : public Dawg {
 public:
@@ -418,6 +426,7 @@ public:
                int debug_level)
       : Dawg(type, lang, perm, debug_level),
         edges_(edges),
+        owns_edges_(true),
         num_edges_(num_edges) {
     init(unicharset_size);
     num_forward_edges_in_node0 = num_forward_edges(0);
@@ -485,8 +494,14 @@ public:
   /// At most max_num_edges will be printed.
   void print_node(NODE_REF node, int max_num_edges) const override;
 
-  /// Writes the squished/reduced Dawg to a file.
-  bool write_squished_dawg(TFile *file);
+  /// Writes the squished/reduced Dawg to a file, followed by a child index
+  /// if with_child_index is true.
+  bool write_squished_dawg(TFile *file, bool with_child_index = false);
+
+  /// Returns true if the dawg has a child index.
+  bool has_child_index() const {
+    return child_tables_ != nullptr;
+  }
 
   /// Opens the file with the given filename and writes the
   /// squished/reduced Dawg to the file.
@@ -545,6 +560,47 @@ private:
   /// Counts and returns the number of forward edges in this node.
   int32_t num_forward_edges(NODE_REF node) const;
 
+  /// Returns the index of the child table of the given node, or -1 if it
+  /// has none. Uses the rank of the node in child_node_bits_, so it takes
+  /// constant time.
+  int child_table(NODE_REF node) const {
+    if (child_tables_ == nullptr || node < 0 || node >= num_edges_) {
+      return -1;
+    }
+    uint64_t bits = child_node_bits_[node >> 6];
+    uint64_t bit = 1ULL << (node & 63);
+    if ((bits & bit) == 0) {
+      return -1;
+    }
+    return child_node_ranks_[node >> 6] + Popcount(bits & (bit - 1));
+  }
+  /// Returns the number of bits set in x.
+  static int Popcount(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x != 0; x &= x - 1) {
+      ++count;
+    }
+    return count;
+#endif
+  }
+  /// Computes the child index of the given edges, which are in the layout
+  /// of the file: the nodes with child tables in increasing order, and
+  /// their tables of unicharset_size_ offsets from the node.
+  void compute_child_index(const std::vector<EDGE_RECORD> &edges,
+                           std::vector<uint32_t> *nodes,
+                           std::vector<uint16_t> *tables) const;
+  /// Reads the child index if there is one after the edges. Returns false
+  /// if it is invalid.
+  bool read_child_index(TFile *file);
+  /// Sets up child_node_bits_ and child_node_ranks_ for the given nodes,
+  /// which are in increasing order.
+  void set_child_nodes(const std::vector<uint32_t> &nodes);
+  /// Releases the child index.
+  void FreeChildIndex();
+
   /// Reads SquishedDawg from a file.
   bool read_squished_dawg(TFile *file);
 
@@ -561,11 +617,38 @@ private:
   }
   /// Constructs a mapping from the memory node indices to disk node indices.
   std::unique_ptr<EDGE_REF[]> build_node_map(int32_t *num_nodes) const;
+  /// Releases the edges (unless they are in a mapped file) and clears them.
+  void FreeEdges();
+
+  /// Magic number of the child index after the edges in a file.
+  static constexpr int16_t kChildIndexMagicNumber = 43;
+  /// Child table entry for a unichar_id that has no edge.
+  static constexpr uint16_t kNoChild = UINT16_MAX;
+  /// Minimum number of edges of a node with a child table.
+  static constexpr int kMinChildTableEdges = 8;
+  /// A node only gets a child table if the table has at most this many
+  /// entries per edge of the node, which bounds the size of the index.
+  static constexpr int kMaxChildTableSparsity = 4;
 
   // Member variables.
   EDGE_ARRAY edges_ = nullptr;
+  // True if edges_ was allocated here, false if it points into mapping_.
+  bool owns_edges_ = false;
+  // The mapped file that edges_ or child_tables_ point into, or nullptr if
+  // neither is used in place.
+  std::shared_ptr<const MappedFile> mapping_;
   uint32_t num_edges_ = 0;
   int num_forward_edges_in_node0 = 0;
+  // The child tables: unicharset_size_ offsets from the node to the first
+  // edge for each unichar_id, or kNoChild, for each node that has one.
+  // Points into owned_child_tables_ or the mapped file.
+  const uint16_t *child_tables_ = nullptr;
+  std::vector<uint16_t> owned_child_tables_;
+  // A bit for each edge, set if it is a node with a child table.
+  std::vector<uint64_t> child_node_bits_;
+  // The number of bits set in child_node_bits_ before each of its words,
+  // which is the index of the first child table of the word.
+  std::vector<uint32_t> child_node_ranks_;
 };
 
 } // namespace tesseract
@@ -21,12 +21,21 @@
 #include "tesserrstream.h"  // for tesserr
 #include "tprintf.h"
 
+#include <atomic> // for std::atomic
 #include <cstdio>
 
 namespace tesseract {
 
 class Image;
 
+// Returns a new value for Dict::dawgs_generation_, unique in the process,
+// so a DawgTransitionCache notices a new set of dawgs even if they reuse
+// the addresses of the old ones.
+static uint32_t NextDawgsGeneration() {
+  static std::atomic<uint32_t> generation(0);
+  return ++generation;
+}
+
 Dict::Dict(CCUtil *ccutil)
     : letter_is_okay_(&tesseract::Dict::def_letter_is_okay)
     , probability_in_context_(&tesseract::Dict::def_probability_in_context)
@@ -374,6 +383,7 @@ bool Dict::FinishLoad() {
     }
     successors_.push_back(lst);
   }
+  dawgs_generation_ = NextDawgsGeneration();
   return true;
 }
 
@@ -396,6 +406,7 @@ void Dict::End() {
   }
   dawgs_.clear();
   successors_.clear();
+  dawgs_generation_ = NextDawgsGeneration();
   document_words_ = nullptr;
   delete pending_words_;
   pending_words_ = nullptr;
@@ -447,14 +458,15 @@ int Dict::def_letter_is_okay(void *void_dawg_args, const UNICHARSET &unicharset,
       // We're in the punctuation dawg.  A core dawg has not been chosen.
       NODE_REF punc_node = GetStartingNode(punc_dawg, pos.punc_ref);
       EDGE_REF punc_transition_edge =
-          punc_dawg->edge_char_of(punc_node, Dawg::kPatternUnicharID, word_end);
+          EdgeCharOf(*dawg_args, pos.punc_index, punc_dawg, punc_node, Dawg::kPatternUnicharID,
+                     word_end);
       if (punc_transition_edge != NO_EDGE) {
         // Find all successors, and see which can transition.
         const SuccessorList &slist = *(successors_[pos.punc_index]);
         for (int sdawg_index : slist) {
           const Dawg *sdawg = dawgs_[sdawg_index];
           UNICHAR_ID ch = char_for_dawg(unicharset, unichar_id, sdawg);
-          EDGE_REF dawg_edge = sdawg->edge_char_of(0, ch, word_end);
+          EDGE_REF dawg_edge = EdgeCharOf(*dawg_args, sdawg_index, sdawg, 0, ch, word_end);
           if (dawg_edge != NO_EDGE) {
             if (dawg_debug_level >= 3) {
               tprintf("Letter found in dawg %d\n", sdawg_index);
@@ -471,7 +483,8 @@ int Dict::def_letter_is_okay(void *void_dawg_args, const UNICHARSET &unicharset,
           }
         }
       }
-      EDGE_REF punc_edge = punc_dawg->edge_char_of(punc_node, unichar_id, word_end);
+      EDGE_REF punc_edge =
+          EdgeCharOf(*dawg_args, pos.punc_index, punc_dawg, punc_node, unichar_id, word_end);
       if (punc_edge != NO_EDGE) {
         if (dawg_debug_level >= 3) {
           tprintf("Letter found in punctuation dawg\n");
@@ -494,7 +507,9 @@ int Dict::def_letter_is_okay(void *void_dawg_args, const UNICHARSET &unicharset,
       //  If we can continue on the punc ref, add that possibility.
       NODE_REF punc_node = GetStartingNode(punc_dawg, pos.punc_ref);
       EDGE_REF punc_edge =
-          punc_node == NO_EDGE ? NO_EDGE : punc_dawg->edge_char_of(punc_node, unichar_id, word_end);
+          punc_node == NO_EDGE
+              ? NO_EDGE
+              : EdgeCharOf(*dawg_args, pos.punc_index, punc_dawg, punc_node, unichar_id, word_end);
       if (punc_edge != NO_EDGE) {
         dawg_args->updated_dawgs->add_unique(
             DawgPosition(pos.dawg_index, pos.dawg_ref, pos.punc_index, punc_edge, true),
@@ -527,7 +542,8 @@ int Dict::def_letter_is_okay(void *void_dawg_args, const UNICHARSET &unicharset,
     EDGE_REF edge =
         (node == NO_EDGE)
             ? NO_EDGE
-            : dawg->edge_char_of(node, char_for_dawg(unicharset, unichar_id, dawg), word_end);
+            : EdgeCharOf(*dawg_args, pos.dawg_index, dawg, node,
+                         char_for_dawg(unicharset, unichar_id, dawg), word_end);
 
     if (dawg_debug_level >= 3) {
       tprintf("Active dawg: [%d, " REFFORMAT "] edge=" REFFORMAT "\n", pos.dawg_index, node, edge);
@@ -32,6 +32,9 @@
 #include "stopper.h"
 #include "trie.h"
 #include "unicharset.h"
+
+#include <algorithm> // for std::fill
+#include <cstdint>   // for uint32_t
 #ifndef DISABLED_LEGACY_ENGINE
 #  include "params_training_featdef.h"
 #endif // ndef DISABLED_LEGACY_ENGINE
@@ -80,6 +83,120 @@ static const int kDocDictMaxRepChars = 4;
 //  2 - the word is inconsistent.
 enum XHeightConsistencyEnum { XH_GOOD, XH_SUBNORMAL, XH_INCONSISTENT };
 
+// Fixed size cache of the results of Dawg::edge_char_of, keyed by the index
+// of the dawg in the Dict, the node and the unichar_id. A search that
+// extends the same dawg positions with the same unichars over and over, like
+// the beam search of the LSTM recognizer, can own one and pass it to
+// Dict::def_letter_is_okay in DawgArgs to save repeating the linear search
+// of the edges of each node. Only SquishedDawgs are cached, as a Trie can
+// change after it has been loaded.
+// The cache is direct mapped, so a new entry just replaces whatever was in
+// its slot, and it never allocates after construction. It is not thread
+// safe, so each thread needs its own.
+class DawgTransitionCache {
+public:
+  // The default size is 1 << kDefaultSizeBits entries.
+  static const int kDefaultSizeBits = 13;
+
+  explicit DawgTransitionCache(int size_bits = kDefaultSizeBits)
+      : shift_(64 - size_bits), entries_(size_t{1} << size_bits) {}
+
+  // Returns true if the result of edge_char_of for the given dawg can be
+  // cached. generation is Dict::dawgs_generation() of the Dict that owns
+  // the dawg, which changes whenever its dawgs are replaced, and clears the
+  // cache when it changes. A different dawg at dawg_index in the same
+  // generation also clears it.
+  bool Cacheable(int dawg_index, const Dawg *dawg, uint32_t generation) {
+    if (generation != generation_) {
+      Clear();
+      generation_ = generation;
+    }
+    if (dawg_index >= static_cast<int>(dawgs_.size())) {
+      dawgs_.resize(dawg_index + 1, nullptr);
+      cacheable_.resize(dawg_index + 1, false);
+    }
+    if (dawgs_[dawg_index] != dawg) {
+      if (dawgs_[dawg_index] != nullptr) {
+        Clear();
+      }
+      dawgs_[dawg_index] = dawg;
+      cacheable_[dawg_index] = dynamic_cast<const SquishedDawg *>(dawg) != nullptr;
+    }
+    return cacheable_[dawg_index];
+  }
+
+  // Returns true and sets *edge if the result of edge_char_of for the given
+  // arguments is in the cache.
+  bool Lookup(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id, bool word_end,
+              EDGE_REF *edge) {
+    const Entry &entry = entries_[Slot(dawg_index, node, unichar_id, word_end)];
+    if (entry.dawg_index == dawg_index && entry.node == node && entry.unichar_id == unichar_id &&
+        entry.word_end == word_end) {
+      *edge = entry.edge;
+      ++hits_;
+      return true;
+    }
+    ++misses_;
+    return false;
+  }
+  // Stores the result of edge_char_of for the given arguments.
+  void Store(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id, bool word_end,
+             EDGE_REF edge) {
+    Entry &entry = entries_[Slot(dawg_index, node, unichar_id, word_end)];
+    entry.node = node;
+    entry.edge = edge;
+    entry.unichar_id = unichar_id;
+    entry.dawg_index = dawg_index;
+    entry.word_end = word_end;
+  }
+
+  // Empties the cache and forgets the dawgs, but keeps the counts.
+  void Clear() {
+    for (auto &entry : entries_) {
+      entry.dawg_index = -1;
+    }
+    std::fill(dawgs_.begin(), dawgs_.end(), nullptr);
+    std::fill(cacheable_.begin(), cacheable_.end(), false);
+  }
+
+  uint64_t hits() const {
+    return hits_;
+  }
+  uint64_t misses() const {
+    return misses_;
+  }
+
+private:
+  struct Entry {
+    NODE_REF node = NO_EDGE;
+    EDGE_REF edge = NO_EDGE;
+    UNICHAR_ID unichar_id = INVALID_UNICHAR_ID;
+    // -1 for an empty entry.
+    int16_t dawg_index = -1;
+    bool word_end = false;
+  };
+
+  // Returns the index in entries_ for the given key, with a multiplicative
+  // hash to spread the similar keys of neighbouring nodes over the table.
+  size_t Slot(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id, bool word_end) const {
+    uint64_t key = static_cast<uint64_t>(node) << 24 ^ static_cast<uint64_t>(unichar_id) << 5 ^
+                   static_cast<uint64_t>(dawg_index) << 1 ^ static_cast<uint64_t>(word_end);
+    return (key * 0x9E3779B97F4A7C15ULL) >> shift_;
+  }
+
+  // 64 minus the number of bits in a slot index.
+  int shift_;
+  std::vector<Entry> entries_;
+  // The dawg seen at each dawg_index, and whether it can be cached.
+  std::vector<const Dawg *> dawgs_;
+  std::vector<bool> cacheable_;
+  // The generation of the dawgs of the Dict that the entries belong to.
+  uint32_t generation_ = 0;
+  // Counts of the lookups that were found or not found.
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
 struct DawgArgs {
   DawgArgs(DawgPositionVector *d, DawgPositionVector *up, PermuterType p)
       : active_dawgs(d), updated_dawgs(up), permuter(p), valid_end(false) {}
@@ -89,6 +206,8 @@ struct DawgArgs {
   PermuterType permuter;
   // True if the current position is a valid word end.
   bool valid_end;
+  // Optional cache of dawg transitions, owned by the caller.
+  DawgTransitionCache *transition_cache = nullptr;
 };
 
 class TESS_API Dict {
@@ -383,6 +502,11 @@ public:
   inline const Dawg *GetDawg(int index) const {
     return dawgs_[index];
   }
+  /// Return a number that changes whenever the dawgs_ vector is replaced,
+  /// and is different for every Dict.
+  inline uint32_t dawgs_generation() const {
+    return dawgs_generation_;
+  }
   /// Return the points to the punctuation dawg.
   inline const Dawg *GetPuncDawg() const {
     return punc_dawg_;
@@ -418,6 +542,22 @@ public:
     }
   }
 
+  /// Returns dawg->edge_char_of(node, unichar_id, word_end), using the
+  /// transition cache of dawg_args if it has one.
+  EDGE_REF EdgeCharOf(const DawgArgs &dawg_args, int dawg_index, const Dawg *dawg,
+                      NODE_REF node, UNICHAR_ID unichar_id, bool word_end) const {
+    DawgTransitionCache *cache = dawg_args.transition_cache;
+    if (cache == nullptr || !cache->Cacheable(dawg_index, dawg, dawgs_generation_)) {
+      return dawg->edge_char_of(node, unichar_id, word_end);
+    }
+    EDGE_REF edge;
+    if (!cache->Lookup(dawg_index, node, unichar_id, word_end, &edge)) {
+      edge = dawg->edge_char_of(node, unichar_id, word_end);
+      cache->Store(dawg_index, node, unichar_id, word_end, edge);
+    }
+    return edge;
+  }
+
   /// For each of the character classes of the given unichar_id (and the
   /// unichar_id itself) finds the corresponding outgoing node or self-loop
   /// in the given dawg and (after checking that it is valid) records it in
@@ -507,6 +647,8 @@ private:
   // Dawgs.
   DawgVector dawgs_;
   SuccessorListsVector successors_;
+  // Changes whenever dawgs_ is loaded or emptied, see dawgs_generation().
+  uint32_t dawgs_generation_ = 0;
   Trie *pending_words_;
   /// The following pointers are only cached for convenience.
   /// The dawgs will be deleted when dawgs_ vector is destroyed.
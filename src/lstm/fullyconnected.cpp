@@ -103,6 +103,13 @@ void FullyConnected::ConvertToInt() {
   weights_.ConvertToInt();
 }
 
+// Makes *this use the weights of other, which must have the same structure.
+void FullyConnected::ShareWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto *fc = static_cast<const FullyConnected *>(&other);
+  weights_.ShareWeights(fc->weights_);
+}
+
 // Provides debug output on the weights.
 void FullyConnected::DebugWeights() {
   weights_.Debug2D(name_.c_str());
@@ -113,7 +120,7 @@ bool FullyConnected::Serialize(TFile *fp) const {
   if (!Network::Serialize(fp)) {
     return false;
   }
-  if (!weights_.Serialize(IsTraining(), fp)) {
+  if (!weights_.Serialize(IsTraining(), TestFlag(NF_SHAPED_WEIGHTS), fp)) {
     return false;
   }
   return true;
@@ -121,7 +128,11 @@ bool FullyConnected::Serialize(TFile *fp) const {
 
 // Reads from the given file. Returns false in case of error.
 bool FullyConnected::DeSerialize(TFile *fp) {
-  return weights_.DeSerialize(IsTraining(), fp);
+  if (!weights_.DeSerialize(IsTraining(), fp)) {
+    return false;
+  }
+  weights_.ShapeWeights();
+  return true;
 }
 
 // Runs forward propagation of activations on the input line.
@@ -77,6 +77,9 @@ public:
   // Converts a float network to an int network.
   void ConvertToInt() override;
 
+  // Makes *this use the weights of other, which must have the same structure.
+  void ShareWeights(const Network &other) override;
+
   // Provides debug output on the weights.
   void DebugWeights() override;
 
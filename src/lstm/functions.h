@@ -18,7 +18,9 @@
 #ifndef TESSERACT_LSTM_FUNCTIONS_H_
 #define TESSERACT_LSTM_FUNCTIONS_H_
 
+#include "activation.h" // for Tanh, Logistic
 #include "helpers.h"
+#include "simddetect.h"  // for TanhInPlace, LogisticInPlace
 #include "tesstypes.h"
 
 // Setting this to 1 or more causes massive dumps of debug data: weights,
@@ -31,46 +33,6 @@
 
 namespace tesseract {
 
-// Size of static tables.
-constexpr int kTableSize = 4096;
-// Scale factor for float arg to int index.
-constexpr TFloat kScaleFactor = 256.0;
-
-// Generated lookup tables.
-extern const TFloat TanhTable[];
-extern const TFloat LogisticTable[];
-
-// Non-linearity (sigmoid) functions with cache tables and clipping.
-inline TFloat Tanh(TFloat x) {
-  if (x < 0) {
-    return -Tanh(-x);
-  }
-  x *= kScaleFactor;
-  auto index = static_cast<unsigned>(x);
-  if (index >= (kTableSize - 1)) {
-    return 1;
-  }
-  TFloat tanh_i0 = TanhTable[index];
-  TFloat tanh_i1 = TanhTable[index + 1];
-  // Linear interpolation.
-  return tanh_i0 + (tanh_i1 - tanh_i0) * (x - index);
-}
-
-inline TFloat Logistic(TFloat x) {
-  if (x < 0) {
-    return 1 - Logistic(-x);
-  }
-  x *= kScaleFactor;
-  auto index = static_cast<unsigned>(x);
-  if (index >= (kTableSize - 1)) {
-    return 1;
-  }
-  TFloat l0 = LogisticTable[index];
-  TFloat l1 = LogisticTable[index + 1];
-  // Linear interpolation.
-  return l0 + (l1 - l0) * (x - index);
-}
-
 // Non-linearity (sigmoid) functions and their derivatives.
 struct FFunc {
   inline TFloat operator()(TFloat x) const {
@@ -167,6 +129,15 @@ inline void FuncInplace(int n, TFloat *inout) {
     inout[i] = f(inout[i]);
   }
 }
+// The table functions are applied by the best SIMD implementation.
+template <>
+inline void FuncInplace<GFunc>(int n, TFloat *inout) {
+  TanhInPlace(n, inout);
+}
+template <>
+inline void FuncInplace<FFunc>(int n, TFloat *inout) {
+  LogisticInPlace(n, inout);
+}
 // Applies Func to u and multiplies the result by v component-wise,
 // putting the product in out, all of size n.
 template <class Func>
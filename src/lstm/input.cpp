@@ -98,15 +98,9 @@ Image Input::PrepareLSTMInputs(const ImageData &image_data, const Network *netwo
   return pix;
 }
 
-// Converts the given pix to a NetworkIO of height and depth appropriate to the
-// given StaticShape:
-// If depth == 3, convert to 24 bit color, otherwise normalized grey.
-// Scale to target height, if the shape's height is > 1, or its depth if the
-// height == 1. If height == 0 then no scaling.
-// NOTE: It isn't safe for multiple threads to call this on the same pix.
-/* static */
-void Input::PreparePixInput(const StaticShape &shape, const Image pix, TRand *randomizer,
-                            NetworkIO *input) {
+// Converts the given pix to the depth required by the given StaticShape and
+// scales it to the target height. Must be pixDestroyed after use.
+static Image NormalizePix(const StaticShape &shape, const Image pix) {
   bool color = shape.depth() == 3;
   Image var_pix = pix;
   int depth = pixGetDepth(var_pix);
@@ -140,8 +134,37 @@ void Input::PreparePixInput(const StaticShape &shape, const Image pix, TRand *ra
     normed_pix.destroy();
     normed_pix = scaled_pix;
   }
+  return normed_pix;
+}
+
+// Converts the given pix to a NetworkIO of height and depth appropriate to the
+// given StaticShape:
+// If depth == 3, convert to 24 bit color, otherwise normalized grey.
+// Scale to target height, if the shape's height is > 1, or its depth if the
+// height == 1. If height == 0 then no scaling.
+// NOTE: It isn't safe for multiple threads to call this on the same pix.
+/* static */
+void Input::PreparePixInput(const StaticShape &shape, const Image pix, TRand *randomizer,
+                            NetworkIO *input) {
+  Image normed_pix = NormalizePix(shape, pix);
   input->FromPix(shape, normed_pix, randomizer);
   normed_pix.destroy();
 }
 
+// As PreparePixInput, but converts all the given pixes to a single batch
+// in the NetworkIO, one batch index per pix.
+/* static */
+void Input::PreparePixesInput(const StaticShape &shape, const std::vector<Image> &pixes,
+                              TRand *randomizer, NetworkIO *input) {
+  std::vector<Image> normed_pixes;
+  normed_pixes.reserve(pixes.size());
+  for (auto &pix : pixes) {
+    normed_pixes.push_back(NormalizePix(shape, pix));
+  }
+  input->FromPixes(shape, normed_pixes, randomizer);
+  for (auto &normed_pix : normed_pixes) {
+    normed_pix.destroy();
+  }
+}
+
 } // namespace tesseract.
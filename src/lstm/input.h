@@ -92,6 +92,11 @@ public:
   // NOTE: It isn't safe for multiple threads to call this on the same pix.
   static void PreparePixInput(const StaticShape &shape, const Image pix,
                               TRand *randomizer, NetworkIO *input);
+  // As PreparePixInput, but converts all the given pixes to a single batch
+  // in the NetworkIO, one batch index per pix.
+  static void PreparePixesInput(const StaticShape &shape,
+                                const std::vector<Image> &pixes,
+                                TRand *randomizer, NetworkIO *input);
 
 private:
   void DebugWeights() override {
@@ -24,6 +24,7 @@
 #ifdef _OPENMP
 #  include <omp.h>
 #endif
+#include <algorithm> // for std::max, std::min
 #include <cstdio>
 #include <cstdlib>
 #include <sstream> // for std::ostringstream
@@ -35,6 +36,7 @@
 #include "fullyconnected.h"
 #include "functions.h"
 #include "networkscratch.h"
+#include "threadpool.h"
 #include "tprintf.h"
 
 // Macros for openmp code if it is available, otherwise empty macros.
@@ -71,6 +73,9 @@ namespace tesseract {
 const TFloat kStateClip = 100.0;
 // Max absolute value of gate_errors (the gradients).
 const TFloat kErrClip = 1.0f;
+// Max number of independent rows that ForwardRows steps together. Limits the
+// scratch space, while still getting plenty of reuse out of each weight.
+const int kMaxForwardRows = 32;
 
 // Calculate ceil(log2(n)).
 static inline uint32_t ceil_log2(uint32_t n) {
@@ -161,6 +166,8 @@ void LSTM::SetEnableTraining(TrainingState state) {
           continue;
         }
         gate_weights_[w].InitBackward();
+        // Training runs Forward with the separate gates, even if fused.
+        gate_weights_[w].ShapeWeights();
       }
     }
     training_ = state;
@@ -185,6 +192,7 @@ int LSTM::InitWeights(float range, TRand *randomizer) {
   if (softmax_ != nullptr) {
     num_weights_ += softmax_->InitWeights(range, randomizer);
   }
+  FuseGates(true);
   return num_weights_;
 }
 
@@ -206,11 +214,60 @@ void LSTM::ConvertToInt() {
     }
     gate_weights_[w].ConvertToInt();
   }
+  FuseGates(true);
   if (softmax_ != nullptr) {
     softmax_->ConvertToInt();
   }
 }
 
+// Sets whether Serialize writes the int weights also SIMD-shaped.
+void LSTM::SetShapedWeights(bool shaped) {
+  Network::SetShapedWeights(shaped);
+  if (softmax_ != nullptr) {
+    softmax_->SetShapedWeights(shaped);
+  }
+}
+
+// Makes *this use the weights of other, which must have the same structure.
+void LSTM::ShareWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM *lstm = static_cast<const LSTM *>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) {
+      continue;
+    }
+    gate_weights_[w].ShareWeights(lstm->gate_weights_[w]);
+  }
+  fused_gates_.ShareWeights(lstm->fused_gates_);
+  if (softmax_ != nullptr) {
+    softmax_->ShareWeights(*lstm->softmax_);
+  }
+}
+
+// Interleaves the gate weights into fused_gates_, or frees it.
+void LSTM::FuseGates(bool fuse) {
+  if (fuse && !Is2D()) {
+    // The first GFS weight types are the 1-d gates, in the order of the
+    // interleaved output.
+    fused_gates_.Init(GFS, gate_weights_);
+    // Only the fused copy of int weights is used when not training, so the
+    // gates keep just wi_ and scales_ for Serialize and FuseGates.
+    if (!IsTraining()) {
+      for (int w = 0; w < GFS; ++w) {
+        gate_weights_[w].FreeShapedWeights();
+      }
+    }
+  } else {
+    fused_gates_.Clear();
+    for (int w = 0; w < WT_COUNT; ++w) {
+      if (w == GFS && !Is2D()) {
+        continue;
+      }
+      gate_weights_[w].ShapeWeights();
+    }
+  }
+}
+
 // Sets up the network for training using the given weight_range.
 void LSTM::DebugWeights() {
   for (int w = 0; w < WT_COUNT; ++w) {
@@ -234,14 +291,20 @@ bool LSTM::Serialize(TFile *fp) const {
   if (!fp->Serialize(&na_)) {
     return false;
   }
+  // Forward uses only the interleaved gates when they exist, so the gates are
+  // then written without shaped weights, and reshaped on reading if needed.
+  bool shaped_gates = TestFlag(NF_SHAPED_WEIGHTS) && !HasShapedFusedGates();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) {
       continue;
     }
-    if (!gate_weights_[w].Serialize(IsTraining(), fp)) {
+    if (!gate_weights_[w].Serialize(IsTraining(), shaped_gates, fp)) {
       return false;
     }
   }
+  if (HasShapedFusedGates() && !fp->omit_weights() && !fused_gates_.Serialize(fp)) {
+    return false;
+  }
   if (softmax_ != nullptr && !softmax_->Serialize(fp)) {
     return false;
   }
@@ -274,6 +337,20 @@ bool LSTM::DeSerialize(TFile *fp) {
       is_2d_ = na_ - nf_ == ni_ + 2 * ns_;
     }
   }
+  if (gate_weights_[CI].weights_omitted()) {
+    // ShareWeights provides the fused gates with the weights.
+    fused_gates_.Clear();
+  } else if (HasShapedFusedGates()) {
+    if (!fused_gates_.DeSerialize(GFS, gate_weights_, fp)) {
+      return false;
+    }
+    // Gates written shaped by older versions don't need their shaped copy.
+    for (int w = 0; w < GFS; ++w) {
+      gate_weights_[w].FreeShapedWeights();
+    }
+  } else {
+    FuseGates(true);
+  }
   delete softmax_;
   if (type_ == NT_LSTM_SOFTMAX || type_ == NT_LSTM_SOFTMAX_ENCODED) {
     softmax_ = static_cast<FullyConnected *>(Network::CreateFromFile(fp));
@@ -301,14 +378,33 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
     output->Resize(input, no_);
   }
   ResizeForward(input);
-  // Temporary storage of forward computation for each gate.
-  NetworkScratch::FloatVec temp_lines[WT_COUNT];
-  int ro = ns_;
-  if (source_.int_mode() && IntSimdMatrix::intSimdMatrix) {
-    ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
+  // The rows are only stepped together for a batch of lines, which only
+  // LSTMRecognizer::RecognizeLines makes, if lstm_batch_size > 1. Everything
+  // else runs the row by row code below as before.
+  if (!Is2D() && softmax_ == nullptr && input_map_.Size(FD_BATCH) > 1) {
+    ForwardRows(input, scratch, output);
+#ifndef GRAPHICS_DISABLED
+    if (debug) {
+      DisplayForward(*output);
+    }
+#endif
+    return;
   }
-  for (auto &temp_line : temp_lines) {
-    temp_line.Init(ns_, ro, scratch);
+  // Temporary storage of forward computation for each gate, or for all the
+  // gates interleaved if fused.
+  bool fused = !fused_gates_.empty() && !IsTraining();
+  NetworkScratch::FloatVec temp_lines[WT_COUNT];
+  NetworkScratch::FloatVec fused_line;
+  if (fused) {
+    fused_line.Init(fused_gates_.NumOutputs(), scratch);
+  } else {
+    int ro = ns_;
+    if (source_.int_mode() && IntSimdMatrix::intSimdMatrix) {
+      ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
+    }
+    for (auto &temp_line : temp_lines) {
+      temp_line.Init(ns_, ro, scratch);
+    }
   }
   // Single timestep buffers for the current/recurrent output and state.
   NetworkScratch::FloatVec curr_state, curr_output;
@@ -331,16 +427,17 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
       ZeroVector<TFloat>(ns_, outputs[i]);
     }
   }
+  // The current output in the representation of source_, so it is only
+  // quantized once per timestep in int mode, and then copied to the source,
+  // the output and the softmax input. It is padded for the softmax.
+  NetworkScratch::IO line_output;
+  line_output.Resize2d(source_.int_mode(), 1, gate_weights_[CI].RoundInputs(ns_), scratch);
+  line_output->ZeroTimeStep(0);
   // Used only if a softmax LSTM.
   NetworkScratch::FloatVec softmax_output;
-  NetworkScratch::IO int_output;
   if (softmax_ != nullptr) {
     softmax_output.Init(no_, scratch);
     ZeroVector<TFloat>(no_, softmax_output);
-    int rounded_softmax_inputs = gate_weights_[CI].RoundInputs(ns_);
-    if (input.int_mode()) {
-      int_output.Resize2d(true, 1, rounded_softmax_inputs, scratch);
-    }
     softmax_->SetupForward(input, nullptr);
   }
   NetworkScratch::FloatVec curr_input;
@@ -365,101 +462,124 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
     if (softmax_ != nullptr) {
       source_.WriteTimeStepPart(t, ni_, nf_, softmax_output);
     }
-    source_.WriteTimeStepPart(t, ni_ + nf_, ns_, curr_output);
+    source_.CopyTimeStepGeneral(t, ni_ + nf_, ns_, *line_output, 0, 0);
     if (Is2D()) {
       source_.WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
     }
     if (!source_.int_mode()) {
       source_.ReadTimeStep(t, curr_input);
     }
-    // Matrix multiply the inputs with the source.
-    PARALLEL_IF_OPENMP(GFS)
-    // It looks inefficient to create the threads on each t iteration, but the
-    // alternative of putting the parallel outside the t loop, a single around
-    // the t-loop and then tasks in place of the sections is a *lot* slower.
-    // Cell inputs.
-    if (source_.int_mode()) {
-      gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
+    if (fused) {
+      // Compute all the gates with a single matrix multiply of the inputs with
+      // the source, and then the new state and output.
+      if (thread_pool_ != nullptr && thread_pool_->num_threads() > 1) {
+        ForwardFusedParallel(t, curr_input, fused_line, curr_state, curr_output);
+      } else {
+        if (source_.int_mode()) {
+          fused_gates_.MatrixDotVector(source_.i(t), fused_line);
+        } else {
+          fused_gates_.MatrixDotVector(curr_input, fused_line);
+        }
+        FusedStateUpdate(0, ns_, fused_line, curr_state, curr_output);
+      }
     } else {
-      gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
-    }
-    FuncInplace<GFunc>(ns_, temp_lines[CI]);
+      // Matrix multiply the inputs with the source.
+      if (thread_pool_ != nullptr && thread_pool_->num_threads() > 1) {
+        TFloat *gate_outputs[WT_COUNT];
+        for (int w = 0; w < WT_COUNT; ++w) {
+          gate_outputs[w] = temp_lines[w];
+        }
+        ForwardGatesParallel(t, curr_input, gate_outputs);
+      } else {
+        PARALLEL_IF_OPENMP(GFS)
+        // It looks inefficient to create the threads on each t iteration, but the
+        // alternative of putting the parallel outside the t loop, a single around
+        // the t-loop and then tasks in place of the sections is a *lot* slower.
+        // Cell inputs.
+        if (source_.int_mode()) {
+          gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
+        } else {
+          gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
+        }
+        FuncInplace<GFunc>(ns_, temp_lines[CI]);
 
-    SECTION_IF_OPENMP
-    // Input Gates.
-    if (source_.int_mode()) {
-      gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
-    } else {
-      gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
-    }
-    FuncInplace<FFunc>(ns_, temp_lines[GI]);
+        SECTION_IF_OPENMP
+        // Input Gates.
+        if (source_.int_mode()) {
+          gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
+        } else {
+          gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
+        }
+        FuncInplace<FFunc>(ns_, temp_lines[GI]);
 
-    SECTION_IF_OPENMP
-    // 1-D forget gates.
-    if (source_.int_mode()) {
-      gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
-    } else {
-      gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
-    }
-    FuncInplace<FFunc>(ns_, temp_lines[GF1]);
+        SECTION_IF_OPENMP
+        // 1-D forget gates.
+        if (source_.int_mode()) {
+          gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
+        } else {
+          gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
+        }
+        FuncInplace<FFunc>(ns_, temp_lines[GF1]);
 
-    // 2-D forget gates.
-    if (Is2D()) {
-      if (source_.int_mode()) {
-        gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
-      } else {
-        gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
-      }
-      FuncInplace<FFunc>(ns_, temp_lines[GFS]);
-    }
+        // 2-D forget gates.
+        if (Is2D()) {
+          if (source_.int_mode()) {
+            gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
+          } else {
+            gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
+          }
+          FuncInplace<FFunc>(ns_, temp_lines[GFS]);
+        }
 
-    SECTION_IF_OPENMP
-    // Output gates.
-    if (source_.int_mode()) {
-      gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
-    } else {
-      gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
-    }
-    FuncInplace<FFunc>(ns_, temp_lines[GO]);
-    END_PARALLEL_IF_OPENMP
+        SECTION_IF_OPENMP
+        // Output gates.
+        if (source_.int_mode()) {
+          gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
+        } else {
+          gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
+        }
+        FuncInplace<FFunc>(ns_, temp_lines[GO]);
+        END_PARALLEL_IF_OPENMP
+      }
 
-    // Apply forget gate to state.
-    MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
-    if (Is2D()) {
-      // Max-pool the forget gates (in 2-d) instead of blindly adding.
-      int8_t *which_fg_col = which_fg_[t];
-      memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
-      if (valid_2d) {
-        const TFloat *stepped_state = states[mod_t];
-        for (int i = 0; i < ns_; ++i) {
-          if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
-            curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
-            which_fg_col[i] = 2;
+      // Apply forget gate to state.
+      MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
+      if (Is2D()) {
+        // Max-pool the forget gates (in 2-d) instead of blindly adding.
+        int8_t *which_fg_col = which_fg_[t];
+        memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
+        if (valid_2d) {
+          const TFloat *stepped_state = states[mod_t];
+          for (int i = 0; i < ns_; ++i) {
+            if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
+              curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
+              which_fg_col[i] = 2;
+            }
           }
         }
       }
-    }
-    MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
-    // Clip curr_state to a sane range.
-    ClipVector<TFloat>(ns_, -kStateClip, kStateClip, curr_state);
-    if (IsTraining()) {
-      // Save the gate node values.
-      node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
-      node_values_[GI].WriteTimeStep(t, temp_lines[GI]);
-      node_values_[GF1].WriteTimeStep(t, temp_lines[GF1]);
-      node_values_[GO].WriteTimeStep(t, temp_lines[GO]);
-      if (Is2D()) {
-        node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
+      MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
+      // Clip curr_state to a sane range.
+      ClipVector<TFloat>(ns_, -kStateClip, kStateClip, curr_state);
+      if (IsTraining()) {
+        // Save the gate node values.
+        node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
+        node_values_[GI].WriteTimeStep(t, temp_lines[GI]);
+        node_values_[GF1].WriteTimeStep(t, temp_lines[GF1]);
+        node_values_[GO].WriteTimeStep(t, temp_lines[GO]);
+        if (Is2D()) {
+          node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
+        }
+      }
+      FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
+      if (IsTraining()) {
+        state_.WriteTimeStep(t, curr_state);
       }
     }
-    FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
-    if (IsTraining()) {
-      state_.WriteTimeStep(t, curr_state);
-    }
+    line_output->WriteTimeStepPart(0, 0, ns_, curr_output);
     if (softmax_ != nullptr) {
       if (input.int_mode()) {
-        int_output->WriteTimeStepPart(0, 0, ns_, curr_output);
-        softmax_->ForwardTimeStep(int_output->i(0), softmax_output);
+        softmax_->ForwardTimeStep(line_output->i(0), softmax_output);
       } else {
         softmax_->ForwardTimeStep(curr_output, t, softmax_output);
       }
@@ -470,11 +590,11 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
     } else if (type_ == NT_LSTM_SUMMARY) {
       // Output only at the end of a row.
       if (src_index.IsLast(FD_WIDTH)) {
-        output->WriteTimeStep(dest_index.t(), curr_output);
+        output->CopyTimeStepGeneral(dest_index.t(), 0, ns_, *line_output, 0, 0);
         dest_index.Increment();
       }
     } else {
-      output->WriteTimeStep(t, curr_output);
+      output->CopyTimeStepGeneral(t, 0, ns_, *line_output, 0, 0);
     }
     // Save states for use by the 2nd dimension only if needed.
     if (Is2D()) {
@@ -486,6 +606,7 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
     if (src_index.IsLast(FD_WIDTH)) {
       ZeroVector<TFloat>(ns_, curr_state);
       ZeroVector<TFloat>(ns_, curr_output);
+      line_output->ZeroTimeStep(0);
     }
   } while (src_index.Increment());
 #if DEBUG_DETAIL > 0
@@ -503,6 +624,238 @@ void LSTM::Forward(bool debug, const NetworkIO &input,
 #endif
 }
 
+// Forward for a 1-d LSTM without softmax. As there is no recurrence between
+// rows, the rows are processed in groups of up to kMaxForwardRows, stepping
+// along x together, so the gate weights are applied to all the rows of a
+// group with one MatrixDotVectors call per gate. The computation for each row
+// is exactly the same as in Forward.
+void LSTM::ForwardRows(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output) {
+  // The start and width of each row of the input.
+  std::vector<StrideMap::Index> rows;
+  std::vector<int> widths;
+  int num_batches = input_map_.Size(FD_BATCH);
+  for (int b = 0; b < num_batches; ++b) {
+    int max_y = StrideMap::Index(input_map_, b, 0, 0).MaxIndexOfDim(FD_HEIGHT);
+    for (int y = 0; y <= max_y; ++y) {
+      StrideMap::Index row(input_map_, b, y, 0);
+      widths.push_back(row.MaxIndexOfDim(FD_WIDTH) + 1);
+      rows.push_back(row);
+    }
+  }
+  int num_rows = std::min(static_cast<int>(rows.size()), kMaxForwardRows);
+  int ro = ns_;
+  if (source_.int_mode() && IntSimdMatrix::intSimdMatrix) {
+    ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
+  }
+  // Per-row storage of the gate values, or of all the gates interleaved if
+  // fused, state, output and input.
+  bool fused = !fused_gates_.empty() && !IsTraining();
+  std::vector<NetworkScratch::FloatVec> temp_lines[GFS];
+  std::vector<NetworkScratch::FloatVec> fused_lines;
+  std::vector<NetworkScratch::FloatVec> curr_states(num_rows), curr_outputs(num_rows);
+  std::vector<NetworkScratch::FloatVec> curr_inputs(num_rows);
+  if (fused) {
+    fused_lines.resize(num_rows);
+    for (auto &line : fused_lines) {
+      line.Init(fused_gates_.NumOutputs(), scratch);
+    }
+  } else {
+    for (auto &lines : temp_lines) {
+      lines.resize(num_rows);
+      for (auto &line : lines) {
+        line.Init(ns_, ro, scratch);
+      }
+    }
+  }
+  for (int r = 0; r < num_rows; ++r) {
+    curr_states[r].Init(ns_, scratch);
+    curr_outputs[r].Init(ns_, scratch);
+    curr_inputs[r].Init(na_, scratch);
+  }
+  // The current output of each row in the representation of source_, as in
+  // Forward.
+  NetworkScratch::IO line_outputs;
+  line_outputs.Resize2d(source_.int_mode(), num_rows, ns_, scratch);
+  // Arguments to MatrixDotVectors for the rows that are active at some x.
+  std::vector<int> active;
+  std::vector<const int8_t *> int_inputs(num_rows);
+  std::vector<const TFloat *> float_inputs(num_rows);
+  std::vector<TFloat *> gate_outputs[GFS];
+  for (auto &gate_output : gate_outputs) {
+    gate_output.resize(num_rows);
+  }
+  std::vector<TFloat *> fused_outputs(num_rows);
+  for (unsigned start = 0; start < rows.size(); start += num_rows) {
+    int group_size = std::min(num_rows, static_cast<int>(rows.size() - start));
+    int max_width = 0;
+    for (int r = 0; r < group_size; ++r) {
+      ZeroVector<TFloat>(ns_, curr_states[r]);
+      line_outputs->ZeroTimeStep(r);
+      max_width = std::max(max_width, widths[start + r]);
+    }
+    for (int x = 0; x < max_width; ++x) {
+      active.clear();
+      for (int r = 0; r < group_size; ++r) {
+        if (x < widths[start + r]) {
+          active.push_back(r);
+        }
+      }
+      int num_active = active.size();
+      // Setup the padded input in source for each active row. Width is the
+      // innermost dimension, so the timestep is just offset by x.
+      for (int i = 0; i < num_active; ++i) {
+        int r = active[i];
+        int t = rows[start + r].t() + x;
+        source_.CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
+        source_.CopyTimeStepGeneral(t, ni_ + nf_, ns_, *line_outputs, r, 0);
+        if (source_.int_mode()) {
+          int_inputs[i] = source_.i(t);
+        } else {
+          source_.ReadTimeStep(t, curr_inputs[r]);
+          float_inputs[i] = curr_inputs[r];
+        }
+        if (fused) {
+          fused_outputs[i] = fused_lines[r];
+        } else {
+          for (int w = 0; w < GFS; ++w) {
+            gate_outputs[w][i] = temp_lines[w][r];
+          }
+        }
+      }
+      // Matrix multiply the inputs with the source.
+      if (fused) {
+        if (source_.int_mode()) {
+          fused_gates_.MatrixDotVectors(num_active, &int_inputs[0], &fused_outputs[0]);
+        } else {
+          fused_gates_.MatrixDotVectors(num_active, &float_inputs[0], &fused_outputs[0]);
+        }
+      } else {
+        for (int w = 0; w < GFS; ++w) {
+          if (source_.int_mode()) {
+            gate_weights_[w].MatrixDotVectors(num_active, &int_inputs[0], &gate_outputs[w][0]);
+          } else {
+            gate_weights_[w].MatrixDotVectors(num_active, &float_inputs[0], &gate_outputs[w][0]);
+          }
+        }
+      }
+      for (int i = 0; i < num_active; ++i) {
+        int r = active[i];
+        const StrideMap::Index &row = rows[start + r];
+        int t = row.t() + x;
+        TFloat *curr_state = curr_states[r];
+        TFloat *curr_output = curr_outputs[r];
+        if (fused) {
+          FusedStateUpdate(0, ns_, fused_lines[r], curr_state, curr_output);
+        } else {
+          FuncInplace<GFunc>(ns_, temp_lines[CI][r]);
+          FuncInplace<FFunc>(ns_, temp_lines[GI][r]);
+          FuncInplace<FFunc>(ns_, temp_lines[GF1][r]);
+          FuncInplace<FFunc>(ns_, temp_lines[GO][r]);
+          // Apply forget gate to state.
+          MultiplyVectorsInPlace(ns_, temp_lines[GF1][r], curr_state);
+          MultiplyAccumulate(ns_, temp_lines[CI][r], temp_lines[GI][r], curr_state);
+          // Clip curr_state to a sane range.
+          ClipVector<TFloat>(ns_, -kStateClip, kStateClip, curr_state);
+          if (IsTraining()) {
+            // Save the gate node values.
+            for (int w = 0; w < GFS; ++w) {
+              node_values_[w].WriteTimeStep(t, temp_lines[w][r]);
+            }
+          }
+          FuncMultiply<HFunc>(curr_state, temp_lines[GO][r], ns_, curr_output);
+          if (IsTraining()) {
+            state_.WriteTimeStep(t, curr_state);
+          }
+        }
+        line_outputs->WriteTimeStepPart(r, 0, ns_, curr_output);
+        if (type_ == NT_LSTM_SUMMARY) {
+          // Output only at the end of a row.
+          if (x + 1 == widths[start + r]) {
+            StrideMap::Index dest_index(output->stride_map(), row.index(FD_BATCH),
+                                        row.index(FD_HEIGHT), 0);
+            output->CopyTimeStepGeneral(dest_index.t(), 0, ns_, *line_outputs, r, 0);
+          }
+        } else {
+          output->CopyTimeStepGeneral(t, 0, ns_, *line_outputs, r, 0);
+        }
+      }
+    }
+  }
+}
+
+// Computes the activated gate values of timestep t, sharing the rows of all
+// the gates out between the threads of thread_pool_.
+void LSTM::ForwardGatesParallel(int t, const TFloat *curr_input, TFloat *const *gate_outputs) {
+  int num_gates = Is2D() ? WT_COUNT : GFS;
+  int num_threads = thread_pool_->num_threads();
+  // Each part is a whole number of the output groups of the SIMD code, so the
+  // parts never write over each other.
+  int group_size = gate_weights_[CI].OutputGroupSize();
+  int part_size = (ns_ + num_threads - 1) / num_threads;
+  part_size = (part_size + group_size - 1) / group_size * group_size;
+  int num_parts = (ns_ + part_size - 1) / part_size;
+  const int8_t *int_input = source_.int_mode() ? source_.i(t) : nullptr;
+  thread_pool_->ParallelFor(num_gates * num_parts, [&](int item, int) {
+    int gate = item / num_parts;
+    int start = item % num_parts * part_size;
+    int end = std::min(start + part_size, static_cast<int>(ns_));
+    TFloat *gate_output = gate_outputs[gate];
+    if (int_input != nullptr) {
+      gate_weights_[gate].MatrixDotVectorPart(int_input, start, end, gate_output);
+    } else {
+      gate_weights_[gate].MatrixDotVectorPart(curr_input, start, end, gate_output);
+    }
+    if (gate == CI) {
+      FuncInplace<GFunc>(end - start, gate_output + start);
+    } else {
+      FuncInplace<FFunc>(end - start, gate_output + start);
+    }
+  });
+}
+
+// Computes the interleaved gate values of timestep t with fused_gates_, and
+// the new curr_state and curr_output from them, sharing the rows out between
+// the threads of thread_pool_.
+void LSTM::ForwardFusedParallel(int t, const TFloat *curr_input, TFloat *gates,
+                                TFloat *curr_state, TFloat *curr_output) {
+  int num_threads = thread_pool_->num_threads();
+  int num_outputs = fused_gates_.NumOutputs();
+  int num_gates = fused_gates_.num_gates();
+  // Each part is a whole number of blocks of all the gates, and of output
+  // groups of the SIMD code, so the parts never write over each other, and
+  // each part holds all the gate values of its own cells.
+  int group_size = fused_gates_.OutputGroupSize();
+  int part_size = (num_outputs + num_threads - 1) / num_threads;
+  part_size = (part_size + group_size - 1) / group_size * group_size;
+  int num_parts = (num_outputs + part_size - 1) / part_size;
+  const int8_t *int_input = source_.int_mode() ? source_.i(t) : nullptr;
+  thread_pool_->ParallelFor(num_parts, [&](int part, int) {
+    int start = part * part_size;
+    int end = std::min(start + part_size, num_outputs);
+    if (int_input != nullptr) {
+      fused_gates_.MatrixDotVectorPart(int_input, start, end, gates);
+    } else {
+      fused_gates_.MatrixDotVectorPart(curr_input, start, end, gates);
+    }
+    FusedStateUpdate(start / num_gates, std::min(end / num_gates, static_cast<int>(ns_)), gates,
+                     curr_state, curr_output);
+  });
+}
+
+// Updates the state and output of the cells [start, end) from the
+// interleaved gate values computed with fused_gates_, one block at a time,
+// so all the values of a block are still in cache.
+void LSTM::FusedStateUpdate(int start, int end, const TFloat *gates, TFloat *curr_state,
+                            TFloat *curr_output) const {
+  int block_size = fused_gates_.block_size();
+  for (int i = start; i < end; i += block_size) {
+    int n = std::min(block_size, end - i);
+    LSTMStateUpdate(n, gates + fused_gates_.Index(CI, i), gates + fused_gates_.Index(GI, i),
+                    gates + fused_gates_.Index(GF1, i), gates + fused_gates_.Index(GO, i),
+                    kStateClip, curr_state + i, curr_output + i);
+  }
+}
+
 // Runs backward propagation of errors on the deltas line.
 // See NetworkCpp for a detailed discussion of the arguments.
 bool LSTM::Backward(bool debug, const NetworkIO &fwd_deltas, NetworkScratch *scratch,
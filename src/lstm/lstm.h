@@ -85,6 +85,11 @@ public:
 
   // Converts a float network to an int network.
   void ConvertToInt() override;
+  // Sets whether Serialize writes the int weights also SIMD-shaped.
+  void SetShapedWeights(bool shaped) override;
+
+  // Makes *this use the weights of other, which must have the same structure.
+  void ShareWeights(const Network &other) override;
 
   // Provides debug output on the weights.
   void DebugWeights() override;
@@ -120,9 +125,40 @@ public:
     return is_2d_;
   }
 
+  // If fuse, interleaves the gate weights into fused_gates_, so that Forward
+  // computes all the gates with a single matrix.vector product per timestep
+  // when not training, otherwise frees fused_gates_, so Forward uses the
+  // separate gate weights. Only a 1-d LSTM is fused. Called with true
+  // whenever the gate weights are loaded or converted.
+  TESS_API
+  void FuseGates(bool fuse);
+
 private:
+  // Returns true if Serialize writes the shaped fused gate weights.
+  bool HasShapedFusedGates() const {
+    return TestFlag(NF_SHAPED_WEIGHTS) && !Is2D() && gate_weights_[CI].is_int_mode();
+  }
   // Resizes forward data to cope with an input image of the given width.
   void ResizeForward(const NetworkIO &input);
+  // Forward for a 1-d LSTM without softmax, in which the rows of the input
+  // are independent. Steps several rows along x together, so that each gate
+  // weight matrix is applied to the inputs of all of them in one pass.
+  void ForwardRows(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output);
+  // Computes the activated gate values of timestep t into gate_outputs, from
+  // source_ in int mode, or else from curr_input. The rows of all the gates
+  // together are split into parts that are shared out between the threads of
+  // thread_pool_. The results are identical to computing each gate in turn.
+  void ForwardGatesParallel(int t, const TFloat *curr_input, TFloat *const *gate_outputs);
+  // As ForwardGatesParallel, but computes the interleaved gate values with
+  // fused_gates_ and then updates curr_state and curr_output from them, so
+  // each part of the rows also completes the timestep for its own cells.
+  void ForwardFusedParallel(int t, const TFloat *curr_input, TFloat *gates, TFloat *curr_state,
+                            TFloat *curr_output);
+  // Updates the state and output of the cells [start, end) from the
+  // interleaved gate values computed with fused_gates_. start must be at the
+  // start of a block.
+  void FusedStateUpdate(int start, int end, const TFloat *gates, TFloat *curr_state,
+                        TFloat *curr_output) const;
 
 private:
   // Size of padded input to weight matrices = ni_ + no_ for 1-D operation
@@ -141,6 +177,9 @@ private:
 
   // Gate weight arrays of size [na + 1, no].
   WeightMatrix gate_weights_[WT_COUNT];
+  // The CI, GI, GF1 and GO gate weights interleaved, used to run forward
+  // when not training. Empty for a 2-d LSTM.
+  FusedWeightMatrix fused_gates_;
   // Used only if this is a softmax LSTM.
   FullyConnected *softmax_;
   // Input padded with previous output of size [width, na].
@@ -35,8 +35,10 @@
 #include "recodebeam.h"
 #include "scrollview.h"
 #include "statistc.h"
+#include "threadpool.h"
 #include "tprintf.h"
 
+#include <algorithm>
 #include <unordered_set>
 #include <vector>
 
@@ -63,23 +65,38 @@ LSTMRecognizer::LSTMRecognizer()
     , adam_beta_(0.0f)
     , dict_(nullptr)
     , search_(nullptr)
+    , shared_model_(nullptr)
+    , parent_(nullptr)
+    , thread_pool_(nullptr)
     , debug_win_(nullptr) {}
 
 LSTMRecognizer::~LSTMRecognizer() {
   delete network_;
   delete dict_;
   delete search_;
+  delete thread_pool_;
+  GlobalModelCache()->Free(shared_model_);
+}
+
+ObjectCache<LSTMRecognizer> *LSTMRecognizer::GlobalModelCache() {
+  // This global cache (a singleton) will outlive every Tesseract instance
+  // (even those that someone else might declare as global static variables).
+  static ObjectCache<LSTMRecognizer> cache;
+  return &cache;
 }
 
 // Loads a model from mgr, including the dictionary only if lang is not null.
 bool LSTMRecognizer::Load(const ParamsVectors *params, const std::string &lang,
                           TessdataManager *mgr) {
-  TFile fp;
-  if (!mgr->GetComponent(TESSDATA_LSTM, &fp)) {
-    return false;
-  }
-  if (!DeSerialize(mgr, &fp)) {
-    return false;
+  if (!ShareModel(mgr)) {
+    // The model is not in the cache, so *this gets a private copy.
+    TFile fp;
+    if (!mgr->GetComponent(TESSDATA_LSTM, &fp)) {
+      return false;
+    }
+    if (!DeSerialize(mgr, &fp)) {
+      return false;
+    }
   }
   if (lang.empty()) {
     return true;
@@ -89,6 +106,99 @@ bool LSTMRecognizer::Load(const ParamsVectors *params, const std::string &lang,
   return true;
 }
 
+// Makes *this a copy of the model of mgr in the GlobalModelCache, reading
+// it there first if needed, whose network_ uses the weights of the cached one
+// and whose GetRecoder() returns the cached recoder, so that the model is read
+// only once and held in memory only once, however many instances use it. The
+// cache is keyed like the DawgCache, plus the contents of the components read
+// by DeSerialize, as the file name alone does not tell apart a file that was
+// replaced, or different models loaded from memory under the same name. The
+// unicharset is copied, as the Dict is bound to the one in ccutil_.
+bool LSTMRecognizer::ShareModel(TessdataManager *mgr) {
+  std::string model_id = mgr->GetDataFileName();
+  model_id += kTessdataFileSuffixes[TESSDATA_LSTM];
+  for (auto type : {TESSDATA_LSTM, TESSDATA_LSTM_UNICHARSET, TESSDATA_LSTM_RECODER}) {
+    model_id += ':';
+    model_id += mgr->ComponentId(type);
+  }
+  LSTMRecognizer *model = GlobalModelCache()->Get(model_id, [mgr]() -> LSTMRecognizer * {
+    TFile fp;
+    auto *model = new LSTMRecognizer;
+    if (!mgr->GetComponent(TESSDATA_LSTM, &fp) || !model->DeSerialize(mgr, &fp)) {
+      delete model;
+      return nullptr;
+    }
+    return model;
+  });
+  if (model == nullptr) {
+    return false;
+  }
+  std::vector<char> unicharset_data;
+  TFile writer;
+  writer.OpenWrite(&unicharset_data);
+  TFile reader;
+  bool copied = model->ccutil_.unicharset.save_to_file(&writer) &&
+                reader.Open(&unicharset_data[0], unicharset_data.size()) &&
+                ccutil_.unicharset.load_from_file(&reader, false);
+  Network *network = copied ? model->network_->CopySharingWeights() : nullptr;
+  if (network == nullptr) {
+    GlobalModelCache()->Free(model);
+    return false;
+  }
+  delete network_;
+  network_ = network;
+  network_->SetRandomizer(&randomizer_);
+  network_->SetThreadPool(thread_pool_);
+  network_->CacheXScaleFactor(network_->XScaleFactor());
+  network_str_ = model->network_str_;
+  training_flags_ = model->training_flags_;
+  training_iteration_ = model->training_iteration_;
+  sample_iteration_ = model->sample_iteration_;
+  null_char_ = model->null_char_;
+  adam_beta_ = model->adam_beta_;
+  learning_rate_ = model->learning_rate_;
+  momentum_ = model->momentum_;
+  recoder_ = UnicharCompress();
+  GlobalModelCache()->Free(shared_model_);
+  shared_model_ = model;
+  return true;
+}
+
+// Returns a new LSTMRecognizer that shares the model and Dict of *this, with
+// a private copy of the network structure to hold the state of a forward pass.
+LSTMRecognizer *LSTMRecognizer::NewWorker() {
+  auto *worker = new LSTMRecognizer;
+  worker->network_ = network_->CopySharingWeights();
+  if (worker->network_ == nullptr) {
+    delete worker;
+    return nullptr;
+  }
+  worker->network_->SetRandomizer(&worker->randomizer_);
+  worker->network_->CacheXScaleFactor(worker->network_->XScaleFactor());
+  worker->network_str_ = network_str_;
+  worker->training_flags_ = training_flags_;
+  worker->training_iteration_ = training_iteration_;
+  worker->sample_iteration_ = sample_iteration_;
+  worker->null_char_ = null_char_;
+  worker->adam_beta_ = adam_beta_;
+  worker->learning_rate_ = learning_rate_;
+  worker->momentum_ = momentum_;
+  worker->parent_ = this;
+  return worker;
+}
+
+// Sets the number of threads that share the work of each timestep.
+void LSTMRecognizer::SetNumThreads(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  int current_threads = thread_pool_ != nullptr ? thread_pool_->num_threads() : 1;
+  if (num_threads == current_threads) {
+    return;
+  }
+  delete thread_pool_;
+  thread_pool_ = num_threads > 1 ? new ThreadPool(num_threads) : nullptr;
+  network_->SetThreadPool(thread_pool_);
+}
+
 // Writes to the given file. Returns false in case of error.
 bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp) const {
   bool include_charsets = mgr == nullptr || !mgr->IsComponentAvailable(TESSDATA_LSTM_RECODER) ||
@@ -123,7 +233,7 @@ bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp) const {
   if (!fp->Serialize(&momentum_)) {
     return false;
   }
-  if (include_charsets && IsRecoding() && !recoder_.Serialize(fp)) {
+  if (include_charsets && IsRecoding() && !GetRecoder().Serialize(fp)) {
     return false;
   }
   return true;
@@ -131,6 +241,8 @@ bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp) const {
 
 // Reads from the given file. Returns false in case of error.
 bool LSTMRecognizer::DeSerialize(const TessdataManager *mgr, TFile *fp) {
+  GlobalModelCache()->Free(shared_model_);
+  shared_model_ = nullptr;
   delete network_;
   network_ = Network::CreateFromFile(fp);
   if (network_ == nullptr) {
@@ -172,6 +284,7 @@ bool LSTMRecognizer::DeSerialize(const TessdataManager *mgr, TFile *fp) {
     return false;
   }
   network_->SetRandomizer(&randomizer_);
+  network_->SetThreadPool(thread_pool_);
   network_->CacheXScaleFactor(network_->XScaleFactor());
   return true;
 }
@@ -255,10 +368,25 @@ void LSTMRecognizer::RecognizeLine(const ImageData &image_data,
   if (!RecognizeLine(image_data, invert_threshold, debug, false, false, &scale_factor, &inputs, &outputs)) {
     return;
   }
+  DecodeLine(outputs, scale_factor, debug, worst_dict_cert, line_box, words, lstm_choice_mode,
+             lstm_choice_amount);
+}
+
+// Decodes the given network outputs of a line, as computed by RecognizeLine
+// or RecognizeLines, into tesseract WERD_RES for the words.
+void LSTMRecognizer::DecodeLine(const NetworkIO &outputs, float scale_factor, bool debug,
+                                double worst_dict_cert, const TBOX &line_box,
+                                PointerVector<WERD_RES> *words, int lstm_choice_mode,
+                                int lstm_choice_amount) {
   if (search_ == nullptr) {
-    search_ = new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+    search_ = new RecodeBeamSearch(GetRecoder(), null_char_, SimpleTextOutput(), GetDict());
   }
   search_->excludedUnichars.clear();
+  if (thread_pool_ != nullptr) {
+    // Use the threads that computed the outputs to find the top choices of
+    // all the timesteps, so the search only has to look them up.
+    search_->PrecomputeTopN(outputs, thread_pool_);
+  }
   search_->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert, &GetUnicharset(),
                   lstm_choice_mode);
   search_->ExtractBestPathAsWords(line_box, scale_factor, debug, &GetUnicharset(), words);
@@ -290,6 +418,47 @@ void LSTMRecognizer::RecognizeLine(const ImageData &image_data,
   }
 }
 
+// Runs the network forward on all the given line images as a single batch.
+// The padding of the shorter lines does not affect the outputs of the others,
+// as all the layers respect the size of each element of the batch.
+void LSTMRecognizer::RecognizeLines(const std::vector<const ImageData *> &images,
+                                    std::vector<float> *scale_factors,
+                                    std::vector<NetworkIO> *outputs) {
+  scale_factors->assign(images.size(), 0.0f);
+  outputs->clear();
+  outputs->resize(images.size());
+  int min_width = network_->XScaleFactor();
+  std::vector<Image> pixes;
+  // Index into images of each element of the batch.
+  std::vector<unsigned> batch_indices;
+  for (unsigned i = 0; i < images.size(); ++i) {
+    float scale_factor;
+    Image pix = Input::PrepareLSTMInputs(*images[i], network_, min_width, &scale_factor);
+    if (pix == nullptr) {
+      tprintf("Line cannot be recognized!!\n");
+      continue;
+    }
+    // Reduction factor from image to coords.
+    (*scale_factors)[i] = min_width / scale_factor;
+    pixes.push_back(pix);
+    batch_indices.push_back(i);
+  }
+  if (pixes.empty()) {
+    return;
+  }
+  NetworkIO inputs, batch_outputs;
+  inputs.set_int_mode(IsIntMode());
+  SetRandomSeed();
+  Input::PreparePixesInput(network_->InputShape(), pixes, &randomizer_, &inputs);
+  network_->Forward(false, inputs, nullptr, &scratch_space_, &batch_outputs);
+  for (unsigned b = 0; b < batch_indices.size(); ++b) {
+    (*outputs)[batch_indices[b]].CopyBatchItem(batch_outputs, b);
+  }
+  for (auto &pix : pixes) {
+    pix.destroy();
+  }
+}
+
 // Helper computes min and mean best results in the output.
 void LSTMRecognizer::OutputStats(const NetworkIO &outputs, float *min_output, float *mean_output,
                                  float *sd) {
@@ -529,7 +698,7 @@ void LSTMRecognizer::LabelsFromOutputs(const NetworkIO &outputs, std::vector<int
 void LSTMRecognizer::LabelsViaReEncode(const NetworkIO &output, std::vector<int> *labels,
                                        std::vector<int> *xcoords) {
   if (search_ == nullptr) {
-    search_ = new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+    search_ = new RecodeBeamSearch(GetRecoder(), null_char_, SimpleTextOutput(), GetDict());
   }
   search_->Decode(output, 1.0, 0.0, RecodeBeamSearch::kMinCertainty, nullptr);
   search_->ExtractBestPathAsLabels(labels, xcoords);
@@ -565,7 +734,7 @@ const char *LSTMRecognizer::DecodeLabel(const std::vector<int> &labels, unsigned
     if (labels[start] == null_char_) {
       if (decoded != nullptr) {
         code.Set(0, null_char_);
-        *decoded = recoder_.DecodeUnichar(code);
+        *decoded = GetRecoder().DecodeUnichar(code);
       }
       return "<null>";
     }
@@ -575,12 +744,12 @@ const char *LSTMRecognizer::DecodeLabel(const std::vector<int> &labels, unsigned
       while (index < labels.size() && labels[index] == null_char_) {
         ++index;
       }
-      int uni_id = recoder_.DecodeUnichar(code);
+      int uni_id = GetRecoder().DecodeUnichar(code);
       // If the next label isn't a valid first code, then we need to continue
       // extending even if we have a valid uni_id from this prefix.
       if (uni_id != INVALID_UNICHAR_ID &&
           (index == labels.size() || code.length() == RecodedCharID::kMaxCodeLen ||
-           recoder_.IsValidFirstCode(labels[index]))) {
+           GetRecoder().IsValidFirstCode(labels[index]))) {
         *end = index;
         if (decoded != nullptr) {
           *decoded = uni_id;
@@ -616,7 +785,7 @@ const char *LSTMRecognizer::DecodeSingleLabel(int label) {
     // Decode label via recoder_.
     RecodedCharID code;
     code.Set(0, label);
-    label = recoder_.DecodeUnichar(code);
+    label = GetRecoder().DecodeUnichar(code);
     if (label == INVALID_UNICHAR_ID) {
       return ".."; // Part of a bigger code.
     }
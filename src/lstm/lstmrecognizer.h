@@ -23,6 +23,7 @@
 #include "matrix.h"
 #include "network.h"
 #include "networkscratch.h"
+#include "object_cache.h"
 #include "params.h"
 #include "recodebeam.h"
 #include "series.h"
@@ -39,6 +40,7 @@ namespace tesseract {
 
 class Dict;
 class ImageData;
+class ThreadPool;
 
 // Enum indicating training mode control flags.
 enum TrainingFlags {
@@ -184,24 +186,33 @@ public:
       training_flags_ |= TF_INT_MODE;
     }
   }
+  // Makes Serialize write the int weights also shaped for the SIMD code of
+  // this machine, so loading them on a machine with the same SIMD layout
+  // doesn't have to shape them again.
+  void SetShapedWeights(bool shaped) {
+    network_->SetShapedWeights(shaped);
+  }
 
   // Provides access to the UNICHARSET that this classifier works with.
   const UNICHARSET &GetUnicharset() const {
-    return ccutil_.unicharset;
+    return parent_ != nullptr ? parent_->GetUnicharset() : ccutil_.unicharset;
   }
   UNICHARSET &GetUnicharset() {
-    return ccutil_.unicharset;
+    return parent_ != nullptr ? parent_->GetUnicharset() : ccutil_.unicharset;
   }
   // Provides access to the UnicharCompress that this classifier works with.
   const UnicharCompress &GetRecoder() const {
-    return recoder_;
+    if (parent_ != nullptr) {
+      return parent_->GetRecoder();
+    }
+    return shared_model_ != nullptr ? shared_model_->recoder_ : recoder_;
   }
   // Provides access to the Dict that this classifier works with.
   const Dict *GetDict() const {
-    return dict_;
+    return parent_ != nullptr ? parent_->GetDict() : dict_;
   }
   Dict *GetDict() {
-    return dict_;
+    return parent_ != nullptr ? parent_->GetDict() : dict_;
   }
   // Sets the sample iteration to the given value. The sample_iteration_
   // determines the seed for the random number generator. The training
@@ -220,8 +231,25 @@ public:
   }
 
   // Loads a model from mgr, including the dictionary only if lang is not null.
+  // The weights and recoder are shared with all other LSTMRecognizers that
+  // Load the same traineddata, through the GlobalModelCache.
   bool Load(const ParamsVectors *params, const std::string &lang, TessdataManager *mgr);
 
+  // Returns the cache of the read-only models that are shared between
+  // LSTMRecognizers. It outlives every LSTMRecognizer.
+  static ObjectCache<LSTMRecognizer> *GlobalModelCache();
+
+  // Returns a new LSTMRecognizer that uses the weights, charsets and Dict of
+  // *this, but has its own network state, scratch space and beam search, so
+  // it can recognize lines on another thread at the same time as *this, and
+  // as any other worker. *this must outlive the worker and must not be
+  // changed while it is in use. Returns nullptr in case of error.
+  LSTMRecognizer *NewWorker();
+
+  // Sets the number of threads that share the work of each timestep of the
+  // network, using a thread pool owned by *this. 1 runs on the calling thread.
+  void SetNumThreads(int num_threads);
+
   // Writes to the given file. Returns false in case of error.
   // If mgr contains a unicharset and recoder, then they are not encoded to fp.
   bool Serialize(const TessdataManager *mgr, TFile *fp) const;
@@ -253,6 +281,23 @@ public:
                      const TBOX &line_box, PointerVector<WERD_RES> *words, int lstm_choice_mode = 0,
                      int lstm_choice_amount = 5);
 
+  // Decodes the given network outputs of a line, as computed by RecognizeLine
+  // or RecognizeLines, into tesseract WERD_RES for the words, as above.
+  // scale_factor is the reduction factor between the image and the outputs.
+  void DecodeLine(const NetworkIO &outputs, float scale_factor, bool debug,
+                  double worst_dict_cert, const TBOX &line_box,
+                  PointerVector<WERD_RES> *words, int lstm_choice_mode = 0,
+                  int lstm_choice_amount = 5);
+
+  // Runs the network forward on all the given line images at once, as a
+  // single batch, which amortizes the cost of the weights over all the lines.
+  // Returns the outputs and scale factors, as from RecognizeLine, for each
+  // line. An empty output indicates a line that could not be recognized.
+  // Does not attempt inversion.
+  void RecognizeLines(const std::vector<const ImageData *> &images,
+                      std::vector<float> *scale_factors,
+                      std::vector<NetworkIO> *outputs);
+
   // Helper computes min and mean best results in the output.
   void OutputStats(const NetworkIO &outputs, float *min_output, float *mean_output, float *sd);
   // Recognizes the image_data, returning the labels,
@@ -284,6 +329,11 @@ public:
                          std::vector<int> *xcoords);
 
 protected:
+  // Makes *this a copy of the model of mgr in the GlobalModelCache, loading
+  // it there first if needed, that shares its weights and recoder. Returns
+  // false if the model could not be loaded into the cache.
+  bool ShareModel(TessdataManager *mgr);
+
   // Sets the random seed from the sample_iteration_;
   void SetRandomSeed() {
     int64_t seed = sample_iteration_ * 0x10000001LL;
@@ -360,6 +410,15 @@ protected:
   Dict *dict_;
   // Beam search held between uses to optimize memory allocation/use.
   RecodeBeamSearch *search_;
+  // Model from the GlobalModelCache whose weights and recoder are used by
+  // network_ and GetRecoder(), or nullptr. Freed back to the cache on
+  // destruction.
+  LSTMRecognizer *shared_model_;
+  // The LSTMRecognizer that made *this with NewWorker, whose weights,
+  // charsets and Dict are used by *this, or nullptr. Not owned.
+  LSTMRecognizer *parent_;
+  // Threads that share the work of each timestep of network_, or nullptr.
+  ThreadPool *thread_pool_;
 
   // == Debugging parameters.==
   // Recognition debug display window.
@@ -84,7 +84,8 @@ Network::Network()
     , num_weights_(0)
     , forward_win_(nullptr)
     , backward_win_(nullptr)
-    , randomizer_(nullptr) {}
+    , randomizer_(nullptr)
+    , thread_pool_(nullptr) {}
 Network::Network(NetworkType type, const std::string &name, int ni, int no)
     : type_(type)
     , training_(TS_ENABLED)
@@ -96,7 +97,8 @@ Network::Network(NetworkType type, const std::string &name, int ni, int no)
     , name_(name)
     , forward_win_(nullptr)
     , backward_win_(nullptr)
-    , randomizer_(nullptr) {}
+    , randomizer_(nullptr)
+    , thread_pool_(nullptr) {}
 
 // Suspends/Enables/Permanently disables training by setting the training_
 // flag. Serialize and DeSerialize only operate on the run-time data if state
@@ -129,6 +131,16 @@ void Network::SetNetworkFlags(uint32_t flags) {
   network_flags_ = flags;
 }
 
+// Sets whether Serialize writes the int weights also shaped for the
+// IntSimdMatrix in use.
+void Network::SetShapedWeights(bool shaped) {
+  if (shaped) {
+    network_flags_ |= NF_SHAPED_WEIGHTS;
+  } else {
+    network_flags_ &= ~NF_SHAPED_WEIGHTS;
+  }
+}
+
 // Sets up the network for training. Initializes weights using weights of
 // scale `range` picked according to the random number generator `randomizer`.
 int Network::InitWeights([[maybe_unused]] float range, TRand *randomizer) {
@@ -143,6 +155,11 @@ void Network::SetRandomizer(TRand *randomizer) {
   randomizer_ = randomizer;
 }
 
+// Provides a pool of threads for any networks that can use it.
+void Network::SetThreadPool(ThreadPool *pool) {
+  thread_pool_ = pool;
+}
+
 // Sets needs_to_backprop_ to needs_backprop and returns true if
 // needs_backprop || any weights in this network so the next layer forward
 // can be told to produce backprop for this layer if needed.
@@ -208,6 +225,25 @@ static NetworkType getNetworkType(TFile *fp) {
   return static_cast<NetworkType>(data);
 }
 
+// Returns a new network with the structure of *this, which uses the weights
+// of *this. Returns nullptr in case of error.
+Network *Network::CopySharingWeights() const {
+  std::vector<char> data;
+  TFile writer;
+  writer.OpenWrite(&data);
+  writer.set_omit_weights(true);
+  if (!Serialize(&writer)) {
+    return nullptr;
+  }
+  TFile reader;
+  reader.Open(&data[0], data.size());
+  Network *network = CreateFromFile(&reader);
+  if (network != nullptr) {
+    network->ShareWeights(*this);
+  }
+  return network;
+}
+
 // Reads from the given file. Returns nullptr in case of error.
 // Determines the type of the serialized class and calls its DeSerialize
 // on a new object of the appropriate type, which is returned.
@@ -35,6 +35,7 @@ class ScrollView;
 class TBOX;
 class ImageData;
 class NetworkScratch;
+class ThreadPool;
 
 // Enum to store the run-time type of a Network. Keep in sync with kTypeNames.
 enum NetworkType {
@@ -83,6 +84,7 @@ enum NetworkFlags {
   // Network forward/backprop behavior.
   NF_LAYER_SPECIFIC_LR = 64, // Separate learning rate for each layer.
   NF_ADAM = 128,             // Weight-specific learning rate.
+  NF_SHAPED_WEIGHTS = 256,   // Int weights are also stored SIMD-shaped.
 };
 
 // State of training and desired state used in SetEnableTraining.
@@ -191,12 +193,31 @@ public:
 
   // Converts a float network to an int network.
   virtual void ConvertToInt() {}
+  // Sets whether Serialize writes the int weights also shaped for the
+  // IntSimdMatrix in use, so they don't have to be shaped again when they
+  // are loaded on a machine that uses an IntSimdMatrix of the same layout.
+  virtual void SetShapedWeights(bool shaped);
+
+  // Makes *this use the weights of other, which must have the same structure,
+  // and must outlive *this without changing its weights. The weights of *this
+  // are freed, so it can only be used for running forward afterwards.
+  virtual void ShareWeights([[maybe_unused]] const Network &other) {}
+  // Returns a new network with the structure of *this, which uses the weights
+  // of *this as with ShareWeights, without ever holding a copy of them.
+  // Returns nullptr in case of error.
+  Network *CopySharingWeights() const;
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
   // and should not be deleted by any of the networks.
   virtual void SetRandomizer(TRand *randomizer);
 
+  // Provides a pool of threads for any networks that can split the work of a
+  // single timestep between threads, or nullptr to run on the calling thread.
+  // Note that pool is a borrowed pointer that should outlive the network
+  // and should not be deleted by any of the networks.
+  virtual void SetThreadPool(ThreadPool *pool);
+
   // Sets needs_to_backprop_ to needs_backprop and returns true if
   // needs_backprop || any weights in this network so the next layer forward
   // can be told to produce backprop for this layer if needed.
@@ -307,6 +328,7 @@ protected:
   ScrollView *forward_win_;  // Recognition debug display window.
   ScrollView *backward_win_; // Training debug display window.
   TRand *randomizer_;        // Random number generator.
+  ThreadPool *thread_pool_;  // Threads to share the work of a timestep.
 };
 
 } // namespace tesseract.
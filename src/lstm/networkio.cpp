@@ -923,6 +923,24 @@ void NetworkIO::CopyWithXYTranspose(const NetworkIO &src) {
   } while (src_b_index.AddOffset(1, FD_BATCH) && dest_b_index.AddOffset(1, FD_BATCH));
 }
 
+// Copies the given batch index of src to *this, which becomes a single
+// image of the same height and width as that element of src.
+void NetworkIO::CopyBatchItem(const NetworkIO &src, int batch) {
+  StrideMap::Index src_index(src.stride_map_, batch, 0, 0);
+  int height = src_index.MaxIndexOfDim(FD_HEIGHT) + 1;
+  int width = src_index.MaxIndexOfDim(FD_WIDTH) + 1;
+  std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(height, width));
+  StrideMap stride_map;
+  stride_map.SetStride(h_w_pairs);
+  ResizeToMap(src.int_mode(), stride_map, src.NumFeatures());
+  StrideMap::Index dest_index(stride_map_);
+  do {
+    StrideMap::Index index(src.stride_map_, batch, dest_index.index(FD_HEIGHT),
+                           dest_index.index(FD_WIDTH));
+    CopyTimeStepFrom(dest_index.t(), src, index.t());
+  } while (dest_index.Increment());
+}
+
 // Copies src to *this, at the given feature_offset, returning the total
 // feature offset after the copy. Multiple calls will stack outputs from
 // multiple sources in feature space.
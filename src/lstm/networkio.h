@@ -240,6 +240,9 @@ public:
   void CopyWithXReversal(const NetworkIO &src);
   // Copies src to *this with independent transpose of the x and y dimensions.
   void CopyWithXYTranspose(const NetworkIO &src);
+  // Copies the given batch index of src to *this, which becomes a single
+  // image of the same height and width as that element of src.
+  void CopyBatchItem(const NetworkIO &src, int batch);
   // Copies src to *this, at the given feature_offset, returning the total
   // feature offset after the copy. Multiple calls will stack outputs from
   // multiple sources in feature space.
@@ -71,6 +71,14 @@ void Plumbing::ConvertToInt() {
   }
 }
 
+// Sets whether Serialize writes the int weights also SIMD-shaped.
+void Plumbing::SetShapedWeights(bool shaped) {
+  Network::SetShapedWeights(shaped);
+  for (auto &i : stack_) {
+    i->SetShapedWeights(shaped);
+  }
+}
+
 // Provides a pointer to a TRand for any networks that care to use it.
 // Note that randomizer is a borrowed pointer that should outlive the network
 // and should not be deleted by any of the networks.
@@ -80,6 +88,14 @@ void Plumbing::SetRandomizer(TRand *randomizer) {
   }
 }
 
+// Provides the pool of threads to all the networks in the stack.
+void Plumbing::SetThreadPool(ThreadPool *pool) {
+  Network::SetThreadPool(pool);
+  for (auto &i : stack_) {
+    i->SetThreadPool(pool);
+  }
+}
+
 // Adds the given network to the stack.
 void Plumbing::AddToStack(Network *network) {
   if (stack_.empty()) {
@@ -256,6 +272,16 @@ void Plumbing::Update(float learning_rate, float momentum, float adam_beta, int
   }
 }
 
+// Makes *this use the weights of other, which must have the same structure.
+void Plumbing::ShareWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto *plumbing = static_cast<const Plumbing *>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (size_t i = 0; i < stack_.size(); ++i) {
+    stack_[i]->ShareWeights(*plumbing->stack_[i]);
+  }
+}
+
 // Sums the products of weight updates in *this and other, splitting into
 // positive (same direction) in *same and negative (different direction) in
 // *changed.
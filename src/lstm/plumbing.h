@@ -69,12 +69,20 @@ public:
 
   // Converts a float network to an int network.
   void ConvertToInt() override;
+  // Sets whether Serialize writes the int weights also SIMD-shaped.
+  void SetShapedWeights(bool shaped) override;
+
+  // Makes *this use the weights of other, which must have the same structure.
+  void ShareWeights(const Network &other) override;
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
   // and should not be deleted by any of the networks.
   void SetRandomizer(TRand *randomizer) override;
 
+  // Provides the pool of threads to all the networks in the stack.
+  void SetThreadPool(ThreadPool *pool) override;
+
   // Adds the given network to the stack.
   virtual void AddToStack(Network *network);
 
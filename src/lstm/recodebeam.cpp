@@ -21,9 +21,12 @@
 
 #include "networkio.h"
 #include "pageres.h"
+#include "simddetect.h"
+#include "threadpool.h"
 #include "unicharcompress.h"
 
 #include <algorithm> // for std::reverse
+#include <cinttypes> // for PRIu64
 
 namespace tesseract {
 
@@ -59,8 +62,11 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress &recoder,
                                    int null_char, bool simple_text, Dict *dict)
     : recoder_(recoder),
       beam_size_(0),
+      secondary_beam_size_(0),
+      num_used_dawgs_(0),
       top_code_(-1),
       second_code_(-1),
+      line_top_n_width_(0),
       dict_(dict),
       space_delimited_(true),
       is_simple_text_(simple_text),
@@ -68,6 +74,22 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress &recoder,
   if (dict_ != nullptr && !dict_->IsSpaceDelimitedLang()) {
     space_delimited_ = false;
   }
+  int num_codes = recoder_.code_range();
+  RecodedCharID empty_prefix;
+  first_final_positions_.resize(num_codes, -1);
+  const std::vector<int> *final_codes = recoder_.GetFinalCodes(empty_prefix);
+  if (final_codes != nullptr) {
+    for (unsigned i = 0; i < final_codes->size(); ++i) {
+      first_final_positions_[(*final_codes)[i]] = i;
+    }
+  }
+  first_next_positions_.resize(num_codes, -1);
+  const std::vector<int> *next_codes = recoder_.GetNextCodes(empty_prefix);
+  if (next_codes != nullptr) {
+    for (unsigned i = 0; i < next_codes->size(); ++i) {
+      first_next_positions_[(*next_codes)[i]] = i;
+    }
+  }
 }
 
 RecodeBeamSearch::~RecodeBeamSearch() {
@@ -84,12 +106,19 @@ void RecodeBeamSearch::Decode(const NetworkIO &output, double dict_ratio,
                               double cert_offset, double worst_dict_cert,
                               const UNICHARSET *charset, int lstm_choice_mode) {
   beam_size_ = 0;
+  ResetDawgs();
   int width = output.Width();
   if (lstm_choice_mode) {
     timesteps.clear();
   }
+  bool precomputed = line_top_n_width_ == width;
+  line_top_n_width_ = 0;
   for (int t = 0; t < width; ++t) {
-    ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    if (precomputed) {
+      SetTopN(output.NumFeatures(), line_top_n_[t], line_num_top_n_[t]);
+    } else {
+      ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    }
     DecodeStep(output.f(t), t, dict_ratio, cert_offset, worst_dict_cert,
                charset);
     if (lstm_choice_mode) {
@@ -102,6 +131,7 @@ void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float> &output,
                               double worst_dict_cert,
                               const UNICHARSET *charset) {
   beam_size_ = 0;
+  ResetDawgs();
   int width = output.dim1();
   for (int t = 0; t < width; ++t) {
     ComputeTopN(output[t], output.dim2(), kBeamWidths[0]);
@@ -109,13 +139,40 @@ void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float> &output,
   }
 }
 
+// Computes the top-n choices of all the timesteps of output in one pass.
+void RecodeBeamSearch::PrecomputeTopN(const NetworkIO &output,
+                                      ThreadPool *pool) {
+  int width = output.Width();
+  int num_features = output.NumFeatures();
+  int top_n = kBeamWidths[0];
+  line_top_n_.ResizeNoInit(width, top_n);
+  line_num_top_n_.resize(width);
+  int num_threads = pool != nullptr ? pool->num_threads() : 1;
+  if (static_cast<int>(thread_heaps_.size()) < num_threads) {
+    thread_heaps_.resize(num_threads);
+    thread_above_indices_.resize(num_threads);
+  }
+  auto find_top_n = [&](int t, int thread) {
+    line_num_top_n_[t] =
+        FindTopN(output.f(t), num_features, top_n, nullptr,
+                 &thread_heaps_[thread], &thread_above_indices_[thread],
+                 line_top_n_[t]);
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(width, find_top_n);
+  } else {
+    for (int t = 0; t < width; ++t) {
+      find_top_n(t, 0);
+    }
+  }
+  line_top_n_width_ = width;
+}
+
 void RecodeBeamSearch::DecodeSecondaryBeams(
     const NetworkIO &output, double dict_ratio, double cert_offset,
     double worst_dict_cert, const UNICHARSET *charset) {
-  for (auto data : secondary_beam_) {
-    delete data;
-  }
-  secondary_beam_.clear();
+  secondary_beam_size_ = 0;
+  ResetDawgs();
   if (character_boundaries_.size() < 2) {
     return;
   }
@@ -231,6 +288,7 @@ void RecodeBeamSearch::ExtractBestPathAsUnicharIds(
     DebugPath(unicharset, best_nodes);
     DebugUnicharPath(unicharset, best_nodes, *unichar_ids, *certs, *ratings,
                      *xcoords);
+    DebugTransitionCache();
   }
 }
 
@@ -265,6 +323,7 @@ void RecodeBeamSearch::ExtractBestPathAsWords(const TBOX &line_box,
   if (debug) {
     DebugUnicharPath(unicharset, best_nodes, unichar_ids, certs, ratings,
                      xcoords);
+    DebugTransitionCache();
   }
   // Convert labels to unichar-ids.
   int word_end = 0;
@@ -331,13 +390,14 @@ void RecodeBeamSearch::PrintBeam2(bool uids,
   std::vector<std::vector<const RecodeNode *>> topology;
   std::unordered_set<const RecodeNode *> visited;
   const std::vector<RecodeBeam *> &beam = !secondary ? beam_ : secondary_beam_;
+  int beam_size = !secondary ? beam_size_ : secondary_beam_size_;
   // create the topology
-  for (int step = beam.size() - 1; step >= 0; --step) {
+  for (int step = beam_size - 1; step >= 0; --step) {
     std::vector<const RecodeNode *> layer;
     topology.push_back(layer);
   }
   // fill the topology with depths first
-  for (int step = beam.size() - 1; step >= 0; --step) {
+  for (int step = beam_size - 1; step >= 0; --step) {
     std::vector<tesseract::RecodePair> &heaps = beam.at(step)->beams_->heap();
     for (auto &&node : heaps) {
       int backtracker = 0;
@@ -411,7 +471,7 @@ void RecodeBeamSearch::extractSymbolChoices(const UNICHARSET *unicharset) {
   // For the first iteration the original beam is analyzed. After that a
   // new beam is calculated based on the results from the original beam.
   std::vector<RecodeBeam *> &currentBeam =
-      secondary_beam_.empty() ? beam_ : secondary_beam_;
+      secondary_beam_size_ == 0 ? beam_ : secondary_beam_;
   character_boundaries_[0] = 0;
   for (unsigned j = 1; j < character_boundaries_.size(); ++j) {
     std::vector<int> unichar_ids;
@@ -504,10 +564,7 @@ void RecodeBeamSearch::extractSymbolChoices(const UNICHARSET *unicharset) {
       }
     }
   }
-  for (auto data : secondary_beam_) {
-    delete data;
-  }
-  secondary_beam_.clear();
+  secondary_beam_size_ = 0;
 }
 
 // Generates debug output of the content of the beams after a Decode.
@@ -527,6 +584,16 @@ void RecodeBeamSearch::DebugBeams(const UNICHARSET &unicharset) const {
       }
     }
   }
+  DebugTransitionCache();
+}
+
+// Prints the hit rate of the dawg transition cache over all the searches.
+void RecodeBeamSearch::DebugTransitionCache() const {
+  uint64_t hits = transition_cache_.hits();
+  uint64_t lookups = hits + transition_cache_.misses();
+  tprintf("Dawg transition cache: %" PRIu64 " hits in %" PRIu64
+          " lookups (%.1f%%)\n",
+          hits, lookups, lookups > 0 ? 100.0 * hits / lookups : 0.0);
 }
 
 // Generates debug output of the content of a single beam position.
@@ -668,72 +735,111 @@ WERD_RES *RecodeBeamSearch::InitializeWord(bool leading_space,
 // is one of the top_n.
 void RecodeBeamSearch::ComputeTopN(const float *outputs, int num_outputs,
                                    int top_n) {
-  top_n_flags_.clear();
-  top_n_flags_.resize(num_outputs, TN_ALSO_RAN);
-  top_code_ = -1;
-  second_code_ = -1;
-  top_heap_.clear();
-  for (int i = 0; i < num_outputs; ++i) {
-    if (top_heap_.size() < top_n || outputs[i] > top_heap_.PeekTop().key()) {
-      TopPair entry(outputs[i], i);
-      top_heap_.Push(&entry);
-      if (top_heap_.size() > top_n) {
-        top_heap_.Pop(&entry);
-      }
-    }
-  }
-  while (!top_heap_.empty()) {
-    TopPair entry;
-    top_heap_.Pop(&entry);
-    if (top_heap_.size() > 1) {
-      top_n_flags_[entry.data()] = TN_TOPN;
-    } else {
-      top_n_flags_[entry.data()] = TN_TOP2;
-      if (top_heap_.empty()) {
-        top_code_ = entry.data();
-      } else {
-        second_code_ = entry.data();
-      }
-    }
-  }
-  top_n_flags_[null_char_] = TN_TOP2;
+  found_codes_.resize(top_n);
+  int num_codes = FindTopN(outputs, num_outputs, top_n, nullptr, &top_heap_,
+                           &above_indices_, &found_codes_[0]);
+  SetTopN(num_outputs, &found_codes_[0], num_codes);
 }
 
 void RecodeBeamSearch::ComputeSecTopN(std::unordered_set<int> *exList,
                                       const float *outputs, int num_outputs,
                                       int top_n) {
-  top_n_flags_.clear();
-  top_n_flags_.resize(num_outputs, TN_ALSO_RAN);
-  top_code_ = -1;
-  second_code_ = -1;
-  top_heap_.clear();
-  for (int i = 0; i < num_outputs; ++i) {
-    if ((top_heap_.size() < top_n || outputs[i] > top_heap_.PeekTop().key()) &&
-        !exList->count(i)) {
+  found_codes_.resize(top_n);
+  int num_codes = FindTopN(outputs, num_outputs, top_n, exList, &top_heap_,
+                           &above_indices_, &found_codes_[0]);
+  SetTopN(num_outputs, &found_codes_[0], num_codes);
+}
+
+// Stores in codes the indices of the top_n largest outputs, best first.
+/* static */
+int RecodeBeamSearch::FindTopN(const float *outputs, int num_outputs,
+                               int top_n,
+                               const std::unordered_set<int> *excluded,
+                               GenericHeap<TopPair> *heap,
+                               std::vector<int> *above, int *codes) {
+  // Number of outputs to search with each call of IndicesAbove.
+  const int kBlockSize = 256;
+  heap->clear();
+  // Anything can go on the heap until it is full.
+  int i = 0;
+  for (; i < num_outputs && heap->size() < top_n; ++i) {
+    if (excluded == nullptr || !excluded->count(i)) {
       TopPair entry(outputs[i], i);
-      top_heap_.Push(&entry);
-      if (top_heap_.size() > top_n) {
-        top_heap_.Pop(&entry);
+      heap->Push(&entry);
+    }
+  }
+  // After that, only the outputs above the worst on the heap can replace it.
+  // The search is done a block at a time, so the threshold rises as better
+  // outputs are found, and the outputs are pushed in the same order as a
+  // plain loop over all of them would push them.
+  above->resize(kBlockSize);
+  for (; i < num_outputs; i += kBlockSize) {
+    int block_size = std::min(kBlockSize, num_outputs - i);
+    int num_above = IndicesAbove(outputs + i, block_size,
+                                 heap->PeekTop().key(), above->data());
+    for (int a = 0; a < num_above; ++a) {
+      int code = i + (*above)[a];
+      if (outputs[code] > heap->PeekTop().key() &&
+          (excluded == nullptr || !excluded->count(code))) {
+        TopPair entry(outputs[code], code);
+        heap->Push(&entry);
+        heap->Pop(&entry);
       }
     }
   }
-  while (!top_heap_.empty()) {
+  // The heap pops the worst first.
+  int num_codes = heap->size();
+  for (int c = num_codes - 1; c >= 0; --c) {
     TopPair entry;
-    top_heap_.Pop(&entry);
-    if (top_heap_.size() > 1) {
-      top_n_flags_[entry.data()] = TN_TOPN;
-    } else {
-      top_n_flags_[entry.data()] = TN_TOP2;
-      if (top_heap_.empty()) {
-        top_code_ = entry.data();
-      } else {
-        second_code_ = entry.data();
-      }
+    heap->Pop(&entry);
+    codes[c] = entry.data();
+  }
+  return num_codes;
+}
+
+// Sets top_n_flags_ and top_n_codes_ from the given codes, best first.
+void RecodeBeamSearch::SetTopN(int num_outputs, const int *codes,
+                               int num_codes) {
+  if (top_n_flags_.size() != static_cast<size_t>(num_outputs)) {
+    top_n_flags_.assign(num_outputs, TN_ALSO_RAN);
+  } else {
+    // Only the flags of the previous timestep need to be reset.
+    for (int code : top_n_codes_) {
+      top_n_flags_[code] = TN_ALSO_RAN;
     }
   }
+  top_n_codes_.assign(codes, codes + num_codes);
+  for (int c = 0; c < num_codes; ++c) {
+    top_n_flags_[codes[c]] = c < 2 ? TN_TOP2 : TN_TOPN;
+  }
+  top_code_ = num_codes > 0 ? codes[0] : -1;
+  second_code_ = num_codes > 1 ? codes[1] : -1;
+  if (top_n_flags_[null_char_] == TN_ALSO_RAN) {
+    top_n_codes_.push_back(null_char_);
+  }
   top_n_flags_[null_char_] = TN_TOP2;
 }
 
+// Stores in candidates the codes of top_n_codes_ with the given flag that
+// are in the list that positions refers to, in the order of the list.
+int RecodeBeamSearch::TopNCandidates(TopNState top_n_flag,
+                                     const std::vector<int> &positions,
+                                     int *candidates) const {
+  int num_candidates = 0;
+  for (int code : top_n_codes_) {
+    if (top_n_flags_[code] != top_n_flag || positions[code] < 0) {
+      continue;
+    }
+    // Insertion sort, as there are only a few of them.
+    int c = num_candidates++;
+    for (; c > 0 && positions[candidates[c - 1]] > positions[code]; --c) {
+      candidates[c] = candidates[c - 1];
+    }
+    candidates[c] = code;
+  }
+  return num_candidates;
+}
+
 // Adds the computation for the current time-step to the beam. Call at each
 // time-step in sequence from left to right. outputs is the activation vector
 // for the current timestep.
@@ -817,6 +923,7 @@ void RecodeBeamSearch::DecodeSecondaryStep(
     secondary_beam_.push_back(new RecodeBeam);
   }
   RecodeBeam *step = secondary_beam_[t];
+  secondary_beam_size_ = t + 1;
   step->Clear();
   if (t == 0) {
     // The first step can only use singles and initials.
@@ -936,9 +1043,22 @@ void RecodeBeamSearch::ContinueContext(
                               NC_ANYTHING, prev, step);
     }
   }
+  // The lists of codes of the empty prefix are long, and only the few codes
+  // in top_n_codes_ can have a top_n_flag other than TN_ALSO_RAN, so then
+  // only those are looked at.
+  bool use_candidates = length == 0 && top_n_flag != TN_ALSO_RAN;
+  candidate_codes_.resize(top_n_codes_.size());
   const std::vector<int> *final_codes = recoder_.GetFinalCodes(prefix);
   if (final_codes != nullptr) {
-    for (int code : *final_codes) {
+    const int *codes = final_codes->data();
+    int num_codes = final_codes->size();
+    if (use_candidates) {
+      codes = candidate_codes_.data();
+      num_codes = TopNCandidates(top_n_flag, first_final_positions_,
+                                 candidate_codes_.data());
+    }
+    for (int i = 0; i < num_codes; ++i) {
+      int code = codes[i];
       if (top_n_flags_[code] != top_n_flag) {
         continue;
       }
@@ -977,7 +1097,15 @@ void RecodeBeamSearch::ContinueContext(
   }
   const std::vector<int> *next_codes = recoder_.GetNextCodes(prefix);
   if (next_codes != nullptr) {
-    for (int code : *next_codes) {
+    const int *codes = next_codes->data();
+    int num_codes = next_codes->size();
+    if (use_candidates) {
+      codes = candidate_codes_.data();
+      num_codes = TopNCandidates(top_n_flag, first_next_positions_,
+                                 candidate_codes_.data());
+    }
+    for (int i = 0; i < num_codes; ++i) {
+      int code = codes[i];
       if (top_n_flags_[code] != top_n_flag) {
         continue;
       }
@@ -1096,21 +1224,23 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
              dict_->getUnicharset().IsSpaceDelimited(unichar_id)) {
     return; // Can't break words between space delimited chars.
   }
-  DawgPositionVector initial_dawgs;
-  auto *updated_dawgs = new DawgPositionVector;
-  DawgArgs dawg_args(&initial_dawgs, updated_dawgs, NO_PERM);
+  DawgPositionVector *active_dawgs;
   bool word_start = false;
   if (uni_prev == nullptr) {
     // Starting from beginning of line.
-    dict_->default_dawgs(&initial_dawgs, false);
+    initial_dawgs_.clear();
+    dict_->default_dawgs(&initial_dawgs_, false);
+    active_dawgs = &initial_dawgs_;
     word_start = true;
   } else if (uni_prev->dawgs != nullptr) {
     // Continuing a previous dict word.
-    dawg_args.active_dawgs = uni_prev->dawgs;
+    active_dawgs = uni_prev->dawgs;
     word_start = uni_prev->start_of_dawg;
   } else {
     return; // Can't continue if not a dict word.
   }
+  DawgArgs dawg_args(active_dawgs, NewDawgs(), NO_PERM);
+  dawg_args.transition_cache = &transition_cache_;
   auto permuter = static_cast<PermuterType>(dict_->def_letter_is_okay(
       &dawg_args, dict_->getUnicharset(), unichar_id, false));
   if (permuter != NO_PERM) {
@@ -1128,7 +1258,7 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
                        nodawg_heap);
     }
   } else {
-    delete updated_dawgs;
+    ReleaseDawgs(dawg_args.updated_dawgs);
   }
 }
 
@@ -1147,12 +1277,13 @@ void RecodeBeamSearch::PushInitialDawgIfBetter(int code, int unichar_id,
     score += prev->score;
   }
   if (best_initial_dawg->code < 0 || score > best_initial_dawg->score) {
-    auto *initial_dawgs = new DawgPositionVector;
+    DawgPositionVector *initial_dawgs = NewDawgs();
     dict_->default_dawgs(initial_dawgs, false);
-    RecodeNode node(code, unichar_id, permuter, true, start, end, false, cert,
-                    score, prev, initial_dawgs,
-                    ComputeCodeHash(code, false, prev));
-    *best_initial_dawg = node;
+    ReleaseDawgs(best_initial_dawg->dawgs);
+    *best_initial_dawg =
+        RecodeNode(code, unichar_id, permuter, true, start, end, false, cert,
+                   score, prev, initial_dawgs,
+                   ComputeCodeHash(code, false, prev));
   }
 }
 
@@ -1203,12 +1334,12 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, int code, int unichar_id,
     }
     RecodePair entry(score, node);
     heap->Push(&entry);
-    ASSERT_HOST(entry.data().dawgs == nullptr);
     if (heap->size() > max_size) {
       heap->Pop(&entry);
+      ReleaseDawgs(entry.data().dawgs);
     }
   } else {
-    delete d;
+    ReleaseDawgs(d);
   }
 }
 
@@ -1217,16 +1348,19 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, int code, int unichar_id,
 void RecodeBeamSearch::PushHeapIfBetter(int max_size, RecodeNode *node,
                                         RecodeHeap *heap) {
   if (heap->size() < max_size || node->score > heap->PeekTop().data().score) {
-    if (UpdateHeapIfMatched(node, heap)) {
-      return;
-    }
-    RecodePair entry(node->score, *node);
-    heap->Push(&entry);
-    ASSERT_HOST(entry.data().dawgs == nullptr);
-    if (heap->size() > max_size) {
-      heap->Pop(&entry);
+    if (!UpdateHeapIfMatched(node, heap)) {
+      RecodePair entry(node->score, *node);
+      heap->Push(&entry);
+      if (heap->size() > max_size) {
+        heap->Pop(&entry);
+        ReleaseDawgs(entry.data().dawgs);
+      }
     }
+  } else {
+    ReleaseDawgs(node->dawgs);
   }
+  // The dawgs now belong to the heap or are released.
+  node->dawgs = nullptr;
 }
 
 // Searches the heap for a matching entry, and updates the score with
@@ -1245,9 +1379,12 @@ bool RecodeBeamSearch::UpdateHeapIfMatched(RecodeNode *new_node,
       if (new_node->score > node.score) {
         // The new one is better. Update the entire node in the heap and
         // reshuffle.
+        ReleaseDawgs(node.dawgs);
         node = *new_node;
         i.key() = node.score;
         heap->Reshuffle(&i);
+      } else {
+        ReleaseDawgs(new_node->dawgs);
       }
       return true;
     }
@@ -1255,6 +1392,22 @@ bool RecodeBeamSearch::UpdateHeapIfMatched(RecodeNode *new_node,
   return false;
 }
 
+// Returns an empty DawgPositionVector from the dawg pool.
+DawgPositionVector *RecodeBeamSearch::NewDawgs() {
+  DawgPositionVector *dawgs;
+  if (!free_dawgs_.empty()) {
+    dawgs = free_dawgs_.back();
+    free_dawgs_.pop_back();
+  } else {
+    if (num_used_dawgs_ == dawgs_pool_.size()) {
+      dawgs_pool_.emplace_back();
+    }
+    dawgs = &dawgs_pool_[num_used_dawgs_++];
+  }
+  dawgs->clear();
+  return dawgs;
+}
+
 // Computes and returns the code-hash for the given code and prev.
 uint64_t RecodeBeamSearch::ComputeCodeHash(int code, bool dup,
                                            const RecodeNode *prev) const {
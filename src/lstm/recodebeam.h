@@ -29,11 +29,14 @@
 #include "ratngs.h"
 #include "unicharcompress.h"
 
+#include <deque>         // for std::deque
 #include <unordered_set> // for std::unordered_set
 #include <vector>        // for std::vector
 
 namespace tesseract {
 
+class ThreadPool;
+
 // Enum describing what can follow the current node.
 // Consider the following softmax outputs:
 // Timestep    0    1    2    3    4    5    6    7    8
@@ -118,37 +121,6 @@ struct RecodeNode {
       , prev(p)
       , dawgs(d)
       , code_hash(hash) {}
-  // NOTE: If we could use C++11, then this would be a move constructor.
-  // Instead we have copy constructor that does a move!! This is because we
-  // don't want to copy the whole DawgPositionVector each time, and true
-  // copying isn't necessary for this struct. It does get moved around a lot
-  // though inside the heap and during heap push, hence the move semantics.
-  RecodeNode(const RecodeNode &src) : dawgs(nullptr) {
-    *this = src;
-    ASSERT_HOST(src.dawgs == nullptr);
-  }
-  RecodeNode &operator=(const RecodeNode &src) {
-    if (this != &src) {
-      delete dawgs;
-      code = src.code;
-      unichar_id = src.unichar_id;
-      permuter = src.permuter;
-      start_of_dawg = src.start_of_dawg;
-      start_of_word = src.start_of_word;
-      end_of_word = src.end_of_word;
-      duplicate = src.duplicate;
-      certainty = src.certainty;
-      score = src.score;
-      prev = src.prev;
-      dawgs = src.dawgs;
-      code_hash = src.code_hash;
-      const_cast<RecodeNode &>(src).dawgs = nullptr;
-    }
-    return *this;
-  }
-  ~RecodeNode() {
-    delete dawgs;
-  }
   // Prints details of the node.
   void Print(int null_char, const UNICHARSET &unicharset, int depth) const;
 
@@ -180,7 +152,9 @@ struct RecodeNode {
   float score;
   // The previous node in this chain. Borrowed pointer.
   const RecodeNode *prev;
-  // The currently active dawgs at this position. Owned pointer.
+  // The currently active dawgs at this position. Borrowed pointer to storage
+  // in the dawg pool of the RecodeBeamSearch, which is only valid during the
+  // search that made the node.
   DawgPositionVector *dawgs;
   // A hash of all codes in the prefix and this->code as well. Used for
   // duplicate path removal.
@@ -203,6 +177,11 @@ public:
               double worst_dict_cert, const UNICHARSET *charset, int lstm_choice_mode = 0);
   void Decode(const GENERIC_2D_ARRAY<float> &output, double dict_ratio, double cert_offset,
               double worst_dict_cert, const UNICHARSET *charset);
+  // Computes the top-n choices of all the timesteps of output in one pass,
+  // sharing the work with the threads of pool if it isn't nullptr. The next
+  // Decode of the same output uses them instead of computing them one
+  // timestep at a time.
+  void PrecomputeTopN(const NetworkIO &output, ThreadPool *pool);
 
   void DecodeSecondaryBeams(const NetworkIO &output, double dict_ratio, double cert_offset,
                             double worst_dict_cert, const UNICHARSET *charset);
@@ -278,6 +257,8 @@ private:
   // to hold all the timesteps and prevent reallocation of the individual heaps.
   struct RecodeBeam {
     // Resets to the initial state without deleting all the memory.
+    // The dawgs of the nodes are not released, as they belong to the dawg
+    // pool, which is reset as a whole at the start of each search.
     void Clear() {
       for (auto &beam : beams_) {
         beam.clear();
@@ -307,6 +288,8 @@ private:
   };
   using TopPair = KDPairInc<float, int>;
 
+  // Prints the hit rate of transition_cache_.
+  void DebugTransitionCache() const;
   // Generates debug output of the content of a single beam position.
   void DebugBeamPos(const UNICHARSET &unicharset, const RecodeHeap &heap) const;
 
@@ -330,6 +313,21 @@ private:
   void ComputeSecTopN(std::unordered_set<int> *exList, const float *outputs, int num_outputs,
                       int top_n);
 
+  // Stores in codes the indices of the top_n largest outputs, best first,
+  // leaving out any which are in excluded, if not nullptr, and returns their
+  // number. heap and above are scratch space.
+  static int FindTopN(const float *outputs, int num_outputs, int top_n,
+                      const std::unordered_set<int> *excluded, GenericHeap<TopPair> *heap,
+                      std::vector<int> *above, int *codes);
+  // Sets top_n_flags_ and top_n_codes_ from the given codes, best first, as
+  // found by FindTopN.
+  void SetTopN(int num_outputs, const int *codes, int num_codes);
+  // Stores in candidates the codes of top_n_codes_ that have the given flag
+  // and are in the list of codes that positions refers to, in the order of
+  // the list, and returns their number.
+  int TopNCandidates(TopNState top_n_flag, const std::vector<int> &positions,
+                     int *candidates) const;
+
   // Adds the computation for the current time-step to the beam. Call at each
   // time-step in sequence from left to right. outputs is the activation vector
   // for the current timestep.
@@ -380,10 +378,27 @@ private:
                         const RecodeNode *prev, DawgPositionVector *d, RecodeHeap *heap);
   // Adds a RecodeNode to heap if there is room
   // or if better than the current worst element if already full.
+  // Takes the dawgs of node, which are released if it is not used.
   void PushHeapIfBetter(int max_size, RecodeNode *node, RecodeHeap *heap);
   // Searches the heap for an entry matching new_node, and updates the entry
-  // with reshuffle if needed. Returns true if there was a match.
+  // with reshuffle if needed. Returns true if there was a match, in which
+  // case the dawgs of the losing node are released.
   bool UpdateHeapIfMatched(RecodeNode *new_node, RecodeHeap *heap);
+  // Returns an empty DawgPositionVector from the dawg pool, which only
+  // allocates when the pool is bigger than it has ever been before.
+  DawgPositionVector *NewDawgs();
+  // Returns dawgs (which may be nullptr) to the dawg pool for reuse.
+  void ReleaseDawgs(DawgPositionVector *dawgs) {
+    if (dawgs != nullptr) {
+      free_dawgs_.push_back(dawgs);
+    }
+  }
+  // Makes all of the dawg pool available again, invalidating the dawgs of
+  // all the nodes of the previous search.
+  void ResetDawgs() {
+    num_used_dawgs_ = 0;
+    free_dawgs_.clear();
+  }
   // Computes and returns the code-hash for the given code and prev.
   uint64_t ComputeCodeHash(int code, bool dup, const RecodeNode *prev) const;
   // Backtracks to extract the best path through the lattice that was built
@@ -414,6 +429,18 @@ private:
   std::vector<RecodeBeam *> secondary_beam_;
   // The number of timesteps valid in beam_;
   int beam_size_;
+  // The number of timesteps valid in secondary_beam_;
+  int secondary_beam_size_;
+  // Storage for the dawgs of all the nodes in the beams. The beams and the
+  // pool are kept between searches, so after the first few lines a search
+  // doesn't allocate any memory. A deque keeps the dawgs in place as it grows.
+  std::deque<DawgPositionVector> dawgs_pool_;
+  // The number of elements of dawgs_pool_ handed out since the last reset.
+  size_t num_used_dawgs_;
+  // Elements of dawgs_pool_ that were handed out and released again.
+  std::vector<DawgPositionVector *> free_dawgs_;
+  // Scratch space for the initial dawgs of a word at the start of the line.
+  DawgPositionVector initial_dawgs_;
   // A flag to indicate which outputs are the top-n choices. Current timestep
   // only.
   std::vector<TopNState> top_n_flags_;
@@ -422,8 +449,34 @@ private:
   int second_code_;
   // Heap used to compute the top_n_flags_.
   GenericHeap<TopPair> top_heap_;
+  // The codes that top_n_flags_ doesn't mark as TN_ALSO_RAN, so they can be
+  // reset for the next timestep, and ContinueContext can use them instead of
+  // searching long lists of codes for the few that are in the top-n.
+  std::vector<int> top_n_codes_;
+  // Scratch space for ComputeTopN and FindTopN.
+  std::vector<int> found_codes_;
+  std::vector<int> above_indices_;
+  // The position of each code in the lists of final and next codes of the
+  // empty prefix, or -1 if it isn't in the list. These are the longest lists
+  // by far, as they hold the first code of every unichar.
+  std::vector<int> first_final_positions_;
+  std::vector<int> first_next_positions_;
+  // Scratch space for the codes from TopNCandidates in ContinueContext.
+  std::vector<int> candidate_codes_;
+  // The top-n codes of each timestep found by PrecomputeTopN, best first, and
+  // the number of them.
+  GENERIC_2D_ARRAY<int> line_top_n_;
+  std::vector<int> line_num_top_n_;
+  // The number of timesteps in line_top_n_, or 0 if there are none to use.
+  int line_top_n_width_;
+  // Scratch space for each thread of PrecomputeTopN.
+  std::vector<GenericHeap<TopPair>> thread_heaps_;
+  std::vector<std::vector<int>> thread_above_indices_;
   // Borrowed pointer to the dictionary to use in the search.
   Dict *dict_;
+  // Cache of the dawg transitions looked up by ContinueDawg, which are
+  // mostly the same for every line.
+  DawgTransitionCache transition_cache_;
   // True if the language is space-delimited, which is true for most languages
   // except chi*, jpn, tha.
   bool space_delimited_;
@@ -17,7 +17,10 @@
 
 #include "weightmatrix.h"
 
+#include <algorithm> // for std::min
 #include <cassert> // for assert
+#include <cstring>   // for memcpy
+#include <numeric>   // for std::lcm
 #include "intsimdmatrix.h"
 #include "simddetect.h" // for DotProduct
 #include "statistc.h"
@@ -205,11 +208,42 @@ void WeightMatrix::ConvertToInt() {
   }
   wf_.Resize(1, 1, 0.0);
   int_mode_ = true;
-  if (IntSimdMatrix::intSimdMatrix) {
-    int32_t rounded_num_out;
-    IntSimdMatrix::intSimdMatrix->Init(wi_, shaped_w_, rounded_num_out);
-    scales_.resize(rounded_num_out);
+  ShapeWeights();
+}
+
+// Shapes the int weights for the IntSimdMatrix in use, unless they are
+// already shaped or there is none.
+void WeightMatrix::ShapeWeights() {
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (!int_mode_ || matrix == nullptr || shared_ != nullptr || weights_omitted() ||
+      mapped_shaped_w_ != nullptr || !shaped_w_.empty()) {
+    return;
   }
+  int32_t rounded_num_out;
+  matrix->Init(wi_, shaped_w_, rounded_num_out);
+  scales_.resize(rounded_num_out);
+}
+
+// Frees the shaped int weights, keeping wi_ and scales_.
+void WeightMatrix::FreeShapedWeights() {
+  std::vector<int8_t>().swap(shaped_w_);
+  mapped_shaped_w_ = nullptr;
+}
+
+// Makes *this use the weights of src, which must have the same shape, and
+// must outlive *this without changing. The weights of *this are freed.
+void WeightMatrix::ShareWeights(const WeightMatrix &src) {
+  const WeightMatrix *shared = src.shared_ != nullptr ? src.shared_ : &src;
+  ASSERT_HOST(shared->int_mode_ == int_mode_);
+  ASSERT_HOST(shared->NumOutputs() == NumOutputs());
+  shared_ = shared;
+  wf_.Free();
+  wi_.Free();
+  mapped_shaped_w_ = nullptr;
+  mapping_.reset();
+  wf_t_.Free();
+  std::vector<TFloat>().swap(scales_);
+  std::vector<int8_t>().swap(shaped_w_);
 }
 
 // Allocates any needed memory for running Backward, and zeroes the deltas,
@@ -229,16 +263,79 @@ void WeightMatrix::InitBackward() {
 const int kInt8Flag = 1;
 // Flag on mode to indicate that this weightmatrix uses adam.
 const int kAdamFlag = 4;
+// Flag on mode to indicate that the int weights are followed by the weights
+// shaped for an IntSimdMatrix.
+const int kShapedFlag = 16;
+// Flag on mode to indicate that only the shape of the weights follows.
+const int kShapeOnlyFlag = 32;
 // Flag on mode to indicate that this weightmatrix uses double. Set
 // independently of kInt8Flag as even in int mode the scales can
 // be float or double.
 const int kDoubleFlag = 128;
 
+// Returns the size of the weights of a num_out x num_in + 1 matrix shaped
+// by the given IntSimdMatrix.
+static size_t ShapedSize(const IntSimdMatrix *matrix, int num_out, int num_in) {
+  return static_cast<size_t>(IntSimdMatrix::Roundup(num_in, matrix->num_inputs_per_group_) + 1) *
+         matrix->RoundOutputs(num_out);
+}
+
+// Writes the shaped weights of a num_out x num_in + 1 matrix with the
+// identifier of their layout, which is that of the IntSimdMatrix in use, or
+// no weights with the identifier 0 if there is none.
+static bool SerializeShapedWeights(const int8_t *shaped_w, int num_out, int num_in, TFile *fp) {
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  uint32_t shape_id = matrix != nullptr ? matrix->ShapeId() : 0;
+  uint32_t size = matrix != nullptr ? ShapedSize(matrix, num_out, num_in) : 0;
+  return fp->Serialize(&shape_id) && fp->Serialize(&size) && fp->Serialize(shaped_w, size);
+}
+
+// Reads shaped weights written by SerializeShapedWeights. If they have the
+// layout of the IntSimdMatrix in use and the expected size, they are used in
+// place in a memory mapped file, setting *mapped_w, or else copied to
+// shaped_w, and *loaded is set to true. Otherwise they are skipped.
+// Returns false in case of error.
+static bool DeSerializeShapedWeights(TFile *fp, size_t expected_size,
+                                     std::vector<int8_t> &shaped_w, const int8_t **mapped_w,
+                                     bool *loaded) {
+  *loaded = false;
+  uint32_t shape_id;
+  uint32_t size;
+  if (!fp->DeSerialize(&shape_id) || !fp->DeSerialize(&size)) {
+    return false;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (matrix == nullptr || shape_id != matrix->ShapeId() || size != expected_size) {
+    // Skip fails at the end of the file, even for nothing.
+    return size == 0 || fp->Skip(size);
+  }
+  *mapped_w = fp->DeSerializeInPlace<int8_t>(size);
+  if (*mapped_w == nullptr) {
+    shaped_w.resize(size);
+    if (!fp->DeSerialize(&shaped_w[0], size)) {
+      return false;
+    }
+  }
+  *loaded = true;
+  return true;
+}
+
 // Writes to the given file. Returns false in case of error.
-bool WeightMatrix::Serialize(bool training, TFile *fp) const {
+bool WeightMatrix::Serialize(bool training, bool shaped, TFile *fp) const {
+  if (shared_ != nullptr) {
+    return shared_->Serialize(training, shaped, fp);
+  }
+  if (fp->omit_weights()) {
+    uint8_t mode = (int_mode_ ? kInt8Flag : 0) | kShapeOnlyFlag | kDoubleFlag;
+    int32_t num_outputs = NumOutputs();
+    int32_t row_size = RowSize();
+    return fp->Serialize(&mode) && fp->Serialize(&num_outputs) && fp->Serialize(&row_size);
+  }
+  shaped = shaped && int_mode_;
   // For backward compatibility, add kDoubleFlag to mode to indicate the doubles
   // format, without errs, so we can detect and read old format weight matrices.
-  uint8_t mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) | kDoubleFlag;
+  uint8_t mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) |
+                 (shaped ? kShapedFlag : 0) | kDoubleFlag;
   if (!fp->Serialize(&mode)) {
     return false;
   }
@@ -259,6 +356,9 @@ bool WeightMatrix::Serialize(bool training, TFile *fp) const {
         return false;
       }
     }
+    if (shaped && !SerializeShapedWeights(ShapedWeights(), wi_.dim1(), wi_.dim2() - 1, fp)) {
+      return false;
+    }
   } else {
     if (!tesseract::Serialize(fp, wf_)) {
       return false;
@@ -284,13 +384,29 @@ bool WeightMatrix::DeSerialize(bool training, TFile *fp) {
   }
   int_mode_ = (mode & kInt8Flag) != 0;
   use_adam_ = (mode & kAdamFlag) != 0;
+  FreeShapedWeights();
+  omitted_num_outputs_ = 0;
+  omitted_row_size_ = 0;
   if ((mode & kDoubleFlag) == 0) {
     return DeSerializeOld(training, fp);
   }
+  if ((mode & kShapeOnlyFlag) != 0) {
+    int32_t num_outputs;
+    int32_t row_size;
+    if (!fp->DeSerialize(&num_outputs) || !fp->DeSerialize(&row_size) || num_outputs <= 0) {
+      return false;
+    }
+    omitted_num_outputs_ = num_outputs;
+    omitted_row_size_ = row_size;
+    return true;
+  }
   if (int_mode_) {
-    if (!wi_.DeSerialize(fp)) {
+    // The weights don't need any alignment, so they can always be used in
+    // place if fp reads from a memory mapped file.
+    if (!wi_.DeSerializeInPlace(fp)) {
       return false;
     }
+    mapping_ = fp->mapping();
     uint32_t size;
     if (!fp->DeSerialize(&size)) {
       return false;
@@ -317,10 +433,16 @@ bool WeightMatrix::DeSerialize(bool training, TFile *fp) {
       scale /= INT8_MAX;
     }
 #endif
-    if (IntSimdMatrix::intSimdMatrix) {
-      int32_t rounded_num_out;
-      IntSimdMatrix::intSimdMatrix->Init(wi_, shaped_w_, rounded_num_out);
-      scales_.resize(rounded_num_out);
+    const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+    bool shaped = false;
+    if ((mode & kShapedFlag) != 0) {
+      size_t expected_size = matrix != nullptr ? ShapedSize(matrix, wi_.dim1(), wi_.dim2() - 1) : 0;
+      if (!DeSerializeShapedWeights(fp, expected_size, shaped_w_, &mapped_shaped_w_, &shaped)) {
+        return false;
+      }
+    }
+    if (shaped) {
+      scales_.resize(matrix->RoundOutputs(wi_.dim1()));
     }
   } else {
     if (!tesseract::DeSerialize(fp, wf_)) {
@@ -392,26 +514,345 @@ bool WeightMatrix::DeSerializeOld([[maybe_unused]] bool training,
 // Asserts that the call matches what we have.
 void WeightMatrix::MatrixDotVector(const TFloat *u, TFloat *v) const {
   assert(!int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVector(u, v);
+    return;
+  }
   MatrixDotVectorInternal(wf_, true, false, u, v);
 }
 
 void WeightMatrix::MatrixDotVector(const int8_t *u, TFloat *v) const {
   assert(int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVector(u, v);
+    return;
+  }
   if (IntSimdMatrix::intSimdMatrix) {
-    IntSimdMatrix::intSimdMatrix->matrixDotVectorFunction(wi_.dim1(), wi_.dim2(), &shaped_w_[0],
+    IntSimdMatrix::intSimdMatrix->matrixDotVectorFunction(wi_.dim1(), wi_.dim2(), ShapedWeights(),
                                                           &scales_[0], u, v);
   } else {
     IntSimdMatrix::MatrixDotVector(wi_, scales_, u, v);
   }
 }
 
+// Number of weight rows that MatrixDotVectors applies to all the float input
+// vectors before moving on to the next rows.
+const int kNumRowsPerChunk = 64;
+
+void WeightMatrix::MatrixDotVectors(int num_vectors, const TFloat *const *u,
+                                    TFloat *const *v) const {
+  assert(!int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectors(num_vectors, u, v);
+    return;
+  }
+  int num_results = wf_.dim1();
+  int extent = wf_.dim2() - 1;
+  for (int start = 0; start < num_results; start += kNumRowsPerChunk) {
+    int end = std::min(start + kNumRowsPerChunk, num_results);
+    for (int b = 0; b < num_vectors; ++b) {
+      const TFloat *ub = u[b];
+      TFloat *vb = v[b];
+      for (int i = start; i < end; ++i) {
+        const TFloat *wi = wf_[i];
+        vb[i] = DotProduct(wi, ub, extent) + wi[extent];
+      }
+    }
+  }
+}
+
+void WeightMatrix::MatrixDotVectors(int num_vectors, const int8_t *const *u,
+                                    TFloat *const *v) const {
+  assert(int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectors(num_vectors, u, v);
+    return;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (matrix == nullptr) {
+    for (int b = 0; b < num_vectors; ++b) {
+      IntSimdMatrix::MatrixDotVector(wi_, scales_, u[b], v[b]);
+    }
+    return;
+  }
+  // The shaped weights are laid out in groups of outputs of the largest
+  // register set, so running the SIMD function on one group at a time gives
+  // exactly the same results as running it on the whole matrix.
+  int num_out = wi_.dim1();
+  int num_in = wi_.dim2() - 1;
+  int group_size = matrix->max_output_registers_ * matrix->num_outputs_per_register_;
+  int rounded_num_in = IntSimdMatrix::Roundup(num_in, matrix->num_inputs_per_group_);
+  int output = 0;
+  for (; output + group_size <= num_out; output += group_size) {
+    const int8_t *shaped_w = ShapedWeights() + output * (rounded_num_in + 1);
+    for (int b = 0; b < num_vectors; ++b) {
+      matrix->matrixDotVectorFunction(group_size, wi_.dim2(), shaped_w, &scales_[output], u[b],
+                                      v[b] + output);
+    }
+  }
+  if (output < num_out) {
+    const int8_t *shaped_w = ShapedWeights() + output * (rounded_num_in + 1);
+    for (int b = 0; b < num_vectors; ++b) {
+      matrix->matrixDotVectorFunction(num_out - output, wi_.dim2(), shaped_w, &scales_[output],
+                                      u[b], v[b] + output);
+    }
+  }
+}
+
+void WeightMatrix::MatrixDotVectorPart(const TFloat *u, int start, int end, TFloat *v) const {
+  assert(!int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectorPart(u, start, end, v);
+    return;
+  }
+  int extent = wf_.dim2() - 1;
+  for (int i = start; i < end; ++i) {
+    const TFloat *wi = wf_[i];
+    v[i] = DotProduct(wi, u, extent) + wi[extent];
+  }
+}
+
+void WeightMatrix::MatrixDotVectorPart(const int8_t *u, int start, int end, TFloat *v) const {
+  assert(int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectorPart(u, start, end, v);
+    return;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (matrix == nullptr) {
+    int num_in = wi_.dim2() - 1;
+    for (int i = start; i < end; ++i) {
+      const int8_t *wi = wi_[i];
+      int total = 0;
+      for (int j = 0; j < num_in; ++j) {
+        total += wi[j] * u[j];
+      }
+      // Add in the bias and correct for integer values.
+      v[i] = (total + wi[num_in] * INT8_MAX) * scales_[i];
+    }
+    return;
+  }
+  assert(start % OutputGroupSize() == 0);
+  int rounded_num_in = IntSimdMatrix::Roundup(wi_.dim2() - 1, matrix->num_inputs_per_group_);
+  matrix->matrixDotVectorFunction(end - start, wi_.dim2(), ShapedWeights() + start * (rounded_num_in + 1),
+                                  &scales_[start], u, v + start);
+}
+
+int WeightMatrix::OutputGroupSize() const {
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (!int_mode_ || matrix == nullptr) {
+    return 1;
+  }
+  return matrix->max_output_registers_ * matrix->num_outputs_per_register_;
+}
+
+// Minimum number of outputs of each gate in a block of a FusedWeightMatrix.
+const int kFusedBlockSize = 8;
+
+// Sets up everything but the int weights for the num_gates matrices in
+// gates, as Init.
+void FusedWeightMatrix::InitLayout(int num_gates, const WeightMatrix *gates) {
+  Clear();
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  int_mode_ = gates[0].is_int_mode();
+  int num_gate_outputs = gates[0].NumOutputs();
+  num_gates_ = num_gates;
+  // A whole block of each gate fills whole output registers of the SIMD code.
+  block_size_ = kFusedBlockSize;
+  if (int_mode_ && matrix != nullptr) {
+    block_size_ = IntSimdMatrix::Roundup(block_size_, matrix->num_outputs_per_register_);
+  }
+  num_outputs_ = IntSimdMatrix::Roundup(num_gate_outputs, block_size_) * num_gates_;
+  row_size_ = gates[0].RowSize();
+  if (!int_mode_) {
+    float_rows_.resize(num_outputs_, nullptr);
+    for (int g = 0; g < num_gates_; ++g) {
+      ASSERT_HOST(!gates[g].is_int_mode() && gates[g].NumOutputs() == num_gate_outputs);
+      for (int i = 0; i < num_gate_outputs; ++i) {
+        float_rows_[Index(g, i)] = gates[g].GetWeights(i);
+      }
+    }
+    return;
+  }
+  scales_.resize(num_outputs_, 0.0);
+  for (int g = 0; g < num_gates_; ++g) {
+    ASSERT_HOST(gates[g].is_int_mode() && gates[g].NumOutputs() == num_gate_outputs);
+    for (int i = 0; i < num_gate_outputs; ++i) {
+      scales_[Index(g, i)] = gates[g].GetScale(i);
+    }
+  }
+}
+
+// Interleaves the rows of the num_gates matrices in gates, which must all
+// have the same shape and mode.
+void FusedWeightMatrix::Init(int num_gates, const WeightMatrix *gates) {
+  InitLayout(num_gates, gates);
+  if (!int_mode_) {
+    return;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  int num_gate_outputs = gates[0].NumOutputs();
+  wi_.Resize(num_outputs_, row_size_, 0);
+  for (int g = 0; g < num_gates_; ++g) {
+    for (int i = 0; i < num_gate_outputs; ++i) {
+      memcpy(wi_[Index(g, i)], gates[g].GetIntWeights(i), row_size_ * sizeof(int8_t));
+    }
+  }
+  if (matrix != nullptr) {
+    int32_t rounded_num_out;
+    matrix->Init(wi_, shaped_w_, rounded_num_out);
+    scales_.resize(rounded_num_out);
+    wi_.Free();
+  }
+}
+
+// Frees the weights, making *this empty.
+void FusedWeightMatrix::Clear() {
+  num_gates_ = 0;
+  block_size_ = 0;
+  num_outputs_ = 0;
+  row_size_ = 0;
+  std::vector<const TFloat *>().swap(float_rows_);
+  wi_.Free();
+  std::vector<TFloat>().swap(scales_);
+  std::vector<int8_t>().swap(shaped_w_);
+  mapped_shaped_w_ = nullptr;
+  mapping_.reset();
+  shared_ = nullptr;
+}
+
+// Makes *this use the weights of src, which must outlive *this.
+void FusedWeightMatrix::ShareWeights(const FusedWeightMatrix &src) {
+  Clear();
+  if (src.empty()) {
+    return;
+  }
+  num_gates_ = src.num_gates_;
+  block_size_ = src.block_size_;
+  num_outputs_ = src.num_outputs_;
+  row_size_ = src.row_size_;
+  int_mode_ = src.int_mode_;
+  shared_ = src.shared_ != nullptr ? src.shared_ : &src;
+}
+
+bool FusedWeightMatrix::Serialize(TFile *fp) const {
+  if (shared_ != nullptr) {
+    return shared_->Serialize(fp);
+  }
+  return SerializeShapedWeights(ShapedWeights(), num_outputs_, row_size_ - 1, fp);
+}
+
+bool FusedWeightMatrix::DeSerialize(int num_gates, const WeightMatrix *gates, TFile *fp) {
+  InitLayout(num_gates, gates);
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  size_t expected_size =
+      int_mode_ && matrix != nullptr ? ShapedSize(matrix, num_outputs_, row_size_ - 1) : 0;
+  bool shaped;
+  if (!DeSerializeShapedWeights(fp, expected_size, shaped_w_, &mapped_shaped_w_, &shaped)) {
+    return false;
+  }
+  if (!shaped) {
+    Init(num_gates, gates);
+  } else {
+    if (mapped_shaped_w_ != nullptr) {
+      mapping_ = fp->mapping();
+    }
+    scales_.resize(matrix->RoundOutputs(num_outputs_));
+  }
+  return true;
+}
+
+int FusedWeightMatrix::OutputGroupSize() const {
+  int group_size = num_gates_ * block_size_;
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (int_mode_ && matrix != nullptr) {
+    int register_set_size = matrix->max_output_registers_ * matrix->num_outputs_per_register_;
+    group_size = std::lcm(group_size, register_set_size);
+  }
+  return group_size;
+}
+
+void FusedWeightMatrix::MatrixDotVector(const TFloat *u, TFloat *v) const {
+  MatrixDotVectorPart(u, 0, num_outputs_, v);
+}
+
+void FusedWeightMatrix::MatrixDotVector(const int8_t *u, TFloat *v) const {
+  MatrixDotVectorPart(u, 0, num_outputs_, v);
+}
+
+void FusedWeightMatrix::MatrixDotVectors(int num_vectors, const TFloat *const *u,
+                                         TFloat *const *v) const {
+  for (int start = 0; start < num_outputs_; start += kNumRowsPerChunk) {
+    int end = std::min(start + kNumRowsPerChunk, num_outputs_);
+    for (int b = 0; b < num_vectors; ++b) {
+      MatrixDotVectorPart(u[b], start, end, v[b]);
+    }
+  }
+}
+
+void FusedWeightMatrix::MatrixDotVectors(int num_vectors, const int8_t *const *u,
+                                         TFloat *const *v) const {
+  // Each chunk is a whole number of SIMD register sets, so running the SIMD
+  // function on one chunk at a time gives exactly the same results as running
+  // it on the whole matrix.
+  int chunk_size = OutputGroupSize();
+  for (int start = 0; start < num_outputs_; start += chunk_size) {
+    int end = std::min(start + chunk_size, num_outputs_);
+    for (int b = 0; b < num_vectors; ++b) {
+      MatrixDotVectorPart(u[b], start, end, v[b]);
+    }
+  }
+}
+
+void FusedWeightMatrix::MatrixDotVectorPart(const TFloat *u, int start, int end,
+                                            TFloat *v) const {
+  assert(!int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectorPart(u, start, end, v);
+    return;
+  }
+  int extent = row_size_ - 1;
+  for (int i = start; i < end; ++i) {
+    const TFloat *wi = float_rows_[i];
+    v[i] = wi != nullptr ? DotProduct(wi, u, extent) + wi[extent] : 0;
+  }
+}
+
+void FusedWeightMatrix::MatrixDotVectorPart(const int8_t *u, int start, int end,
+                                            TFloat *v) const {
+  assert(int_mode_);
+  if (shared_ != nullptr) {
+    shared_->MatrixDotVectorPart(u, start, end, v);
+    return;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  int num_in = row_size_ - 1;
+  if (matrix == nullptr) {
+    for (int i = start; i < end; ++i) {
+      const int8_t *wi = wi_[i];
+      int total = 0;
+      for (int j = 0; j < num_in; ++j) {
+        total += wi[j] * u[j];
+      }
+      // Add in the bias and correct for integer values.
+      v[i] = (total + wi[num_in] * INT8_MAX) * scales_[i];
+    }
+    return;
+  }
+  assert(start % OutputGroupSize() == 0);
+  int rounded_num_in = IntSimdMatrix::Roundup(num_in, matrix->num_inputs_per_group_);
+  matrix->matrixDotVectorFunction(end - start, row_size_, ShapedWeights() + start * (rounded_num_in + 1),
+                                  &scales_[start], u, v + start);
+}
+
 // MatrixDotVector for peep weights, MultiplyAccumulate adds the
 // component-wise products of *this[0] and v to inout.
 void WeightMatrix::MultiplyAccumulate(const TFloat *v, TFloat *inout) {
   assert(!int_mode_);
-  assert(wf_.dim1() == 1);
-  int n = wf_.dim2();
-  const TFloat *u = wf_[0];
+  const WeightMatrix &src = shared_ != nullptr ? *shared_ : *this;
+  assert(src.wf_.dim1() == 1);
+  int n = src.wf_.dim2();
+  const TFloat *u = src.wf_[0];
   for (int i = 0; i < n; ++i) {
     inout[i] += u[i] * v[i];
   }
@@ -530,17 +971,18 @@ static void HistogramWeight(TFloat weight, STATS *histogram) {
 }
 
 void WeightMatrix::Debug2D(const char *msg) {
+  const WeightMatrix &src = shared_ != nullptr ? *shared_ : *this;
   STATS histogram(0, kHistogramBuckets - 1);
   if (int_mode_) {
-    for (int i = 0; i < wi_.dim1(); ++i) {
-      for (int j = 0; j < wi_.dim2(); ++j) {
-        HistogramWeight(wi_[i][j] * scales_[i], &histogram);
+    for (int i = 0; i < src.wi_.dim1(); ++i) {
+      for (int j = 0; j < src.wi_.dim2(); ++j) {
+        HistogramWeight(src.wi_[i][j] * src.scales_[i], &histogram);
       }
     }
   } else {
-    for (int i = 0; i < wf_.dim1(); ++i) {
-      for (int j = 0; j < wf_.dim2(); ++j) {
-        HistogramWeight(wf_[i][j], &histogram);
+    for (int i = 0; i < src.wf_.dim1(); ++i) {
+      for (int j = 0; j < src.wf_.dim2(); ++j) {
+        HistogramWeight(src.wf_[i][j], &histogram);
       }
     }
   }
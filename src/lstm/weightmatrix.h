@@ -69,7 +69,7 @@ public:
 // backward steps with the matrix and updates to the weights.
 class WeightMatrix {
 public:
-  WeightMatrix() : int_mode_(false), use_adam_(false) {}
+  WeightMatrix() : int_mode_(false), use_adam_(false), shared_(nullptr) {}
   // Sets up the network for training. Initializes weights using weights of
   // scale `range` picked according to the random number generator `randomizer`.
   // Note the order is outputs, inputs, as this is the order of indices to
@@ -91,6 +91,18 @@ public:
   // Store a multiplicative scale factor (as a float) that will reproduce
   // the original value, subject to rounding errors.
   void ConvertToInt();
+  // Makes *this use the weights of src, which must have the same shape, and
+  // must outlive *this without changing. The weights of *this are freed, so
+  // it can only be used for running forward afterwards.
+  void ShareWeights(const WeightMatrix &src);
+  // Shapes the int weights for the IntSimdMatrix in use, unless they are
+  // already shaped or there is none. ConvertToInt does it, but DeSerialize
+  // leaves it to the caller, if the weights were not written shaped.
+  void ShapeWeights();
+  // Frees the shaped int weights, keeping wi_ and scales_, which Serialize
+  // needs, and from which ShapeWeights can make them again. For matrices
+  // that are only used through a FusedWeightMatrix made from them.
+  void FreeShapedWeights();
   // Returns the size rounded up to an internal factor used by the SIMD
   // implementation for its input.
   int RoundInputs(int size) const {
@@ -105,11 +117,40 @@ public:
     return int_mode_;
   }
   int NumOutputs() const {
+    if (shared_ != nullptr) {
+      return shared_->NumOutputs();
+    }
+    if (weights_omitted()) {
+      return omitted_num_outputs_;
+    }
     return int_mode_ ? wi_.dim1() : wf_.dim1();
   }
-  // Provides one set of weights. Only used by peep weight maxpool.
+  // Returns the number of weights in each row, including the bias.
+  int RowSize() const {
+    if (shared_ != nullptr) {
+      return shared_->RowSize();
+    }
+    if (weights_omitted()) {
+      return omitted_row_size_;
+    }
+    return int_mode_ ? wi_.dim2() : wf_.dim2();
+  }
+  // Returns true if only the shape of the weights was read, as written to a
+  // TFile with omit_weights set, so ShareWeights must provide the weights.
+  bool weights_omitted() const {
+    return omitted_num_outputs_ > 0;
+  }
+  // Provides one set of weights. Only used by peep weight maxpool and
+  // FusedWeightMatrix.
   const TFloat *GetWeights(int index) const {
-    return wf_[index];
+    return shared_ != nullptr ? shared_->GetWeights(index) : wf_[index];
+  }
+  // Provides one set of int weights and its scale factor.
+  const int8_t *GetIntWeights(int index) const {
+    return shared_ != nullptr ? shared_->GetIntWeights(index) : wi_[index];
+  }
+  TFloat GetScale(int index) const {
+    return shared_ != nullptr ? shared_->GetScale(index) : scales_[index];
   }
   // Provides access to the deltas (dw_).
   TFloat GetDW(int i, int j) const {
@@ -121,8 +162,13 @@ public:
   void InitBackward();
 
   // Writes to the given file. Returns false in case of error.
-  bool Serialize(bool training, TFile *fp) const;
+  // If fp->omit_weights(), only the mode and shape are written.
+  // If shaped, int weights are also written shaped for the IntSimdMatrix in
+  // use, so DeSerialize can use them without shaping them again if it runs
+  // with an IntSimdMatrix of the same layout.
+  bool Serialize(bool training, bool shaped, TFile *fp) const;
   // Reads from the given file. Returns false in case of error.
+  // Int weights that were not written shaped need ShapeWeights before use.
   bool DeSerialize(bool training, TFile *fp);
   // As DeSerialize, but reads an old (float) format WeightMatrix for
   // backward compatibility.
@@ -135,6 +181,22 @@ public:
   // Asserts that the call matches what we have.
   void MatrixDotVector(const TFloat *u, TFloat *v) const;
   void MatrixDotVector(const int8_t *u, TFloat *v) const;
+  // As MatrixDotVector, but computes v[b] = Wu[b] for each of the num_vectors
+  // input vectors, working through the weights in chunks so that each chunk
+  // is reused for all the inputs while it is still in cache. The results are
+  // identical to calling MatrixDotVector for each vector separately.
+  void MatrixDotVectors(int num_vectors, const TFloat *const *u, TFloat *const *v) const;
+  void MatrixDotVectors(int num_vectors, const int8_t *const *u, TFloat *const *v) const;
+  // As MatrixDotVector, but computes only the outputs [start, end) of v, so
+  // the rows of a matrix can be shared out between threads. For int weights,
+  // start must be a multiple of OutputGroupSize(), and the SIMD code may
+  // write v up to end rounded up by IntSimdMatrix::RoundOutputs. The results
+  // are identical to those of MatrixDotVector.
+  void MatrixDotVectorPart(const TFloat *u, int start, int end, TFloat *v) const;
+  void MatrixDotVectorPart(const int8_t *u, int start, int end, TFloat *v) const;
+  // Returns the number of outputs that MatrixDotVector computes together, to
+  // which the start of a MatrixDotVectorPart must be aligned.
+  int OutputGroupSize() const;
   // MatrixDotVector for peep weights, MultiplyAccumulate adds the
   // component-wise products of *this[0] and v to inout.
   void MultiplyAccumulate(const TFloat *v, TFloat *inout);
@@ -161,9 +223,17 @@ public:
   void Debug2D(const char *msg);
 
 private:
+  // Returns the weights shaped for the IntSimdMatrix.
+  const int8_t *ShapedWeights() const {
+    return mapped_shaped_w_ != nullptr ? mapped_shaped_w_ : shaped_w_.data();
+  }
+
   // Choice between float and 8 bit int implementations.
   GENERIC_2D_ARRAY<TFloat> wf_;
   GENERIC_2D_ARRAY<int8_t> wi_;
+  // If wi_ or the shaped weights were read in place from a memory mapped
+  // traineddata file, the mapping, which is kept alive while they use it.
+  std::shared_ptr<const MappedFile> mapping_;
   // Transposed copy of wf_, used only for Backward, and set with each Update.
   TransposedArray wf_t_;
   // Which of wf_ and wi_ are we actually using.
@@ -182,6 +252,114 @@ private:
   GENERIC_2D_ARRAY<TFloat> dw_sq_sum_;
   // The weights matrix reorganized in whatever way suits this instance.
   std::vector<int8_t> shaped_w_;
+  // If not null, the reorganized weights in mapping_, used instead of
+  // shaped_w_.
+  const int8_t *mapped_shaped_w_ = nullptr;
+  // If not null, the WeightMatrix whose weights are used instead of those of
+  // *this. Borrowed pointer. Don't delete!
+  const WeightMatrix *shared_;
+  // If the weights were omitted from the file, their shape, else 0.
+  int omitted_num_outputs_ = 0;
+  int omitted_row_size_ = 0;
+};
+
+// The rows of several WeightMatrix of the same shape, such as the gates of an
+// LSTM, interleaved into a single matrix, so one matrix.vector product with
+// the input computes all of them, and each input is loaded only once for all
+// the outputs of a set of SIMD registers.
+// The rows are interleaved in blocks of block_size() outputs, so output i of
+// gate g is at Index(g, i), and the values of all the gates for the outputs
+// of a block are close together for the following element-wise operations.
+// The last block of each gate is padded with zero rows.
+// For int weights, the interleaved rows are copied into a block shaped for
+// the IntSimdMatrix. For float weights, the rows are not copied. Only
+// pointers to them are kept, so the source matrices must outlive *this
+// without being resized.
+class FusedWeightMatrix {
+public:
+  FusedWeightMatrix() = default;
+  // Interleaves the rows of the num_gates matrices in gates, which must all
+  // have the same shape and mode.
+  void Init(int num_gates, const WeightMatrix *gates);
+  // Frees the weights, making *this empty.
+  void Clear();
+  // Makes *this use the weights of src, which must outlive *this.
+  void ShareWeights(const FusedWeightMatrix &src);
+  // Writes the int weights shaped for the IntSimdMatrix in use. The rest of
+  // *this is not written, as it is made again from the source matrices.
+  // Returns false in case of error.
+  bool Serialize(TFile *fp) const;
+  // As Init, but uses the shaped weights written by Serialize instead of
+  // shaping the interleaved rows again, if they have the layout of the
+  // IntSimdMatrix in use. Returns false in case of error.
+  bool DeSerialize(int num_gates, const WeightMatrix *gates, TFile *fp);
+
+  // Accessors.
+  bool empty() const {
+    return num_gates_ == 0;
+  }
+  int num_gates() const {
+    return num_gates_;
+  }
+  int block_size() const {
+    return block_size_;
+  }
+  // Returns the number of rows including the padding. An output vector of
+  // MatrixDotVector must have this size.
+  int NumOutputs() const {
+    return num_outputs_;
+  }
+  // Returns the index of output i of gate in the interleaved output.
+  int Index(int gate, int i) const {
+    return (i / block_size_ * num_gates_ + gate) * block_size_ + i % block_size_;
+  }
+  // Returns the number of outputs to which the start of a MatrixDotVectorPart
+  // must be aligned. It is a whole number of blocks of all the gates.
+  int OutputGroupSize() const;
+
+  // Computes matrix.vector v = Wu for all the interleaved rows, as
+  // WeightMatrix::MatrixDotVector. The results are identical to those of
+  // the source matrices.
+  void MatrixDotVector(const TFloat *u, TFloat *v) const;
+  void MatrixDotVector(const int8_t *u, TFloat *v) const;
+  // As MatrixDotVector, but for each of the num_vectors input vectors.
+  void MatrixDotVectors(int num_vectors, const TFloat *const *u, TFloat *const *v) const;
+  void MatrixDotVectors(int num_vectors, const int8_t *const *u, TFloat *const *v) const;
+  // As MatrixDotVector, but computes only the outputs [start, end) of v.
+  // start must be a multiple of OutputGroupSize(), and end must be one too,
+  // or NumOutputs().
+  void MatrixDotVectorPart(const TFloat *u, int start, int end, TFloat *v) const;
+  void MatrixDotVectorPart(const int8_t *u, int start, int end, TFloat *v) const;
+
+private:
+  // Sets up everything but the int weights for the num_gates matrices in
+  // gates, as Init.
+  void InitLayout(int num_gates, const WeightMatrix *gates);
+  // Returns the weights shaped for the IntSimdMatrix.
+  const int8_t *ShapedWeights() const {
+    return mapped_shaped_w_ != nullptr ? mapped_shaped_w_ : shaped_w_.data();
+  }
+
+  int num_gates_ = 0;
+  int block_size_ = 0;
+  int num_outputs_ = 0;
+  // Number of weights in each row, including the bias.
+  int row_size_ = 0;
+  bool int_mode_ = false;
+  // Float mode: the interleaved rows of the sources, nullptr for padding.
+  std::vector<const TFloat *> float_rows_;
+  // Int mode: the interleaved rows, kept only if there is no IntSimdMatrix,
+  // the scales, and the rows shaped for the IntSimdMatrix.
+  GENERIC_2D_ARRAY<int8_t> wi_;
+  std::vector<TFloat> scales_;
+  std::vector<int8_t> shaped_w_;
+  // If not null, the shaped rows in a memory mapped traineddata file, used
+  // instead of shaped_w_, and the mapping, which is kept alive for them.
+  const int8_t *mapped_shaped_w_ = nullptr;
+  std::shared_ptr<const MappedFile> mapping_;
+  // If not null, the FusedWeightMatrix whose weights are used instead of
+  // those of *this. Borrowed pointer. Don't delete!
+  const FusedWeightMatrix *shared_ = nullptr;
 };
 
 } // namespace tesseract.
@@ -33,6 +33,7 @@
 
 #include <tesseract/baseapi.h>
 #include "dict.h"
+#include "lstmrecognizer.h"
 #include <tesseract/renderer.h>
 #include "simddetect.h"
 #include "tesseractclass.h" // for AnyTessLang
@@ -707,10 +708,12 @@ static int main1(int argc, char **argv) {
     return EXIT_SUCCESS;
   }
 
-  // Call GlobalDawgCache here to create the global DawgCache object before
-  // the TessBaseAPI object. This fixes the order of destructor calls:
-  // first TessBaseAPI must be destructed, DawgCache must be the last object.
+  // Call GlobalDawgCache and GlobalModelCache here to create the global
+  // caches before the TessBaseAPI object. This fixes the order of destructor
+  // calls: first TessBaseAPI must be destructed, the caches must be the last
+  // objects.
   tesseract::Dict::GlobalDawgCache();
+  tesseract::LSTMRecognizer::GlobalModelCache();
 
   TessBaseAPI api;
 
@@ -23,7 +23,13 @@
 #include "image.h"    // for Image
 #include "pdblock.h"
 
-#include <memory> // std::unique_ptr
+#include <algorithm> // std::min, std::max
+#include <cstdint>   // uint32_t
+#include <memory>    // std::unique_ptr
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h> // _BitScanReverse
+#endif
 
 namespace tesseract {
 
@@ -32,6 +38,27 @@ namespace tesseract {
 // Flips between WHITE_PIX and BLACK_PIX.
 #define FLIP_COLOUR(pix) (1 - (pix))
 
+// Lines are scanned as packed words of kWordBits pixels, leftmost pixel in
+// the most significant bit, like the words of a Pix.
+const int kWordBits = 32;
+
+// Returns the index from the left of the leftmost pixel set in word != 0.
+static inline int first_pixel(uint32_t word) {
+#if defined(__GNUC__)
+  return __builtin_clz(word);
+#elif defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanReverse(&index, word);
+  return kWordBits - 1 - index;
+#else
+  int index = 0;
+  for (uint32_t mask = 0x80000000u; (word & mask) == 0; mask >>= 1) {
+    ++index;
+  }
+  return index;
+#endif
+}
+
 struct CrackPos {
   CRACKEDGE **free_cracks; // Freelist for fast allocation.
   int x;                   // Position of new edge.
@@ -43,12 +70,15 @@ static void free_crackedges(CRACKEDGE *start);
 static void join_edges(CRACKEDGE *edge1, CRACKEDGE *edge2, CRACKEDGE **free_cracks,
                        C_OUTLINE_IT *outline_it);
 
-static void line_edges(TDimension x, TDimension y, TDimension xext, uint8_t uppercolour, uint8_t *bwpos,
-                       CRACKEDGE **prevline, CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it);
+static void line_edges(TDimension x, TDimension y, TDimension xext, uint8_t uppercolour,
+                       const uint32_t *bwline, const uint32_t *upperline, CRACKEDGE **prevline,
+                       CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it);
 
-static void make_margins(PDBLK *block, BLOCK_LINE_IT *line_it, uint8_t *pixels, uint8_t margin,
+static void make_margins(PDBLK *block, BLOCK_LINE_IT *line_it, uint32_t *pixels, uint8_t margin,
                          TDimension left, TDimension right, TDimension y);
 
+static void set_pixels(uint32_t *pixels, int start, int end, uint8_t colour);
+
 static CRACKEDGE *h_edge(int sign, CRACKEDGE *join, CrackPos *pos);
 static CRACKEDGE *v_edge(int sign, CRACKEDGE *join, CrackPos *pos);
 
@@ -80,23 +110,40 @@ void block_edges(Image t_pix,   // thresholded image
     ptrline[x] = nullptr; //  no lines in progress
   }
 
-  std::unique_ptr<uint8_t[]> bwline(new uint8_t[width]);
+  // The current line and the one above it, packed, with WHITE_PIX as 1.
+  int block_wpl = block_width / kWordBits + 1;
+  std::unique_ptr<uint32_t[]> bwline(new uint32_t[block_wpl]);
+  std::unique_ptr<uint32_t[]> upperline(new uint32_t[block_wpl]);
 
   const uint8_t margin = WHITE_PIX;
+  const uint32_t margin_word = margin == WHITE_PIX ? ~0u : 0u;
 
+  for (int i = 0; i < block_wpl; ++i) {
+    upperline[i] = margin_word;
+  }
+  int shift = bleft.x() % kWordBits;
   for (int y = tright.y() - 1; y >= bleft.y() - 1; y--) {
     if (y >= bleft.y() && y < tright.y()) {
-      // Get the binary pixels from the image.
-      l_uint32 *line = pixGetData(t_pix) + wpl * (height - 1 - y);
-      for (int x = 0; x < block_width; ++x) {
-        bwline[x] = Image::getDataBit(line, x + bleft.x()) ^ 1;
+      // Get the binary pixels from the image, shifted to start at the block
+      // and inverted to make white 1.
+      l_uint32 *line = pixGetData(t_pix) + wpl * (height - 1 - y) + bleft.x() / kWordBits;
+      int line_words = wpl - bleft.x() / kWordBits;
+      for (int i = 0; i < block_wpl; ++i) {
+        uint32_t word = i < line_words ? line[i] << shift : 0;
+        if (shift != 0 && i + 1 < line_words) {
+          word |= line[i + 1] >> (kWordBits - shift);
+        }
+        bwline[i] = ~word;
       }
       make_margins(block, &line_it, bwline.get(), margin, bleft.x(), tright.x(), y);
     } else {
-      memset(bwline.get(), margin, block_width * sizeof(bwline[0]));
+      for (int i = 0; i < block_wpl; ++i) {
+        bwline[i] = margin_word;
+      }
     }
-    line_edges(bleft.x(), y, block_width, margin, bwline.get(), ptrline.get(), &free_cracks,
-               outline_it);
+    line_edges(bleft.x(), y, block_width, margin, bwline.get(), upperline.get(), ptrline.get(),
+               &free_cracks, outline_it);
+    bwline.swap(upperline);
   }
 
   free_crackedges(free_cracks); // really free them
@@ -111,7 +158,7 @@ void block_edges(Image t_pix,   // thresholded image
 static void make_margins(   // get a line
     PDBLK *block,           // block in image
     BLOCK_LINE_IT *line_it, // for old style
-    uint8_t *pixels,        // pixels to strip
+    uint32_t *pixels,       // packed pixels to strip
     uint8_t margin,         // white-out pixel
     TDimension left,        // block edges
     TDimension right,
@@ -127,30 +174,47 @@ static void make_margins(   // get a line
       seg_it.mark_cycle_pt();
       auto start = seg_it.data()->x();
       auto xext = seg_it.data()->y();
-      for (auto xindex = left; xindex < right; xindex++) {
+      for (int xindex = left; xindex < right;) {
         if (xindex >= start && !seg_it.cycled_list()) {
-          xindex = start + xext - 1;
+          xindex = start + xext;
           seg_it.forward();
           start = seg_it.data()->x();
           xext = seg_it.data()->y();
         } else {
-          pixels[xindex - left] = margin;
+          // Strip up to the next segment.
+          int end = seg_it.cycled_list() ? right : std::min<int>(start, right);
+          set_pixels(pixels, xindex - left, end - left, margin);
+          xindex = end;
         }
       }
     } else {
-      for (auto xindex = left; xindex < right; xindex++) {
-        pixels[xindex - left] = margin;
-      }
+      set_pixels(pixels, 0, right - left, margin);
     }
   } else {
     TDimension xext;  // of segment
     auto start = line_it->get_line(y, xext);
-    for (auto xindex = left; xindex < start; xindex++) {
-      pixels[xindex - left] = margin;
-    }
-    for (auto xindex = start + xext; xindex < right; xindex++) {
-      pixels[xindex - left] = margin;
+    set_pixels(pixels, 0, std::min<int>(start, right) - left, margin);
+    set_pixels(pixels, std::max<int>(start + xext, left) - left, right - left, margin);
+  }
+}
+
+/**********************************************************************
+ * set_pixels
+ *
+ * Set the packed pixels in [start, end) to colour.
+ **********************************************************************/
+
+static void set_pixels(uint32_t *pixels, int start, int end, uint8_t colour) {
+  while (start < end) {
+    int bit = start % kWordBits;
+    int count = std::min(end - start, kWordBits - bit);
+    uint32_t mask = (count == kWordBits ? ~0u : ((1u << count) - 1) << (kWordBits - bit - count));
+    if (colour == WHITE_PIX) {
+      pixels[start / kWordBits] |= mask;
+    } else {
+      pixels[start / kWordBits] &= ~mask;
     }
+    start += count;
   }
 }
 
@@ -159,69 +223,95 @@ static void make_margins(   // get a line
  *
  * Scan a line for edges and update the edges in progress.
  * When edges close into loops, send them for approximation.
+ * A pixel that has the same colour as the one above it, and as the
+ * pixel before it on both lines, changes no edge, so the line is scanned
+ * a word at a time for the pixels that do.
  **********************************************************************/
 
-static void line_edges(TDimension x,         // coord of line start
-                       TDimension y,         // coord of line
-                       TDimension xext,      // width of line
-                       uint8_t uppercolour,  // start of prev line
-                       uint8_t *bwpos,       // thresholded line
-                       CRACKEDGE **prevline, // edges in progress
+static void line_edges(TDimension x,              // coord of line start
+                       TDimension y,              // coord of line
+                       TDimension xext,           // width of line
+                       uint8_t uppercolour,       // start of prev line
+                       const uint32_t *bwline,    // thresholded line
+                       const uint32_t *upperline, // thresholded prev line
+                       CRACKEDGE **prevline,      // edges in progress
                        CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it) {
   CrackPos pos = {free_cracks, x, y};
-  int xmax;              // max x coord
   int prevcolour;        // of previous pixel
   CRACKEDGE *current;    // current h edge
   CRACKEDGE *newcurrent; // new h edge
 
-  xmax = x + xext;          // max allowable coord
   prevcolour = uppercolour; // forced plain margin
   current = nullptr;        // nothing yet
-
-  // do each pixel
-  for (; pos.x < xmax; pos.x++, prevline++) {
-    const int colour = *bwpos++; // current pixel
-    if (*prevline != nullptr) {
-      // changed above
-      // change colour
-      uppercolour = FLIP_COLOUR(uppercolour);
-      if (colour == prevcolour) {
-        if (colour == uppercolour) {
-          // finish a line
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = nullptr; // no edge now
+  CRACKEDGE **lineptrs = prevline;
+  // Colour of the pixel before the word on the line and the line above.
+  uint32_t carry = uppercolour == WHITE_PIX ? 1 : 0;
+  uint32_t uppercarry = carry;
+
+  // do each word
+  for (int word_x = 0; word_x < xext; word_x += kWordBits) {
+    const uint32_t bits = *bwline++;
+    const uint32_t upperbits = *upperline++;
+    const uint32_t diff = bits ^ upperbits;
+    const uint32_t prevdiff = (diff >> 1) | ((carry ^ uppercarry) << (kWordBits - 1));
+    const uint32_t change = bits ^ ((bits >> 1) | (carry << (kWordBits - 1)));
+    uint32_t busy = diff | prevdiff | change;
+    if (xext - word_x < kWordBits) {
+      busy &= ~(~0u >> (xext - word_x)); // ignore the pixels past the end
+    }
+    carry = bits & 1;
+    uppercarry = upperbits & 1;
+    // do each pixel that changes an edge
+    while (busy != 0) {
+      const int bit = first_pixel(busy);
+      busy &= ~(0x80000000u >> bit);
+      pos.x = x + word_x + bit;
+      prevline = lineptrs + word_x + bit;
+      const int colour = (bits >> (kWordBits - 1 - bit)) & 1; // current pixel
+      if (*prevline != nullptr) {
+        // changed above
+        // change colour
+        uppercolour = FLIP_COLOUR(uppercolour);
+        if (colour == prevcolour) {
+          if (colour == uppercolour) {
+            // finish a line
+            join_edges(current, *prevline, free_cracks, outline_it);
+            current = nullptr; // no edge now
+          } else {
+            // new horiz edge
+            current = h_edge(uppercolour - colour, *prevline, &pos);
+          }
+          *prevline = nullptr; // no change this time
         } else {
-          // new horiz edge
-          current = h_edge(uppercolour - colour, *prevline, &pos);
+          if (colour == uppercolour) {
+            *prevline = v_edge(colour - prevcolour, *prevline, &pos);
+          // 8 vs 4 connection
+          } else if (colour == WHITE_PIX) {
+            join_edges(current, *prevline, free_cracks, outline_it);
+            current = h_edge(uppercolour - colour, nullptr, &pos);
+            *prevline = v_edge(colour - prevcolour, current, &pos);
+          } else {
+            newcurrent = h_edge(uppercolour - colour, *prevline, &pos);
+            *prevline = v_edge(colour - prevcolour, current, &pos);
+            current = newcurrent; // right going h edge
+          }
+          prevcolour = colour; // remember new colour
         }
-        *prevline = nullptr; // no change this time
       } else {
-        if (colour == uppercolour) {
-          *prevline = v_edge(colour - prevcolour, *prevline, &pos);
-        // 8 vs 4 connection
-        } else if (colour == WHITE_PIX) {
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = h_edge(uppercolour - colour, nullptr, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
+        if (colour != prevcolour) {
+          *prevline = current = v_edge(colour - prevcolour, current, &pos);
+          prevcolour = colour;
+        }
+        if (colour != uppercolour) {
+          current = h_edge(uppercolour - colour, current, &pos);
         } else {
-          newcurrent = h_edge(uppercolour - colour, *prevline, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
-          current = newcurrent; // right going h edge
+          current = nullptr; // no edge now
         }
-        prevcolour = colour; // remember new colour
-      }
-    } else {
-      if (colour != prevcolour) {
-        *prevline = current = v_edge(colour - prevcolour, current, &pos);
-        prevcolour = colour;
-      }
-      if (colour != uppercolour) {
-        current = h_edge(uppercolour - colour, current, &pos);
-      } else {
-        current = nullptr; // no edge now
       }
     }
   }
+  pos.x = x + xext;
+  prevline = lineptrs + xext;
   if (current != nullptr) {
     // out of block
     if (*prevline != nullptr) { // got one to join to?
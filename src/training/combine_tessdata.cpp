@@ -18,11 +18,14 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "commontraining.h" // CheckSharedLibraryVersion
+#include "dawg.h"
 #include "lstmrecognizer.h"
 #include "tessdatamanager.h"
 
 #include <cerrno>
-#include <iostream> // std::cout
+#include <filesystem>   // for std::filesystem::rename
+#include <iostream>     // std::cout
+#include <system_error> // for std::error_code
 
 using namespace tesseract;
 
@@ -36,6 +39,52 @@ static int list_components(TessdataManager &tm, const char *filename) {
   return EXIT_SUCCESS;
 }
 
+// Replaces the given traineddata file, from which tm was loaded, by the
+// data in tm. An aligned file is memory mapped by Init, so tm first copies
+// its entries out of the mapping and releases it, as a mapped file can't be
+// replaced on Windows. The file is replaced by renaming a new file, so it is
+// never left half written.
+static bool replace_traineddata(TessdataManager &tm, const char *filename) {
+  tm.ReleaseMapping();
+  std::string traineddata_filename = filename;
+  traineddata_filename += ".__tmp__";
+  if (!tm.SaveFile(traineddata_filename.c_str(), nullptr)) {
+    return false;
+  }
+  // Unlike rename, this replaces an existing file on Windows too.
+  std::error_code error;
+  std::filesystem::rename(traineddata_filename, filename, error);
+  return !error;
+}
+
+// Rewrites all the DAWG components of tm with a child index, which makes
+// lookups in nodes with many edges faster.
+static bool add_child_indexes(TessdataManager &tm) {
+  for (auto type : {TESSDATA_PUNC_DAWG, TESSDATA_SYSTEM_DAWG, TESSDATA_NUMBER_DAWG,
+                    TESSDATA_FREQ_DAWG, TESSDATA_BIGRAM_DAWG, TESSDATA_UNAMBIG_DAWG,
+                    TESSDATA_LSTM_PUNC_DAWG, TESSDATA_LSTM_SYSTEM_DAWG,
+                    TESSDATA_LSTM_NUMBER_DAWG}) {
+    tesseract::TFile fp;
+    if (!tm.GetComponent(type, &fp)) {
+      continue;
+    }
+    // The type and permuter aren't stored in the file.
+    tesseract::SquishedDawg dawg(DAWG_TYPE_WORD, "", NO_PERM, 0);
+    if (!dawg.Load(&fp)) {
+      tprintf("Failed to read DAWG component %d\n", type);
+      return false;
+    }
+    std::vector<char> dawg_data;
+    fp.OpenWrite(&dawg_data);
+    if (!dawg.write_squished_dawg(&fp, true)) {
+      tprintf("Failed to write DAWG component %d\n", type);
+      return false;
+    }
+    tm.OverwriteEntry(type, &dawg_data[0], dawg_data.size());
+  }
+  return true;
+}
+
 static int list_network(TessdataManager &tm, const char *filename) {
   if (filename != nullptr && !tm.Init(filename)) {
     tprintf("Failed to read %s\n", filename);
@@ -114,6 +163,10 @@ static int list_network(TessdataManager &tm, const char *filename) {
 // This will create  /home/$USER/temp/eng.* files with individual tessdata
 // components from tessdata/eng.traineddata.
 //
+// Specify option -x to add a child index to all the DAWGs:
+//
+// combine_tessdata -x tessdata/eng.traineddata
+//
 int main(int argc, char **argv) {
   tesseract::CheckSharedLibraryVersion();
 
@@ -194,28 +247,54 @@ int main(int argc, char **argv) {
 
     // Write the updated traineddata file.
     tm.OverwriteComponents(new_traineddata_filename, argv + 3, argc - 3);
-  } else if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+  } else if (argc == 3 && (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "-s") == 0)) {
     if (!tm.Init(argv[2])) {
       tprintf("Failed to read %s\n", argv[2]);
       return EXIT_FAILURE;
     }
-    tesseract::TFile fp;
-    if (!tm.GetComponent(tesseract::TESSDATA_LSTM, &fp)) {
-      tprintf("No LSTM Component found in %s!\n", argv[2]);
+    {
+      // The recognizer and fp may use the mapped file, so they must be gone
+      // before the file is replaced.
+      tesseract::TFile fp;
+      if (!tm.GetComponent(tesseract::TESSDATA_LSTM, &fp)) {
+        tprintf("No LSTM Component found in %s!\n", argv[2]);
+        return EXIT_FAILURE;
+      }
+      tesseract::LSTMRecognizer recognizer;
+      if (!recognizer.DeSerialize(&tm, &fp)) {
+        tprintf("Failed to deserialize LSTM in %s!\n", argv[2]);
+        return EXIT_FAILURE;
+      }
+      recognizer.ConvertToInt();
+      if (strcmp(argv[1], "-s") == 0) {
+        recognizer.SetShapedWeights(true);
+      }
+      std::vector<char> lstm_data;
+      fp.OpenWrite(&lstm_data);
+      ASSERT_HOST(recognizer.Serialize(&tm, &fp));
+      tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data[0],
+                        lstm_data.size());
+    }
+    if (!replace_traineddata(tm, argv[2])) {
+      tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
       return EXIT_FAILURE;
     }
-    tesseract::LSTMRecognizer recognizer;
-    if (!recognizer.DeSerialize(&tm, &fp)) {
-      tprintf("Failed to deserialize LSTM in %s!\n", argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "-m") == 0) {
+    if (!tm.Init(argv[2])) {
+      tprintf("Failed to read %s\n", argv[2]);
       return EXIT_FAILURE;
     }
-    recognizer.ConvertToInt();
-    std::vector<char> lstm_data;
-    fp.OpenWrite(&lstm_data);
-    ASSERT_HOST(recognizer.Serialize(&tm, &fp));
-    tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data[0],
-                      lstm_data.size());
-    if (!tm.SaveFile(argv[2], nullptr)) {
+    tm.set_aligned(true);
+    if (!replace_traineddata(tm, argv[2])) {
+      tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  } else if (argc == 3 && strcmp(argv[1], "-x") == 0) {
+    if (!tm.Init(argv[2])) {
+      tprintf("Failed to read %s\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    if (!add_child_indexes(tm) || !replace_traineddata(tm, argv[2])) {
       tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
       return EXIT_FAILURE;
     }
@@ -270,7 +349,20 @@ int main(int argc, char **argv) {
         );
     printf(
         "Usage for compacting LSTM component to int:\n"
-        "  %s -c traineddata_file\n",
+        "  %s -c traineddata_file\n\n",
+        argv[0]);
+    printf(
+        "Usage for compacting LSTM component to int, with the weights also\n"
+        "shaped for the SIMD code of this machine:\n"
+        "  %s -s traineddata_file\n\n",
+        argv[0]);
+    printf(
+        "Usage for converting to the aligned layout, which is memory mapped:\n"
+        "  %s -m traineddata_file\n\n",
+        argv[0]);
+    printf(
+        "Usage for adding a child index to the DAWGs for faster lookups:\n"
+        "  %s -x traineddata_file\n",
         argv[0]);
     return EXIT_FAILURE;
   }
@@ -22,9 +22,7 @@ namespace tesseract {
 static bool IntFlagExists(std::string_view flag_name, int32_t *value) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<IntParam *> empty;
-  auto *p =
-      ParamUtils::FindParam<IntParam>(full_flag_name.c_str(), GlobalParams()->int_params, empty);
+  auto *p = ParamUtils::FindParam<IntParam>(full_flag_name.c_str(), nullptr);
   if (p == nullptr) {
     return false;
   }
@@ -35,9 +33,7 @@ static bool IntFlagExists(std::string_view flag_name, int32_t *value) {
 static bool DoubleFlagExists(std::string_view flag_name, double *value) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<DoubleParam *> empty;
-  auto *p = ParamUtils::FindParam<DoubleParam>(full_flag_name.c_str(),
-                                               GlobalParams()->double_params, empty);
+  auto *p = ParamUtils::FindParam<DoubleParam>(full_flag_name.c_str(), nullptr);
   if (p == nullptr) {
     return false;
   }
@@ -48,9 +44,7 @@ static bool DoubleFlagExists(std::string_view flag_name, double *value) {
 static bool BoolFlagExists(std::string_view flag_name, bool *value) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<BoolParam *> empty;
-  auto *p =
-      ParamUtils::FindParam<BoolParam>(full_flag_name.c_str(), GlobalParams()->bool_params, empty);
+  auto *p = ParamUtils::FindParam<BoolParam>(full_flag_name.c_str(), nullptr);
   if (p == nullptr) {
     return false;
   }
@@ -61,9 +55,7 @@ static bool BoolFlagExists(std::string_view flag_name, bool *value) {
 static bool StringFlagExists(std::string_view flag_name, const char **value) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<StringParam *> empty;
-  auto *p = ParamUtils::FindParam<StringParam>(full_flag_name.c_str(),
-                                               GlobalParams()->string_params, empty);
+  auto *p = ParamUtils::FindParam<StringParam>(full_flag_name.c_str(), nullptr);
   *value = (p != nullptr) ? p->c_str() : nullptr;
   return p != nullptr;
 }
@@ -71,9 +63,7 @@ static bool StringFlagExists(std::string_view flag_name, const char **value) {
 static void SetIntFlagValue(std::string_view flag_name, const int32_t new_val) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<IntParam *> empty;
-  auto *p =
-      ParamUtils::FindParam<IntParam>(full_flag_name.c_str(), GlobalParams()->int_params, empty);
+  auto *p = ParamUtils::FindParam<IntParam>(full_flag_name.c_str(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -81,9 +71,7 @@ static void SetIntFlagValue(std::string_view flag_name, const int32_t new_val) {
 static void SetDoubleFlagValue(std::string_view flag_name, const double new_val) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<DoubleParam *> empty;
-  auto *p = ParamUtils::FindParam<DoubleParam>(full_flag_name.c_str(),
-                                               GlobalParams()->double_params, empty);
+  auto *p = ParamUtils::FindParam<DoubleParam>(full_flag_name.c_str(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -91,9 +79,7 @@ static void SetDoubleFlagValue(std::string_view flag_name, const double new_val)
 static void SetBoolFlagValue(std::string_view flag_name, const bool new_val) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<BoolParam *> empty;
-  auto *p =
-      ParamUtils::FindParam<BoolParam>(full_flag_name.c_str(), GlobalParams()->bool_params, empty);
+  auto *p = ParamUtils::FindParam<BoolParam>(full_flag_name.c_str(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -101,9 +87,7 @@ static void SetBoolFlagValue(std::string_view flag_name, const bool new_val) {
 static void SetStringFlagValue(std::string_view flag_name, const char *new_val) {
   std::string full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  std::vector<StringParam *> empty;
-  auto *p = ParamUtils::FindParam<StringParam>(full_flag_name.c_str(),
-                                               GlobalParams()->string_params, empty);
+  auto *p = ParamUtils::FindParam<StringParam>(full_flag_name.c_str(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(std::string(new_val));
 }
@@ -52,6 +52,8 @@ static BOOL_PARAM_FLAG(debug_float, false, "Raise error on certain float errors.
 #endif
 static BOOL_PARAM_FLAG(stop_training, false, "Just convert the training model to a runtime model.");
 static BOOL_PARAM_FLAG(convert_to_int, false, "Convert the recognition model to an integer model.");
+static BOOL_PARAM_FLAG(shaped_weights, false,
+                       "Also store the integer weights shaped for the SIMD code of this machine.");
 static BOOL_PARAM_FLAG(sequential_training, false,
                        "Use the training files sequentially instead of round-robin.");
 static INT_PARAM_FLAG(append_index, -1,
@@ -130,6 +132,9 @@ int main(int argc, char **argv) {
     } else {
       if (FLAGS_convert_to_int) {
         trainer.ConvertToInt();
+        if (FLAGS_shaped_weights) {
+          trainer.SetShapedWeights(true);
+        }
       }
       if (!trainer.SaveTraineddata(FLAGS_model_output.c_str())) {
         tprintf("Failed to write recognition model : %s\n", FLAGS_model_output.c_str());
@@ -0,0 +1,206 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "activation.h"
+#include "functions.h"
+#include "include_gunit.h"
+#include "intsimdmatrix.h"
+#include "params.h"
+#include "simddetect.h"
+#include "threshold.h"
+
+#include <vector>
+
+namespace tesseract {
+
+// The SIMD functions use the same tables and the same order of arithmetic as
+// the scalar functions. Only a compiler which contracts the scalar code to
+// fused multiply-add can make them differ, by an ulp or so.
+const double kTolerance = 1e-6;
+
+class ActivationTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    // A dense range over the whole table, with an odd length, so the SIMD
+    // functions also have a scalar tail.
+    for (double x = -20.0; x <= 20.0; x += 1.0 / 1024) {
+      inputs_.push_back(static_cast<TFloat>(x));
+    }
+    // Values at and next to the ends of the table and the sign change.
+    for (TFloat x : {0.0, -0.0, 1.0 / kScaleFactor, 15.99, 15.996, 15.9961, 16.0, 16.01, 1e10}) {
+      inputs_.push_back(x);
+      inputs_.push_back(-x);
+    }
+    inputs_.push_back(1.0);
+    randomizer_.set_seed(1);
+  }
+
+  // Checks that func computes the scalar function on all the inputs.
+  void ExpectSameFunction(ActivationFunction func, TFloat (*scalar)(TFloat), const char *name) {
+    std::vector<TFloat> values(inputs_);
+    func(values.size(), &values[0]);
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      EXPECT_NEAR(scalar(inputs_[i]), values[i], kTolerance) << name << " x=" << inputs_[i];
+    }
+  }
+
+  // Checks that func computes the same LSTM states and outputs as the
+  // composition of the scalar functions.
+  void ExpectSameStateUpdate(StateUpdateFunction func, const char *name) {
+    const TFloat kClip = 100.0;
+    const int kNumCells = 1001;
+    std::vector<TFloat> ci(kNumCells), gi(kNumCells), gf(kNumCells), go(kNumCells);
+    std::vector<TFloat> state(kNumCells), output(kNumCells);
+    for (int i = 0; i < kNumCells; ++i) {
+      ci[i] = randomizer_.SignedRand(20.0);
+      gi[i] = randomizer_.SignedRand(20.0);
+      gf[i] = randomizer_.SignedRand(20.0);
+      go[i] = randomizer_.SignedRand(20.0);
+      // Some of the states are clipped.
+      state[i] = randomizer_.SignedRand(2 * kClip);
+    }
+    std::vector<TFloat> expected_state(state), expected_output(kNumCells);
+    for (int i = 0; i < kNumCells; ++i) {
+      expected_state[i] *= Logistic(gf[i]);
+      expected_state[i] += Tanh(ci[i]) * Logistic(gi[i]);
+      expected_state[i] = ClipToRange(expected_state[i], -kClip, kClip);
+      expected_output[i] = Tanh(expected_state[i]) * Logistic(go[i]);
+    }
+    func(kNumCells, &ci[0], &gi[0], &gf[0], &go[0], kClip, &state[0], &output[0]);
+    for (int i = 0; i < kNumCells; ++i) {
+      EXPECT_NEAR(expected_state[i], state[i], kTolerance * kClip) << name << " i=" << i;
+      EXPECT_NEAR(expected_output[i], output[i], kTolerance) << name << " i=" << i;
+    }
+  }
+
+  // Checks all the functions of an implementation.
+  void ExpectSameResults(ActivationFunction tanh_in_place, ActivationFunction logistic_in_place,
+                         StateUpdateFunction state_update, const char *name) {
+    ExpectSameFunction(tanh_in_place, Tanh, name);
+    ExpectSameFunction(logistic_in_place, Logistic, name);
+    ExpectSameStateUpdate(state_update, name);
+  }
+
+  std::vector<TFloat> inputs_;
+  TRand randomizer_;
+};
+
+// Tests the functions which were selected by SIMDDetect.
+TEST_F(ActivationTest, Default) {
+  ExpectSameResults(TanhInPlace, LogisticInPlace, LSTMStateUpdate, "default");
+}
+
+// Tests that FuncInplace uses the selected functions for GFunc and FFunc.
+TEST_F(ActivationTest, FuncInplace) {
+  std::vector<TFloat> values(inputs_);
+  FuncInplace<GFunc>(values.size(), &values[0]);
+  std::vector<TFloat> expected(inputs_);
+  TanhInPlace(expected.size(), &expected[0]);
+  EXPECT_EQ(expected, values);
+  values = inputs_;
+  FuncInplace<FFunc>(values.size(), &values[0]);
+  expected = inputs_;
+  LogisticInPlace(expected.size(), &expected[0]);
+  EXPECT_EQ(expected, values);
+}
+
+// Tests the NEON implementation.
+TEST_F(ActivationTest, NEON) {
+#if defined(__aarch64__)
+  ExpectSameResults(TanhInPlaceNEON, LogisticInPlaceNEON, LSTMStateUpdateNEON, "NEON");
+#else
+  GTEST_LOG_(INFO) << "NEON unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the SSE implementation.
+TEST_F(ActivationTest, SSE) {
+#if defined(HAVE_SSE4_1)
+  if (!SIMDDetect::IsSSEAvailable()) {
+    GTEST_LOG_(INFO) << "No SSE found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameResults(TanhInPlaceSSE, LogisticInPlaceSSE, LSTMStateUpdateSSE, "SSE");
+#else
+  GTEST_LOG_(INFO) << "SSE unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the AVX2 implementation.
+TEST_F(ActivationTest, AVX2) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameResults(TanhInPlaceAVX2, LogisticInPlaceAVX2, LSTMStateUpdateAVX2, "AVX2");
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the AVX512F implementation.
+TEST_F(ActivationTest, AVX512F) {
+#if defined(HAVE_AVX512F)
+  if (!SIMDDetect::IsAVX512FAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512F found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameResults(TanhInPlaceAVX512F, LogisticInPlaceAVX512F, LSTMStateUpdateAVX512F,
+                    "AVX512F");
+#else
+  GTEST_LOG_(INFO) << "AVX512F unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the dot product functions without vectorized activation
+// functions of their own select the generic ones, whatever was detected.
+TEST_F(ActivationTest, DotProductSelectsActivations) {
+  const DotProductFunction dot_product = DotProduct;
+  const IntSimdMatrix *int_simd_matrix = IntSimdMatrix::intSimdMatrix;
+  const ActivationFunction tanh_in_place = TanhInPlace;
+  const ActivationFunction logistic_in_place = LogisticInPlace;
+  const StateUpdateFunction state_update = LSTMStateUpdate;
+  const IndicesAboveFunction indices_above = IndicesAbove;
+  ASSERT_TRUE(ParamUtils::SetParam("dotproduct", "generic", SET_PARAM_CONSTRAINT_NONE, nullptr));
+  SIMDDetect::Update();
+  const ActivationFunction generic_tanh = TanhInPlace;
+  const ActivationFunction generic_logistic = LogisticInPlace;
+  const StateUpdateFunction generic_state_update = LSTMStateUpdate;
+  const IndicesAboveFunction generic_indices_above = IndicesAbove;
+  for (const char *method : {"native", "std::inner_product"}) {
+    // Start from the detected functions, as if they had been detected.
+    TanhInPlace = tanh_in_place;
+    LogisticInPlace = logistic_in_place;
+    LSTMStateUpdate = state_update;
+    IndicesAbove = indices_above;
+    ASSERT_TRUE(ParamUtils::SetParam("dotproduct", method, SET_PARAM_CONSTRAINT_NONE, nullptr));
+    SIMDDetect::Update();
+    EXPECT_TRUE(TanhInPlace == generic_tanh) << method;
+    EXPECT_TRUE(LogisticInPlace == generic_logistic) << method;
+    EXPECT_TRUE(LSTMStateUpdate == generic_state_update) << method;
+    EXPECT_TRUE(IndicesAbove == generic_indices_above) << method;
+  }
+  // Restore the detected functions for the other tests.
+  ParamUtils::SetParam("dotproduct", "auto", SET_PARAM_CONSTRAINT_NONE, nullptr);
+  DotProduct = dot_product;
+  IntSimdMatrix::intSimdMatrix = int_simd_matrix;
+  TanhInPlace = tanh_in_place;
+  LogisticInPlace = logistic_in_place;
+  LSTMStateUpdate = state_update;
+  IndicesAbove = indices_above;
+}
+
+} // namespace tesseract
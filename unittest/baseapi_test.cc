@@ -12,18 +12,24 @@
 #include "include_gunit.h"
 
 #include "cycletimer.h" // for CycleTimer
+#include "helpers.h"    // for split
 #include "image.h"      // for Image
 #include "log.h"        // for LOG
 #include "ocrblock.h"   // for class BLOCK
 #include "pageres.h"
+#include "tesseractclass.h"
 
 #include <tesseract/baseapi.h>
+#include <tesseract/renderer.h>
 
 #include "gmock/gmock-matchers.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace tesseract {
@@ -88,6 +94,139 @@ TEST_F(TesseractTest, BasicTesseractTest) {
   }
 }
 
+// Tests that pre-classifying the blobs of phototest on a thread pool gives
+// the same text as pre-classifying them sequentially.
+TEST_F(TesseractTest, ParallelizeTest) {
+#ifdef DISABLED_LEGACY_ENGINE
+  // Skip test because the legacy engine is missing.
+  GTEST_SKIP();
+#else
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_TESSERACT_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  std::string ocr_texts[3];
+  const char *kParallelize[] = {"0", "1", "4"};
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(api.SetVariable("tessedit_parallelize", kParallelize[i]));
+    // Start each run with an empty adaptive classifier.
+    api.ClearAdaptiveClassifier();
+    ocr_texts[i] = GetCleanedTextResult(&api, src_pix);
+    EXPECT_FALSE(ocr_texts[i].empty()) << "tessedit_parallelize=" << kParallelize[i];
+  }
+  EXPECT_STREQ(ocr_texts[1].c_str(), ocr_texts[2].c_str());
+  src_pix.destroy();
+#endif
+}
+
+// Tests that the legacy engine gives the same text and word confidences
+// with and without classify_cache_matches, and that the cache is used.
+TEST_F(TesseractTest, CacheMatchesTest) {
+#ifdef DISABLED_LEGACY_ENGINE
+  // Skip test because the legacy engine is missing.
+  GTEST_SKIP();
+#else
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_TESSERACT_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  std::string ocr_texts[2];
+  std::vector<int> confidences[2];
+  const char *kCacheMatches[] = {"0", "1"};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(api.SetVariable("classify_cache_matches", kCacheMatches[i]));
+    // Start each run with an empty adaptive classifier.
+    api.ClearAdaptiveClassifier();
+    ocr_texts[i] = GetCleanedTextResult(&api, src_pix);
+    int *word_confidences = api.AllWordConfidences();
+    for (int *conf = word_confidences; *conf >= 0; ++conf) {
+      confidences[i].push_back(*conf);
+    }
+    delete[] word_confidences;
+    if (i == 1) {
+      EXPECT_GT(api.tesseract()->match_cache().hits(), 0);
+    }
+  }
+  EXPECT_FALSE(ocr_texts[0].empty());
+  EXPECT_STREQ(ocr_texts[0].c_str(), ocr_texts[1].c_str());
+  EXPECT_EQ(confidences[0], confidences[1]);
+  src_pix.destroy();
+#endif
+}
+
+// Tests that recognizing the lines in batches gives the same text as
+// recognizing them one by one.
+TEST_F(TesseractTest, LSTMBatchSizeTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  std::string ocr_texts[2];
+  const char *kBatchSizes[] = {"1", "8"};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(api.SetVariable("lstm_batch_size", kBatchSizes[i]));
+    ocr_texts[i] = GetCleanedTextResult(&api, src_pix);
+    EXPECT_FALSE(ocr_texts[i].empty()) << "lstm_batch_size=" << kBatchSizes[i];
+  }
+  EXPECT_STREQ(ocr_texts[0].c_str(), ocr_texts[1].c_str());
+  src_pix.destroy();
+}
+
+// Tests that recognizing the lines on several threads gives the same text as
+// recognizing them on one.
+TEST_F(TesseractTest, LSTMNumThreadsTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  std::string ocr_texts[2];
+  const char *kNumThreads[] = {"1", "4"};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(api.SetVariable("lstm_num_threads", kNumThreads[i]));
+    ocr_texts[i] = GetCleanedTextResult(&api, src_pix);
+    EXPECT_FALSE(ocr_texts[i].empty()) << "lstm_num_threads=" << kNumThreads[i];
+  }
+  EXPECT_STREQ(ocr_texts[0].c_str(), ocr_texts[1].c_str());
+  src_pix.destroy();
+}
+
+// Tests that sharing the gates of each LSTM timestep between threads, also
+// together with lstm_num_threads, gives the same text as a single thread.
+TEST_F(TesseractTest, LSTMGateThreadsTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  const char *kGateThreads[] = {"1", "4", "2"};
+  const char *kNumThreads[] = {"1", "1", "2"};
+  std::string ocr_texts[3];
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(api.SetVariable("lstm_gate_threads", kGateThreads[i]));
+    EXPECT_TRUE(api.SetVariable("lstm_num_threads", kNumThreads[i]));
+    ocr_texts[i] = GetCleanedTextResult(&api, src_pix);
+    EXPECT_FALSE(ocr_texts[i].empty()) << "lstm_gate_threads=" << kGateThreads[i]
+                                       << " lstm_num_threads=" << kNumThreads[i];
+  }
+  EXPECT_STREQ(ocr_texts[0].c_str(), ocr_texts[1].c_str());
+  EXPECT_STREQ(ocr_texts[0].c_str(), ocr_texts[2].c_str());
+  src_pix.destroy();
+}
+
 // Test that api.GetComponentImages() will return a set of images for
 // paragraphs even if text recognition was not run.
 TEST_F(TesseractTest, IteratesParagraphsEvenIfNotDetected) {
@@ -223,6 +362,245 @@ TEST_F(TesseractTest, BasicLSTMTest) {
   src_pix.destroy();
 }
 
+// Tests that a binarized image, with and without its grey original, gives
+// the same text as thresholding the grey image with SetImage.
+TEST_F(TesseractTest, BinarizedImageTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest_2.tif").c_str());
+  CHECK(src_pix);
+  Image grey_pix = pixConvertTo8(src_pix, false);
+  CHECK(grey_pix);
+  std::string expected_text = GetCleanedTextResult(&api, grey_pix);
+  Image binary_pix = api.GetThresholdedImage();
+  CHECK(binary_pix);
+
+  api.SetBinarizedImage(binary_pix, grey_pix);
+  char *result = api.GetUTF8Text();
+  std::string ocr_text = result;
+  delete[] result;
+  trim(ocr_text);
+  EXPECT_STREQ(expected_text.c_str(), ocr_text.c_str());
+
+  api.SetBinarizedImage(binary_pix, nullptr);
+  result = api.GetUTF8Text();
+  EXPECT_TRUE(result != nullptr && *result != '\0');
+  delete[] result;
+
+  binary_pix.destroy();
+  grey_pix.destroy();
+  src_pix.destroy();
+}
+
+// Tests that pages recognized by the page queue give the same text as
+// recognizing them directly, both with WaitForPage and with a callback.
+TEST_F(TesseractTest, PageQueueTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest_2.tif").c_str());
+  CHECK(src_pix);
+  std::string expected_text = GetCleanedTextResult(&api, src_pix);
+  ASSERT_TRUE(api.StartPageQueue(2, 1));
+  const int kNumPages = 4;
+  std::vector<int> job_ids;
+  for (int i = 0; i < kNumPages; ++i) {
+    job_ids.push_back(api.SubmitPage(src_pix, nullptr, nullptr, nullptr, nullptr));
+    EXPECT_GE(job_ids.back(), 0);
+  }
+  for (int job_id : job_ids) {
+    char *text = nullptr;
+    EXPECT_TRUE(api.WaitForPage(job_id, &text));
+    ASSERT_TRUE(text != nullptr);
+    std::string ocr_text = text;
+    delete[] text;
+    trim(ocr_text);
+    EXPECT_STREQ(expected_text.c_str(), ocr_text.c_str());
+    EXPECT_FALSE(api.WaitForPage(job_id, &text));
+  }
+
+  struct CallbackData {
+    std::mutex mutex;
+    std::vector<std::string> texts;
+  } data;
+  auto page_done = [](int job_id, bool success, tesseract::TessBaseAPI *worker,
+                      void *user_data) {
+    auto *data = static_cast<CallbackData *>(user_data);
+    char *text = success ? worker->GetUTF8Text() : nullptr;
+    std::lock_guard<std::mutex> lock(data->mutex);
+    data->texts.emplace_back(text != nullptr ? text : "");
+    delete[] text;
+  };
+  for (int i = 0; i < kNumPages; ++i) {
+    EXPECT_GE(api.SubmitPage(src_pix, nullptr, nullptr, page_done, &data), 0);
+  }
+  api.EndPageQueue();
+  EXPECT_EQ(-1, api.SubmitPage(src_pix, nullptr, nullptr, nullptr, nullptr));
+  ASSERT_EQ(kNumPages, static_cast<int>(data.texts.size()));
+  for (auto &text : data.texts) {
+    trim(text);
+    EXPECT_STREQ(expected_text.c_str(), text.c_str());
+  }
+  src_pix.destroy();
+}
+
+// Tests that pages can be waited for while other pages are submitted from
+// another thread, and that only one of two waits for a page gets its text.
+TEST_F(TesseractTest, PageQueueConcurrentWaitTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest_2.tif").c_str());
+  CHECK(src_pix);
+  std::string expected_text = GetCleanedTextResult(&api, src_pix);
+  ASSERT_TRUE(api.StartPageQueue(2, 2));
+  const int kNumPages = 8;
+  std::mutex mutex;
+  std::condition_variable submitted;
+  std::vector<int> job_ids;
+  std::thread producer([&] {
+    for (int i = 0; i < kNumPages; ++i) {
+      int job_id = api.SubmitPage(src_pix, nullptr, nullptr, nullptr, nullptr);
+      std::lock_guard<std::mutex> lock(mutex);
+      job_ids.push_back(job_id);
+      submitted.notify_all();
+    }
+  });
+  for (int i = 0; i < kNumPages; ++i) {
+    int job_id;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      submitted.wait(lock, [&] { return static_cast<int>(job_ids.size()) > i; });
+      job_id = job_ids[i];
+    }
+    EXPECT_GE(job_id, 0);
+    // Two threads wait for the same page.
+    char *texts[2] = {nullptr, nullptr};
+    bool results[2] = {false, false};
+    std::thread waiter([&] { results[1] = api.WaitForPage(job_id, &texts[1]); });
+    results[0] = api.WaitForPage(job_id, &texts[0]);
+    waiter.join();
+    EXPECT_NE(results[0], results[1]);
+    char *text = results[0] ? texts[0] : texts[1];
+    EXPECT_TRUE(texts[results[0] ? 1 : 0] == nullptr);
+    // No ASSERT here, as the producer must be joined.
+    EXPECT_TRUE(text != nullptr);
+    if (text != nullptr) {
+      std::string ocr_text = text;
+      delete[] text;
+      trim(ocr_text);
+      EXPECT_STREQ(expected_text.c_str(), ocr_text.c_str());
+    }
+  }
+  producer.join();
+  api.EndPageQueue();
+  src_pix.destroy();
+}
+
+// Tests that the renderers stream the same output to a sink as the Get*Text
+// functions give for the whole page.
+TEST_F(TesseractTest, RendererSinkTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  api.SetImage(src_pix);
+  const std::unique_ptr<const char[]> utf8(api.GetUTF8Text());
+  const std::unique_ptr<const char[]> tsv(api.GetTSVText(0));
+  const std::unique_ptr<const char[]> hocr(api.GetHOCRText(0));
+  const std::unique_ptr<const char[]> alto(api.GetAltoText(0));
+  ASSERT_TRUE(utf8 != nullptr);
+  ASSERT_TRUE(tsv != nullptr);
+  ASSERT_TRUE(hocr != nullptr);
+  ASSERT_TRUE(alto != nullptr);
+
+  std::string text_output;
+  std::string tsv_output;
+  std::string hocr_output;
+  std::string alto_output;
+  tesseract::TessStringSink text_sink(&text_output);
+  tesseract::TessStringSink tsv_sink(&tsv_output);
+  tesseract::TessStringSink hocr_sink(&hocr_output);
+  tesseract::TessStringSink alto_sink(&alto_output);
+  tesseract::TessTextRenderer renderer("-");
+  renderer.SetOutputSink(&text_sink);
+  auto *tsv_renderer = new tesseract::TessTsvRenderer("-");
+  tsv_renderer->SetOutputSink(&tsv_sink);
+  renderer.insert(tsv_renderer);
+  auto *hocr_renderer = new tesseract::TessHOcrRenderer("-");
+  hocr_renderer->SetOutputSink(&hocr_sink);
+  renderer.insert(hocr_renderer);
+  auto *alto_renderer = new tesseract::TessAltoRenderer("-");
+  alto_renderer->SetOutputSink(&alto_sink);
+  renderer.insert(alto_renderer);
+  EXPECT_TRUE(renderer.BeginDocument("test"));
+  EXPECT_TRUE(renderer.AddImage(&api));
+  EXPECT_TRUE(renderer.EndDocument());
+  EXPECT_STREQ(utf8.get(), text_output.c_str());
+  EXPECT_THAT(tsv_output, HasSubstr(tsv.get()));
+  EXPECT_THAT(hocr_output, HasSubstr(hocr.get()));
+  EXPECT_THAT(alto_output, HasSubstr(alto.get()));
+  src_pix.destroy();
+}
+
+// Tests that recognizing the pages of a multipage tiff on several threads
+// gives the text of each page in page order, and the same text and hOCR
+// output as recognizing them one at a time.
+TEST_F(TesseractTest, PageNumThreadsTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  file::MakeTmpdir();
+  static const char *kPages[] = {"phototest.tif", "HelloGoogle.tif", "deslant.tif",
+                                 "phototest.tif", "HelloGoogle.tif", nullptr};
+  const std::string tiff_path = file::JoinPath(FLAGS_test_tmpdir, "page_num_threads.tif");
+  std::vector<std::string> page_texts;
+  for (int i = 0; kPages[i] != nullptr; ++i) {
+    Image src_pix = pixRead(TestDataNameToPath(kPages[i]).c_str());
+    CHECK(src_pix);
+    page_texts.push_back(GetCleanedTextResult(&api, src_pix));
+    CHECK_EQ(0, pixWriteTiff(tiff_path.c_str(), src_pix, IFF_TIFF_ZIP, i == 0 ? "w" : "a"));
+    src_pix.destroy();
+  }
+
+  std::string text_outputs[2];
+  std::string hocr_outputs[2];
+  const char *kNumThreads[] = {"1", "3"};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(api.SetVariable("page_num_threads", kNumThreads[i]));
+    tesseract::TessStringSink text_sink(&text_outputs[i]);
+    tesseract::TessStringSink hocr_sink(&hocr_outputs[i]);
+    tesseract::TessTextRenderer renderer("-");
+    renderer.SetOutputSink(&text_sink);
+    auto *hocr_renderer = new tesseract::TessHOcrRenderer("-");
+    hocr_renderer->SetOutputSink(&hocr_sink);
+    renderer.insert(hocr_renderer);
+    EXPECT_TRUE(api.ProcessPages(tiff_path.c_str(), nullptr, 0, &renderer));
+  }
+  EXPECT_STREQ(text_outputs[0].c_str(), text_outputs[1].c_str());
+  EXPECT_STREQ(hocr_outputs[0].c_str(), hocr_outputs[1].c_str());
+
+  // The text renderer separates the pages with form feeds.
+  std::vector<std::string> rendered_pages = split(text_outputs[1], '\f');
+  ASSERT_EQ(page_texts.size(), rendered_pages.size());
+  for (size_t i = 0; i < page_texts.size(); ++i) {
+    trim(rendered_pages[i]);
+    EXPECT_STREQ(page_texts[i].c_str(), rendered_pages[i].c_str()) << "page " << i;
+  }
+}
+
 // Test that LSTM's character bounding boxes are properly converted to
 // Tesseract structures. Note that we can't guarantee that LSTM's
 // character boxes fall completely within Tesseract's word box because
@@ -11,11 +11,18 @@
 
 #include "include_gunit.h"
 
+#include "dict.h"
+#include "helpers.h"
 #include "ratngs.h"
+#include "serialis.h"
+#include "tessdatamanager.h"
 #include "trie.h"
 #include "unicharset.h"
 
 #include <sys/stat.h>
+#include <cctype> // for toupper
+#include <chrono>
+#include <cstdio>
 #include <cstdlib> // for system
 #include <fstream> // for ifstream
 #include <set>
@@ -59,6 +66,27 @@ protected:
   std::string OutputNameToPath(const std::string &name) const {
     return file::JoinPath(FLAGS_test_tmpdir, name);
   }
+  // Returns a dawg of the given words, written and read back with or without
+  // a child index.
+  std::unique_ptr<SquishedDawg> MakeDawg(const UNICHARSET &unicharset,
+                                         const std::vector<std::string> &words,
+                                         bool with_child_index) const {
+    Trie trie(DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, unicharset.size(), 0);
+    for (auto &word : words) {
+      WERD_CHOICE choice(word.c_str(), unicharset);
+      trie.add_word_to_dawg(choice);
+    }
+    std::unique_ptr<SquishedDawg> trie_dawg(trie.trie_to_dawg());
+    std::vector<char> data;
+    TFile fp;
+    fp.OpenWrite(&data);
+    EXPECT_TRUE(trie_dawg->write_squished_dawg(&fp, with_child_index));
+    fp.Open(&data[0], data.size());
+    std::unique_ptr<SquishedDawg> dawg(
+        new SquishedDawg(DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, 0));
+    EXPECT_TRUE(dawg->Load(&fp));
+    return dawg;
+  }
   int RunCommand(const std::string &program, const std::string &arg1, const std::string &arg2,
                  const std::string &arg3) const {
     std::string cmdline = TessBinaryPath(program) + " " + arg1 + " " + arg2 + " " + arg3;
@@ -107,4 +135,211 @@ TEST_F(DawgTest, TestMatching) {
   EXPECT_TRUE(trie.prefix_in_dawg(space_apos, true));
 }
 
+// Tests that a dawg in a memory mapped traineddata file with the aligned
+// layout works in place, also after the traineddata is cleared.
+TEST_F(DawgTest, TestMappedDawg) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  tesseract::Trie trie(tesseract::DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, unicharset.size(), 0);
+  WERD_CHOICE hello("hello", unicharset);
+  WERD_CHOICE help("help", unicharset);
+  WERD_CHOICE hell("hell", unicharset);
+  trie.add_word_to_dawg(hello);
+  trie.add_word_to_dawg(help);
+  std::unique_ptr<SquishedDawg> dawg(trie.trie_to_dawg());
+  std::vector<char> dawg_data;
+  TFile fp;
+  fp.OpenWrite(&dawg_data);
+  ASSERT_TRUE(dawg->write_squished_dawg(&fp));
+
+  TessdataManager tm;
+  // An odd sized entry before the dawg, which the layout has to pad.
+  tm.OverwriteEntry(TESSDATA_LANG_CONFIG, "x", 1);
+  tm.OverwriteEntry(TESSDATA_SYSTEM_DAWG, &dawg_data[0], dawg_data.size());
+  tm.set_aligned(true);
+  std::string filename = OutputNameToPath("mapped.traineddata");
+  ASSERT_TRUE(tm.SaveFile(filename.c_str(), nullptr));
+
+  TessdataManager mapped_tm;
+  ASSERT_TRUE(mapped_tm.Init(filename.c_str()));
+  EXPECT_TRUE(mapped_tm.is_aligned());
+  SquishedDawg mapped_dawg(DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, 0);
+  ASSERT_TRUE(mapped_tm.GetComponent(TESSDATA_SYSTEM_DAWG, &fp));
+  ASSERT_TRUE(mapped_dawg.Load(&fp));
+  mapped_tm.Clear();
+  EXPECT_EQ(dawg->NumEdges(), mapped_dawg.NumEdges());
+  EXPECT_TRUE(mapped_dawg.word_in_dawg(hello));
+  EXPECT_TRUE(mapped_dawg.word_in_dawg(help));
+  EXPECT_FALSE(mapped_dawg.word_in_dawg(hell));
+
+  // Writing the mapped dawg must not modify the read-only edges.
+  std::vector<char> rewritten_data;
+  fp.OpenWrite(&rewritten_data);
+  ASSERT_TRUE(mapped_dawg.write_squished_dawg(&fp));
+  EXPECT_EQ(dawg_data, rewritten_data);
+}
+
+// Tests that the transition cache gives the same edges as the dawg, and only
+// caches a SquishedDawg.
+TEST_F(DawgTest, TestTransitionCache) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  tesseract::Trie trie(tesseract::DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, unicharset.size(), 0);
+  for (const char *word : {"hello", "help", "held", "yellow"}) {
+    WERD_CHOICE choice(word, unicharset);
+    trie.add_word_to_dawg(choice);
+  }
+  std::unique_ptr<SquishedDawg> dawg(trie.trie_to_dawg());
+  // A tiny cache, so entries get replaced.
+  DawgTransitionCache cache(4);
+  EXPECT_FALSE(cache.Cacheable(0, &trie, 1));
+  EXPECT_TRUE(cache.Cacheable(1, dawg.get(), 1));
+  uint64_t num_lookups = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (NODE_REF node = 0; node < dawg->NumEdges(); ++node) {
+      for (UNICHAR_ID id = 0; id < static_cast<int>(unicharset.size()); ++id) {
+        EDGE_REF edge = dawg->edge_char_of(node, id, false);
+        EDGE_REF cached_edge;
+        if (!cache.Lookup(1, node, id, false, &cached_edge)) {
+          cache.Store(1, node, id, false, edge);
+          ASSERT_TRUE(cache.Lookup(1, node, id, false, &cached_edge));
+          ++num_lookups;
+        }
+        EXPECT_EQ(edge, cached_edge);
+        ++num_lookups;
+      }
+    }
+  }
+  EXPECT_LT(0u, cache.hits());
+  EXPECT_LT(0u, cache.misses());
+  EXPECT_EQ(num_lookups, cache.hits() + cache.misses());
+  // A different dawg at the same index empties the cache.
+  EDGE_REF edge = dawg->edge_char_of(0, unicharset.size() - 1, false);
+  cache.Store(1, 0, unicharset.size() - 1, false, edge);
+  ASSERT_TRUE(cache.Lookup(1, 0, unicharset.size() - 1, false, &edge));
+  EXPECT_FALSE(cache.Cacheable(1, &trie, 1));
+  EXPECT_FALSE(cache.Lookup(1, 0, unicharset.size() - 1, false, &edge));
+  EXPECT_FALSE(cache.Cacheable(0, &trie, 1));
+  // So does a new generation of dawgs, even at the same address.
+  EXPECT_TRUE(cache.Cacheable(1, dawg.get(), 1));
+  cache.Store(1, 0, unicharset.size() - 1, false, edge);
+  ASSERT_TRUE(cache.Lookup(1, 0, unicharset.size() - 1, false, &edge));
+  EXPECT_TRUE(cache.Cacheable(1, dawg.get(), 2));
+  EXPECT_FALSE(cache.Lookup(1, 0, unicharset.size() - 1, false, &edge));
+  EXPECT_FALSE(cache.Cacheable(0, &trie, 2));
+}
+
+// Tests that a dawg with a child index finds the same edges as without it.
+TEST_F(DawgTest, TestChildIndex) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  // Many words that start with "a" or "b" make wide nodes after the
+  // root and after "a" and "b". "ab" is also a prefix and a word.
+  const std::string letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  std::vector<std::string> words = {"ab", "abc"};
+  for (char first : letters) {
+    words.push_back(std::string(1, first) + "e");
+  }
+  for (char first : {'a', 'b'}) {
+    for (char second : letters) {
+      words.push_back(std::string(1, first) + second + "s");
+    }
+  }
+  std::unique_ptr<SquishedDawg> dawg = MakeDawg(unicharset, words, false);
+  std::unique_ptr<SquishedDawg> indexed_dawg = MakeDawg(unicharset, words, true);
+  EXPECT_FALSE(dawg->has_child_index());
+  ASSERT_TRUE(indexed_dawg->has_child_index());
+  ASSERT_EQ(dawg->NumEdges(), indexed_dawg->NumEdges());
+  for (NODE_REF node = 0; node < dawg->NumEdges(); ++node) {
+    for (UNICHAR_ID id = -1; id <= static_cast<int>(unicharset.size()); ++id) {
+      for (bool word_end : {false, true}) {
+        EXPECT_EQ(dawg->edge_char_of(node, id, word_end),
+                  indexed_dawg->edge_char_of(node, id, word_end))
+            << "node=" << node << " id=" << id << " word_end=" << word_end;
+      }
+    }
+  }
+  for (auto &word : words) {
+    WERD_CHOICE choice(word.c_str(), unicharset);
+    EXPECT_TRUE(indexed_dawg->word_in_dawg(choice)) << word;
+  }
+  WERD_CHOICE not_word("abs s", unicharset);
+  EXPECT_FALSE(indexed_dawg->word_in_dawg(not_word));
+
+  // A dawg read with a child index writes the same data.
+  std::vector<char> data, rewritten_data;
+  TFile fp;
+  fp.OpenWrite(&data);
+  ASSERT_TRUE(indexed_dawg->write_squished_dawg(&fp, true));
+  SquishedDawg read_dawg(DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM, 0);
+  fp.Open(&data[0], data.size());
+  ASSERT_TRUE(read_dawg.Load(&fp));
+  fp.OpenWrite(&rewritten_data);
+  ASSERT_TRUE(read_dawg.write_squished_dawg(&fp, true));
+  EXPECT_EQ(data, rewritten_data);
+  // A corrupt index is rejected.
+  data.back() ^= 1;
+  fp.Open(&data[0], data.size());
+  EXPECT_FALSE(read_dawg.Load(&fp));
+}
+
+// Compares the speed of lookups in a large dawg with and without a child
+// index.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(DawgTest, DISABLED_ChildIndexBenchmark) {
+  const int kNumWords = 200000;
+  const int kNumRuns = 20;
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  // Random words with letter frequencies roughly like English.
+  const std::string letters = "eeeeeeetttttaaaaoooiiinnnsssrrhhlldcumfpgwybvkxjqz";
+  TRand randomizer;
+  randomizer.set_seed(1);
+  std::vector<std::string> words;
+  for (int w = 0; w < kNumWords; ++w) {
+    std::string word;
+    int length = 2 + randomizer.IntRand() % 10;
+    for (int i = 0; i < length; ++i) {
+      word += letters[randomizer.IntRand() % letters.size()];
+    }
+    if (randomizer.IntRand() % 4 == 0) {
+      word[0] = toupper(word[0]);
+    }
+    words.push_back(word);
+  }
+  // The lookups of a search: the letters of words along the dawg.
+  std::vector<std::vector<UNICHAR_ID>> id_words;
+  for (int w = 0; w < kNumWords; w += 10) {
+    WERD_CHOICE choice(words[w].c_str(), unicharset);
+    id_words.emplace_back();
+    for (unsigned i = 0; i < choice.length(); ++i) {
+      id_words.back().push_back(choice.unichar_id(i));
+    }
+  }
+  for (bool with_child_index : {false, true}) {
+    std::unique_ptr<SquishedDawg> dawg = MakeDawg(unicharset, words, with_child_index);
+    int64_t num_lookups = 0;
+    EDGE_REF found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < kNumRuns; ++run) {
+      for (auto &ids : id_words) {
+        NODE_REF node = 0;
+        for (auto id : ids) {
+          EDGE_REF edge = dawg->edge_char_of(node, id, false);
+          ++num_lookups;
+          if (edge == NO_EDGE) {
+            break;
+          }
+          found += edge;
+          node = dawg->next_node(edge);
+        }
+      }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%s: %u edges, %.1f ns per lookup (%" PRId64 ")\n",
+           with_child_index ? "child index" : "squished", dawg->NumEdges(),
+           elapsed.count() / num_lookups, found);
+  }
+}
+
 } // namespace tesseract
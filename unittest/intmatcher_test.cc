@@ -0,0 +1,329 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "helpers.h"
+#include "include_gunit.h"
+#include "intmatch.h"
+#include "intmatcher.h"
+#include "params.h"
+#include "shapetable.h"
+#include "simddetect.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tesseract {
+
+// Parameters of a synthetic class.
+const int kNumProtos = 150;
+const int kNumConfigs = 12;
+// Maximum number of features in a synthetic blob.
+const int kMaxBlobFeatures = 120;
+// Half the width of the proto pruner ranges, in buckets.
+const int kPrunerPad = 3;
+
+class IntMatcherTest : public testing::Test {
+protected:
+  IntMatcherTest()
+      : debug_level_(0, "classify_debug_level", "Classify debug level", false, &params_)
+      , matcher_(&debug_level_) {}
+
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+    std::fill(std::begin(all_protos_), std::end(all_protos_), ~0u);
+    std::fill(std::begin(all_configs_), std::end(all_configs_), ~0u);
+  }
+
+  // Makes a class of num_protos random protos, each in some of num_configs
+  // configs, with a proto pruner that lets the features near each proto
+  // through.
+  std::unique_ptr<INT_CLASS_STRUCT> MakeClass(int num_protos, int num_configs) {
+    auto int_class = std::make_unique<INT_CLASS_STRUCT>(num_protos);
+    for (int c = 0; c < num_configs; ++c) {
+      AddIntConfig(int_class.get());
+    }
+    for (int p = 0; p < num_protos; ++p) {
+      AddIntProto(int_class.get());
+      INT_PROTO_STRUCT *proto = ProtoForProtoId(int_class.get(), p);
+      // A line through (x, y) in the direction angle, like FillABC makes.
+      double x = randomizer_.SignedRand(0.4);
+      double y = randomizer_.SignedRand(0.4);
+      double angle = randomizer_.UnsignedRand(1.0);
+      double slope = std::tan(angle * 2.0 * M_PI);
+      double normalizer = 1.0 / std::sqrt(slope * slope + 1.0);
+      proto->A = ClipToRange<int>(IntCastRounded(slope * normalizer * 128), -128, 127);
+      proto->B = ClipToRange<int>(IntCastRounded(normalizer * 256), 0, 255);
+      proto->C = ClipToRange<int>(IntCastRounded((y - slope * x) * normalizer * 128), -128, 127);
+      proto->Angle = static_cast<uint8_t>(angle * 256);
+      // Some protos are longer than MAX_PROTO_INDEX.
+      int_class->ProtoLengths[p] = 1 + randomizer_.IntRand() % 30;
+      for (int c = 0; c < num_configs; ++c) {
+        if (randomizer_.IntRand() % 3 == 0) {
+          proto->Configs[0] |= 1u << c;
+          int_class->ConfigLengths[c] += int_class->ProtoLengths[p];
+        }
+      }
+      PROTO_SET_STRUCT *proto_set = int_class->ProtoSets[SetForProto(p)];
+      int buckets[NUM_PP_PARAMS] = {IntCastRounded((x + 0.5) * (NUM_PP_BUCKETS - 1)),
+                                    IntCastRounded((y + 0.5) * (NUM_PP_BUCKETS - 1)),
+                                    proto->Angle * NUM_PP_BUCKETS / 256};
+      for (int param = 0; param < NUM_PP_PARAMS; ++param) {
+        for (int b = buckets[param] - kPrunerPad; b <= buckets[param] + kPrunerPad; ++b) {
+          int bucket =
+              param == 2 ? Modulo(b, NUM_PP_BUCKETS) : ClipToRange(b, 0, NUM_PP_BUCKETS - 1);
+          proto_set->ProtoPruner[param][bucket][PPrunerWordIndexFor(p)] |= PPrunerMaskFor(p);
+        }
+      }
+      centers_.emplace_back(IntCastRounded((x + 0.5) * 255), IntCastRounded((y + 0.5) * 255),
+                            proto->Angle);
+    }
+    return int_class;
+  }
+
+  // Makes a blob of features, most of them close to the protos made so far.
+  std::vector<INT_FEATURE_STRUCT> MakeBlob() {
+    std::vector<INT_FEATURE_STRUCT> features;
+    int num_features = 1 + randomizer_.IntRand() % kMaxBlobFeatures;
+    for (int f = 0; f < num_features; ++f) {
+      if (randomizer_.IntRand() % 8 == 0) {
+        features.emplace_back(randomizer_.IntRand() % 256, randomizer_.IntRand() % 256,
+                              randomizer_.IntRand() % 256);
+      } else {
+        const INT_FEATURE_STRUCT &center = centers_[randomizer_.IntRand() % centers_.size()];
+        features.emplace_back(center.X + randomizer_.IntRand() % 9 - 4,
+                              center.Y + randomizer_.IntRand() % 9 - 4,
+                              center.Theta + randomizer_.IntRand() % 9 - 4);
+      }
+    }
+    return features;
+  }
+
+  void Match(INT_CLASS_STRUCT *int_class, const std::vector<INT_FEATURE_STRUCT> &features,
+             UnicharRating *result) {
+    matcher_.Match(int_class, all_protos_, all_configs_, features.size(), &features[0], result, 0,
+                   0, false);
+  }
+
+  static void ExpectSameRating(const UnicharRating &expected, const UnicharRating &actual) {
+    EXPECT_EQ(expected.rating, actual.rating);
+    EXPECT_EQ(expected.config, actual.config);
+    EXPECT_EQ(expected.feature_misses, actual.feature_misses);
+    ASSERT_EQ(expected.fonts.size(), actual.fonts.size());
+    for (unsigned i = 0; i < expected.fonts.size(); ++i) {
+      EXPECT_EQ(expected.fonts[i].fontinfo_id, actual.fonts[i].fontinfo_id);
+      EXPECT_EQ(expected.fonts[i].score, actual.fonts[i].score);
+    }
+  }
+
+  // Checks that class_pruner_sum and proto_evidence give the same results as
+  // plain loops, for all numbers of protos up to a few SIMD registers, so all
+  // the tails are covered.
+  void ExpectSameKernels(ClassPrunerSumFunction class_pruner_sum,
+                         ProtoEvidenceFunction proto_evidence, const char *name) {
+    const int kNumPruners = 3;
+    const int kPrunerWords = 64;
+    const int kNumOffsets = 20;
+    std::vector<uint32_t> pruner_words(kNumPruners * kPrunerWords);
+    for (auto &word : pruner_words) {
+      word = randomizer_.IntRand() ^ (randomizer_.IntRand() << 16);
+    }
+    const uint32_t *pruners[kNumPruners];
+    for (int p = 0; p < kNumPruners; ++p) {
+      pruners[p] = &pruner_words[p * kPrunerWords];
+    }
+    std::vector<int> offsets(kNumOffsets);
+    for (auto &offset : offsets) {
+      offset = randomizer_.IntRand() % (kPrunerWords / 2) * 2;
+    }
+    std::vector<int> expected_counts(kNumPruners * CLASSES_PER_CP, 7);
+    for (int p = 0; p < kNumPruners; ++p) {
+      for (int offset : offsets) {
+        for (int c = 0; c < CLASSES_PER_CP; ++c) {
+          uint32_t word = pruners[p][offset + c / CLASSES_PER_CP_WERD];
+          expected_counts[p * CLASSES_PER_CP + c] +=
+              (word >> (c % CLASSES_PER_CP_WERD * NUM_BITS_PER_CLASS)) & CLASS_PRUNER_CLASS_MASK;
+        }
+      }
+    }
+    std::vector<int> counts(kNumPruners * CLASSES_PER_CP, 7);
+    class_pruner_sum(pruners, kNumPruners, &offsets[0], kNumOffsets, &counts[0]);
+    EXPECT_EQ(expected_counts, counts) << name;
+
+    const int kMaxProtos = 40;
+    std::vector<uint32_t> protos(kMaxProtos);
+    for (auto &proto : protos) {
+      proto = randomizer_.IntRand() ^ (randomizer_.IntRand() << 16);
+    }
+    uint8_t table[kSETableSize];
+    for (auto &entry : table) {
+      entry = randomizer_.IntRand() % 256;
+    }
+    ProtoEvidenceParams params;
+    params.theta_fudge = IntegerMatcher::kIntThetaFudge;
+    params.table = table;
+    // The constants of the IntegerMatcher, and other ones which use the
+    // shifts and limits.
+    for (int mult_shift : {14 - IntegerMatcher::kIntEvidenceTruncBits, 3}) {
+      params.mult_trunc_shift = mult_shift;
+      params.evidence_mult_mask = (1 << (14 - mult_shift)) - 1;
+      params.table_trunc_shift = 27 - kSETableBits - 2 * mult_shift;
+      params.evidence_table_mask = kSETableSize - 1;
+      for (int feature = 0; feature < 10; ++feature) {
+        params.x = feature == 0 ? 0 : randomizer_.IntRand() % 256;
+        params.y = feature == 1 ? 255 : randomizer_.IntRand() % 256;
+        params.theta = randomizer_.IntRand() % 256;
+        for (int n = 0; n <= kMaxProtos; ++n) {
+          std::vector<uint8_t> expected(n);
+          for (int i = 0; i < n; ++i) {
+            INT_PROTO_STRUCT proto;
+            memcpy(&proto.A, &protos[i], sizeof(protos[i]));
+            int32_t A3 = (((proto.A * (params.x - 128)) * 2) - (proto.B * (params.y - 128)) +
+                          (proto.C * 512));
+            int32_t M3 = ((static_cast<int8_t>(params.theta - proto.Angle)) *
+                          IntegerMatcher::kIntThetaFudge) *
+                         2;
+            A3 = std::min((A3 < 0 ? ~A3 : A3) >> mult_shift, params.evidence_mult_mask);
+            M3 = std::min((M3 < 0 ? ~M3 : M3) >> mult_shift, params.evidence_mult_mask);
+            uint32_t A4 = static_cast<uint32_t>(A3 * A3 + M3 * M3) >> params.table_trunc_shift;
+            expected[i] = A4 >= kSETableSize ? 0 : table[A4];
+          }
+          std::vector<uint8_t> evidence(n);
+          proto_evidence(&protos[0], n, params, evidence.data());
+          EXPECT_EQ(expected, evidence) << name << " n=" << n;
+        }
+      }
+    }
+  }
+
+  ParamsVectors params_;
+  IntParam debug_level_;
+  IntegerMatcher matcher_;
+  TRand randomizer_;
+  // The centers of the protos, as features.
+  std::vector<INT_FEATURE_STRUCT> centers_;
+  uint32_t all_protos_[MAX_NUM_PROTOS / BITS_PER_WERD];
+  uint32_t all_configs_[WERDS_PER_CONFIG_VEC];
+};
+
+// Tests the class pruner and proto evidence functions which were selected by
+// SIMDDetect.
+TEST_F(IntMatcherTest, DefaultKernels) {
+  ExpectSameKernels(ClassPrunerSum, ProtoEvidence, "default");
+}
+
+// Tests the AVX2 implementation.
+TEST_F(IntMatcherTest, AVX2Kernels) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameKernels(ClassPrunerSumAVX2, ProtoEvidenceAVX2, "AVX2");
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the evidence left behind by earlier matches on a thread does
+// not change the result of a match, by comparing with a new thread.
+TEST_F(IntMatcherTest, ReusedEvidenceGivesSameResult) {
+  auto small_class = MakeClass(10, 3);
+  auto large_class = MakeClass(kNumProtos, kNumConfigs);
+  std::vector<std::vector<INT_FEATURE_STRUCT>> blobs;
+  for (int b = 0; b < 20; ++b) {
+    blobs.push_back(MakeBlob());
+  }
+  // Alternates between the classes, so a small class follows a large one.
+  auto class_for = [&](unsigned b) { return b % 3 == 1 ? small_class.get() : large_class.get(); };
+  std::vector<UnicharRating> expected(blobs.size());
+  for (unsigned b = 0; b < blobs.size(); ++b) {
+    std::thread([&] { Match(class_for(b), blobs[b], &expected[b]); }).join();
+  }
+  for (unsigned b = 0; b < blobs.size(); ++b) {
+    UnicharRating result;
+    Match(class_for(b), blobs[b], &result);
+    ExpectSameRating(expected[b], result);
+  }
+  // The blobs match the protos, so the ratings are not all zero.
+  EXPECT_GT(expected[0].rating, 0.0f);
+}
+
+// Tests that FindGoodProtos and FindBadFeatures are not affected by the
+// evidence of an earlier Match.
+TEST_F(IntMatcherTest, GoodProtosAfterMatch) {
+  auto int_class = MakeClass(kNumProtos, kNumConfigs);
+  auto blob = MakeBlob();
+  INT_FEATURE_ARRAY features;
+  std::copy(blob.begin(), blob.end(), features.begin());
+  std::vector<PROTO_ID> good_protos(kNumProtos), expected_protos(kNumProtos);
+  std::vector<FEATURE_ID> bad_features(kMaxBlobFeatures), expected_features(kMaxBlobFeatures);
+  int num_good = 0, num_bad = 0;
+  std::thread([&] {
+    num_good = matcher_.FindGoodProtos(int_class.get(), all_protos_, all_configs_, blob.size(),
+                                       features, &expected_protos[0], 100, 0);
+    num_bad = matcher_.FindBadFeatures(int_class.get(), all_protos_, all_configs_, blob.size(),
+                                       features, &expected_features[0], 100, 0);
+  }).join();
+  UnicharRating result;
+  Match(int_class.get(), MakeBlob(), &result);
+  EXPECT_EQ(num_good, matcher_.FindGoodProtos(int_class.get(), all_protos_, all_configs_,
+                                              blob.size(), features, &good_protos[0], 100, 0));
+  EXPECT_EQ(num_bad, matcher_.FindBadFeatures(int_class.get(), all_protos_, all_configs_,
+                                              blob.size(), features, &bad_features[0], 100, 0));
+  good_protos.resize(num_good);
+  expected_protos.resize(num_good);
+  bad_features.resize(num_bad);
+  expected_features.resize(num_bad);
+  EXPECT_EQ(expected_protos, good_protos);
+  EXPECT_EQ(expected_features, bad_features);
+}
+
+// Measures the speed of the integer matcher on a fixed set of blobs, each
+// matched against every class, like MasterMatcher does for the classes of
+// the class pruner.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(IntMatcherTest, DISABLED_MatchBenchmark) {
+  const int kNumClasses = 50;
+  const int kNumBlobs = 200;
+  const int kNumRuns = 10;
+  std::vector<std::unique_ptr<INT_CLASS_STRUCT>> classes;
+  for (int c = 0; c < kNumClasses; ++c) {
+    classes.push_back(MakeClass(kNumProtos / 2 + randomizer_.IntRand() % kNumProtos, kNumConfigs));
+  }
+  std::vector<std::vector<INT_FEATURE_STRUCT>> blobs;
+  for (int b = 0; b < kNumBlobs; ++b) {
+    blobs.push_back(MakeBlob());
+  }
+  UnicharRating result;
+  float total_rating = 0.0f;
+  int64_t num_matches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int run = 0; run < kNumRuns; ++run) {
+    for (auto &blob : blobs) {
+      for (auto &int_class : classes) {
+        Match(int_class.get(), blob, &result);
+        total_rating += result.rating;
+        ++num_matches;
+      }
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%.0f matches per second (%g)\n", num_matches / elapsed.count(), total_rating);
+}
+
+} // namespace tesseract
@@ -17,6 +17,7 @@
 #include "intsimdmatrix.h"
 #include <gtest/gtest.h>
 #include <gtest/internal/gtest-port.h>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include "include_gunit.h"
@@ -66,9 +67,11 @@ protected:
         GENERIC_2D_ARRAY<int8_t> w = InitRandom(num_out, num_in + 1);
         std::vector<int8_t> u = RandomVector(num_in, matrix);
         std::vector<TFloat> scales = RandomScales(num_out);
-        int ro = num_out;
+        // The outputs are rounded up for the tested matrix, which may write
+        // more outputs than the matrix selected by SIMDDetect.
+        int ro = matrix.RoundOutputs(num_out);
         if (IntSimdMatrix::intSimdMatrix) {
-          ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
+          ro = std::max(ro, IntSimdMatrix::intSimdMatrix->RoundOutputs(num_out));
         }
         std::vector<TFloat> base_result(num_out);
         IntSimdMatrix::MatrixDotVector(w, scales, u.data(), base_result.data());
@@ -134,4 +137,32 @@ TEST_F(IntSimdMatrixTest, AVX2) {
 #endif
 }
 
+// Tests that the AVX512 VNNI implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX512VNNI) {
+#if defined(HAVE_AVX512VNNI)
+  if (!SIMDDetect::IsAVX512VNNIAvailable() || !SIMDDetect::IsAVX512BWAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512 VNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#else
+  GTEST_LOG_(INFO) << "AVX512 VNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the AVX VNNI implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVXVNNI) {
+#if defined(HAVE_AVXVNNI)
+  if (!SIMDDetect::IsAVXVNNIAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX VNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVXVNNI);
+#else
+  GTEST_LOG_(INFO) << "AVX VNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
 } // namespace tesseract
@@ -0,0 +1,189 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "include_gunit.h"
+#include "helpers.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "stridemap.h"
+
+#include <memory>
+
+namespace tesseract {
+
+class LSTMBatchTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+    // A batch of images of different sizes, so there is padding in both
+    // height and width.
+    h_w_pairs_ = {{3, 17}, {2, 5}, {4, 40}};
+  }
+
+  // Fills a NetworkIO of the given depth with random values over the batch.
+  void SetupInput(bool int_mode, int num_features, NetworkIO *input) {
+    StrideMap stride_map;
+    stride_map.SetStride(h_w_pairs_);
+    input->ResizeToMap(int_mode, stride_map, num_features);
+    std::vector<TFloat> values(num_features);
+    StrideMap::Index index(stride_map);
+    do {
+      for (auto &value : values) {
+        value = randomizer_.SignedRand(1.0);
+      }
+      input->WriteTimeStep(index.t(), &values[0]);
+    } while (index.Increment());
+  }
+
+  // Runs an LSTM of the given type over a batch of images, and checks that
+  // the outputs match running each row of each image on its own.
+  void TestBatchMatchesRows(NetworkType type, bool int_mode) {
+    const int kNumInputs = 20;
+    const int kNumStates = 100;
+    LSTM lstm("LSTM", kNumInputs, kNumStates, kNumStates, false, type);
+    lstm.SetEnableTraining(TS_ENABLED);
+    lstm.InitWeights(0.5f, &randomizer_);
+    lstm.SetEnableTraining(TS_DISABLED);
+    if (int_mode) {
+      lstm.ConvertToInt();
+    }
+    NetworkScratch scratch;
+    scratch.set_int_mode(int_mode);
+    NetworkIO input, output;
+    SetupInput(int_mode, kNumInputs, &input);
+    lstm.Forward(false, input, nullptr, &scratch, &output);
+    std::vector<TFloat> batch_values(kNumStates), row_values(kNumStates);
+    for (unsigned b = 0; b < h_w_pairs_.size(); ++b) {
+      int height = h_w_pairs_[b].first;
+      int width = h_w_pairs_[b].second;
+      for (int y = 0; y < height; ++y) {
+        std::vector<std::pair<int, int>> row_size(1, std::make_pair(1, width));
+        StrideMap row_map;
+        row_map.SetStride(row_size);
+        NetworkIO row_input, row_output;
+        row_input.ResizeToMap(int_mode, row_map, kNumInputs);
+        for (int x = 0; x < width; ++x) {
+          row_input.CopyTimeStepFrom(x, input, StrideMap::Index(input.stride_map(), b, y, x).t());
+        }
+        lstm.Forward(false, row_input, nullptr, &scratch, &row_output);
+        int out_width = type == NT_LSTM_SUMMARY ? 1 : width;
+        for (int x = 0; x < out_width; ++x) {
+          output.ReadTimeStep(StrideMap::Index(output.stride_map(), b, y, x).t(), &batch_values[0]);
+          row_output.ReadTimeStep(x, &row_values[0]);
+          for (int i = 0; i < kNumStates; ++i) {
+            EXPECT_EQ(batch_values[i], row_values[i]) << "b=" << b << " y=" << y << " x=" << x;
+          }
+        }
+      }
+    }
+  }
+
+  // Checks that an LSTM of the given type that shares the weights of
+  // another, and a copy made with CopySharingWeights, give the same outputs
+  // as the owner of the weights, and that the copy writes the same file.
+  void TestSharedWeightsMatch(NetworkType type, bool int_mode) {
+    const int kNumInputs = 20;
+    const int kNumStates = 64;
+    const int kNumOutputs = type == NT_LSTM_SOFTMAX ? 16 : kNumStates;
+    LSTM owner("LSTM", kNumInputs, kNumStates, kNumOutputs, false, type);
+    LSTM user("LSTM", kNumInputs, kNumStates, kNumOutputs, false, type);
+    for (auto *lstm : {&owner, &user}) {
+      lstm->SetEnableTraining(TS_ENABLED);
+      lstm->InitWeights(0.5f, &randomizer_);
+      lstm->SetEnableTraining(TS_DISABLED);
+      if (int_mode) {
+        lstm->ConvertToInt();
+      }
+    }
+    user.ShareWeights(owner);
+    std::unique_ptr<Network> copy(owner.CopySharingWeights());
+    ASSERT_NE(nullptr, copy);
+    std::vector<char> owner_data, copy_data;
+    TFile fp;
+    fp.OpenWrite(&owner_data);
+    ASSERT_TRUE(owner.Serialize(&fp));
+    fp.OpenWrite(&copy_data);
+    ASSERT_TRUE(copy->Serialize(&fp));
+    EXPECT_TRUE(owner_data == copy_data);
+    NetworkScratch scratch;
+    scratch.set_int_mode(int_mode);
+    NetworkIO input, owner_output, user_output, copy_output;
+    SetupInput(int_mode, kNumInputs, &input);
+    owner.Forward(false, input, nullptr, &scratch, &owner_output);
+    user.Forward(false, input, nullptr, &scratch, &user_output);
+    copy->Forward(false, input, nullptr, &scratch, &copy_output);
+    ASSERT_EQ(owner_output.Width(), user_output.Width());
+    ASSERT_EQ(owner_output.Width(), copy_output.Width());
+    std::vector<TFloat> owner_values(kNumOutputs), user_values(kNumOutputs),
+        copy_values(kNumOutputs);
+    for (int t = 0; t < owner_output.Width(); ++t) {
+      owner_output.ReadTimeStep(t, &owner_values[0]);
+      user_output.ReadTimeStep(t, &user_values[0]);
+      copy_output.ReadTimeStep(t, &copy_values[0]);
+      for (int i = 0; i < kNumOutputs; ++i) {
+        EXPECT_EQ(owner_values[i], user_values[i]) << "t=" << t;
+        EXPECT_EQ(owner_values[i], copy_values[i]) << "t=" << t;
+      }
+    }
+  }
+
+  TRand randomizer_;
+  std::vector<std::pair<int, int>> h_w_pairs_;
+};
+
+// Tests that a float LSTM gives the same results on a batch as line by line.
+TEST_F(LSTMBatchTest, FloatBatchMatchesRows) {
+  TestBatchMatchesRows(NT_LSTM, false);
+}
+
+// Tests that an int LSTM gives the same results on a batch as line by line.
+TEST_F(LSTMBatchTest, IntBatchMatchesRows) {
+  TestBatchMatchesRows(NT_LSTM, true);
+}
+
+// Tests that a summarizing LSTM gives the same results on a batch.
+TEST_F(LSTMBatchTest, SummaryBatchMatchesRows) {
+  TestBatchMatchesRows(NT_LSTM_SUMMARY, false);
+  TestBatchMatchesRows(NT_LSTM_SUMMARY, true);
+}
+
+// Tests that CopyBatchItem extracts a single image from a batch.
+TEST_F(LSTMBatchTest, CopyBatchItem) {
+  const int kNumFeatures = 3;
+  NetworkIO batch;
+  SetupInput(false, kNumFeatures, &batch);
+  for (unsigned b = 0; b < h_w_pairs_.size(); ++b) {
+    NetworkIO item;
+    item.CopyBatchItem(batch, b);
+    EXPECT_EQ(1, item.stride_map().Size(FD_BATCH));
+    EXPECT_EQ(h_w_pairs_[b].first, item.stride_map().Size(FD_HEIGHT));
+    EXPECT_EQ(h_w_pairs_[b].second, item.stride_map().Size(FD_WIDTH));
+    StrideMap::Index index(item.stride_map());
+    do {
+      StrideMap::Index src_index(batch.stride_map(), b, index.index(FD_HEIGHT),
+                                 index.index(FD_WIDTH));
+      for (int f = 0; f < kNumFeatures; ++f) {
+        EXPECT_EQ(batch.f(src_index.t())[f], item.f(index.t())[f]);
+      }
+    } while (index.Increment());
+  }
+}
+
+// Tests that LSTMs that share weights give the same results as the owner.
+TEST_F(LSTMBatchTest, SharedWeightsMatchOwner) {
+  TestSharedWeightsMatch(NT_LSTM, false);
+  TestSharedWeightsMatch(NT_LSTM, true);
+  TestSharedWeightsMatch(NT_LSTM_SOFTMAX, false);
+  TestSharedWeightsMatch(NT_LSTM_SOFTMAX, true);
+}
+
+} // namespace tesseract
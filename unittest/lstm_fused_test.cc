@@ -0,0 +1,303 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "include_gunit.h"
+#include "helpers.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "stridemap.h"
+#include "threadpool.h"
+#include "weightmatrix.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+namespace tesseract {
+
+class LSTMFusedTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+  }
+
+  // Makes an LSTM with random weights.
+  void MakeLSTM(int num_inputs, int num_states, int num_outputs, NetworkType type, bool int_mode,
+                std::unique_ptr<LSTM> *lstm) {
+    lstm->reset(new LSTM("LSTM", num_inputs, num_states, num_outputs, false, type));
+    (*lstm)->SetEnableTraining(TS_ENABLED);
+    (*lstm)->InitWeights(0.5f, &randomizer_);
+    (*lstm)->SetEnableTraining(TS_DISABLED);
+    if (int_mode) {
+      (*lstm)->ConvertToInt();
+    }
+  }
+
+  // Fills input with images of the given sizes of random values.
+  void SetupInput(bool int_mode, const std::vector<std::pair<int, int>> &h_w_pairs,
+                  int num_features, NetworkIO *input) {
+    StrideMap stride_map;
+    stride_map.SetStride(h_w_pairs);
+    input->ResizeToMap(int_mode, stride_map, num_features);
+    std::vector<TFloat> values(num_features);
+    for (int t = 0; t < input->Width(); ++t) {
+      for (auto &value : values) {
+        value = randomizer_.SignedRand(1.0);
+      }
+      input->WriteTimeStep(t, &values[0]);
+    }
+  }
+
+  // Checks that the LSTM gives exactly the same results with fused gates as
+  // with separate gates, optionally running with a pool of threads.
+  void TestFusedMatchesSeparate(NetworkType type, bool int_mode, int num_states,
+                                const std::vector<std::pair<int, int>> &h_w_pairs,
+                                int num_threads) {
+    const int kNumInputs = 24;
+    // Round number of softmax outputs, as Forward does not pad them.
+    int num_outputs = type == NT_LSTM_SOFTMAX ? 16 : num_states;
+    std::unique_ptr<LSTM> lstm;
+    MakeLSTM(kNumInputs, num_states, num_outputs, type, int_mode, &lstm);
+    NetworkScratch scratch;
+    scratch.set_int_mode(int_mode);
+    NetworkIO input, separate_output, fused_output;
+    SetupInput(int_mode, h_w_pairs, kNumInputs, &input);
+    ThreadPool pool(num_threads);
+    lstm->SetThreadPool(&pool);
+    lstm->FuseGates(false);
+    lstm->Forward(false, input, nullptr, &scratch, &separate_output);
+    lstm->FuseGates(true);
+    lstm->Forward(false, input, nullptr, &scratch, &fused_output);
+    lstm->SetThreadPool(nullptr);
+    ASSERT_EQ(separate_output.Width(), fused_output.Width());
+    std::vector<TFloat> separate_values(num_outputs), fused_values(num_outputs);
+    for (int t = 0; t < separate_output.Width(); ++t) {
+      separate_output.ReadTimeStep(t, &separate_values[0]);
+      fused_output.ReadTimeStep(t, &fused_values[0]);
+      for (int i = 0; i < num_outputs; ++i) {
+        EXPECT_EQ(separate_values[i], fused_values[i]) << "t=" << t << " i=" << i;
+      }
+    }
+  }
+
+  // Returns the mean time in microseconds of a forward pass over a line.
+  double TimeForward(LSTM *lstm, const NetworkIO &input, NetworkScratch *scratch) {
+    const int kNumRuns = 5;
+    NetworkIO output;
+    lstm->Forward(false, input, nullptr, scratch, &output);
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < kNumRuns; ++run) {
+      lstm->Forward(false, input, nullptr, scratch, &output);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / kNumRuns;
+  }
+
+  TRand randomizer_;
+};
+
+// Tests that the fused matrix computes the same values as each of its
+// source matrices, in the interleaved order.
+TEST_F(LSTMFusedTest, FusedMatrixMatchesGates) {
+  const int kNumGates = 4;
+  const int kNumInputs = 37;
+  const int kNumOutputs = 45;
+  for (bool int_mode : {false, true}) {
+    WeightMatrix gates[kNumGates];
+    for (auto &gate : gates) {
+      gate.InitWeightsFloat(kNumOutputs, kNumInputs + 1, false, 0.5f, &randomizer_);
+      if (int_mode) {
+        gate.ConvertToInt();
+      }
+    }
+    FusedWeightMatrix fused;
+    fused.Init(kNumGates, gates);
+    EXPECT_EQ(0, fused.NumOutputs() % (kNumGates * fused.block_size()));
+    EXPECT_LE(kNumGates * kNumOutputs, fused.NumOutputs());
+    int rounded_inputs = gates[0].RoundInputs(kNumInputs);
+    std::vector<int8_t> int_input(rounded_inputs);
+    std::vector<TFloat> float_input(kNumInputs);
+    for (int i = 0; i < kNumInputs; ++i) {
+      float_input[i] = randomizer_.SignedRand(1.0);
+      int_input[i] = IntCastRounded(float_input[i] * INT8_MAX);
+    }
+    std::vector<TFloat> fused_output(fused.NumOutputs());
+    if (int_mode) {
+      fused.MatrixDotVector(&int_input[0], &fused_output[0]);
+    } else {
+      fused.MatrixDotVector(&float_input[0], &fused_output[0]);
+    }
+    for (int g = 0; g < kNumGates; ++g) {
+      std::vector<TFloat> gate_output(kNumOutputs + fused.block_size());
+      if (int_mode) {
+        gates[g].MatrixDotVector(&int_input[0], &gate_output[0]);
+      } else {
+        gates[g].MatrixDotVector(&float_input[0], &gate_output[0]);
+      }
+      for (int i = 0; i < kNumOutputs; ++i) {
+        EXPECT_EQ(gate_output[i], fused_output[fused.Index(g, i)]) << "g=" << g << " i=" << i;
+      }
+    }
+  }
+}
+
+// Tests that a 1-d LSTM gives the same results with fused gates on a single
+// line. The number of states is not a multiple of the block size, so the
+// last block is padded.
+TEST_F(LSTMFusedTest, LineMatchesSeparate) {
+  std::vector<std::pair<int, int>> h_w_pairs = {{1, 30}};
+  for (bool int_mode : {false, true}) {
+    TestFusedMatchesSeparate(NT_LSTM, int_mode, 100, h_w_pairs, 1);
+    TestFusedMatchesSeparate(NT_LSTM, int_mode, 64, h_w_pairs, 1);
+  }
+}
+
+// Tests that a softmax LSTM gives the same results with fused gates.
+TEST_F(LSTMFusedTest, SoftmaxMatchesSeparate) {
+  std::vector<std::pair<int, int>> h_w_pairs = {{1, 30}};
+  TestFusedMatchesSeparate(NT_LSTM_SOFTMAX, false, 40, h_w_pairs, 1);
+  TestFusedMatchesSeparate(NT_LSTM_SOFTMAX, true, 40, h_w_pairs, 1);
+}
+
+// Tests that a batch of rows gives the same results with fused gates.
+TEST_F(LSTMFusedTest, BatchMatchesSeparate) {
+  std::vector<std::pair<int, int>> h_w_pairs = {{3, 17}, {2, 5}, {4, 40}};
+  for (bool int_mode : {false, true}) {
+    TestFusedMatchesSeparate(NT_LSTM, int_mode, 100, h_w_pairs, 1);
+    TestFusedMatchesSeparate(NT_LSTM_SUMMARY, int_mode, 100, h_w_pairs, 1);
+  }
+}
+
+// Tests that the fused gates give the same results with a pool of threads.
+TEST_F(LSTMFusedTest, PoolMatchesSeparate) {
+  std::vector<std::pair<int, int>> h_w_pairs = {{1, 30}};
+  for (bool int_mode : {false, true}) {
+    TestFusedMatchesSeparate(NT_LSTM, int_mode, 100, h_w_pairs, 3);
+    TestFusedMatchesSeparate(NT_LSTM, int_mode, 200, h_w_pairs, 4);
+  }
+}
+
+// Tests that an int LSTM with shaped weights gives the same results after
+// writing and reading it, both with the shaped weights and without them,
+// as when there is no IntSimdMatrix when writing it.
+TEST_F(LSTMFusedTest, ShapedWeightsRoundTrip) {
+  const int kNumInputs = 24;
+  const int kNumOutputs = 16;
+  std::unique_ptr<LSTM> lstm;
+  MakeLSTM(kNumInputs, 100, kNumOutputs, NT_LSTM_SOFTMAX, true, &lstm);
+  lstm->SetShapedWeights(true);
+  NetworkScratch scratch;
+  scratch.set_int_mode(true);
+  NetworkIO input, output;
+  SetupInput(true, {{1, 30}}, kNumInputs, &input);
+  lstm->Forward(false, input, nullptr, &scratch, &output);
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  for (bool shaped : {true, false}) {
+    std::vector<char> data;
+    TFile fp;
+    fp.OpenWrite(&data);
+    IntSimdMatrix::intSimdMatrix = shaped ? matrix : nullptr;
+    ASSERT_TRUE(lstm->Serialize(&fp));
+    IntSimdMatrix::intSimdMatrix = matrix;
+    fp.Open(&data[0], data.size());
+    std::unique_ptr<Network> network(Network::CreateFromFile(&fp));
+    ASSERT_NE(nullptr, network);
+    EXPECT_TRUE(network->TestFlag(NF_SHAPED_WEIGHTS));
+    NetworkIO read_output;
+    network->Forward(false, input, nullptr, &scratch, &read_output);
+    ASSERT_EQ(output.Width(), read_output.Width());
+    std::vector<TFloat> values(kNumOutputs), read_values(kNumOutputs);
+    for (int t = 0; t < output.Width(); ++t) {
+      output.ReadTimeStep(t, &values[0]);
+      read_output.ReadTimeStep(t, &read_values[0]);
+      for (int i = 0; i < kNumOutputs; ++i) {
+        EXPECT_EQ(values[i], read_values[i]) << "shaped=" << shaped << " t=" << t << " i=" << i;
+      }
+    }
+  }
+}
+
+// Tests that a 1-d int LSTM with shaped weights writes only the shaped fused
+// gates, so its file is bigger than without shaped weights by exactly one
+// shaped fused matrix, and that it gives the same results after reading it.
+TEST_F(LSTMFusedTest, ShapedFusedGatesWrittenOnce) {
+  const int kNumInputs = 24;
+  const int kNumStates = 100;
+  const int kNumGates = 4;
+  std::unique_ptr<LSTM> lstm;
+  MakeLSTM(kNumInputs, kNumStates, kNumStates, NT_LSTM, true, &lstm);
+  std::vector<char> plain_data, shaped_data;
+  TFile fp;
+  fp.OpenWrite(&plain_data);
+  ASSERT_TRUE(lstm->Serialize(&fp));
+  lstm->SetShapedWeights(true);
+  fp.OpenWrite(&shaped_data);
+  ASSERT_TRUE(lstm->Serialize(&fp));
+  // A stand-alone fused matrix of the same shape as the interleaved gates.
+  WeightMatrix gates[kNumGates];
+  for (auto &gate : gates) {
+    gate.InitWeightsFloat(kNumStates, kNumInputs + kNumStates + 1, false, 0.5f, &randomizer_);
+    gate.ConvertToInt();
+  }
+  FusedWeightMatrix fused;
+  fused.Init(kNumGates, gates);
+  std::vector<char> fused_data;
+  fp.OpenWrite(&fused_data);
+  ASSERT_TRUE(fused.Serialize(&fp));
+  EXPECT_EQ(plain_data.size() + fused_data.size(), shaped_data.size());
+
+  NetworkScratch scratch;
+  scratch.set_int_mode(true);
+  NetworkIO input, output, read_output;
+  SetupInput(true, {{1, 30}}, kNumInputs, &input);
+  lstm->Forward(false, input, nullptr, &scratch, &output);
+  fp.Open(&shaped_data[0], shaped_data.size());
+  std::unique_ptr<Network> network(Network::CreateFromFile(&fp));
+  ASSERT_NE(nullptr, network);
+  network->Forward(false, input, nullptr, &scratch, &read_output);
+  ASSERT_EQ(output.Width(), read_output.Width());
+  std::vector<TFloat> values(kNumStates), read_values(kNumStates);
+  for (int t = 0; t < output.Width(); ++t) {
+    output.ReadTimeStep(t, &values[0]);
+    read_output.ReadTimeStep(t, &read_values[0]);
+    for (int i = 0; i < kNumStates; ++i) {
+      EXPECT_EQ(values[i], read_values[i]) << "t=" << t << " i=" << i;
+    }
+  }
+}
+
+// Compares the time of a forward pass with separate and fused gates, for a
+// range of network sizes.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(LSTMFusedTest, DISABLED_FusedGatesBenchmark) {
+  const int kNumInputs = 48;
+  const int kWidth = 500;
+  printf("%8s %5s %12s %12s\n", "mode", "ns", "separate(us)", "fused(us)");
+  for (bool int_mode : {false, true}) {
+    for (int num_states : {64, 96, 192, 384}) {
+      std::unique_ptr<LSTM> lstm;
+      MakeLSTM(kNumInputs, num_states, num_states, NT_LSTM, int_mode, &lstm);
+      NetworkScratch scratch;
+      scratch.set_int_mode(int_mode);
+      NetworkIO input;
+      SetupInput(int_mode, {{1, kWidth}}, kNumInputs, &input);
+      lstm->FuseGates(false);
+      double separate_time = TimeForward(lstm.get(), input, &scratch);
+      lstm->FuseGates(true);
+      double fused_time = TimeForward(lstm.get(), input, &scratch);
+      printf("%8s %5d %12.0f %12.0f\n", int_mode ? "int" : "float", num_states, separate_time,
+             fused_time);
+    }
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,163 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "include_gunit.h"
+#include "helpers.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "stridemap.h"
+#include "threadpool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace tesseract {
+
+class LSTMThreadsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+  }
+
+  // Makes an LSTM with random weights.
+  void MakeLSTM(int num_inputs, int num_states, bool two_d, bool int_mode,
+                std::unique_ptr<LSTM> *lstm) {
+    lstm->reset(new LSTM("LSTM", num_inputs, num_states, num_states, two_d, NT_LSTM));
+    (*lstm)->SetEnableTraining(TS_ENABLED);
+    (*lstm)->InitWeights(0.5f, &randomizer_);
+    (*lstm)->SetEnableTraining(TS_DISABLED);
+    if (int_mode) {
+      (*lstm)->ConvertToInt();
+    }
+  }
+
+  // Fills input with a single image of random values.
+  void SetupInput(bool int_mode, int height, int width, int num_features, NetworkIO *input) {
+    std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(height, width));
+    StrideMap stride_map;
+    stride_map.SetStride(h_w_pairs);
+    input->ResizeToMap(int_mode, stride_map, num_features);
+    std::vector<TFloat> values(num_features);
+    for (int t = 0; t < input->Width(); ++t) {
+      for (auto &value : values) {
+        value = randomizer_.SignedRand(1.0);
+      }
+      input->WriteTimeStep(t, &values[0]);
+    }
+  }
+
+  // Checks that running the LSTM with a pool of threads gives exactly the
+  // same results as running it without.
+  void TestPoolMatchesSerial(bool two_d, bool int_mode, int num_states) {
+    const int kNumInputs = 24;
+    const int kHeight = two_d ? 3 : 1;
+    const int kWidth = 30;
+    std::unique_ptr<LSTM> lstm;
+    MakeLSTM(kNumInputs, num_states, two_d, int_mode, &lstm);
+    NetworkScratch scratch;
+    scratch.set_int_mode(int_mode);
+    NetworkIO input, serial_output, pool_output;
+    SetupInput(int_mode, kHeight, kWidth, kNumInputs, &input);
+    lstm->Forward(false, input, nullptr, &scratch, &serial_output);
+    ThreadPool pool(3);
+    lstm->SetThreadPool(&pool);
+    lstm->Forward(false, input, nullptr, &scratch, &pool_output);
+    lstm->SetThreadPool(nullptr);
+    ASSERT_EQ(serial_output.Width(), pool_output.Width());
+    std::vector<TFloat> serial_values(num_states), pool_values(num_states);
+    for (int t = 0; t < serial_output.Width(); ++t) {
+      serial_output.ReadTimeStep(t, &serial_values[0]);
+      pool_output.ReadTimeStep(t, &pool_values[0]);
+      for (int i = 0; i < num_states; ++i) {
+        EXPECT_EQ(serial_values[i], pool_values[i]) << "t=" << t << " i=" << i;
+      }
+    }
+  }
+
+  // Returns the mean time in microseconds of a forward pass over a line.
+  double TimeForward(LSTM *lstm, const NetworkIO &input, NetworkScratch *scratch) {
+    const int kNumRuns = 5;
+    NetworkIO output;
+    lstm->Forward(false, input, nullptr, scratch, &output);
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < kNumRuns; ++run) {
+      lstm->Forward(false, input, nullptr, scratch, &output);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / kNumRuns;
+  }
+
+  TRand randomizer_;
+};
+
+// Tests that a float 1-d LSTM gives the same results with a pool of threads.
+TEST_F(LSTMThreadsTest, Float1DPoolMatchesSerial) {
+  TestPoolMatchesSerial(false, false, 40);
+}
+
+// Tests that an int 1-d LSTM gives the same results with a pool of threads.
+// The number of states is not a multiple of the SIMD register size, so the
+// parts of the last gate are uneven.
+TEST_F(LSTMThreadsTest, Int1DPoolMatchesSerial) {
+  TestPoolMatchesSerial(false, true, 100);
+}
+
+// Tests that a 2-d LSTM gives the same results with a pool of threads.
+TEST_F(LSTMThreadsTest, TwoDPoolMatchesSerial) {
+  TestPoolMatchesSerial(true, false, 32);
+  TestPoolMatchesSerial(true, true, 32);
+}
+
+// Compares the time of a forward pass without threads, with the OpenMP
+// sections and with a pool of threads, for a range of network sizes.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(LSTMThreadsTest, DISABLED_GateThreadsBenchmark) {
+  const int kNumInputs = 48;
+  const int kWidth = 500;
+  printf("%8s %5s %8s %12s %12s %12s\n", "mode", "ns", "threads", "serial(us)", "openmp(us)",
+         "pool(us)");
+  for (bool int_mode : {false, true}) {
+    for (int num_states : {64, 192, 384, 768}) {
+      std::unique_ptr<LSTM> lstm;
+      MakeLSTM(kNumInputs, num_states, false, int_mode, &lstm);
+      NetworkScratch scratch;
+      scratch.set_int_mode(int_mode);
+      NetworkIO input;
+      SetupInput(int_mode, 1, kWidth, kNumInputs, &input);
+      double openmp_time = 0.0;
+#ifdef _OPENMP
+      openmp_time = TimeForward(lstm.get(), input, &scratch);
+      // Make every parallel region run on a single thread.
+      int max_levels = omp_get_max_active_levels();
+      omp_set_max_active_levels(0);
+#endif
+      double serial_time = TimeForward(lstm.get(), input, &scratch);
+      for (int num_threads : {2, 4}) {
+        ThreadPool pool(num_threads);
+        lstm->SetThreadPool(&pool);
+        double pool_time = TimeForward(lstm.get(), input, &scratch);
+        lstm->SetThreadPool(nullptr);
+        printf("%8s %5d %8d %12.0f %12.0f %12.0f\n", int_mode ? "int" : "float", num_states,
+               num_threads, serial_time, openmp_time, pool_time);
+      }
+#ifdef _OPENMP
+      omp_set_max_active_levels(max_levels);
+#endif
+    }
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,129 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matchcache.h"
+
+#include "include_gunit.h"
+
+namespace tesseract {
+
+class MatchCacheTest : public testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+
+  // Returns an entry with a single match of the given unichar and rating.
+  static MatchCacheEntry MakeEntry(UNICHAR_ID unichar_id, float rating) {
+    MatchCacheEntry entry;
+    entry.blob_length = 100;
+    entry.has_nonfragment = true;
+    entry.best_unichar_id = unichar_id;
+    entry.best_match_index = 0;
+    entry.best_rating = rating;
+    entry.match.emplace_back(unichar_id, rating);
+    return entry;
+  }
+};
+
+// Tests that stored entries are found again, and only those.
+TEST_F(MatchCacheTest, LookupFindsStoredEntries) {
+  MatchCache cache;
+  MatchCacheEntry entry;
+  EXPECT_FALSE(cache.Lookup("a", &entry));
+  cache.Store("a", MakeEntry(3, 0.75f));
+  cache.Store("b", MakeEntry(4, 0.5f));
+  EXPECT_EQ(2, cache.size());
+  ASSERT_TRUE(cache.Lookup("a", &entry));
+  EXPECT_EQ(100, entry.blob_length);
+  EXPECT_TRUE(entry.has_nonfragment);
+  EXPECT_EQ(3, entry.best_unichar_id);
+  EXPECT_EQ(0, entry.best_match_index);
+  EXPECT_FLOAT_EQ(0.75f, entry.best_rating);
+  ASSERT_EQ(1, entry.match.size());
+  EXPECT_EQ(3, entry.match[0].unichar_id);
+  EXPECT_FLOAT_EQ(0.75f, entry.match[0].rating);
+  ASSERT_TRUE(cache.Lookup("b", &entry));
+  EXPECT_EQ(4, entry.best_unichar_id);
+  EXPECT_FALSE(cache.Lookup("c", &entry));
+  // Keys are compared as bytes, so embedded zeros matter.
+  cache.Store(std::string("a\0b", 3), MakeEntry(5, 0.25f));
+  ASSERT_TRUE(cache.Lookup(std::string("a\0b", 3), &entry));
+  EXPECT_EQ(5, entry.best_unichar_id);
+  ASSERT_TRUE(cache.Lookup("a", &entry));
+  EXPECT_EQ(3, entry.best_unichar_id);
+}
+
+// Tests that Clear forgets the entries but keeps the statistics, and
+// ResetStats does the opposite.
+TEST_F(MatchCacheTest, ClearAndResetStats) {
+  MatchCache cache;
+  MatchCacheEntry entry;
+  cache.Store("a", MakeEntry(3, 0.75f));
+  EXPECT_TRUE(cache.Lookup("a", &entry));
+  EXPECT_FALSE(cache.Lookup("b", &entry));
+  EXPECT_EQ(2, cache.lookups());
+  EXPECT_EQ(1, cache.hits());
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_FALSE(cache.Lookup("a", &entry));
+  EXPECT_EQ(3, cache.lookups());
+  EXPECT_EQ(1, cache.hits());
+  cache.Store("a", MakeEntry(3, 0.75f));
+  cache.ResetStats();
+  EXPECT_EQ(0, cache.lookups());
+  EXPECT_EQ(0, cache.hits());
+  EXPECT_TRUE(cache.Lookup("a", &entry));
+}
+
+// Tests that the cache never grows beyond kMaxEntries.
+TEST_F(MatchCacheTest, SizeIsBounded) {
+  MatchCache cache;
+  for (int i = 0; i <= MatchCache::kMaxEntries; ++i) {
+    cache.Store(std::to_string(i), MakeEntry(i, 0.5f));
+  }
+  EXPECT_LE(cache.size(), MatchCache::kMaxEntries);
+  MatchCacheEntry entry;
+  ASSERT_TRUE(cache.Lookup(std::to_string(MatchCache::kMaxEntries), &entry));
+  EXPECT_EQ(MatchCache::kMaxEntries, entry.best_unichar_id);
+}
+
+// Tests that several threads can use the cache at the same time.
+TEST_F(MatchCacheTest, ConcurrentAccess) {
+  const int kNumThreads = 4;
+  const int kNumKeys = 1000;
+  MatchCache cache;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&cache]() {
+      MatchCacheEntry entry;
+      for (int i = 0; i < kNumKeys; ++i) {
+        std::string key = std::to_string(i);
+        if (cache.Lookup(key, &entry)) {
+          EXPECT_EQ(i, entry.best_unichar_id);
+        } else {
+          cache.Store(key, MakeEntry(i, 0.5f));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(kNumKeys, cache.size());
+  EXPECT_EQ(kNumThreads * kNumKeys, cache.lookups());
+  EXPECT_LE(cache.hits(), cache.lookups());
+}
+
+} // namespace tesseract
@@ -0,0 +1,81 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "include_gunit.h"
+#include "params.h"
+
+#include <memory>
+
+namespace tesseract {
+
+class ParamsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+
+  ParamsVectors params_;
+};
+
+// Tests that params of each type are found by name in their own index only.
+TEST_F(ParamsTest, FindByName) {
+  IntParam int_param(3, "test_int_param", "", false, &params_);
+  BoolParam bool_param(true, "test_bool_param", "", false, &params_);
+  DoubleParam double_param(0.5, "test_double_param", "", false, &params_);
+  StringParam string_param("abc", "test_string_param", "", false, &params_);
+  EXPECT_EQ(&int_param, ParamUtils::FindParam<IntParam>("test_int_param", &params_));
+  EXPECT_EQ(&bool_param, ParamUtils::FindParam<BoolParam>("test_bool_param", &params_));
+  EXPECT_EQ(&double_param, ParamUtils::FindParam<DoubleParam>("test_double_param", &params_));
+  EXPECT_EQ(&string_param, ParamUtils::FindParam<StringParam>("test_string_param", &params_));
+  EXPECT_EQ(nullptr, ParamUtils::FindParam<BoolParam>("test_int_param", &params_));
+  EXPECT_EQ(nullptr, ParamUtils::FindParam<IntParam>("test_no_param", &params_));
+  EXPECT_EQ(nullptr, ParamUtils::FindParam<IntParam>("test_int_param", nullptr));
+}
+
+// Tests that a global param is found before a member param of the same name.
+TEST_F(ParamsTest, GlobalFirst) {
+  IntParam int_param(3, "log_level", "", false, &params_);
+  IntParam *global_param = ParamUtils::FindParam<IntParam>("log_level", nullptr);
+  ASSERT_NE(nullptr, global_param);
+  EXPECT_NE(&int_param, global_param);
+  EXPECT_EQ(global_param, ParamUtils::FindParam<IntParam>("log_level", &params_));
+}
+
+// Tests that the first of several params with the same name is found, and
+// that the next one is found when it is destroyed, like a search of the
+// vector of params.
+TEST_F(ParamsTest, DuplicateNames) {
+  auto first = std::make_unique<IntParam>(1, "test_dup_param", "", false, &params_);
+  IntParam second(2, "test_dup_param", "", false, &params_);
+  EXPECT_EQ(first.get(), ParamUtils::FindParam<IntParam>("test_dup_param", &params_));
+  first.reset();
+  EXPECT_EQ(&second, ParamUtils::FindParam<IntParam>("test_dup_param", &params_));
+  {
+    IntParam third(3, "test_dup_param", "", false, &params_);
+    EXPECT_EQ(&second, ParamUtils::FindParam<IntParam>("test_dup_param", &params_));
+  }
+  EXPECT_EQ(&second, ParamUtils::FindParam<IntParam>("test_dup_param", &params_));
+}
+
+// Tests that params are set by name through the index.
+TEST_F(ParamsTest, SetByName) {
+  IntParam int_param(3, "test_int_param", "", false, &params_);
+  StringParam string_param("abc", "test_string_param", "", false, &params_);
+  EXPECT_TRUE(
+      ParamUtils::SetParam("test_int_param", "42", SET_PARAM_CONSTRAINT_NONE, &params_));
+  EXPECT_EQ(42, static_cast<int32_t>(int_param));
+  EXPECT_TRUE(
+      ParamUtils::SetParam("test_string_param", "xyz", SET_PARAM_CONSTRAINT_NONE, &params_));
+  EXPECT_STREQ("xyz", string_param.c_str());
+  EXPECT_FALSE(
+      ParamUtils::SetParam("test_no_param", "1", SET_PARAM_CONSTRAINT_NONE, &params_));
+}
+
+} // namespace tesseract
@@ -22,6 +22,9 @@
 
 #include "helpers.h"
 
+#include <chrono>
+#include <cstdio>
+
 namespace tesseract {
 
 // Number of characters to test beam search with.
@@ -466,6 +469,36 @@ TEST_F(RecodeBeamTest, DISABLED_ChiDictionary) {
   }
 }
 
+// Times decoding a long line made of copies of the recorded outputs, with and
+// without the dictionary. After the first line, the search reuses all of its
+// memory for the beams and the dawgs.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(RecodeBeamTest, DISABLED_DecodeBenchmark) {
+  const int kNumCopies = 50;
+  const int kNumRuns = 20;
+  LoadUnicharset("eng_beam.unicharset");
+  GENERIC_2D_ARRAY<float> outputs =
+      GenerateSyntheticOutputs(kGWRTops, kGWRTopScores, kGWR2nds, kGWR2ndScores, nullptr);
+  GENERIC_2D_ARRAY<float> line(outputs.dim1() * kNumCopies, outputs.dim2(), 0.0f);
+  for (int t = 0; t < line.dim1(); ++t) {
+    for (int c = 0; c < line.dim2(); ++c) {
+      line(t, c) = outputs(t % outputs.dim1(), c);
+    }
+  }
+  LoadDict("eng_beam");
+  for (Dict *dict : {static_cast<Dict *>(nullptr), &lstm_dict_}) {
+    RecodeBeamSearch beam_search(recoder_, encoded_null_char_, false, dict);
+    beam_search.Decode(line, 3.5, -0.125, -25.0, nullptr);
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < kNumRuns; ++run) {
+      beam_search.Decode(line, 3.5, -0.125, -25.0, nullptr);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%s: %.0f us per line of %d timesteps\n", dict == nullptr ? "no dict" : "dict",
+           elapsed.count() / kNumRuns, line.dim1());
+  }
+}
+
 // Tests that a recoder built with decomposed unicode allows true ctc
 // arbitrary duplicates and inserted nulls inside the multicode sequence.
 TEST_F(RecodeBeamTest, DISABLED_MultiCodeSequences) {
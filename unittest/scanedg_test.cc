@@ -0,0 +1,331 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <allheaders.h>
+
+#include "coutln.h"
+#include "crakedge.h"
+#include "edgloop.h"
+#include "helpers.h"
+#include "image.h"
+#include "pdblock.h"
+#include "polyblk.h"
+#include "scanedg.h"
+
+#include "include_gunit.h"
+
+namespace tesseract {
+
+// The scan that block_edges used before it worked on whole words of pixels:
+// one byte per pixel, visiting every pixel of the block. It is kept here as
+// the reference that block_edges must match exactly.
+class ByteWiseEdgeScanner {
+public:
+  explicit ByteWiseEdgeScanner(C_OUTLINE_IT *outline_it) : outline_it_(outline_it) {}
+
+  void Scan(Image pix, PDBLK *block) {
+    const uint8_t kWhite = 1;
+    int height = pixGetHeight(pix);
+    int wpl = pixGetWpl(pix);
+    BLOCK_LINE_IT line_it = block;
+    ICOORD bleft, tright;
+    block->bounding_box(bleft, tright);
+    int block_width = tright.x() - bleft.x();
+    std::vector<CRACKEDGE *> prevline(block_width + 1, nullptr);
+    std::vector<uint8_t> bwline(block_width);
+    for (int y = tright.y() - 1; y >= bleft.y() - 1; y--) {
+      if (y >= bleft.y() && y < tright.y()) {
+        l_uint32 *line = pixGetData(pix) + wpl * (height - 1 - y);
+        for (int x = 0; x < block_width; ++x) {
+          bwline[x] = Image::getDataBit(line, x + bleft.x()) ^ 1;
+        }
+        MakeMargins(block, &line_it, &bwline[0], kWhite, bleft.x(), tright.x(), y);
+      } else {
+        std::fill(bwline.begin(), bwline.end(), kWhite);
+      }
+      LineEdges(bleft.x(), y, block_width, kWhite, &bwline[0], &prevline[0]);
+    }
+  }
+
+private:
+  static void MakeMargins(PDBLK *block, BLOCK_LINE_IT *line_it, uint8_t *pixels, uint8_t margin,
+                          TDimension left, TDimension right, TDimension y) {
+    if (block->poly_block() != nullptr) {
+      PB_LINE_IT lines(block->poly_block());
+      const std::unique_ptr<ICOORDELT_LIST> segments(lines.get_line(y));
+      if (segments->empty()) {
+        for (auto xindex = left; xindex < right; xindex++) {
+          pixels[xindex - left] = margin;
+        }
+        return;
+      }
+      ICOORDELT_IT seg_it(segments.get());
+      seg_it.mark_cycle_pt();
+      auto start = seg_it.data()->x();
+      auto xext = seg_it.data()->y();
+      for (auto xindex = left; xindex < right; xindex++) {
+        if (xindex >= start && !seg_it.cycled_list()) {
+          xindex = start + xext - 1;
+          seg_it.forward();
+          start = seg_it.data()->x();
+          xext = seg_it.data()->y();
+        } else {
+          pixels[xindex - left] = margin;
+        }
+      }
+    } else {
+      TDimension xext;
+      auto start = line_it->get_line(y, xext);
+      for (auto xindex = left; xindex < start; xindex++) {
+        pixels[xindex - left] = margin;
+      }
+      for (auto xindex = start + xext; xindex < right; xindex++) {
+        pixels[xindex - left] = margin;
+      }
+    }
+  }
+
+  void LineEdges(int x, int y, int xext, uint8_t uppercolour, const uint8_t *bwpos,
+                 CRACKEDGE **prevline) {
+    int xmax = x + xext;
+    int prevcolour = uppercolour;
+    CRACKEDGE *current = nullptr;
+    for (; x < xmax; x++, prevline++) {
+      const int colour = *bwpos++;
+      if (*prevline != nullptr) {
+        uppercolour = 1 - uppercolour;
+        if (colour == prevcolour) {
+          if (colour == uppercolour) {
+            JoinEdges(current, *prevline);
+            current = nullptr;
+          } else {
+            current = HEdge(uppercolour - colour, *prevline, x, y);
+          }
+          *prevline = nullptr;
+        } else {
+          if (colour == uppercolour) {
+            *prevline = VEdge(colour - prevcolour, *prevline, x, y);
+          } else if (colour == 1) {
+            JoinEdges(current, *prevline);
+            current = HEdge(uppercolour - colour, nullptr, x, y);
+            *prevline = VEdge(colour - prevcolour, current, x, y);
+          } else {
+            CRACKEDGE *newcurrent = HEdge(uppercolour - colour, *prevline, x, y);
+            *prevline = VEdge(colour - prevcolour, current, x, y);
+            current = newcurrent;
+          }
+          prevcolour = colour;
+        }
+      } else {
+        if (colour != prevcolour) {
+          *prevline = current = VEdge(colour - prevcolour, current, x, y);
+          prevcolour = colour;
+        }
+        if (colour != uppercolour) {
+          current = HEdge(uppercolour - colour, current, x, y);
+        } else {
+          current = nullptr;
+        }
+      }
+    }
+    if (current != nullptr) {
+      if (*prevline != nullptr) {
+        JoinEdges(current, *prevline);
+        *prevline = nullptr;
+      } else {
+        *prevline = VEdge(1 - 2 * prevcolour, current, x, y);
+      }
+    } else if (*prevline != nullptr) {
+      *prevline = VEdge(1 - 2 * prevcolour, *prevline, x, y);
+    }
+  }
+
+  // Links newpt into the loop of join, before it if newpt ends where join
+  // starts, else after it.
+  static void Link(CRACKEDGE *newpt, CRACKEDGE *join, bool before) {
+    if (join == nullptr) {
+      newpt->next = newpt;
+      newpt->prev = newpt;
+    } else if (before) {
+      newpt->prev = join->prev;
+      newpt->prev->next = newpt;
+      newpt->next = join;
+      join->prev = newpt;
+    } else {
+      newpt->next = join->next;
+      newpt->next->prev = newpt;
+      newpt->prev = join;
+      join->next = newpt;
+    }
+  }
+
+  CRACKEDGE *NewCrack() {
+    cracks_.emplace_back(new CRACKEDGE);
+    return cracks_.back().get();
+  }
+
+  CRACKEDGE *HEdge(int sign, CRACKEDGE *join, int x, int y) {
+    CRACKEDGE *newpt = NewCrack();
+    newpt->pos.set_y(y + 1);
+    newpt->stepy = 0;
+    newpt->pos.set_x(sign > 0 ? x + 1 : x);
+    newpt->stepx = sign > 0 ? -1 : 1;
+    newpt->stepdir = sign > 0 ? 0 : 2;
+    Link(newpt, join,
+         join != nullptr && newpt->pos.x() + newpt->stepx == join->pos.x() &&
+             newpt->pos.y() == join->pos.y());
+    return newpt;
+  }
+
+  CRACKEDGE *VEdge(int sign, CRACKEDGE *join, int x, int y) {
+    CRACKEDGE *newpt = NewCrack();
+    newpt->pos.set_x(x);
+    newpt->stepx = 0;
+    newpt->pos.set_y(sign > 0 ? y : y + 1);
+    newpt->stepy = sign > 0 ? 1 : -1;
+    newpt->stepdir = sign > 0 ? 3 : 1;
+    Link(newpt, join,
+         join != nullptr && newpt->pos.x() == join->pos.x() &&
+             newpt->pos.y() + newpt->stepy == join->pos.y());
+    return newpt;
+  }
+
+  void JoinEdges(CRACKEDGE *edge1, CRACKEDGE *edge2) {
+    if (edge1->pos.x() + edge1->stepx != edge2->pos.x() ||
+        edge1->pos.y() + edge1->stepy != edge2->pos.y()) {
+      std::swap(edge1, edge2);
+    }
+    if (edge1->next == edge2) {
+      complete_edge(edge1, outline_it_);
+    } else {
+      edge2->prev->next = edge1->next;
+      edge1->next->prev = edge2->prev;
+      edge1->next = edge2;
+      edge2->prev = edge1;
+    }
+  }
+
+  C_OUTLINE_IT *outline_it_;
+  // All the edges made, freed when the scan is done.
+  std::vector<std::unique_ptr<CRACKEDGE>> cracks_;
+};
+
+class ScanEdgesTest : public testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+  }
+
+  // Returns a 1 bpp image of random pixels. The density picks sparse, dense
+  // or mostly solid words. The padding bits at the end of each line are
+  // random too, as the scan must ignore them.
+  Image MakeRandomImage(int width, int height, int density) {
+    Image pix = pixCreate(width, height, 1);
+    l_uint32 *data = pixGetData(pix);
+    int num_words = pixGetWpl(pix) * height;
+    for (int i = 0; i < num_words; ++i) {
+      uint32_t word = RandomWord();
+      if (density == 0) {
+        word &= RandomWord() & RandomWord();
+      } else if (density == 1) {
+        word |= RandomWord() | RandomWord();
+      } else if (randomizer_.IntRand() % 3 != 0) {
+        word = randomizer_.IntRand() % 2 ? 0 : ~0u;
+      }
+      data[i] = word;
+    }
+    return pix;
+  }
+
+  uint32_t RandomWord() {
+    return static_cast<uint32_t>(randomizer_.IntRand()) << 16 ^ randomizer_.IntRand();
+  }
+
+  // Makes a block of the given box, which is a pentagon cut into from the
+  // left if poly, and checks that block_edges finds the same outlines as the
+  // byte-wise scan.
+  void TestBlockMatchesByteWise(Image pix, int left, int bottom, int right, int top, bool poly) {
+    C_OUTLINE_LIST outlines[2];
+    for (int scan = 0; scan < 2; ++scan) {
+      PDBLK block(left, bottom, right, top);
+      if (poly) {
+        ICOORDELT_LIST points;
+        ICOORDELT_IT it(&points);
+        it.add_after_then_move(new ICOORDELT(left, bottom));
+        it.add_after_then_move(new ICOORDELT((left + right) / 2, (bottom + top) / 2));
+        it.add_after_then_move(new ICOORDELT(left, top));
+        it.add_after_then_move(new ICOORDELT(right, top));
+        it.add_after_then_move(new ICOORDELT(right, bottom));
+        block.set_poly_block(new POLY_BLOCK(&points, PT_FLOWING_TEXT));
+      }
+      C_OUTLINE_IT outline_it(&outlines[scan]);
+      if (scan == 0) {
+        ByteWiseEdgeScanner scanner(&outline_it);
+        scanner.Scan(pix, &block);
+      } else {
+        block_edges(pix, &block, &outline_it);
+      }
+    }
+    ASSERT_EQ(outlines[0].length(), outlines[1].length())
+        << "box=" << left << "," << bottom << "," << right << "," << top << " poly=" << poly;
+    C_OUTLINE_IT expected_it(&outlines[0]);
+    C_OUTLINE_IT actual_it(&outlines[1]);
+    for (expected_it.mark_cycle_pt(); !expected_it.cycled_list();
+         expected_it.forward(), actual_it.forward()) {
+      const C_OUTLINE *expected = expected_it.data();
+      const C_OUTLINE *actual = actual_it.data();
+      EXPECT_EQ(expected->start_pos().x(), actual->start_pos().x());
+      EXPECT_EQ(expected->start_pos().y(), actual->start_pos().y());
+      ASSERT_EQ(expected->pathlength(), actual->pathlength());
+      for (int s = 0; s < expected->pathlength(); ++s) {
+        EXPECT_EQ(expected->step_dir(s).get_dir(), actual->step_dir(s).get_dir()) << "step " << s;
+      }
+    }
+  }
+
+  TRand randomizer_;
+};
+
+// Tests whole random images, of widths that are and are not a multiple of
+// the word size, so the tail of the last word has to be masked.
+TEST_F(ScanEdgesTest, WholeImageMatchesByteWise) {
+  for (int width : {1, 31, 32, 33, 64, 100, 129}) {
+    for (int density = 0; density < 3; ++density) {
+      Image pix = MakeRandomImage(width, 23, density);
+      TestBlockMatchesByteWise(pix, 0, 0, width, 23, false);
+      pix.destroy();
+    }
+  }
+}
+
+// Tests random rectangular and polygonal blocks within random images, so
+// the left edge of the block is mostly not at the start of a word and
+// make_margins has to clear pixels in the middle of words.
+TEST_F(ScanEdgesTest, BlocksMatchByteWise) {
+  for (int i = 0; i < 300; ++i) {
+    int width = 1 + randomizer_.IntRand() % 200;
+    int height = 1 + randomizer_.IntRand() % 60;
+    Image pix = MakeRandomImage(width, height, i % 3);
+    int left = randomizer_.IntRand() % width;
+    int right = left + 1 + randomizer_.IntRand() % (width - left);
+    int bottom = randomizer_.IntRand() % height;
+    int top = bottom + 1 + randomizer_.IntRand() % (height - bottom);
+    TestBlockMatchesByteWise(pix, left, bottom, right, top, false);
+    TestBlockMatchesByteWise(pix, left, bottom, right, top, true);
+    pix.destroy();
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,74 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "threadpool.h"
+
+#include "include_gunit.h"
+
+#include <atomic>
+#include <vector>
+
+namespace tesseract {
+
+class ThreadPoolTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+
+  // Runs a loop of num_items on the pool and checks that every item ran
+  // exactly once, on a valid thread.
+  void TestAllItemsRunOnce(ThreadPool *pool, int num_items) {
+    std::vector<std::atomic<int>> counts(num_items);
+    std::atomic<int> bad_threads(0);
+    pool->ParallelFor(num_items, [&](int item, int thread) {
+      ++counts[item];
+      if (thread < 0 || thread >= pool->num_threads()) {
+        ++bad_threads;
+      }
+    });
+    for (int i = 0; i < num_items; ++i) {
+      EXPECT_EQ(1, counts[i].load()) << "item " << i;
+    }
+    EXPECT_EQ(0, bad_threads.load());
+  }
+};
+
+// Tests that a pool with only the calling thread runs every item.
+TEST_F(ThreadPoolTest, SingleThread) {
+  ThreadPool pool(1);
+  EXPECT_EQ(1, pool.num_threads());
+  TestAllItemsRunOnce(&pool, 100);
+}
+
+// Tests that the items are all run once, however they fit the threads, and
+// that the pool can be reused for many loops.
+TEST_F(ThreadPoolTest, ManyLoops) {
+  ThreadPool pool(4);
+  EXPECT_EQ(4, pool.num_threads());
+  for (int num_items = 0; num_items < 50; ++num_items) {
+    TestAllItemsRunOnce(&pool, num_items);
+  }
+}
+
+// Tests that per-thread data indexed by the thread needs no locking.
+TEST_F(ThreadPoolTest, PerThreadSums) {
+  const int kNumItems = 10000;
+  ThreadPool pool(3);
+  std::vector<int64_t> sums(pool.num_threads());
+  pool.ParallelFor(kNumItems, [&sums](int item, int thread) { sums[thread] += item; });
+  int64_t total = 0;
+  for (auto sum : sums) {
+    total += sum;
+  }
+  EXPECT_EQ(static_cast<int64_t>(kNumItems) * (kNumItems - 1) / 2, total);
+}
+
+} // namespace tesseract
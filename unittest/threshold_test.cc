@@ -0,0 +1,120 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "helpers.h"
+#include "include_gunit.h"
+#include "simddetect.h"
+#include "threshold.h"
+
+#include <cmath>
+#include <vector>
+
+namespace tesseract {
+
+class ThresholdTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    randomizer_.set_seed(1);
+  }
+
+  // Checks that func finds the same indices as a scalar loop, for all sizes
+  // up to a few SIMD registers, so all the tails are covered, and for a
+  // range of thresholds, from none to all of the values.
+  void ExpectSameIndices(IndicesAboveFunction func, const char *name) {
+    const int kMaxSize = 100;
+    std::vector<float> values(kMaxSize);
+    for (auto &value : values) {
+      value = randomizer_.UnsignedRand(1.0);
+    }
+    // Equal values and NaN are never above the threshold.
+    values[17] = 0.5f;
+    values[40] = std::nanf("");
+    for (float threshold : {-1.0f, 0.0f, 0.5f, 0.9f, 0.99f, 2.0f}) {
+      for (int n = 0; n <= kMaxSize; ++n) {
+        std::vector<int> expected;
+        for (int i = 0; i < n; ++i) {
+          if (values[i] > threshold) {
+            expected.push_back(i);
+          }
+        }
+        std::vector<int> indices(n);
+        int count = func(&values[0], n, threshold, indices.data());
+        indices.resize(count);
+        EXPECT_EQ(expected, indices) << name << " n=" << n << " threshold=" << threshold;
+      }
+    }
+  }
+
+  TRand randomizer_;
+};
+
+// Tests the function which was selected by SIMDDetect.
+TEST_F(ThresholdTest, Default) {
+  ExpectSameIndices(IndicesAbove, "default");
+}
+
+// Tests the NEON implementation.
+TEST_F(ThresholdTest, NEON) {
+#if defined(HAVE_NEON) || defined(__aarch64__)
+  if (!SIMDDetect::IsNEONAvailable()) {
+    GTEST_LOG_(INFO) << "No NEON found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameIndices(IndicesAboveNEON, "NEON");
+#else
+  GTEST_LOG_(INFO) << "NEON unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the SSE implementation.
+TEST_F(ThresholdTest, SSE) {
+#if defined(HAVE_SSE4_1)
+  if (!SIMDDetect::IsSSEAvailable()) {
+    GTEST_LOG_(INFO) << "No SSE found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameIndices(IndicesAboveSSE, "SSE");
+#else
+  GTEST_LOG_(INFO) << "SSE unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the AVX2 implementation.
+TEST_F(ThresholdTest, AVX2) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameIndices(IndicesAboveAVX2, "AVX2");
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests the AVX512F implementation.
+TEST_F(ThresholdTest, AVX512F) {
+#if defined(HAVE_AVX512F)
+  if (!SIMDDetect::IsAVX512FAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512F found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameIndices(IndicesAboveAVX512F, "AVX512F");
+#else
+  GTEST_LOG_(INFO) << "AVX512F unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+} // namespace tesseract